@@ -0,0 +1,92 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "BenchData.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace convex_hull_filtering_bench {
+
+std::vector<chf::ConvexHull> makeRandomConvexHulls(std::size_t count,
+                                                   int nbVertices,
+                                                   float worldSize,
+                                                   float radius,
+                                                   unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> centerDist(0.0f, worldSize);
+  std::uniform_real_distribution<float> radiusDist(0.5f * radius,
+                                                   1.5f * radius);
+  std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * M_PI);
+
+  std::vector<chf::ConvexHull> convexHulls;
+  convexHulls.reserve(count);
+  std::vector<float> angles(nbVertices);
+  for (std::size_t i = 0; i < count; i++) {
+    // Points on an ellipse sorted by angle always form a convex polygon
+    float cx = centerDist(gen);
+    float cy = centerDist(gen);
+    float rx = radiusDist(gen);
+    float ry = radiusDist(gen);
+    for (auto& angle : angles) {
+      angle = angleDist(gen);
+    }
+    std::sort(angles.begin(), angles.end());
+    std::vector<chf::Point> points;
+    points.reserve(nbVertices);
+    for (float angle : angles) {
+      points.push_back(
+          chf::Point(cx + rx * std::cos(angle), cy + ry * std::sin(angle)));
+    }
+    convexHulls.push_back(chf::ConvexHull(points, i));
+  }
+  return convexHulls;
+}
+
+std::vector<chf::ConvexHull> makeRandomElongatedConvexHulls(
+    std::size_t count, int nbVertices, float worldSize, float length,
+    float aspectRatio, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> centerDist(0.0f, worldSize);
+  std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * M_PI);
+
+  std::vector<chf::ConvexHull> convexHulls;
+  convexHulls.reserve(count);
+  float rx = 0.5f * length;
+  float ry = rx / aspectRatio;
+  for (std::size_t i = 0; i < count; i++) {
+    float cx = centerDist(gen);
+    float cy = centerDist(gen);
+    float rotation = angleDist(gen);
+    float c = std::cos(rotation);
+    float s = std::sin(rotation);
+    std::vector<chf::Point> points;
+    points.reserve(nbVertices);
+    for (int k = 0; k < nbVertices; k++) {
+      float angle = 2.0f * M_PI * k / nbVertices;
+      float x = rx * std::cos(angle);
+      float y = ry * std::sin(angle);
+      points.push_back(chf::Point(cx + c * x - s * y, cy + s * x + c * y));
+    }
+    convexHulls.push_back(chf::ConvexHull(points, i));
+  }
+  return convexHulls;
+}
+
+std::vector<std::pair<int, int>> findCandidatePairs(
+    const std::vector<chf::ConvexHull>& convexHulls, unsigned int m,
+    unsigned int M) {
+  chf::RTree rtree(m, M);
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    rtree.insertEntry(i, chf::BoundingBox(convexHulls[i].points));
+  }
+  return rtree.findPairwiseIntersections();
+}
+}  // namespace convex_hull_filtering_bench
@@ -0,0 +1,37 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef BENCH_BENCHDATA_HPP_
+#define BENCH_BENCHDATA_HPP_
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering_bench {
+
+namespace chf = convex_hull_filtering;
+
+// Random convex hulls whose centers are uniformly spread over a square of
+// side worldSize, the mean radius controls how much they overlap
+std::vector<chf::ConvexHull> makeRandomConvexHulls(std::size_t count,
+                                                   int nbVertices,
+                                                   float worldSize,
+                                                   float radius,
+                                                   unsigned int seed);
+
+// Same with ellipses of the given length and ratio of length to width, each
+// rotated by a random angle, so that their bounding boxes are loose
+std::vector<chf::ConvexHull> makeRandomElongatedConvexHulls(
+    std::size_t count, int nbVertices, float worldSize, float length,
+    float aspectRatio, unsigned int seed);
+
+// Candidate pairs found by the RTree broad phase
+std::vector<std::pair<int, int>> findCandidatePairs(
+    const std::vector<chf::ConvexHull>& convexHulls, unsigned int m,
+    unsigned int M);
+}  // namespace convex_hull_filtering_bench
+
+#endif  // BENCH_BENCHDATA_HPP_
@@ -0,0 +1,95 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+// Same 100k convex hulls written in every format
+class LoadFiles {
+ public:
+  LoadFiles() {
+    auto tmpDir = std::filesystem::temp_directory_path();
+    jsonFile = (tmpDir / "chf_bench_format.json").string();
+    floatFile = (tmpDir / "chf_bench_format_float.chb").string();
+    doubleFile = (tmpDir / "chf_bench_format_double.chb").string();
+    auto convexHulls =
+        chfb::makeRandomConvexHulls(100000, 8, 5000.0f, 6.0f, 42);
+    chf::saveJson(jsonFile, convexHulls);
+    chf::saveBinary(floatFile, convexHulls, sizeof(float));
+    chf::saveBinary(doubleFile, convexHulls, sizeof(double));
+  }
+
+  std::string jsonFile;
+  std::string floatFile;
+  std::string doubleFile;
+};
+
+const LoadFiles& getLoadFiles() {
+  static LoadFiles files;
+  return files;
+}
+
+void setFileCounters(benchmark::State* state, const std::string& filePath) {
+  auto fileSize = std::filesystem::file_size(filePath);
+  state->SetBytesProcessed(state->iterations() * fileSize);
+  state->counters["file_MB"] = fileSize / (1024.0 * 1024.0);
+}
+}  // namespace
+
+static void BM_LoadFormatJson(benchmark::State& state) {
+  const auto& filePath = getLoadFiles().jsonFile;
+  for (auto _ : state) {
+    auto convexHulls = chf::loadJson(filePath);
+    benchmark::DoNotOptimize(convexHulls);
+  }
+  setFileCounters(&state, filePath);
+}
+BENCHMARK(BM_LoadFormatJson)->Unit(benchmark::kMillisecond);
+
+// Copy every convex hull out of the mapping
+static void BM_LoadFormatBinary(benchmark::State& state) {
+  const auto& files = getLoadFiles();
+  const auto& filePath = state.range(0) ? files.doubleFile : files.floatFile;
+  for (auto _ : state) {
+    auto convexHulls = chf::loadBinary(filePath);
+    benchmark::DoNotOptimize(convexHulls);
+  }
+  setFileCounters(&state, filePath);
+}
+BENCHMARK(BM_LoadFormatBinary)
+    ->ArgName("double")
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// Map the file and read every point through the views
+static void BM_LoadFormatBinaryViews(benchmark::State& state) {
+  const auto& filePath = getLoadFiles().floatFile;
+  for (auto _ : state) {
+    chf::MappedHullFile file(filePath);
+    float sum = 0.0f;
+    for (std::size_t i = 0; i < file.size(); i++) {
+      auto view = file[i];
+      const chf::Point* points = view.data();
+      for (std::size_t j = 0; j < view.size(); j++) {
+        sum += points[j].x;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  setFileCounters(&state, filePath);
+}
+BENCHMARK(BM_LoadFormatBinaryViews)->Unit(benchmark::kMillisecond);
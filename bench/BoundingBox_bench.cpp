@@ -0,0 +1,53 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+constexpr std::size_t NB_BOUNDING_BOXES = 1024;
+
+std::vector<chf::BoundingBox> makeBoundingBoxes() {
+  std::vector<chf::BoundingBox> boundingBoxes;
+  for (const auto& convexHull :
+       chfb::makeRandomConvexHulls(NB_BOUNDING_BOXES, 8, 100.0f, 6.0f, 42)) {
+    boundingBoxes.push_back(chf::BoundingBox(convexHull.points));
+  }
+  return boundingBoxes;
+}
+}  // namespace
+
+static void BM_BoundingBoxGetUnion(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes();
+  std::size_t i = 0;
+  for (auto _ : state) {
+    auto boundingBox =
+        boundingBoxes[i].getUnion(boundingBoxes[(i + 1) % NB_BOUNDING_BOXES]);
+    benchmark::DoNotOptimize(boundingBox);
+    i = (i + 1) % NB_BOUNDING_BOXES;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoundingBoxGetUnion);
+
+static void BM_BoundingBoxIntersect(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes();
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        boundingBoxes[i].intersect(boundingBoxes[(i + 1) % NB_BOUNDING_BOXES]));
+    i = (i + 1) % NB_BOUNDING_BOXES;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BoundingBoxIntersect);
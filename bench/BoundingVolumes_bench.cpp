@@ -0,0 +1,62 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BoundingVolumes.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+static void BM_BoundingVolumesBuild(benchmark::State& state) {
+  auto convexHulls = chfb::makeRandomElongatedConvexHulls(
+      5000, 32, 400.0f, 20.0f, 8.0f, 42);
+  auto leafVolume = static_cast<chf::LeafVolume>(state.range(0));
+  for (auto _ : state) {
+    chf::BoundingVolumes volumes(convexHulls, leafVolume);
+    benchmark::DoNotOptimize(volumes.size());
+  }
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_BoundingVolumesBuild)->Arg(1)->Arg(2);
+
+// Whole pairwise filter on one thread over sticks of range(0) vertices in
+// random directions, with the leaf volume range(1) (box, 8-DOP, oriented
+// box). false_positives is the fraction of the candidate pairs that don't
+// intersect.
+static void BM_HullFilterLeafVolume(benchmark::State& state) {
+  auto convexHulls = chfb::makeRandomElongatedConvexHulls(
+      5000, state.range(0), 400.0f, 20.0f, 8.0f, 42);
+  chf::HullFilterConfig config;
+  config.nbThreads = 1;
+  config.leafVolume = static_cast<chf::LeafVolume>(state.range(1));
+  chf::HullFilter hullFilter(config);
+  chf::Instrumentation instrumentation;
+  for (auto _ : state) {
+    instrumentation = chf::Instrumentation();
+    hullFilter.setInstrumentation(&instrumentation);
+    auto kept = hullFilter.filter(convexHulls);
+    benchmark::DoNotOptimize(kept);
+  }
+  auto nbCandidatePairs = instrumentation.get(chf::Counter::CANDIDATE_PAIRS);
+  state.counters["pairs"] = nbCandidatePairs;
+  state.counters["rejected"] =
+      instrumentation.get(chf::Counter::REJECTED_PAIRS);
+  state.counters["false_positives"] =
+      1.0 - static_cast<double>(
+                instrumentation.get(chf::Counter::INTERSECTIONS)) /
+                nbCandidatePairs;
+  state.counters["broad_ms"] =
+      instrumentation.getSeconds(chf::Stage::BROAD_PHASE) * 1000.0;
+  state.counters["narrow_ms"] =
+      instrumentation.getSeconds(chf::Stage::NARROW_PHASE) * 1000.0;
+}
+BENCHMARK(BM_HullFilterLeafVolume)
+    ->ArgsProduct({{8, 32}, {0, 1, 2}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,104 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+constexpr std::size_t NB_CONVEX_HULLS = 1024;
+
+// Convex hulls crowded in a small square so that consecutive ones overlap
+std::vector<chf::ConvexHull> makeOverlappingConvexHulls(int nbVertices) {
+  return chfb::makeRandomConvexHulls(NB_CONVEX_HULLS, nbVertices, 10.0f,
+                                     10.0f, 42);
+}
+}  // namespace
+
+// O'Rourke intersection of two overlapping convex hulls per vertex count
+static void BM_ConvexHullIntersection(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  std::vector<chf::Point> interPoints;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const auto& P = convexHulls[i];
+    const auto& Q = convexHulls[(i + 1) % NB_CONVEX_HULLS];
+    bool intersect = P.intersection(Q, &interPoints);
+    benchmark::DoNotOptimize(intersect);
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvexHullIntersection)->RangeMultiplier(2)->Range(4, 64);
+
+// Same pairs through the dispatcher, up to 16 vertices they go to the
+// FixedConvexHull kernels and above to the O'Rourke intersection
+static void BM_ConvexHullIntersectionArea(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  std::vector<chf::Point> interPoints;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const auto& P = convexHulls[i];
+    const auto& Q = convexHulls[(i + 1) % NB_CONVEX_HULLS];
+    float interArea;
+    bool intersect = P.intersectionArea(Q, &interArea, &interPoints);
+    benchmark::DoNotOptimize(intersect);
+    benchmark::DoNotOptimize(interArea);
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvexHullIntersectionArea)->RangeMultiplier(2)->Range(4, 64);
+
+// Generic intersection followed by the area, what the dispatcher replaces
+static void BM_ConvexHullIntersectionThenArea(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  std::vector<chf::Point> interPoints;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    const auto& P = convexHulls[i];
+    const auto& Q = convexHulls[(i + 1) % NB_CONVEX_HULLS];
+    float interArea = P.intersection(Q, &interPoints)
+                          ? chf::ConvexHull::computeArea(interPoints)
+                          : 0.0f;
+    benchmark::DoNotOptimize(interArea);
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvexHullIntersectionThenArea)
+    ->RangeMultiplier(2)
+    ->Range(4, 64);
+
+// Through the FixedConvexHull kernels up to 16 vertices
+static void BM_ConvexHullArea(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(convexHulls[i].getArea());
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvexHullArea)->RangeMultiplier(4)->Range(4, 64);
+
+static void BM_ConvexHullComputeArea(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  std::size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        chf::ConvexHull::computeArea(convexHulls[i].points));
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ConvexHullComputeArea)->RangeMultiplier(4)->Range(4, 64);
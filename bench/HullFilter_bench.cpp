@@ -0,0 +1,69 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/HullFilter.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+std::vector<chf::ConvexHull> makeBatch(std::size_t count) {
+  // Keep the density constant whatever the size of the batch
+  float worldSize = 20.0f * std::sqrt(static_cast<float>(count));
+  return chfb::makeRandomConvexHulls(count, 8, worldSize, 6.0f, 42);
+}
+}  // namespace
+
+// Filter a batch with a HullFilter that lives across calls
+static void BM_HullFilterInProcess(benchmark::State& state) {
+  auto convexHulls = makeBatch(state.range(0));
+  chf::HullFilter hullFilter;
+  for (auto _ : state) {
+    auto keptIndices = hullFilter.filter(convexHulls);
+    benchmark::DoNotOptimize(keptIndices);
+  }
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_HullFilterInProcess)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000)
+    ->Unit(benchmark::kMillisecond);
+
+// Same batch exchanged through JSON files with a freshly spawned CLI
+static void BM_HullFilterSpawnCli(benchmark::State& state) {
+  auto convexHulls = makeBatch(state.range(0));
+  auto tmpDir = std::filesystem::temp_directory_path();
+  std::string inputFile = (tmpDir / "chf_bench_input.json").string();
+  std::string outputFile = (tmpDir / "chf_bench_output.json").string();
+  std::string command = std::string(CONVEX_HULL_FILTERING_CLI) +
+                        " --output " + outputFile + " " + inputFile +
+                        " > /dev/null";
+  for (auto _ : state) {
+    chf::saveJson(inputFile, convexHulls);
+    if (std::system(command.c_str()) != 0) {
+      state.SkipWithError("convex_hull_filtering failed");
+      break;
+    }
+    auto results = chf::loadJson(outputFile);
+    benchmark::DoNotOptimize(results);
+  }
+  std::filesystem::remove(inputFile);
+  std::filesystem::remove(outputFile);
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_HullFilterSpawnCli)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,82 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/IncrementalFilter.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+constexpr std::size_t NB_CONVEX_HULLS = 20000;
+
+// Two frames differing by the motion of changeRate per mille of the convex
+// hulls, alternating between them moves that many convex hulls every frame
+std::vector<std::vector<chf::ConvexHull>> makeFrames(int changeRate) {
+  std::vector<std::vector<chf::ConvexHull>> frames(2);
+  frames[0] = chfb::makeRandomConvexHulls(
+      NB_CONVEX_HULLS, 8, 20.0f * std::sqrt(float(NB_CONVEX_HULLS)), 6.0f, 42);
+  frames[1] = frames[0];
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> motion(-1.0f, 1.0f);
+  for (std::size_t i = 0; i < NB_CONVEX_HULLS; i++) {
+    if (static_cast<int>(gen() % 1000) >= changeRate) {
+      continue;
+    }
+    float dx = motion(gen);
+    float dy = motion(gen);
+    for (auto& point : frames[1][i].points) {
+      point = chf::Point(point.x + dx, point.y + dy);
+    }
+  }
+  return frames;
+}
+}  // namespace
+
+// Latency of a frame with the tree and the overlaps kept from the previous one
+static void BM_IncrementalFilter(benchmark::State& state) {
+  auto frames = makeFrames(state.range(0));
+  chf::IncrementalFilter incrementalFilter;
+  incrementalFilter.update(frames[1]);
+  std::size_t frameIdx = 0;
+  for (auto _ : state) {
+    auto keptIndices = incrementalFilter.update(frames[frameIdx]);
+    benchmark::DoNotOptimize(keptIndices);
+    frameIdx = 1 - frameIdx;
+  }
+  state.counters["computed_pairs"] = incrementalFilter.getNbComputedPairs();
+  state.counters["cached_pairs"] = incrementalFilter.getNbCachedPairs();
+}
+BENCHMARK(BM_IncrementalFilter)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(100)
+    ->Arg(1000)
+    ->ArgName("change_per_mille")
+    ->Unit(benchmark::kMillisecond);
+
+// Same frames filtered from scratch
+static void BM_FullRecompute(benchmark::State& state) {
+  auto frames = makeFrames(state.range(0));
+  chf::HullFilter hullFilter;
+  std::size_t frameIdx = 0;
+  for (auto _ : state) {
+    auto keptIndices = hullFilter.filter(frames[frameIdx]);
+    benchmark::DoNotOptimize(keptIndices);
+    frameIdx = 1 - frameIdx;
+  }
+}
+BENCHMARK(BM_FullRecompute)
+    ->Arg(10)
+    ->ArgName("change_per_mille")
+    ->Unit(benchmark::kMillisecond);
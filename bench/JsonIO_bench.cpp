@@ -0,0 +1,169 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/JsonIO.hpp"
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+const std::string& getJsonFile() {
+  static std::string filePath = []() {
+    auto path = std::filesystem::temp_directory_path() / "chf_bench_load.json";
+    chf::saveJson(path.string(),
+                  chfb::makeRandomConvexHulls(100000, 8, 5000.0f, 6.0f, 42));
+    return path.string();
+  }();
+  return filePath;
+}
+
+const std::vector<chf::ConvexHull>& getSaveConvexHulls() {
+  static std::vector<chf::ConvexHull> convexHulls =
+      chfb::makeRandomConvexHulls(100000, 8, 5000.0f, 6.0f, 7);
+  return convexHulls;
+}
+
+std::string getSaveFile() {
+  return (std::filesystem::temp_directory_path() / "chf_bench_save.json")
+      .string();
+}
+
+long readProcStatusKb(const std::string& field) {
+  std::ifstream ifs("/proc/self/status");
+  std::string line;
+  while (std::getline(ifs, line)) {
+    if (line.rfind(field + ":", 0) == 0) {
+      return std::stol(line.substr(field.size() + 1));
+    }
+  }
+  return 0;
+}
+
+// Growth of the resident memory in MB while the loader runs, the peak is
+// reset through /proc/self/clear_refs (Linux only)
+template <typename Loader>
+double measurePeakRss(const Loader& loader) {
+  malloc_trim(0);
+  std::ofstream("/proc/self/clear_refs") << "5";
+  long before = readProcStatusKb("VmRSS");
+  benchmark::DoNotOptimize(loader());
+  return (readProcStatusKb("VmHWM") - before) / 1024.0;
+}
+}  // namespace
+
+static void BM_LoadJsonDom(benchmark::State& state) {
+  const auto& filePath = getJsonFile();
+  auto load = [&filePath]() {
+    std::ifstream ifs(filePath);
+    return chf::loadJsonDom(&ifs);
+  };
+  for (auto _ : state) {
+    auto convexHulls = load();
+    benchmark::DoNotOptimize(convexHulls);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(filePath));
+  state.counters["peak_rss_MB"] = measurePeakRss(load);
+}
+BENCHMARK(BM_LoadJsonDom)->Unit(benchmark::kMillisecond);
+
+static void BM_LoadJsonSax(benchmark::State& state) {
+  const auto& filePath = getJsonFile();
+  auto load = [&filePath]() { return chf::loadJson(filePath); };
+  for (auto _ : state) {
+    auto convexHulls = load();
+    benchmark::DoNotOptimize(convexHulls);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(filePath));
+  state.counters["peak_rss_MB"] = measurePeakRss(load);
+}
+BENCHMARK(BM_LoadJsonSax)->Unit(benchmark::kMillisecond);
+
+// Streaming without keeping the convex hulls, memory stays bounded
+static void BM_LoadJsonSaxStreaming(benchmark::State& state) {
+  const auto& filePath = getJsonFile();
+  auto load = [&filePath]() {
+    std::size_t nbPoints = 0;
+    std::ifstream ifs(filePath);
+    chf::loadJson(&ifs, [&nbPoints](chf::ConvexHull&& convexHull) {
+      nbPoints += convexHull.points.size();
+    });
+    return nbPoints;
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(load());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(filePath));
+  state.counters["peak_rss_MB"] = measurePeakRss(load);
+}
+BENCHMARK(BM_LoadJsonSaxStreaming)->Unit(benchmark::kMillisecond);
+
+// Arg is the number of threads parsing the convex hull objects
+static void BM_LoadJsonParallel(benchmark::State& state) {
+  const auto& filePath = getJsonFile();
+  chf::ThreadPool threadPool(state.range(0));
+  auto load = [&filePath, &threadPool]() {
+    return chf::loadJsonParallel(filePath, &threadPool);
+  };
+  for (auto _ : state) {
+    auto convexHulls = load();
+    benchmark::DoNotOptimize(convexHulls);
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(filePath));
+  state.counters["peak_rss_MB"] = measurePeakRss(load);
+}
+BENCHMARK(BM_LoadJsonParallel)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(32)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+static void BM_SaveJsonDom(benchmark::State& state) {
+  const auto& convexHulls = getSaveConvexHulls();
+  auto save = [&convexHulls]() {
+    std::ofstream ofs(getSaveFile());
+    chf::saveJsonDom(&ofs, convexHulls);
+    return ofs.tellp();
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(save());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(getSaveFile()));
+  state.counters["peak_rss_MB"] = measurePeakRss(save);
+}
+BENCHMARK(BM_SaveJsonDom)->Unit(benchmark::kMillisecond);
+
+// Arg is 1 for the pretty output and 0 for the compact one
+static void BM_SaveJsonStreaming(benchmark::State& state) {
+  const auto& convexHulls = getSaveConvexHulls();
+  bool pretty = state.range(0) != 0;
+  auto save = [&convexHulls, pretty]() {
+    std::ofstream ofs(getSaveFile());
+    chf::saveJson(&ofs, convexHulls, pretty);
+    return ofs.tellp();
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(save());
+  }
+  state.SetBytesProcessed(state.iterations() *
+                          std::filesystem::file_size(getSaveFile()));
+  state.counters["peak_rss_MB"] = measurePeakRss(save);
+}
+BENCHMARK(BM_SaveJsonStreaming)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond);
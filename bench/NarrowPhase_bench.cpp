@@ -0,0 +1,51 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/NarrowPhase.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <utility>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+struct DenseScene {
+  DenseScene()
+      : convexHulls(chfb::makeRandomConvexHulls(20000, 8, 1000.0f, 6.0f, 42)),
+        pairs(chfb::findCandidatePairs(convexHulls, 4, 8)) {}
+
+  std::vector<chf::ConvexHull> convexHulls;
+  std::vector<std::pair<int, int>> pairs;
+};
+
+const DenseScene& getDenseScene() {
+  static DenseScene scene;
+  return scene;
+}
+}  // namespace
+
+// Throughput of the narrow phase in pairs per second for 1 to 64 threads
+static void BM_NarrowPhaseScaling(benchmark::State& state) {
+  const auto& scene = getDenseScene();
+  chf::ThreadPool threadPool(state.range(0));
+  chf::NarrowPhase narrowPhase(scene.convexHulls, &threadPool);
+  for (auto _ : state) {
+    auto convexHullsToRemove =
+        narrowPhase.findConvexHullsToRemove(scene.pairs, 50.0f);
+    benchmark::DoNotOptimize(convexHullsToRemove);
+  }
+  state.SetItemsProcessed(state.iterations() * scene.pairs.size());
+  state.counters["pairs"] = scene.pairs.size();
+}
+BENCHMARK(BM_NarrowPhaseScaling)
+    ->RangeMultiplier(2)
+    ->Range(1, 64)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
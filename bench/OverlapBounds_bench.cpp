@@ -0,0 +1,61 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapBounds.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+static void BM_OverlapBoundsBuild(benchmark::State& state) {
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(2000, state.range(0), 400.0f, 6.0f, 42);
+  for (auto _ : state) {
+    chf::OverlapBounds overlapBounds(convexHulls);
+    benchmark::DoNotOptimize(overlapBounds.size());
+  }
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_OverlapBoundsBuild)
+    ->Arg(64)
+    ->Arg(256)
+    ->Unit(benchmark::kMillisecond);
+
+// Decisions at 50% on one thread for convex hulls of range(0) vertices,
+// exactly (0) or from the bounds when they are clear enough (1). The
+// bounded counter is the fraction of the pairs settled without clipping.
+static void BM_NarrowPhaseApproximate(benchmark::State& state) {
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(2000, state.range(0), 400.0f, 6.0f, 42);
+  auto pairs = chfb::findCandidatePairs(convexHulls, 4, 8);
+  chf::ThreadPool threadPool(1);
+  chf::OverlapBounds overlapBounds(convexHulls);
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+  if (state.range(1) != 0) {
+    narrowPhase.setOverlapBounds(&overlapBounds, 50.0f);
+  }
+  for (auto _ : state) {
+    auto convexHullsToRemove =
+        narrowPhase.findConvexHullsToRemove(pairs, 50.0f);
+    benchmark::DoNotOptimize(convexHullsToRemove);
+  }
+  std::size_t nbBounded = 0;
+  narrowPhase.computeOverlaps(pairs, [&](const chf::PairOverlap& overlap) {
+    nbBounded += !overlap.exact;
+  });
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+  state.counters["pairs"] = pairs.size();
+  state.counters["bounded"] = static_cast<double>(nbBounded) / pairs.size();
+}
+BENCHMARK(BM_NarrowPhaseApproximate)
+    ->ArgsProduct({{32, 64, 256}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,58 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapCache.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+// Whole filter on one thread for convex hulls of range(0) vertices without
+// cache (0), with an empty cache (1) and with the cache of a previous run
+// (2). Each iteration opens the cache like a new process would.
+static void BM_HullFilterOverlapCache(benchmark::State& state) {
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(2000, state.range(0), 400.0f, 6.0f, 42);
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_bench");
+  chf::HullFilterConfig config;
+  config.nbThreads = 1;
+  if (state.range(1) != 0) {
+    config.overlapCacheFile = tmpDir.getFilePath("cache.chc");
+  }
+  if (state.range(1) == 2) {
+    chf::HullFilter(config).filter(convexHulls);
+  }
+  std::uint64_t nbHits = 0;
+  std::uint64_t nbLookups = 0;
+  for (auto _ : state) {
+    if (state.range(1) == 1) {
+      state.PauseTiming();
+      std::filesystem::remove(config.overlapCacheFile);
+      state.ResumeTiming();
+    }
+    chf::Instrumentation instrumentation;
+    chf::HullFilter hullFilter(config);
+    hullFilter.setInstrumentation(&instrumentation);
+    auto kept = hullFilter.filter(convexHulls);
+    benchmark::DoNotOptimize(kept);
+    nbHits += instrumentation.get(chf::Counter::CACHE_HITS);
+    nbLookups += instrumentation.get(chf::Counter::CACHE_HITS) +
+                 instrumentation.get(chf::Counter::CACHE_MISSES);
+  }
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+  state.counters["hit_rate"] =
+      nbLookups == 0 ? 0.0 : static_cast<double>(nbHits) / nbLookups;
+}
+BENCHMARK(BM_HullFilterOverlapCache)
+    ->ArgsProduct({{8, 64, 256}, {0, 1, 2}})
+    ->Unit(benchmark::kMillisecond);
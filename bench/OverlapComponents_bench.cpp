@@ -0,0 +1,100 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapComponents.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+// Same scene as BM_NarrowPhase, the radius sets the size of the components
+std::vector<chf::ConvexHull> makeScene(float radius) {
+  return chfb::makeRandomConvexHulls(20000, 8, 1000.0f, radius, 42);
+}
+}  // namespace
+
+// Union-find over the candidate pairs, the radius is in tenths
+static void BM_OverlapComponents(benchmark::State& state) {
+  auto convexHulls = makeScene(state.range(0) / 10.0f);
+  auto pairs = chfb::findCandidatePairs(convexHulls, 4, 8);
+  for (auto _ : state) {
+    chf::OverlapComponents components(convexHulls.size(), pairs);
+    benchmark::DoNotOptimize(components.size());
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+  chf::OverlapComponents components(convexHulls.size(), pairs);
+  const auto& stats = components.getStats();
+  state.counters["pairs"] = pairs.size();
+  state.counters["components"] = stats.nbComponents;
+  state.counters["isolated"] = stats.nbIsolated;
+  state.counters["maxPairs"] = stats.maxPairs;
+  state.counters["meanPairs"] = stats.meanPairs;
+}
+BENCHMARK(BM_OverlapComponents)
+    ->Arg(40)
+    ->Arg(60)
+    ->Arg(80)
+    ->Unit(benchmark::kMillisecond);
+
+// Overlaps of every pair computed one component per task, the efficiency is
+// how much of the time of the threads went into the tasks
+static void BM_ForEachComponent(benchmark::State& state) {
+  auto convexHulls = makeScene(6.0f);
+  auto pairs = chfb::findCandidatePairs(convexHulls, 4, 8);
+  chf::ThreadPool threadPool(state.range(0));
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+  chf::OverlapComponents components(convexHulls.size(), pairs);
+  std::vector<std::vector<chf::Point>> interPoints(threadPool.getNbThreads());
+  for (auto _ : state) {
+    components.forEachComponent(
+        &threadPool, [&](std::size_t component, unsigned int threadIdx) {
+          const std::size_t* pairIndices = components.getPairs(component);
+          for (std::size_t i = 0; i < components.getNbPairs(component); i++) {
+            const auto& pair = pairs[pairIndices[i]];
+            auto overlap = narrowPhase.computeOverlap(
+                pair.first, pair.second, &interPoints[threadIdx]);
+            benchmark::DoNotOptimize(overlap);
+          }
+        });
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+  state.counters["efficiency"] = components.getStats().schedulingEfficiency;
+}
+BENCHMARK(BM_ForEachComponent)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+// Whole greedy filter, components included, per number of threads
+static void BM_HullFilterGreedy(benchmark::State& state) {
+  auto convexHulls = makeScene(6.0f);
+  chf::HullFilterConfig config;
+  config.mode = chf::FilterMode::GREEDY;
+  config.nbThreads = state.range(0);
+  chf::HullFilter hullFilter(config);
+  for (auto _ : state) {
+    auto keptIndices = hullFilter.filter(convexHulls);
+    benchmark::DoNotOptimize(keptIndices);
+  }
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_HullFilterGreedy)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
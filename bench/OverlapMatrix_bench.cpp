@@ -0,0 +1,76 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapMatrix.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+// The thresholds of a typical sweep, from 10% to 90% by steps of 10%
+constexpr int NB_SWEEP_THRESHOLDS = 9;
+
+chf::HullFilterConfig makeSweepConfig(int step) {
+  chf::HullFilterConfig config;
+  config.nbThreads = 1;
+  config.threshold = 10.0f * (step + 1);
+  return config;
+}
+}  // namespace
+
+// Sweep of the pairwise filter over convex hulls of range(0) vertices,
+// rerunning the whole filter for every threshold
+static void BM_ThresholdSweepHullFilter(benchmark::State& state) {
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(5000, state.range(0), 400.0f, 6.0f, 42);
+  for (auto _ : state) {
+    for (int step = 0; step < NB_SWEEP_THRESHOLDS; step++) {
+      chf::HullFilter hullFilter(makeSweepConfig(step));
+      auto kept = hullFilter.filter(convexHulls);
+      benchmark::DoNotOptimize(kept);
+    }
+  }
+}
+BENCHMARK(BM_ThresholdSweepHullFilter)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+
+// Same sweep computing the overlap matrix once then querying it
+static void BM_ThresholdSweepOverlapMatrix(benchmark::State& state) {
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(5000, state.range(0), 400.0f, 6.0f, 42);
+  for (auto _ : state) {
+    auto matrix = chf::computeOverlapMatrix(convexHulls, makeSweepConfig(0));
+    for (int step = 0; step < NB_SWEEP_THRESHOLDS; step++) {
+      auto kept = matrix.filter(makeSweepConfig(step));
+      benchmark::DoNotOptimize(kept);
+    }
+  }
+}
+BENCHMARK(BM_ThresholdSweepOverlapMatrix)
+    ->Arg(8)
+    ->Arg(64)
+    ->Unit(benchmark::kMillisecond);
+
+// A single query of a matrix already computed
+static void BM_OverlapMatrixFilter(benchmark::State& state) {
+  auto convexHulls = chfb::makeRandomConvexHulls(5000, 8, 400.0f, 6.0f, 42);
+  auto matrix = chf::computeOverlapMatrix(convexHulls, makeSweepConfig(0));
+  chf::HullFilterConfig config = makeSweepConfig(4);
+  config.mode = state.range(0) != 0 ? chf::FilterMode::GREEDY
+                                    : chf::FilterMode::PAIRWISE;
+  for (auto _ : state) {
+    auto kept = matrix.filter(config);
+    benchmark::DoNotOptimize(kept);
+  }
+  state.SetItemsProcessed(state.iterations() * matrix.getNbEntries());
+}
+BENCHMARK(BM_OverlapMatrixFilter)->Arg(0)->Arg(1);
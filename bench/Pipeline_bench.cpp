@@ -0,0 +1,55 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+// Everything the executable does in process: load the file, build the tree,
+// find and filter the overlaps and write the kept convex hulls. Args are the
+// count, the radius (the density) and the format (0 JSON, 1 binary).
+static void BM_Pipeline(benchmark::State& state) {
+  std::size_t count = state.range(0);
+  float worldSize = 20.0f * std::sqrt(static_cast<float>(count));
+  auto convexHulls =
+      chfb::makeRandomConvexHulls(count, 8, worldSize, state.range(1), 42);
+  std::string extension = state.range(2) == 0 ? ".json" : ".chb";
+  auto tmpDir = std::filesystem::temp_directory_path();
+  std::string inputFile =
+      (tmpDir / ("chf_bench_pipeline" + extension)).string();
+  std::string outputFile =
+      (tmpDir / ("chf_bench_pipeline_result" + extension)).string();
+  chf::saveConvexHulls(inputFile, convexHulls);
+
+  std::size_t nbKept = 0;
+  for (auto _ : state) {
+    auto loaded = chf::loadConvexHulls(inputFile);
+    chf::HullFilter hullFilter;
+    auto keptIndices = hullFilter.filter(loaded);
+    std::vector<chf::ConvexHull> kept;
+    kept.reserve(keptIndices.size());
+    for (int index : keptIndices) {
+      kept.push_back(loaded[index]);
+    }
+    chf::saveConvexHulls(outputFile, kept);
+    nbKept = kept.size();
+  }
+  std::filesystem::remove(inputFile);
+  std::filesystem::remove(outputFile);
+  state.SetItemsProcessed(state.iterations() * count);
+  state.counters["kept"] = nbKept;
+}
+BENCHMARK(BM_Pipeline)
+    ->ArgsProduct({{1000, 20000}, {2, 6, 12}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
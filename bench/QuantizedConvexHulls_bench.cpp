@@ -0,0 +1,152 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+constexpr std::size_t NB_CONVEX_HULLS = 1024;
+constexpr float RESOLUTION = 1.0f / 1024;
+
+// Same overlapping convex hulls as the ConvexHull benchmarks
+std::vector<chf::ConvexHull> makeOverlappingConvexHulls(int nbVertices) {
+  return chfb::makeRandomConvexHulls(NB_CONVEX_HULLS, nbVertices, 10.0f,
+                                     10.0f, 42);
+}
+
+// Heap bytes of a vector of ConvexHull, counting 16 bytes of malloc
+// bookkeeping per vector of points
+std::size_t getMemoryUsage(const std::vector<chf::ConvexHull>& convexHulls) {
+  std::size_t bytes = convexHulls.capacity() * sizeof(chf::ConvexHull);
+  for (const auto& convexHull : convexHulls) {
+    bytes += convexHull.points.capacity() * sizeof(chf::Point) + 16;
+  }
+  return bytes;
+}
+
+// Convex hulls snapped on the grid then moved by a whole number of cells,
+// the geometry is exactly the same and only the position changes
+std::pair<std::vector<chf::ConvexHull>, std::vector<chf::ConvexHull>>
+makeMovedScenes(std::size_t count) {
+  auto convexHulls = chfb::makeRandomConvexHulls(count, 8, 1000.0f, 6.0f, 42);
+  for (auto& convexHull : convexHulls) {
+    for (auto& pt : convexHull.points) {
+      pt.x = std::round(pt.x / RESOLUTION) * RESOLUTION;
+      pt.y = std::round(pt.y / RESOLUTION) * RESOLUTION;
+    }
+  }
+  auto moved = convexHulls;
+  for (auto& convexHull : moved) {
+    for (auto& pt : convexHull.points) {
+      pt.x += 3072.0f;
+      pt.y += 3072.0f;
+    }
+  }
+  return std::make_pair(convexHulls, moved);
+}
+
+// Pairs whose overlap or removal at 50% changes once the scene is moved
+std::size_t countFlippedPairs(
+    const std::vector<chf::ConvexHull>& convexHulls,
+    const std::vector<chf::ConvexHull>& moved,
+    const std::vector<std::pair<int, int>>& pairs, bool quantize) {
+  chf::ThreadPool threadPool(1);
+  std::vector<chf::PairOverlap> overlaps;
+  std::vector<chf::PairOverlap> movedOverlaps;
+  for (auto [scene, sceneOverlaps] :
+       {std::make_pair(&convexHulls, &overlaps),
+        std::make_pair(&moved, &movedOverlaps)}) {
+    chf::QuantizedConvexHulls quantized(*scene, RESOLUTION);
+    chf::NarrowPhase narrowPhase(*scene, &threadPool,
+                                 quantize ? &quantized : nullptr);
+    narrowPhase.computeOverlaps(pairs, [&](const chf::PairOverlap& overlap) {
+      sceneOverlaps->push_back(overlap);
+    });
+  }
+  std::size_t nbFlipped = 0;
+  for (std::size_t i = 0; i < pairs.size(); i++) {
+    const auto& a = overlaps[i];
+    const auto& b = movedOverlaps[i];
+    nbFlipped += a.inter != b.inter ||
+                 (a.ratioFirst > 50.0f) != (b.ratioFirst > 50.0f) ||
+                 (a.ratioSecond > 50.0f) != (b.ratioSecond > 50.0f);
+  }
+  return nbFlipped;
+}
+}  // namespace
+
+// Exact predicates intersection per vertex count, to compare with
+// BM_ConvexHullIntersectionArea on the same pairs
+static void BM_QuantizedIntersectionArea(benchmark::State& state) {
+  auto convexHulls = makeOverlappingConvexHulls(state.range(0));
+  chf::QuantizedConvexHulls quantized(convexHulls, RESOLUTION);
+  std::size_t i = 0;
+  for (auto _ : state) {
+    double interArea;
+    bool intersect =
+        quantized.intersectionArea(i, (i + 1) % NB_CONVEX_HULLS, &interArea);
+    benchmark::DoNotOptimize(intersect);
+    benchmark::DoNotOptimize(interArea);
+    i = (i + 1) % NB_CONVEX_HULLS;
+  }
+  state.SetItemsProcessed(state.iterations());
+  state.counters["floatBytesPerHull"] =
+      static_cast<double>(getMemoryUsage(convexHulls)) / NB_CONVEX_HULLS;
+  state.counters["quantizedBytesPerHull"] =
+      static_cast<double>(quantized.getMemoryUsage()) / NB_CONVEX_HULLS;
+}
+BENCHMARK(BM_QuantizedIntersectionArea)->RangeMultiplier(2)->Range(4, 64);
+
+static void BM_QuantizeConvexHulls(benchmark::State& state) {
+  auto convexHulls = chfb::makeRandomConvexHulls(state.range(0), 8, 1000.0f,
+                                                 6.0f, 42);
+  for (auto _ : state) {
+    chf::QuantizedConvexHulls quantized(convexHulls, RESOLUTION);
+    benchmark::DoNotOptimize(quantized.size());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_QuantizeConvexHulls)
+    ->Arg(20000)
+    ->Unit(benchmark::kMillisecond);
+
+// Narrow phase on one thread with floats (0) or exact predicates (1). The
+// flippedPairs counter is the number of decisions that change when the
+// whole scene is moved by 3072 without changing its geometry.
+static void BM_NarrowPhaseQuantized(benchmark::State& state) {
+  bool quantize = state.range(0) != 0;
+  auto [convexHulls, moved] = makeMovedScenes(20000);
+  auto pairs = chfb::findCandidatePairs(convexHulls, 4, 8);
+  chf::ThreadPool threadPool(1);
+  chf::QuantizedConvexHulls quantized(convexHulls, RESOLUTION);
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool,
+                               quantize ? &quantized : nullptr);
+  for (auto _ : state) {
+    auto convexHullsToRemove =
+        narrowPhase.findConvexHullsToRemove(pairs, 50.0f);
+    benchmark::DoNotOptimize(convexHullsToRemove);
+  }
+  state.SetItemsProcessed(state.iterations() * pairs.size());
+  state.counters["pairs"] = pairs.size();
+  state.counters["flippedPairs"] =
+      countFlippedPairs(convexHulls, moved, pairs, quantize);
+}
+BENCHMARK(BM_NarrowPhaseQuantized)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
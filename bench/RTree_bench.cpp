@@ -0,0 +1,271 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/RTree.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/RTreeNode.hpp"
+#include "convex_hull_filtering/Spliter.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+// The world grows with the count so that the radius alone sets the density
+std::vector<chf::BoundingBox> makeBoundingBoxes(std::size_t count,
+                                                float radius) {
+  float worldSize = 20.0f * std::sqrt(static_cast<float>(count));
+  std::vector<chf::BoundingBox> boundingBoxes;
+  boundingBoxes.reserve(count);
+  for (const auto& convexHull :
+       chfb::makeRandomConvexHulls(count, 8, worldSize, radius, 42)) {
+    boundingBoxes.push_back(chf::BoundingBox(convexHull.points));
+  }
+  return boundingBoxes;
+}
+
+// The spliter of an RTree points into the tree so it can't be moved
+std::unique_ptr<chf::RTree> buildRTree(
+    const std::vector<chf::BoundingBox>& boundingBoxes, unsigned int m,
+    unsigned int M) {
+  auto rtree = std::make_unique<chf::RTree>(m, M);
+  for (std::size_t i = 0; i < boundingBoxes.size(); i++) {
+    rtree->insertEntry(i, boundingBoxes[i]);
+  }
+  return rtree;
+}
+
+// Forward to the heap and count the calls
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t nbAllocations = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    nbAllocations++;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+// Sum of the areas of the leaves over the area of the root, how many leaves
+// a point query meets on average. Lower is a better tree.
+double getLeafCoverage(const chf::RTree& rtree) {
+  double leafArea = 0.0;
+  std::vector<const chf::RTreeNode*> stack = {rtree.treeRoot.get()};
+  while (!stack.empty()) {
+    const chf::RTreeNode* node = stack.back();
+    stack.pop_back();
+    if (node->isLeaf) {
+      leafArea += node->bb.getArea();
+      continue;
+    }
+    for (const auto& child : node->children) {
+      stack.push_back(child.get());
+    }
+  }
+  return leafArea / rtree.treeRoot->bb.getArea();
+}
+
+void addMinMaxArgs(benchmark::internal::Benchmark* bench, int count) {
+  for (int M : {4, 8, 16, 32}) {
+    bench->Args({count, M / 2, M});
+  }
+}
+}  // namespace
+
+// Build a tree one entry at a time, args are count, m and M. leaf_coverage
+// measures the subtrees picked by chooseLeaf, see getLeafCoverage.
+static void BM_RTreeInsertEntry(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes(state.range(0), 6.0f);
+  std::unique_ptr<chf::RTree> rtree;
+  for (auto _ : state) {
+    rtree = buildRTree(boundingBoxes, state.range(1), state.range(2));
+    benchmark::DoNotOptimize(rtree->treeRoot);
+  }
+  state.SetItemsProcessed(state.iterations() * boundingBoxes.size());
+  state.counters["leaf_coverage"] = getLeafCoverage(*rtree);
+}
+BENCHMARK(BM_RTreeInsertEntry)
+    ->Apply([](benchmark::internal::Benchmark* bench) {
+      addMinMaxArgs(bench, 1000);
+      addMinMaxArgs(bench, 20000);
+    })
+    ->Unit(benchmark::kMillisecond);
+
+// Build and destroy a tree with its nodes on the heap (0) or in a monotonic
+// arena (1) like the trees owning their arena, args are count and resource
+static void BM_RTreeBuildMemoryResource(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes(state.range(0), 6.0f);
+  CountingResource heap;
+  for (auto _ : state) {
+    if (state.range(1) == 0) {
+      chf::RTree rtree(4, 8, &heap);
+      for (std::size_t i = 0; i < boundingBoxes.size(); i++) {
+        rtree.insertEntry(i, boundingBoxes[i]);
+      }
+      benchmark::DoNotOptimize(rtree.treeRoot);
+    } else {
+      std::pmr::monotonic_buffer_resource arena(&heap);
+      chf::RTree rtree(4, 8, &arena);
+      for (std::size_t i = 0; i < boundingBoxes.size(); i++) {
+        rtree.insertEntry(i, boundingBoxes[i]);
+      }
+      benchmark::DoNotOptimize(rtree.treeRoot);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * boundingBoxes.size());
+  state.counters["allocations"] = benchmark::Counter(
+      heap.nbAllocations, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_RTreeBuildMemoryResource)
+    ->ArgsProduct({{1000, 20000, 200000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// Quadratic split of an overflowing node of M + 1 entries, args are m and M
+static void BM_SpliterSplitNode(benchmark::State& state) {
+  constexpr std::size_t NB_NODES = 256;
+  unsigned int m = state.range(0);
+  unsigned int M = state.range(1);
+  auto boundingBoxes = makeBoundingBoxes(NB_NODES * (M + 1), 6.0f);
+  chf::RTreeNodePtrList nodesToAdd;
+  int nodeIdx = -1;
+  chf::Spliter spliter(&nodesToAdd, &nodeIdx);
+  std::vector<chf::RTreeNode> sourceNodes(NB_NODES);
+  chf::RTreeNodePtrList splitNodes;
+  for (auto _ : state) {
+    // Fill the nodes outside of the timing, a split empties them
+    state.PauseTiming();
+    splitNodes.clear();
+    for (std::size_t i = 0; i < NB_NODES; i++) {
+      auto& sourceNode = sourceNodes[i];
+      sourceNode.children.clear();
+      for (unsigned int j = 0; j <= M; j++) {
+        auto iter = chf::makeNewRTreeNode(&sourceNode.children,
+                                          boundingBoxes[i * (M + 1) + j]);
+        (*iter)->value = j;
+        (*iter)->parent = &sourceNode;
+      }
+    }
+    state.ResumeTiming();
+    for (auto& sourceNode : sourceNodes) {
+      spliter.splitNode(m, &sourceNode);
+      chf::moveAllRTreeNode(&nodesToAdd, &splitNodes);
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * NB_NODES);
+}
+BENCHMARK(BM_SpliterSplitNode)
+    ->Apply([](benchmark::internal::Benchmark* bench) {
+      for (int M : {4, 8, 16, 32, 64}) {
+        bench->Args({M / 2, M});
+      }
+    })
+    ->Unit(benchmark::kMicrosecond);
+
+// Broad phase on a built tree, args are count and radius (the density)
+static void BM_RTreeFindPairwiseIntersections(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes(state.range(0), state.range(1));
+  auto rtree = buildRTree(boundingBoxes, 4, 8);
+  std::size_t nbPairs = 0;
+  for (auto _ : state) {
+    auto pairs = rtree->findPairwiseIntersections();
+    nbPairs = pairs.size();
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.SetItemsProcessed(state.iterations() * boundingBoxes.size());
+  state.counters["pairs"] = nbPairs;
+}
+BENCHMARK(BM_RTreeFindPairwiseIntersections)
+    ->ArgsProduct({{1000, 20000}, {2, 6, 12}})
+    ->Unit(benchmark::kMillisecond);
+
+// Same broad phase per node size, args are count, m and M
+static void BM_RTreeFindPairwiseIntersectionsMinMax(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes(state.range(0), 6.0f);
+  auto rtree = buildRTree(boundingBoxes, state.range(1), state.range(2));
+  for (auto _ : state) {
+    auto pairs = rtree->findPairwiseIntersections();
+    benchmark::DoNotOptimize(pairs);
+  }
+  state.SetItemsProcessed(state.iterations() * boundingBoxes.size());
+}
+BENCHMARK(BM_RTreeFindPairwiseIntersectionsMinMax)
+    ->Apply([](benchmark::internal::Benchmark* bench) {
+      addMinMaxArgs(bench, 20000);
+    })
+    ->Unit(benchmark::kMillisecond);
+
+// Insert a batch into a tree of 20000 entries one entry at a time (0) or
+// with insertBatch (1), args are batch size and method. broad_phase_ms is
+// the self join of the resulting tree, to compare its quality.
+static void BM_RTreeInsertBatch(benchmark::State& state) {
+  constexpr std::size_t NB_EXISTING = 20000;
+  std::size_t batchSize = state.range(0);
+  auto boundingBoxes = makeBoundingBoxes(NB_EXISTING + batchSize, 6.0f);
+  std::vector<chf::BoundingBox> existing(boundingBoxes.begin(),
+                                         boundingBoxes.begin() + NB_EXISTING);
+  std::vector<std::pair<int, chf::BoundingBox>> batch;
+  for (std::size_t i = NB_EXISTING; i < boundingBoxes.size(); i++) {
+    batch.push_back(std::make_pair(i, boundingBoxes[i]));
+  }
+  std::unique_ptr<chf::RTree> rtree;
+  for (auto _ : state) {
+    state.PauseTiming();
+    rtree = buildRTree(existing, 4, 8);
+    state.ResumeTiming();
+    if (state.range(1) == 0) {
+      for (const auto& [value, bb] : batch) {
+        rtree->insertEntry(value, bb);
+      }
+    } else {
+      rtree->insertBatch(batch);
+    }
+    benchmark::DoNotOptimize(rtree->treeRoot);
+  }
+  state.SetItemsProcessed(state.iterations() * batchSize);
+  auto start = std::chrono::steady_clock::now();
+  auto pairs = rtree->findPairwiseIntersections();
+  benchmark::DoNotOptimize(pairs);
+  state.counters["broad_phase_ms"] =
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - start)
+          .count();
+}
+BENCHMARK(BM_RTreeInsertBatch)
+    ->ArgsProduct({{100, 1000, 10000, 50000}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_RTreeSearch(benchmark::State& state) {
+  auto boundingBoxes = makeBoundingBoxes(state.range(0), 6.0f);
+  auto rtree = buildRTree(boundingBoxes, 4, 8);
+  std::vector<int> values;
+  std::size_t i = 0;
+  for (auto _ : state) {
+    values.clear();
+    rtree->search(boundingBoxes[i], &values);
+    benchmark::DoNotOptimize(values.data());
+    i = (i + 1) % boundingBoxes.size();
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_RTreeSearch)->Arg(1000)->Arg(20000);
@@ -0,0 +1,75 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/ShardedFilter.hpp"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "BenchData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chfb = convex_hull_filtering_bench;
+
+namespace {
+constexpr std::size_t NB_CONVEX_HULLS = 30000;
+
+const std::vector<chf::ConvexHull>& getBatch() {
+  static const auto convexHulls = chfb::makeRandomConvexHulls(
+      NB_CONVEX_HULLS, 8, 20.0f * std::sqrt(float(NB_CONVEX_HULLS)), 6.0f, 42);
+  return convexHulls;
+}
+
+// Seconds taken by a single process with one narrow phase thread, the
+// reference of the speedup
+double getSingleProcessSeconds() {
+  static const double seconds = []() {
+    chf::HullFilterConfig config;
+    config.nbThreads = 1;
+    chf::HullFilter hullFilter(config);
+    auto start = std::chrono::steady_clock::now();
+    hullFilter.filter(getBatch());
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    return elapsed.count();
+  }();
+  return seconds;
+}
+}  // namespace
+
+// One worker process per shard, each with a single narrow phase thread
+static void BM_ShardedFilter(benchmark::State& state) {
+  const auto& convexHulls = getBatch();
+  double singleProcessSeconds = getSingleProcessSeconds();
+  chf::ShardedFilterConfig config;
+  config.nbWorkers = state.range(0);
+  config.filter.nbThreads = config.nbWorkers;
+  config.workerExecutable = CONVEX_HULL_FILTERING_CLI;
+  chf::ShardedFilter shardedFilter(config);
+  double seconds = 0.0;
+  for (auto _ : state) {
+    auto start = std::chrono::steady_clock::now();
+    auto keptIndices = shardedFilter.filter(convexHulls);
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    seconds += elapsed.count();
+    benchmark::DoNotOptimize(keptIndices);
+  }
+  state.counters["speedup"] =
+      singleProcessSeconds * state.iterations() / seconds;
+  state.counters["cross_pairs"] = shardedFilter.getNbCrossPairs();
+  state.counters["reconcile_ms"] = shardedFilter.getReconcileSeconds() * 1e3;
+  state.SetItemsProcessed(state.iterations() * convexHulls.size());
+}
+BENCHMARK(BM_ShardedFilter)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,19 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include <benchmark/benchmark.h>
+
+// Same as BENCHMARK_MAIN but the revision and the build type are recorded
+// in the context of the JSON output so that results can be compared over time
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::AddCustomContext("git_revision",
+                              CONVEX_HULL_FILTERING_GIT_REVISION);
+  benchmark::AddCustomContext("build_type", CONVEX_HULL_FILTERING_BUILD_TYPE);
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
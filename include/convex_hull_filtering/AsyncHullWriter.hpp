@@ -0,0 +1,46 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_ASYNCHULLWRITER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_ASYNCHULLWRITER_HPP_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering {
+
+// Write the convex hulls from a dedicated thread so that the output overlaps
+// with the filtering. The pushed convex hulls must stay alive until finish
+// returns.
+class AsyncHullWriter {
+ public:
+  using WriteFunction = std::function<void(const ConvexHull&)>;
+
+  explicit AsyncHullWriter(const WriteFunction& write);
+  ~AsyncHullWriter();
+  void push(const ConvexHull* convexHull);
+  // Wait for every pushed convex hull to be written and rethrow the first
+  // exception of the write function, called by the destructor if not called
+  // before
+  void finish();
+
+ private:
+  void run();
+
+  WriteFunction write;
+  std::mutex mutex;
+  std::condition_variable cv;
+  std::deque<const ConvexHull*> queue;
+  bool done;
+  std::exception_ptr error;
+  std::thread thread;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_ASYNCHULLWRITER_HPP_
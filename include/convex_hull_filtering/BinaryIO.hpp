@@ -0,0 +1,132 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_BINARYIO_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_BINARYIO_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+// Binary container for convex hulls (.chb), all fields are little endian,
+// only little endian hosts are supported.
+//
+// Header (32 bytes)
+//   char[4]   magic          "CHFB"
+//   uint32    version        1
+//   uint32    precision      Bytes per coordinate, 4 (float) or 8 (double)
+//   uint32    reserved
+//   uint64    nbConvexHulls
+//   uint64    nbPoints
+// Table (nbConvexHulls entries of 24 bytes)
+//   int32     id
+//   float32   score
+//   uint64    offset         Index of the first point in the vertex array
+//   uint32    count          Number of points of the convex hull
+//   uint32    reserved
+// Vertex array (nbPoints interleaved x, y pairs in the given precision)
+//   Starts right after the table, at 32 + 24 * nbConvexHulls
+constexpr char BINARY_MAGIC[4] = {'C', 'H', 'F', 'B'};
+constexpr std::uint32_t BINARY_VERSION = 1;
+
+class BinaryHeader {
+ public:
+  char magic[4];
+  std::uint32_t version;
+  std::uint32_t precision;
+  std::uint32_t reserved;
+  std::uint64_t nbConvexHulls;
+  std::uint64_t nbPoints;
+};
+
+class BinaryTableEntry {
+ public:
+  std::int32_t id;
+  float score;
+  std::uint64_t offset;
+  std::uint32_t count;
+  std::uint32_t reserved;
+};
+
+// Write a binary file hull by hull, the number of convex hulls has to be known
+// up front so that the table and the vertex array can both be streamed
+class BinaryHullWriter {
+ public:
+  BinaryHullWriter(const std::string& filePath, std::uint64_t nbConvexHulls,
+                   std::uint32_t precision = sizeof(float));
+  ~BinaryHullWriter();
+  void write(const ConvexHull& convexHull);
+  // Write the header, called by the destructor if not called before
+  void close();
+
+ private:
+  std::ofstream tableStream;
+  std::ofstream vertexStream;
+  std::string filePath;
+  std::uint64_t nbConvexHulls;
+  std::uint64_t nbWritten;
+  std::uint64_t nbPoints;
+  std::uint32_t precision;
+  bool closed;
+};
+
+// Read only view of a convex hull stored in a mapped file
+class HullView {
+ public:
+  HullView(const BinaryTableEntry* entry, const unsigned char* vertices,
+           std::uint32_t precision);
+  int getId() const;
+  float getScore() const;
+  std::size_t size() const;
+  Point getPoint(std::size_t index) const;
+  // Points stored in place, only available for float precision files
+  const Point* data() const;
+  ConvexHull toConvexHull() const;
+
+ private:
+  const BinaryTableEntry* entry;
+  const unsigned char* vertices;
+  std::uint32_t precision;
+};
+
+// Memory map a binary file and expose its convex hulls without copying them
+class MappedHullFile {
+ public:
+  explicit MappedHullFile(const std::string& filePath);
+  ~MappedHullFile();
+  MappedHullFile(const MappedHullFile&) = delete;
+  MappedHullFile& operator=(const MappedHullFile&) = delete;
+
+  std::size_t size() const;
+  std::uint32_t getPrecision() const;
+  HullView operator[](std::size_t index) const;
+
+ private:
+  const unsigned char* mapping;
+  std::size_t mappingSize;
+  const BinaryHeader* header;
+  const BinaryTableEntry* table;
+  const unsigned char* vertices;
+};
+
+bool isBinaryFile(const std::string& filePath);
+std::vector<ConvexHull> loadBinary(const std::string& filePath);
+void saveBinary(const std::string& filePath,
+                const std::vector<ConvexHull>& convexHulls,
+                std::uint32_t precision = sizeof(float));
+// Same container in memory, the float precision is used. decodeBinary reuses
+// the convex hulls already in the vector to avoid reallocating their points.
+void encodeBinary(const std::vector<ConvexHull>& convexHulls,
+                  std::vector<unsigned char>* buffer);
+void decodeBinary(const unsigned char* data, std::size_t size,
+                  std::vector<ConvexHull>* convexHulls);
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_BINARYIO_HPP_
@@ -0,0 +1,66 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_BOUNDINGVOLUMES_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_BOUNDINGVOLUMES_HPP_
+
+#include <cstddef>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering {
+
+enum class LeafVolume {
+  BOX,           // Axis aligned bounding box only
+  KDOP8,         // Box and slabs along both diagonals, an 8-DOP
+  ORIENTED_BOX,  // Box and rectangle of minimum area
+};
+
+// Extents along x + y and x - y, rounded outwards to floats. With the axis
+// aligned box of the tree this is an 8-DOP.
+class DiagonalSlabs {
+ public:
+  float minSum;
+  float maxSum;
+  float minDiff;
+  float maxDiff;
+};
+
+// Rectangle of axis (ux, uy) and (-uy, ux) with the given half extents
+class OrientedBox {
+ public:
+  double cx;
+  double cy;
+  double ux;
+  double uy;
+  double halfU;
+  double halfV;
+};
+
+// Rectangle of minimum area containing the points of a convex hull, found
+// with rotating calipers since one of its sides lies on an edge of the hull
+OrientedBox makeOrientedBox(const std::vector<Point>& points);
+
+// Tighter volumes than the bounding boxes, tested by the broad phase once the
+// bounding boxes of two convex hulls intersect
+class BoundingVolumes {
+ public:
+  BoundingVolumes(const std::vector<ConvexHull>& convexHulls,
+                  LeafVolume leafVolume);
+
+  std::size_t size() const;
+  LeafVolume getLeafVolume() const;
+  // False only when the convex hulls are certainly disjoint, the bounding
+  // boxes are not tested again
+  bool intersect(std::size_t first, std::size_t second) const;
+
+ private:
+  LeafVolume leafVolume;
+  std::size_t nbConvexHulls;
+  std::vector<DiagonalSlabs> diagonalSlabs;
+  std::vector<OrientedBox> orientedBoxes;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_BOUNDINGVOLUMES_HPP_
@@ -4,7 +4,6 @@
 #ifndef INCLUDE_CONVEX_HULL_FILTERING_CONVEXHULL_HPP_
 #define INCLUDE_CONVEX_HULL_FILTERING_CONVEXHULL_HPP_
 
-#include <tuple>
 #include <utility>
 #include <vector>
 
@@ -19,18 +18,34 @@ constexpr char Q_POLY = 'Q';
 
 class ConvexHull {
  public:
-  explicit ConvexHull(const std::vector<Point>& points, int id = 0);
+  explicit ConvexHull(const std::vector<Point>& points, int id = 0,
+                      float score = 0.0f);
   Point getCircPoint(int index) const;
   float getArea() const;
   bool isPointInside(const Point& pt) const;
   std::pair<bool, ConvexHull> intersection(const ConvexHull& Q) const;
+  // Same as above but the vertices of the intersection are written to the
+  // caller provided buffer, reusing its capacity so that no heap allocation
+  // happens once the buffer has grown to the size of the largest pair
+  bool intersection(const ConvexHull& Q, std::vector<Point>* interPoints) const;
+  // Area of the intersection only. Pairs of small convex hulls go to the
+  // FixedConvexHull kernel of the smallest size class that fits them, the
+  // others to the intersection above using interPoints as scratch buffer
+  bool intersectionArea(const ConvexHull& Q, float* interArea,
+                        std::vector<Point>* interPoints) const;
+  static float computeArea(const std::vector<Point>& points);
 
   int id;
+  float score;  // Optional confidence used to rank hulls, 0 when not given
   std::vector<Point> points;
 
  private:
-  std::tuple<char, bool, Point> advance(const Edge& pDot, const Edge& qDot,
-                                        char inside) const;
+  // Same as the buffer version, whole is set to P_POLY or Q_POLY when the
+  // intersection is all of this convex hull or all of Q, NOT_INIT otherwise
+  bool intersection(const ConvexHull& Q, std::vector<Point>* interPoints,
+                    char* whole) const;
+  char advance(const Edge& pDot, const Edge& qDot, char inside,
+               std::vector<Point>* interPoints) const;
 };
 }  // namespace convex_hull_filtering
 
@@ -17,6 +17,7 @@ class Edge {
   float crossProdZ(const Edge edgeB) const;
   float getAngle(const Point& pt) const;
   std::pair<bool, Point> checkIntersection(const Edge& qDot) const;
+  bool checkIntersection(const Edge& qDot, Point* interPt) const;
   bool belongToHalfPlane(const Point& pt) const;
 
   Point em;
@@ -0,0 +1,148 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_FILTERSERVER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_FILTERSERVER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace convex_hull_filtering {
+
+// Messages exchanged over the Unix socket, all fields are little endian,
+// only little endian hosts are supported.
+// A connection can carry any number of requests, each one gets a response.
+//
+// Header (16 bytes)
+//   char[4]   magic          "CHFQ" for a request, "CHFA" for a response
+//   uint32    type           RequestType or ResponseStatus
+//   uint64    size           Bytes of the payload following the header
+// Request payload
+//   BINARY    a .chb container of the batch (see BinaryIO.hpp)
+//   JSON      a {"convex hulls": [...]} document of the batch
+//   SHUTDOWN  empty, the server answers then stops
+// Response payload
+//   OK        int32 ID of every kept convex hull in the batch order
+//   ERROR     the error message
+constexpr char REQUEST_MAGIC[4] = {'C', 'H', 'F', 'Q'};
+constexpr char RESPONSE_MAGIC[4] = {'C', 'H', 'F', 'A'};
+constexpr std::uint64_t MAX_PAYLOAD_SIZE = std::uint64_t(1) << 32;
+
+enum class RequestType : std::uint32_t {
+  BINARY = 0,
+  JSON = 1,
+  SHUTDOWN = 2,
+};
+
+enum class ResponseStatus : std::uint32_t {
+  OK = 0,
+  ERROR = 1,
+};
+
+class MessageHeader {
+ public:
+  char magic[4];
+  std::uint32_t type;
+  std::uint64_t size;
+};
+
+class FilterServerConfig {
+ public:
+  HullFilterConfig filter;  // A reference needs FilterMode::PAIRWISE
+  // Only a socket nothing listens on anymore is replaced, the server fails
+  // to start when any other file is there
+  std::string socketPath;
+  // Convex hulls loaded once and kept in an RTree, a convex hull of a batch
+  // is also removed when one of them overlaps it like a convex hull that
+  // comes after it in the batch would. Empty for none.
+  std::string referenceFile;
+};
+
+// Filter the batches sent over a Unix socket, the thread pool of the filter,
+// the request buffers and the reference tree are kept between requests
+class FilterServer {
+ public:
+  explicit FilterServer(const FilterServerConfig& config);
+  ~FilterServer();
+  FilterServer(const FilterServer&) = delete;
+  FilterServer& operator=(const FilterServer&) = delete;
+
+  // Serve the connected clients until a SHUTDOWN request. The bytes of a
+  // request are read as they come so that a client sending slowly or not at
+  // all doesn't hold the others, the request is filtered once whole. A
+  // client that doesn't read its response is dropped after a timeout.
+  void run();
+  // Return the IDs of the convex hulls of the batch to keep, the result is
+  // the one of HullFilter::filter on the batch followed by the reference
+  std::vector<int> filterBatch(const std::vector<ConvexHull>& convexHulls);
+
+  std::size_t getNbReferenceConvexHulls() const;
+  std::uint64_t getNbRequests() const;
+
+ private:
+  // Request being received on a client connection, the payload buffer is
+  // kept between the requests of the connection to reuse its capacity
+  class Connection {
+   public:
+    int fd;
+    MessageHeader header;
+    std::size_t nbHeaderBytes;
+    std::size_t nbPayloadBytes;
+    std::vector<unsigned char> payload;
+  };
+
+  // Read what the client already sent and serve its request once whole.
+  // Return false once the client is gone, sent an invalid request or asked
+  // for a shutdown.
+  bool serveClient(Connection* connection, bool* shutdown);
+  bool serveRequest(const Connection& connection, bool* shutdown);
+  void removeOverlappedByReference(const std::vector<ConvexHull>& convexHulls,
+                                   std::vector<bool>* convexHullsToRemove);
+
+  FilterServerConfig config;
+  HullFilter hullFilter;
+  int listenFd;
+  std::uint64_t nbRequests;
+  // Kept between requests so that their capacity is reused
+  std::vector<ConvexHull> batch;
+  std::vector<int> keptIds;
+  std::vector<int> found;
+  std::vector<Point> interPoints;
+  // Reference convex hulls, their areas and their tree
+  std::vector<ConvexHull> reference;
+  std::vector<float> referenceAreas;
+  std::unique_ptr<RTree> referenceTree;
+};
+
+// Connection to a FilterServer
+class FilterClient {
+ public:
+  explicit FilterClient(const std::string& socketPath);
+  ~FilterClient();
+  FilterClient(const FilterClient&) = delete;
+  FilterClient& operator=(const FilterClient&) = delete;
+
+  // Return the IDs of the convex hulls to keep
+  std::vector<int> filter(const std::vector<ConvexHull>& convexHulls,
+                          RequestType type = RequestType::BINARY);
+  // Send an already encoded batch, throw with the message of the server when
+  // it answers with an error
+  std::vector<int> send(RequestType type, const void* data, std::size_t size);
+  // Stop the server once it has answered
+  void shutdown();
+
+ private:
+  int fd;
+  std::vector<unsigned char> buffer;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_FILTERSERVER_HPP_
@@ -0,0 +1,32 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_FIXEDCONVEXHULL_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_FIXEDCONVEXHULL_HPP_
+
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+// Area and intersection kernels for convex hulls of at most MAX_VERTICES
+// vertices. Everything lives in fixed size arrays on the stack and the loops
+// are bounded at compile time so that the compiler can unroll them.
+// Instantiated for 4, 8 and 16 vertices, ConvexHull::intersectionArea picks
+// the smallest one that fits.
+template <int MAX_VERTICES>
+class FixedConvexHull {
+ public:
+  // Clipping a convex hull by a half plane adds at most one vertex, so the
+  // intersection of two convex hulls has at most the sum of their vertices
+  static constexpr int MAX_INTER_VERTICES = 2 * MAX_VERTICES;
+
+  static float computeArea(const Point* points, int nbPoints);
+  // Sutherland-Hodgman clipping of P by every edge of Q. Return false when
+  // the kernel can't handle the pair (too many vertices, less than 3 or a
+  // flat Q) and the generic intersection has to be used instead
+  static bool intersectionArea(const Point* P, int nbPointsP, const Point* Q,
+                               int nbPointsQ, bool* inter, float* interArea);
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_FIXEDCONVEXHULL_HPP_
@@ -0,0 +1,127 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_HULLFILTER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_HULLFILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingVolumes.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/OverlapBounds.hpp"
+#include "convex_hull_filtering/OverlapCache.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+enum class RemovalRule {
+  // Remove every convex hull overlapped by more than the threshold
+  EACH_OVERLAPPED,
+  // Only the smaller convex hull of an overlapping pair can be removed
+  SMALLER_OF_PAIR,
+};
+
+enum class FilterMode {
+  // Every candidate pair is checked and the removal rule applied to it
+  PAIRWISE,
+  // Non maximum suppression: hulls are visited by decreasing score and a
+  // hull is only suppressed by an already kept hull with a higher score
+  GREEDY,
+};
+
+enum class ScoreSource {
+  AREA,   // Larger hulls win
+  FIELD,  // Use ConvexHull::score
+};
+
+class HullFilterConfig {
+ public:
+  HullFilterConfig();
+
+  float threshold;  // Percentage of its own area above which a hull is removed
+  RemovalRule removalRule;  // Only used by FilterMode::PAIRWISE
+  FilterMode mode;
+  ScoreSource scoreSource;  // Only used by FilterMode::GREEDY
+  unsigned int m;          // Min number of children of the RTree nodes
+  unsigned int M;          // Max number of children of the RTree nodes
+  unsigned int nbThreads;  // Threads used by the narrow phase
+  // Side of the cells of the int32 grid the coordinates are snapped to for
+  // the narrow phase, which then uses exact predicates. 0 keeps the floats.
+  float resolution;
+  // Settle the pairs of convex hulls with many vertices from cheap bounds of
+  // their overlap when those are far enough from the threshold, the exact
+  // intersection is only computed for the others. Same decisions, but the
+  // overlaps seen by the observer are only bounds for the settled pairs.
+  // Ignored when resolution is set and by IncrementalFilter.
+  bool approximate;
+  // Memory mapped file keeping the overlaps of the pairs across runs, empty
+  // for no cache. It is locked while a filter uses it, a filter of another
+  // process then runs without it. Ignored when resolution is set and by
+  // IncrementalFilter.
+  std::string overlapCacheFile;
+  std::size_t overlapCacheEntries;  // Pairs kept before evicting
+  // Volume tested after the bounding boxes before a pair becomes a candidate
+  LeafVolume leafVolume;
+};
+
+// Receive the intermediate results of HullFilter::filter, mostly useful to
+// debug or to report on what the filter did
+class HullFilterObserver {
+ public:
+  virtual ~HullFilterObserver() = default;
+  virtual void onTreeBuilt(const RTree& rtree);
+  virtual void onCandidatePairs(const std::vector<std::pair<int, int>>& pairs);
+  virtual void onOverlap(const PairOverlap& overlap, bool removeFirst,
+                         bool removeSecond);
+  // Called once per kept convex hull in increasing index order as soon as it
+  // is known to be kept, while the rest of the pairs are still being checked
+  // in the pairwise mode
+  virtual void onConvexHullKept(int index);
+};
+
+class HullFilter {
+ public:
+  explicit HullFilter(const HullFilterConfig& config = HullFilterConfig());
+  // Return the indices of the convex hulls to keep in increasing order
+  std::vector<int> filter(const std::vector<ConvexHull>& convexHulls,
+                          HullFilterObserver* observer = nullptr);
+  // Whether the first and the second convex hull of the pair should go
+  std::pair<bool, bool> applyRemovalRule(const PairOverlap& overlap) const;
+  const HullFilterConfig& getConfig() const;
+  // Time the stages of filter and count its pairs and removals, null to stop
+  void setInstrumentation(Instrumentation* instrumentation);
+
+ private:
+  std::vector<int> filterPairwise(const std::vector<ConvexHull>& convexHulls,
+                                  const RTree& rtree,
+                                  HullFilterObserver* observer,
+                                  const QuantizedConvexHulls* quantized,
+                                  const OverlapBounds* overlapBounds);
+  std::vector<int> filterGreedy(const std::vector<ConvexHull>& convexHulls,
+                                const RTree& rtree,
+                                HullFilterObserver* observer,
+                                const QuantizedConvexHulls* quantized,
+                                const OverlapBounds* overlapBounds);
+  // Pairs of entries of rtree whose bounding boxes and leaf volumes intersect
+  std::vector<std::pair<int, int>> findCandidatePairs(
+      const std::vector<ConvexHull>& convexHulls, const RTree& rtree);
+  void count(Counter counter, std::uint64_t value);
+  void setGauge(Gauge gauge, double value);
+
+  HullFilterConfig config;
+  ThreadPool threadPool;
+  Instrumentation* instrumentation;
+  std::unique_ptr<OverlapCache> overlapCache;  // Opened by the first filter
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_HULLFILTER_HPP_
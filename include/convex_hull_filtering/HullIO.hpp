@@ -0,0 +1,27 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_HULLIO_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_HULLIO_HPP_
+
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace convex_hull_filtering {
+// Load a JSON or a binary file, the format is detected from the content.
+// JSON files are parsed with nbThreads threads.
+std::vector<ConvexHull> loadConvexHulls(const std::string& filePath,
+                                        unsigned int nbThreads = 1);
+// Hand the convex hulls of a JSON or a binary file to the sink one by one
+// without keeping them in memory
+void streamConvexHulls(const std::string& filePath, const ConvexHullSink& sink);
+// Files ending with .chb are written in the binary format, others in JSON
+void saveConvexHulls(const std::string& filePath,
+                     const std::vector<ConvexHull>& convexHulls);
+bool hasBinaryExtension(const std::string& filePath);
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_HULLIO_HPP_
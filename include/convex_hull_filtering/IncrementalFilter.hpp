@@ -0,0 +1,96 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_INCREMENTALFILTER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_INCREMENTALFILTER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <unordered_map>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+// Hash of the points of a convex hull, used to find the ones that moved
+std::uint64_t hashGeometry(const ConvexHull& convexHull);
+
+// Filter a sequence of frames in which most convex hulls persist. Convex hulls
+// are matched between frames by ID, the RTree only gets the moved, added and
+// removed ones and only the pairs involving them are intersected again, the
+// overlaps of the other candidate pairs are taken from the previous frames.
+// The result of a frame is the same as HullFilter::filter on it. approximate
+// and overlapCacheFile of the config are ignored: every computed overlap is
+// exact since it is kept for the next frames, which already play the role of
+// the overlap cache.
+class IncrementalFilter {
+ public:
+  // Only FilterMode::PAIRWISE is supported
+  explicit IncrementalFilter(const HullFilterConfig& config = HullFilterConfig());
+  // Return the indices of the convex hulls of frame to keep in increasing
+  // order, the IDs have to be unique within a frame
+  std::vector<int> update(const std::vector<ConvexHull>& frame);
+  // Forget every convex hull and reset the statistics, the next frame is
+  // filtered from scratch
+  void clear();
+
+  // Statistics of the last call to update
+  std::size_t getNbChangedConvexHulls() const;  // Moved or added
+  std::size_t getNbRemovedConvexHulls() const;
+  std::size_t getNbComputedPairs() const;
+  std::size_t getNbCachedPairs() const;
+
+ private:
+  // A convex hull of the previous frame, its slot is its value in the RTree
+  class Slot {
+   public:
+    int id;
+    std::uint64_t hash;
+    std::vector<Point> points;
+    BoundingBox bb;
+    std::vector<int> neighbors;  // Slots whose bounding boxes intersect
+    bool used;
+  };
+
+  // Overlap of a candidate pair of slots a < b, computed with the convex
+  // hull coming first in the frame as the first operand
+  class CachedOverlap {
+   public:
+    bool computed;
+    bool aFirst;  // Whether slot a came first in the frame
+    bool inter;
+    float ratioA;  // Percentage of the area of slot a covered by slot b
+    float ratioB;
+  };
+
+  static std::uint64_t getPairKey(int a, int b);
+  int allocateSlot();
+  void releaseSlot(int slot);
+  void detachNeighbors(int slot);
+
+  HullFilter hullFilter;  // Applies the removal rule
+  ThreadPool threadPool;
+  // The tree lives across frames and loses nodes at every one, a pool
+  // reuses their memory where the default arena would keep growing
+  std::pmr::unsynchronized_pool_resource nodePool;
+  std::unique_ptr<RTree> rtree;
+  std::vector<Slot> slots;
+  std::vector<int> freeSlots;
+  std::unordered_map<int, int> idToSlot;
+  std::unordered_map<std::uint64_t, CachedOverlap> overlaps;
+
+  std::size_t nbChangedConvexHulls;
+  std::size_t nbRemovedConvexHulls;
+  std::size_t nbComputedPairs;
+  std::size_t nbCachedPairs;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_INCREMENTALFILTER_HPP_
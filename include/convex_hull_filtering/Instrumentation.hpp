@@ -0,0 +1,112 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_INSTRUMENTATION_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_INSTRUMENTATION_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+namespace convex_hull_filtering {
+
+enum class Stage {
+  LOAD,
+  TREE_BUILD,
+  BROAD_PHASE,
+  NARROW_PHASE,
+  FILTER,  // Whole HullFilter::filter call, includes the three above
+  WRITE,
+  COUNT,
+};
+
+enum class Counter {
+  CONVEX_HULLS,
+  CANDIDATE_PAIRS,  // Pairs handed to the narrow phase
+  INTERSECTIONS,    // Pairs whose convex hulls really intersect
+  REMOVALS,
+  // Connected components of the candidate pairs, candidate pairs in the
+  // largest of them and convex hulls without any candidate pair, only
+  // counted by the greedy mode
+  COMPONENTS,
+  LARGEST_COMPONENT,
+  ISOLATED_CONVEX_HULLS,
+  BOUNDED_PAIRS,  // Candidate pairs settled without exact intersection
+  CACHE_HITS,     // Candidate pairs found in the overlap cache
+  CACHE_MISSES,
+  // Pairs whose bounding boxes intersect but not their leaf volumes, left
+  // out of the candidate pairs
+  REJECTED_PAIRS,
+  ALLOCATIONS,  // Only counted when an allocation counter is set
+  COUNT,
+};
+
+// Values that aren't counts, each one is the value of the last call that set
+// it and 0 until then
+enum class Gauge {
+  // Candidate pairs per connected component, only set by the greedy mode
+  MEAN_COMPONENT_PAIRS,
+  // Time spent in the components over the time the threads were available,
+  // see ComponentStats, only set by the greedy mode
+  SCHEDULING_EFFICIENCY,
+  COUNT,
+};
+
+// Return the number of allocations made so far by the process
+using AllocationCounter = std::function<std::uint64_t()>;
+
+// Time spent and allocations made in each stage of the pipeline plus a few
+// counters. Only the thread running a stage may update it, different stages
+// can be updated from different threads.
+class Instrumentation {
+ public:
+  Instrumentation();
+
+  void addTime(Stage stage, double seconds);
+  void addAllocations(Stage stage, std::uint64_t nbAllocations);
+  void add(Counter counter, std::uint64_t value);
+  void set(Gauge gauge, double value);
+  double getSeconds(Stage stage) const;
+  std::uint64_t getAllocations(Stage stage) const;
+  std::uint64_t get(Counter counter) const;
+  double get(Gauge gauge) const;
+
+  void setAllocationCounter(const AllocationCounter& allocationCounter);
+  std::uint64_t countAllocations() const;
+
+  // {"stages": {"load": {"seconds": ..., "allocations": ...}, ...},
+  //  "counters": {"convex_hulls": ..., ...},
+  //  "gauges": {"mean_component_pairs": ..., ...}}
+  void writeReport(std::ostream* os) const;
+
+  static const char* getName(Stage stage);
+  static const char* getName(Counter counter);
+  static const char* getName(Gauge gauge);
+
+ private:
+  double seconds[static_cast<int>(Stage::COUNT)];
+  std::uint64_t allocations[static_cast<int>(Stage::COUNT)];
+  std::uint64_t counters[static_cast<int>(Counter::COUNT)];
+  double gauges[static_cast<int>(Gauge::COUNT)];
+  AllocationCounter allocationCounter;
+};
+
+// Add the time and the allocations of its scope to a stage, does nothing
+// when instrumentation is null
+class ScopedTimer {
+ public:
+  ScopedTimer(Instrumentation* instrumentation, Stage stage);
+  ~ScopedTimer();
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Instrumentation* instrumentation;
+  Stage stage;
+  std::chrono::steady_clock::time_point start;
+  std::uint64_t startAllocations;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_INSTRUMENTATION_HPP_
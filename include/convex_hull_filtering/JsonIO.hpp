@@ -0,0 +1,75 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_JSONIO_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_JSONIO_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+using ConvexHullSink = std::function<void(ConvexHull&&)>;
+
+// Read and write the {"convex hulls": [{"ID": ..., "apexes": [...]}]} format.
+// A file path of "-" reads from the standard input.
+std::vector<ConvexHull> loadJson(const std::string& filePath);
+std::vector<ConvexHull> loadJson(std::istream* is);
+// Hand the convex hulls to the sink one by one as they are parsed, only the
+// convex hull being parsed is held in memory so this works on any input size
+void loadJson(std::istream* is, const ConvexHullSink& sink);
+void loadJson(const char* data, std::size_t size, const ConvexHullSink& sink);
+// Map the file, find where each convex hull object of the "convex hulls"
+// array starts and ends, then parse these byte ranges on the thread pool.
+// The convex hulls are returned in the order of the file.
+std::vector<ConvexHull> loadJsonParallel(const std::string& filePath,
+                                         ThreadPool* threadPool);
+// Parse the whole document before building the convex hulls, slower and
+// uses several times the size of the input in memory
+std::vector<ConvexHull> loadJsonDom(std::istream* is);
+void saveJson(const std::string& filePath,
+              const std::vector<ConvexHull>& convexHulls, bool pretty = true);
+void saveJson(std::ostream* os, const std::vector<ConvexHull>& convexHulls,
+              bool pretty = true);
+// Build the whole document before writing it, kept as a reference for the
+// streaming writer
+void saveJsonDom(std::ostream* os, const std::vector<ConvexHull>& convexHulls);
+
+// Write the convex hulls one by one without building the document. The
+// pretty output is the same as the one of nlohmann::json with an indent of 4,
+// the compact one has no whitespace at all.
+class JsonHullWriter {
+ public:
+  explicit JsonHullWriter(std::ostream* os, bool pretty = true);
+  ~JsonHullWriter();
+  void write(const ConvexHull& convexHull);
+  // Close the document and flush it, called by the destructor if not called
+  // before
+  void close();
+
+ private:
+  void newLine(int level);
+  void appendKey(const char* key);
+  void appendNumber(double value);
+  void flush();
+
+  std::ostream* os;
+  std::string buffer;
+  bool pretty;
+  bool empty;
+  bool closed;
+};
+
+// Shortest representation of value that reads back to the same double,
+// formatted like nlohmann::json does. Return the end of the written
+// characters, first needs room for 32 characters.
+char* formatJsonNumber(double value, char* first);
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_JSONIO_HPP_
@@ -0,0 +1,94 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_NARROWPHASE_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_NARROWPHASE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/OverlapBounds.hpp"
+#include "convex_hull_filtering/OverlapCache.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+class PairOverlap {
+ public:
+  PairOverlap();
+
+  int first;
+  int second;
+  bool inter;
+  float interArea;
+  float ratioFirst;   // Percentage of the area of first covered by second
+  float ratioSecond;  // Percentage of the area of second covered by first
+  // False when the pair was settled by OverlapBounds: interArea is then its
+  // lower bound and each ratio is the bound that put it on its side of the
+  // threshold
+  bool exact;
+};
+
+using PairOverlapSink = std::function<void(const PairOverlap&)>;
+// Return true when the pair doesn't need to be intersected anymore
+using PairPredicate = std::function<bool(int, int)>;
+
+class NarrowPhase {
+ public:
+  // When quantizedConvexHulls is given, the areas and the intersections are
+  // computed from it instead of from the float coordinates
+  NarrowPhase(const std::vector<ConvexHull>& convexHulls,
+              ThreadPool* threadPool,
+              const QuantizedConvexHulls* quantizedConvexHulls = nullptr);
+  // Compute the overlap of every pair in parallel, the sink is called from
+  // the calling thread in the order of the pairs whatever the number of
+  // threads so the results are deterministic.
+  // skipPair is evaluated on the calling thread before each block, so it
+  // can depend on what the sink saw in the previous blocks
+  void computeOverlaps(const std::vector<std::pair<int, int>>& pairs,
+                       const PairOverlapSink& sink,
+                       const PairPredicate& skipPair = nullptr);
+  // Flag every convex hull that has more than threshold percent of its area
+  // covered by another convex hull
+  std::vector<bool> findConvexHullsToRemove(
+      const std::vector<std::pair<int, int>>& pairs, float threshold);
+  PairOverlap computeOverlap(int first, int second,
+                             std::vector<Point>* interPoints) const;
+  // Skip the exact intersection of the pairs with more than
+  // NB_BOUND_DIRECTIONS vertices whose bounds are both clearly above or
+  // below threshold, every decision taken against threshold stays the same.
+  // Null to always intersect, ignored with quantized convex hulls.
+  void setOverlapBounds(const OverlapBounds* overlapBounds, float threshold);
+  // Look the pairs up in the cache before intersecting them and store the
+  // exact overlaps computed. Null to stop, ignored with quantized convex
+  // hulls. The cache is shared by the threads of computeOverlaps.
+  void setOverlapCache(OverlapCache* overlapCache);
+
+  std::size_t blockSize;  // Number of pairs computed before calling the sink
+  std::size_t chunkSize;  // Number of pairs handed to a thread at once
+
+ private:
+  const std::vector<ConvexHull>& convexHulls;
+  bool computeBoundedOverlap(int lowIdx, int highIdx,
+                             PairOverlap* overlap) const;
+
+  const QuantizedConvexHulls* quantizedConvexHulls;
+  const OverlapBounds* overlapBounds;
+  float boundsThreshold;
+  OverlapCache* overlapCache;
+  std::vector<std::uint64_t> hashes;  // Only set along with the cache
+  std::vector<float> areas;
+  ThreadPool* threadPool;
+  std::vector<std::vector<Point>> scratchBuffers;  // One per thread
+  std::vector<std::size_t> blockPairs;  // Index of the pairs to compute
+  std::vector<PairOverlap> block;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_NARROWPHASE_HPP_
@@ -0,0 +1,45 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_OVERLAPBOUNDS_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_OVERLAPBOUNDS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+// Directions of the bounding polygons, which have at most that many vertices
+constexpr int NB_BOUND_DIRECTIONS = 16;
+// Percentage points kept between a bound and the threshold before trusting
+// it, well above the rounding of the bounds and of the exact intersection
+constexpr float BOUND_MARGIN = 0.5f;
+
+// Two polygons of at most NB_BOUND_DIRECTIONS vertices per convex hull: the
+// inner one is made of the vertices that are the farthest in each
+// direction, the outer one is the intersection of the supporting half
+// planes in those directions. Convex hulls that are already small enough
+// are their own bounds. Intersecting the inner polygons then the outer ones
+// gives a lower and an upper bound of the intersection with the small fixed
+// size kernels, whatever the number of vertices of the convex hulls.
+class OverlapBounds {
+ public:
+  explicit OverlapBounds(const std::vector<ConvexHull>& convexHulls);
+  std::size_t size() const;
+  // False when the bounds can't be computed (degenerate convex hulls)
+  bool intersectionAreaBounds(std::size_t first, std::size_t second,
+                              float* lowerArea, float* upperArea) const;
+
+ private:
+  std::vector<Point> innerPoints;
+  std::vector<std::uint32_t> innerOffsets;  // size() + 1 offsets
+  std::vector<Point> outerPoints;
+  std::vector<std::uint32_t> outerOffsets;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_OVERLAPBOUNDS_HPP_
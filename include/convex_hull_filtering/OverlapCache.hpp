@@ -0,0 +1,128 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCACHE_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCACHE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering {
+
+// Overlap cache file (.chc), in the byte order of the machine since it is
+// only meant to be reused by the same machine.
+//
+// Header (32 bytes)
+//   char[4]   magic          "CHFC"
+//   uint32    version        2
+//   uint64    capacity       Number of slots, a power of two
+//   uint64    nbEntries
+//   uint32    run            Last run that used the cache
+//   uint32    kernelVersion  OVERLAP_CACHE_KERNEL_VERSION
+// Slots (capacity entries of 40 bytes), open addressing with linear probing
+//   uint64    firstHash      hashConvexHull of the first convex hull
+//   uint64    secondHash
+//   float32   interArea
+//   float32   firstArea
+//   float32   secondArea
+//   uint32    lastRun        Run that last read or wrote it, 0 when empty
+//   uint32    inter          1 when the convex hulls intersect
+//   uint32    reserved
+constexpr char OVERLAP_CACHE_MAGIC[4] = {'C', 'H', 'F', 'C'};
+constexpr std::uint32_t OVERLAP_CACHE_VERSION = 2;
+// Version of ConvexHull::intersection the overlaps were computed with, to
+// bump whenever a change of it can change an overlap so that the files
+// filled by the previous code are cleared instead of read
+constexpr std::uint32_t OVERLAP_CACHE_KERNEL_VERSION = 1;
+
+class OverlapCacheHeader {
+ public:
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t capacity;
+  std::uint64_t nbEntries;
+  std::uint32_t run;
+  std::uint32_t kernelVersion;
+};
+
+class OverlapCacheEntry {
+ public:
+  std::uint64_t firstHash;
+  std::uint64_t secondHash;
+  float interArea;
+  float firstArea;
+  float secondArea;
+  std::uint32_t lastRun;
+  std::uint32_t inter;
+  std::uint32_t reserved;
+};
+
+// Hash of the coordinates of the vertices, in their order
+std::uint64_t hashConvexHull(const ConvexHull& convexHull);
+
+// Intersection results of pairs of convex hulls kept in a memory mapped file
+// across processes. A pair is identified by the hashes of both convex hulls
+// in the order they were intersected, the areas stored with it have to match
+// as well so that a collision of the hashes can't return a wrong overlap.
+// Lookups can run concurrently with each other and with insertions. The
+// file is locked while it is open so that only one process at a time uses
+// it.
+class OverlapCache {
+ public:
+  // Open the cache or create it when it doesn't exist, is unreadable, was
+  // made for another maxEntries or by another kernel version. Once
+  // maxEntries pairs are stored, the least recently used quarter is evicted.
+  // Throw when another process holds the file.
+  OverlapCache(const std::string& filePath, std::size_t maxEntries);
+  // Same but return nullptr when another process holds the file
+  static std::unique_ptr<OverlapCache> tryOpen(const std::string& filePath,
+                                               std::size_t maxEntries);
+  ~OverlapCache();
+  OverlapCache(const OverlapCache&) = delete;
+  OverlapCache& operator=(const OverlapCache&) = delete;
+
+  // Start a new run, used to know which entries are the least recently used
+  void beginRun();
+  // Return false on a miss
+  bool find(std::uint64_t firstHash, std::uint64_t secondHash,
+            float firstArea, float secondArea, bool* inter,
+            float* interArea);
+  void insert(std::uint64_t firstHash, std::uint64_t secondHash,
+              float firstArea, float secondArea, bool inter,
+              float interArea);
+  std::size_t size() const;
+  std::size_t getMaxEntries() const;
+  // Lookups and evictions since the cache was opened
+  std::uint64_t getNbHits() const;
+  std::uint64_t getNbMisses() const;
+  std::uint64_t getNbEvicted() const;
+
+ private:
+  // Take over fd, which is already locked
+  OverlapCache(int fd, const std::string& filePath, std::size_t maxEntries);
+  void map(bool create);
+  OverlapCacheEntry* findSlot(std::uint64_t firstHash,
+                              std::uint64_t secondHash) const;
+  void evict();
+
+  int fd;
+  std::string filePath;
+  std::size_t maxEntries;
+  unsigned char* mapping;
+  std::size_t mappingSize;
+  OverlapCacheHeader* header;
+  OverlapCacheEntry* slots;
+  mutable std::shared_mutex mutex;
+  std::atomic<std::uint64_t> nbHits;
+  std::atomic<std::uint64_t> nbMisses;
+  std::uint64_t nbEvicted;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCACHE_HPP_
@@ -0,0 +1,66 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCOMPONENTS_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCOMPONENTS_HPP_
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+class ComponentStats {
+ public:
+  ComponentStats();
+
+  std::size_t nbComponents;
+  std::size_t nbIsolated;  // Convex hulls without any candidate pair
+  std::size_t maxConvexHulls;
+  std::size_t maxPairs;
+  double meanPairs;
+  // Time spent in the tasks over the time the threads were available during
+  // the last forEachComponent, 1 when no thread ever waited
+  double schedulingEfficiency;
+};
+
+// Called with the index of the component and of the thread running it
+using ComponentTask = std::function<void(std::size_t, unsigned int)>;
+
+// Connected components of the graph whose vertices are the convex hulls and
+// whose edges are the candidate pairs. Nothing that happens in a component
+// can change the outcome of another one, so each of them is an independent
+// unit of work.
+class OverlapComponents {
+ public:
+  // Convex hulls without any pair don't belong to any component. The
+  // components are numbered by their lowest convex hull.
+  OverlapComponents(std::size_t nbConvexHulls,
+                    const std::vector<std::pair<int, int>>& pairs);
+  std::size_t size() const;
+  // Convex hulls of a component in increasing order
+  const int* getConvexHulls(std::size_t component) const;
+  std::size_t getNbConvexHulls(std::size_t component) const;
+  // Index of the pairs of a component, in the order they were given
+  const std::size_t* getPairs(std::size_t component) const;
+  std::size_t getNbPairs(std::size_t component) const;
+  const ComponentStats& getStats() const;
+  // Run the task once per component on the thread pool. The components with
+  // the most pairs are handed out first so that a large one doesn't end up
+  // running alone at the end.
+  void forEachComponent(ThreadPool* threadPool, const ComponentTask& task);
+
+ private:
+  std::vector<int> convexHulls;
+  std::vector<std::size_t> convexHullOffsets;
+  std::vector<std::size_t> pairIndices;
+  std::vector<std::size_t> pairOffsets;
+  std::vector<std::size_t> schedule;  // By decreasing number of pairs
+  ComponentStats stats;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_OVERLAPCOMPONENTS_HPP_
@@ -0,0 +1,109 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_OVERLAPMATRIX_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_OVERLAPMATRIX_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+
+namespace convex_hull_filtering {
+
+// Overlap matrix file (.chm), all fields are little endian, only little
+// endian hosts are supported.
+//
+// Header (32 bytes)
+//   char[4]   magic          "CHFM"
+//   uint32    version        1
+//   uint64    nbConvexHulls
+//   uint64    nbEntries
+//   uint64    reserved
+// Convex hulls (nbConvexHulls entries of 16 bytes)
+//   int32     id
+//   float32   area           Score of the greedy mode by area
+//   float32   score
+//   uint32    reserved
+// Row offsets (nbConvexHulls + 1 uint64), CSR index of the first entry of
+// each row, the last one is nbEntries
+// Entries (nbEntries entries of 8 bytes), sorted by column within a row
+//   int32     column         Index of the overlapping convex hull
+//   float32   ratio          Percentage of the row convex hull it covers
+constexpr char OVERLAP_MATRIX_MAGIC[4] = {'C', 'H', 'F', 'M'};
+constexpr std::uint32_t OVERLAP_MATRIX_VERSION = 1;
+
+class OverlapMatrixHeader {
+ public:
+  char magic[4];
+  std::uint32_t version;
+  std::uint64_t nbConvexHulls;
+  std::uint64_t nbEntries;
+  std::uint64_t reserved;
+};
+
+class OverlapMatrixHull {
+ public:
+  std::int32_t id;
+  float area;
+  float score;
+  std::uint32_t reserved;
+};
+
+class OverlapMatrixEntry {
+ public:
+  std::int32_t column;
+  float ratio;
+};
+
+// Sparse matrix of the overlap ratios of every intersecting pair, row i
+// column j holds the percentage of convex hull i covered by convex hull j.
+// Every pairwise and greedy filter can be replayed from it for any threshold
+// without touching the geometry again.
+class OverlapMatrix {
+ public:
+  OverlapMatrix();
+  // Only the overlaps of intersecting pairs are kept
+  OverlapMatrix(const std::vector<ConvexHull>& convexHulls,
+                const std::vector<PairOverlap>& overlaps);
+
+  std::size_t size() const;
+  std::size_t getNbEntries() const;
+  const OverlapMatrixHull& getConvexHull(std::size_t row) const;
+  const OverlapMatrixEntry* getRow(std::size_t row) const;
+  std::size_t getRowSize(std::size_t row) const;
+  // 0 when the convex hulls don't intersect
+  float getRatio(std::size_t row, std::size_t column) const;
+
+  // Same indices as HullFilter::filter with the same mode, threshold,
+  // removal rule and score source, the other settings are not used
+  std::vector<int> filter(const HullFilterConfig& config) const;
+
+  void save(const std::string& filePath) const;
+  static OverlapMatrix load(const std::string& filePath);
+
+ private:
+  std::vector<int> filterPairwise(float threshold,
+                                  RemovalRule removalRule) const;
+  std::vector<int> filterGreedy(float threshold,
+                                ScoreSource scoreSource) const;
+
+  std::vector<OverlapMatrixHull> convexHulls;
+  std::vector<std::uint64_t> rowOffsets;
+  std::vector<OverlapMatrixEntry> entries;
+};
+
+// Run the broad and the narrow phases of config once on every candidate
+// pair. The threshold, the mode and approximate are ignored, the resolution
+// and the overlap cache are used.
+OverlapMatrix computeOverlapMatrix(const std::vector<ConvexHull>& convexHulls,
+                                   const HullFilterConfig& config,
+                                   Instrumentation* instrumentation = nullptr);
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_OVERLAPMATRIX_HPP_
@@ -0,0 +1,73 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_QUANTIZEDCONVEXHULLS_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_QUANTIZEDCONVEXHULLS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+// Quantized coordinates are kept below this bound so that every cross
+// product and every sum of two of them fits in 64 bits
+constexpr std::int32_t MAX_QUANTIZED_COORDINATE = 1 << 30;
+
+class QuantizedPoint {
+ public:
+  QuantizedPoint();
+  QuantizedPoint(std::int32_t x, std::int32_t y);
+
+  std::int32_t x;
+  std::int32_t y;
+};
+
+bool operator==(const QuantizedPoint& ptA, const QuantizedPoint& ptB);
+
+// Twice the signed area of the triangle abc, positive when it turns left.
+// Exact, unlike Edge::crossProdZ there is no EPSILON involved.
+std::int64_t orientation(const QuantizedPoint& a, const QuantizedPoint& b,
+                         const QuantizedPoint& c);
+
+// Convex hulls snapped onto a grid of cells of side resolution, stored in
+// one array of int32 coordinates instead of one vector per convex hull.
+// Every hull is made counterclockwise. All the decisions of the
+// intersection (which vertex is inside, which edges cross, which crossing
+// comes first) are taken with exact integer math, only the coordinates of
+// the crossings and the areas are floating point.
+class QuantizedConvexHulls {
+ public:
+  // Throw when the convex hulls span more than MAX_QUANTIZED_COORDINATE
+  // cells of the grid
+  QuantizedConvexHulls(const std::vector<ConvexHull>& convexHulls,
+                       float resolution);
+  std::size_t size() const;
+  int getNbPoints(std::size_t index) const;
+  const QuantizedPoint* getPoints(std::size_t index) const;
+  Point dequantize(const QuantizedPoint& pt) const;
+  double getArea(std::size_t index) const;
+  // Area of the intersection of two of the convex hulls, false when it is
+  // empty or flat
+  bool intersectionArea(std::size_t first, std::size_t second,
+                        double* interArea) const;
+  // Bytes used by the coordinates, offsets and areas
+  std::size_t getMemoryUsage() const;
+
+ private:
+  float resolution;
+  // The grid is anchored on (0, 0) so that a point always falls in the same
+  // cell whatever the other convex hulls are, the cells are stored relative
+  // to the lowest one
+  std::int64_t originX;
+  std::int64_t originY;
+  std::vector<QuantizedPoint> points;
+  std::vector<std::uint32_t> offsets;  // size() + 1 offsets into points
+  std::vector<std::int64_t> doubleAreas;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_QUANTIZEDCONVEXHULLS_HPP_
@@ -4,28 +4,73 @@
 #ifndef INCLUDE_CONVEX_HULL_FILTERING_RTREE_HPP_
 #define INCLUDE_CONVEX_HULL_FILTERING_RTREE_HPP_
 
+#include <cstddef>
 #include <functional>
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <utility>
 #include <vector>
 
+#include "convex_hull_filtering/BoundingVolumes.hpp"
 #include "convex_hull_filtering/RTreeNode.hpp"
 #include "convex_hull_filtering/Spliter.hpp"
 
 namespace convex_hull_filtering {
 
+// Nodes are allocated from a memory resource. By default the tree owns a
+// monotonic arena, suited to trees built once and queried: building makes a
+// few large allocations and destroying the tree releases them at once. Trees
+// whose entries are often removed should be given a pool or the heap instead
+// as the memory of removed nodes only comes back with the arena.
 class RTree {
  public:
-  RTree(unsigned int m, unsigned int M);
+  RTree(unsigned int m, unsigned int M,
+        std::pmr::memory_resource* resource = nullptr);
+  ~RTree();
+  RTree(const RTree&) = delete;
+  RTree& operator=(const RTree&) = delete;
   void insertEntry(int value, const BoundingBox& BoundingBox);
+  // Insert many (value, bounding box) entries at once. The batch is sorted
+  // along a Hilbert curve and split between the children of each node on
+  // the way down, so a path shared by several entries is descended once.
+  // Overflowing nodes are packed with Sort-Tile-Recursive and every node
+  // touched is adjusted once, an empty tree ends up bulk loaded.
+  void insertBatch(const std::vector<std::pair<int, BoundingBox> >& entries);
+  // Remove the entry inserted with value and boundingBox, return false when
+  // there is no such entry
+  bool removeEntry(int value, const BoundingBox& boundingBox);
   RTreeNode& chooseLeaf(const BoundingBox& boundingBox);
   void adjustTree(const RTreeNode& L);
   std::vector<std::pair<int, int> > findPairwiseIntersections();
+  // Same as above but the pairs are appended to the caller's vector
+  void findPairwiseIntersections(
+      std::vector<std::pair<int, int> >* pairwiseIntersections) const;
+  // Same as above but the pairs of entries whose bounding boxes intersect
+  // are also tested with their volumes, the values of the entries being
+  // indices in volumes. Return the number of pairs left out by the volumes.
+  std::size_t findPairwiseIntersections(
+      std::vector<std::pair<int, int> >* pairwiseIntersections,
+      const BoundingVolumes& volumes) const;
+  // Append the value of every entry whose bounding box intersects boundingBox
+  void search(const BoundingBox& boundingBox, std::vector<int>* values) const;
 
-  std::unique_ptr<RTreeNode> treeRoot;
+  std::pmr::memory_resource* getMemoryResource() const;
+
+  RTreeNodePtr treeRoot;
 
  private:
+  RTreeNode* findLeaf(RTreeNode* node, int value,
+                      const BoundingBox& boundingBox, bool prune);
+  void condenseTree(RTreeNode* leaf);
+  void insertBatch(RTreeNode* node,
+                   std::vector<std::pair<int, BoundingBox> >::iterator first,
+                   std::vector<std::pair<int, BoundingBox> >::iterator last,
+                   RTreeNodePtrList* siblings);
+  void packNode(RTreeNode* node, RTreeNodePtrList* siblings);
+
+  std::unique_ptr<std::pmr::monotonic_buffer_resource> arena;
+  std::pmr::memory_resource* resource;
   RTreeNodePtrList nodesToAdd;
   unsigned int m;  // Min number of children
   unsigned int M;  // Max number of children
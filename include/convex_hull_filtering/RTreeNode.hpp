@@ -6,6 +6,7 @@
 
 #include <list>
 #include <memory>
+#include <memory_resource>
 #include <utility>
 
 #include "convex_hull_filtering/BoundingBox.hpp"
@@ -14,17 +15,29 @@ namespace convex_hull_filtering {
 
 class RTreeNode;
 
-using RTreeNodePtr = std::unique_ptr<RTreeNode>;
-using RTreeNodePtrList = std::list<RTreeNodePtr>;
+// Destroy a node and give its memory back to the resource it came from
+class RTreeNodeDeleter {
+ public:
+  void operator()(RTreeNode* node) const;
+
+  std::pmr::memory_resource* resource = std::pmr::new_delete_resource();
+};
+
+using RTreeNodePtr = std::unique_ptr<RTreeNode, RTreeNodeDeleter>;
+using RTreeNodePtrList = std::pmr::list<RTreeNodePtr>;
 
+// The node and the list of its children are allocated from the same memory
+// resource, the one of the tree
 class RTreeNode {
  public:
-  RTreeNode();
-  explicit RTreeNode(const BoundingBox& bb);
+  explicit RTreeNode(
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+  explicit RTreeNode(
+      const BoundingBox& bb,
+      std::pmr::memory_resource* resource = std::pmr::get_default_resource());
   bool isRoot() const;
   bool isEntry() const;
 
-  bool hasBeenChecked;
   bool isLeaf;
   int value;
   BoundingBox bb;
@@ -32,10 +45,15 @@ class RTreeNode {
   RTreeNodePtrList children;
 };
 
+RTreeNodePtr makeRTreeNode(const BoundingBox& bb,
+                           std::pmr::memory_resource* resource);
+// Move the node at iter to the end of dest and return the next node of
+// source, the list node is relinked when both lists share a resource
 RTreeNodePtrList::iterator moveRTreeNode(RTreeNodePtrList* source,
                                          const RTreeNodePtrList::iterator& iter,
                                          RTreeNodePtrList* dest);
 void moveAllRTreeNode(RTreeNodePtrList* source, RTreeNodePtrList* dest);
+// Allocate a node from the resource of list and add it to its front
 RTreeNodePtrList::iterator makeNewRTreeNode(RTreeNodePtrList* list,
                                             const BoundingBox& bb);
 
@@ -0,0 +1,83 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_SHARDEDFILTER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_SHARDEDFILTER_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+
+namespace convex_hull_filtering {
+
+class ShardedFilterConfig {
+ public:
+  ShardedFilterConfig();
+
+  HullFilterConfig filter;  // Only FilterMode::PAIRWISE can be sharded
+  unsigned int nbWorkers;   // One shard and one process per worker
+  // Program started for each shard, it has to hand the three arguments
+  // following --worker to ShardedFilter::runWorker like convex_hull_filtering
+  // does. No default, filter throws when it is empty.
+  std::string workerExecutable;
+  std::string tmpDir;  // Where the shards are exchanged, empty for default
+};
+
+// Filter with one process per shard of the plane:
+// 1. the convex hulls are split by their centers into nbWorkers shards of
+//    about the same size, in vertical slabs cut in rows like STR does
+// 2. each shard is written to a binary file and filtered by a worker process
+//    which writes back which of its convex hulls were removed
+// 3. the pairs whose convex hulls are in different shards are checked by the
+//    coordinator, only the convex hulls touching the extent of another shard
+//    can be part of such a pair
+// Every pair is checked exactly once so the result is the same as filtering
+// everything in a single process.
+class ShardedFilter {
+ public:
+  explicit ShardedFilter(
+      const ShardedFilterConfig& config = ShardedFilterConfig());
+  // Return the indices of the convex hulls to keep in increasing order
+  std::vector<int> filter(const std::vector<ConvexHull>& convexHulls);
+  // Filter a shard written by the coordinator with the configuration in
+  // configFile and write a removal flag per convex hull of the shard to
+  // resultFile
+  static void runWorker(const std::string& shardFile,
+                        const std::string& resultFile,
+                        const std::string& configFile);
+  // Every field of config is written, the workers filter exactly like the
+  // coordinator would
+  static void writeWorkerConfig(const std::string& filePath,
+                                const HullFilterConfig& config);
+  static HullFilterConfig readWorkerConfig(const std::string& filePath);
+
+  // Statistics of the last call to filter
+  std::size_t getNbBoundaryConvexHulls() const;
+  std::size_t getNbCrossPairs() const;
+  double getWorkerSeconds() const;     // Wall time of the worker processes
+  double getReconcileSeconds() const;  // Wall time of the cross shard pairs
+
+ private:
+  std::vector<std::vector<int>> partition(
+      const std::vector<BoundingBox>& boundingBoxes) const;
+  std::vector<std::string> getWorkerArguments(
+      const std::string& shardFile, const std::string& resultFile,
+      const std::string& configFile) const;
+  void reconcile(const std::vector<ConvexHull>& convexHulls,
+                 const std::vector<BoundingBox>& boundingBoxes,
+                 const std::vector<std::vector<int>>& shards,
+                 std::vector<bool>* convexHullsToRemove);
+
+  ShardedFilterConfig config;
+  std::size_t nbBoundaryConvexHulls;
+  std::size_t nbCrossPairs;
+  double workerSeconds;
+  double reconcileSeconds;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_SHARDEDFILTER_HPP_
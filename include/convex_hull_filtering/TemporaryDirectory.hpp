@@ -0,0 +1,27 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_TEMPORARYDIRECTORY_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_TEMPORARYDIRECTORY_HPP_
+
+#include <filesystem>
+#include <string>
+
+namespace convex_hull_filtering {
+
+// Directory unique to the process, removed with everything in it on
+// destruction. An empty parent uses the temporary directory of the system.
+class TemporaryDirectory {
+ public:
+  TemporaryDirectory(const std::string& parent, const std::string& prefix);
+  ~TemporaryDirectory();
+  TemporaryDirectory(const TemporaryDirectory&) = delete;
+  TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+  std::string getFilePath(const std::string& fileName) const;
+
+  std::filesystem::path path;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_TEMPORARYDIRECTORY_HPP_
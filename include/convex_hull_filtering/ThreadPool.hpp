@@ -0,0 +1,58 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_THREADPOOL_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_THREADPOOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace convex_hull_filtering {
+
+// Called with [begin, end) of the chunk to process and the index of the
+// thread running it (0 is the thread that called parallelFor)
+using ChunkTask = std::function<void(std::size_t, std::size_t, unsigned int)>;
+
+class ThreadPool {
+ public:
+  // nbThreads includes the calling thread, so 1 means fully serial
+  explicit ThreadPool(unsigned int nbThreads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  unsigned int getNbThreads() const;
+  // Split [0, count) in chunks of chunkSize that are handed to the threads
+  // on demand, blocks until every chunk has been processed
+  void parallelFor(std::size_t count, std::size_t chunkSize,
+                   const ChunkTask& task);
+
+  static unsigned int getDefaultNbThreads();
+
+ private:
+  void workerLoop(unsigned int threadIdx);
+  void runChunks(unsigned int threadIdx);
+
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wakeUp;
+  std::condition_variable allDone;
+  const ChunkTask* task;
+  std::size_t count;
+  std::size_t chunkSize;
+  std::atomic<std::size_t> nextIdx;
+  std::exception_ptr firstError;
+  unsigned int nbBusyWorkers;
+  std::uint64_t generation;
+  bool stopping;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_THREADPOOL_HPP_
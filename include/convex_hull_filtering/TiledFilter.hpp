@@ -0,0 +1,91 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_TILEDFILTER_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_TILEDFILTER_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+
+namespace convex_hull_filtering {
+
+class TiledFilterConfig {
+ public:
+  TiledFilterConfig();
+
+  HullFilterConfig filter;   // Only FilterMode::PAIRWISE can be tiled
+  // Bytes used to hold a tile and its halo while filtering it, see
+  // TiledFilter::getLargestTileBytes
+  std::size_t memoryBudget;
+  std::string tmpDir;        // Where the tiles are spilled, empty for default
+  unsigned int gridSize;     // Resolution of the histogram used for tiling
+};
+
+// Filter files that don't fit in memory. The input is read three times:
+// 1. to build a histogram of the convex hull centers and find the largest
+//    convex hull, the tiles are then made by splitting the histogram until
+//    the convex hulls of a tile and of its halo fit in the memory budget
+// 2. to spill every convex hull to the file of the tile owning its center
+//    and to the files of the tiles within the halo (the largest extent)
+// 3. to write the kept convex hulls in the input order
+// Every convex hull that can overlap a convex hull of a tile is in that tile
+// so the result is the same as filtering everything at once.
+class TiledFilter {
+ public:
+  explicit TiledFilter(const TiledFilterConfig& config = TiledFilterConfig());
+  // Return the number of convex hulls written to outputFile, the output
+  // format is chosen from its extension like saveConvexHulls does
+  std::size_t filter(const std::string& inputFile,
+                     const std::string& outputFile, bool pretty = true);
+  // Number of tiles used by the last call to filter
+  std::size_t getNbTiles() const;
+  // Estimate of the memory taken by the largest tile of the last call to
+  // filter, halo included. Tiles aren't split below the size of the halo so
+  // this is above the budget when the convex hulls around a single tile are
+  // already too many. The spill buffers, half of the budget but at least
+  // 4 kB per tile, are freed before the tiles are filtered.
+  std::size_t getLargestTileBytes() const;
+  // Time the stages of filter, null to stop. Reading the input and the
+  // tiles is LOAD, filtering the tiles adds to FILTER and its stages and the
+  // third pass is WRITE. The counters are those of the filter of each tile,
+  // so the convex hulls and the pairs of a halo count once per tile they
+  // are in.
+  void setInstrumentation(Instrumentation* instrumentation);
+
+ private:
+  // Node of the kd tree splitting the histogram, leaves are the tiles
+  class TileNode {
+   public:
+    int cellMin[2];  // Cells [cellMin, cellMax) covered by the node
+    int cellMax[2];
+    int children[2];  // -1 for a tile
+    int tile;
+  };
+
+  int buildTiles(const std::vector<std::size_t>& summedCounts, int cellMinX,
+                 int cellMinY, int cellMaxX, int cellMaxY,
+                 std::size_t capacity);
+  int getCell(float coord, int axis) const;
+  int findHomeTile(const BoundingBox& boundingBox) const;
+  // Tiles, other than home, whose area grown by the halo meets boundingBox
+  void findHaloTiles(const BoundingBox& boundingBox, int home,
+                     std::vector<int>* tiles) const;
+  BoundingBox getTileArea(const TileNode& node) const;
+
+  TiledFilterConfig config;
+  BoundingBox world;
+  float halo;
+  int haloCells[2];  // Halo in cells of the histogram along x and y
+  std::vector<TileNode> tileNodes;
+  std::size_t nbTiles;
+  std::size_t largestTileBytes;
+  Instrumentation* instrumentation;
+};
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_TILEDFILTER_HPP_
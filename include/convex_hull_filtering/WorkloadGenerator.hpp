@@ -0,0 +1,85 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef INCLUDE_CONVEX_HULL_FILTERING_WORKLOADGENERATOR_HPP_
+#define INCLUDE_CONVEX_HULL_FILTERING_WORKLOADGENERATOR_HPP_
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+enum class Layout {
+  UNIFORM,         // Centers spread over the whole world
+  CLUSTERED,       // Centers uniform in disks around cluster centers
+  GAUSSIAN_BLOBS,  // Centers normally distributed around blob centers
+  GRID,            // Axis aligned boxes on the cells of a grid
+};
+
+enum class VertexDistribution {
+  UNIFORM,  // Uniform in [minVertices, maxVertices]
+  POISSON,  // Poisson of mean meanVertices clamped to the same range
+};
+
+class WorkloadConfig {
+ public:
+  WorkloadConfig();
+
+  std::uint64_t count;
+  Layout layout;
+  VertexDistribution vertexDistribution;
+  int minVertices;  // At least 3, unused by the grid layout
+  int maxVertices;
+  double meanVertices;
+  // Fraction of the convex hulls overlapping at least one other one. The
+  // size of the world is derived from it for the uniform and the grid
+  // layouts, the clustered layouts use the same world so they overlap more.
+  double overlapRate;
+  float radius;                // Mean radius of the convex hulls
+  std::uint64_t nbClusters;    // 0 for one cluster per 1000 convex hulls
+  float clusterRadius;         // Disk radius or standard deviation of blobs
+  std::uint64_t seed;
+};
+
+// Generate convex hulls one at a time so that any count can be streamed to a
+// file. The same config always gives the same convex hulls.
+class WorkloadGenerator {
+ public:
+  explicit WorkloadGenerator(const WorkloadConfig& config = WorkloadConfig());
+  bool hasNext() const;
+  ConvexHull next();
+  // Side of the square holding the centers
+  float getWorldSize() const;
+
+ private:
+  Point nextCenter();
+  int nextNbVertices();
+
+  WorkloadConfig config;
+  std::mt19937_64 gen;
+  float worldSize;
+  float gridStep;
+  std::uint64_t gridSide;
+  double stretchRate;  // Chance for a grid box to overlap its right neighbor
+  std::vector<Point> clusterCenters;
+  std::uint64_t index;
+  std::vector<Point> points;
+};
+
+// Generate every convex hull of config in memory
+std::vector<ConvexHull> generateConvexHulls(const WorkloadConfig& config);
+
+// Stream the generated convex hulls to a JSON or a binary file, the format
+// is chosen from the extension like saveConvexHulls does
+void generateWorkload(const std::string& filePath,
+                      const WorkloadConfig& config = WorkloadConfig(),
+                      bool pretty = true);
+}  // namespace convex_hull_filtering
+
+#endif  // INCLUDE_CONVEX_HULL_FILTERING_WORKLOADGENERATOR_HPP_
@@ -0,0 +1,100 @@
+#!/bin/env python
+
+"""
+Compare the per call functions of the bindings with the RTree type and the
+batch functions on random convex hulls, and check that they agree
+"""
+
+import argparse
+import math
+import time
+
+import numpy as np
+
+import convex_hull_filtering as chf
+
+
+def make_convex_hulls(count, nb_vertices, radius, seed):
+    rng = np.random.default_rng(seed)
+    world_size = 20.0 * math.sqrt(count)
+    centers = rng.uniform(0.0, world_size, (count, 2))
+    radii = rng.uniform(0.5 * radius, 1.5 * radius, (count, 2))
+    sector = 2.0 * math.pi / nb_vertices
+    angles = sector * (np.arange(nb_vertices)
+                       + 0.8 * rng.uniform(0.0, 1.0, (count, nb_vertices)))
+    x = centers[:, 0:1] + radii[:, 0:1] * np.cos(angles)
+    y = centers[:, 1:2] + radii[:, 1:2] * np.sin(angles)
+    points = np.stack([x, y], axis=2).reshape(-1, 2)
+    offsets = np.arange(count + 1, dtype=np.int64) * nb_vertices
+    return points, offsets
+
+
+def get_entries(points, offsets):
+    entries = []
+    for i in range(len(offsets) - 1):
+        hull = points[offsets[i]:offsets[i + 1]]
+        entries.append([i, *hull.min(axis=0), *hull.max(axis=0)])
+    return np.array(entries)
+
+
+def timed(name, function, repeat):
+    best = math.inf
+    for _ in range(repeat):
+        start = time.perf_counter()
+        result = function()
+        best = min(best, time.perf_counter() - start)
+    print(f"{name:<40} {best * 1e3:10.2f} ms")
+    return result, best
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--count", type=int, default=20000)
+    parser.add_argument("--vertices", type=int, default=8)
+    parser.add_argument("--radius", type=float, default=6.0)
+    parser.add_argument("--repeat", type=int, default=3)
+    args = parser.parse_args()
+
+    points, offsets = make_convex_hulls(
+        args.count, args.vertices, args.radius, 42)
+    entries = get_entries(points, offsets)
+    hulls = [np.matrix(points[offsets[i]:offsets[i + 1]])
+             for i in range(args.count)]
+    print(f"{args.count} convex hulls of {args.vertices} vertices")
+
+    # Broad phase: rebuilt at every call against a tree kept between calls
+    pairs, rebuild = timed(
+        "findPairwiseIntersections (rebuild)",
+        lambda: chf.findPairwiseIntersections(4, 8, entries), args.repeat)
+    rtree = chf.RTree(4, 8)
+    _, insert = timed("RTree.insert", lambda: chf.RTree(4, 8).insert(entries),
+                      args.repeat)
+    rtree.insert(entries)
+    joined, join = timed("RTree.join", rtree.join, args.repeat)
+    assert sorted(map(tuple, np.sort(pairs, axis=1))) == \
+        sorted(map(tuple, np.sort(joined, axis=1)))
+
+    # Narrow phase: one call per pair against one call for all of them
+    pairs = pairs.astype(np.int64)
+
+    def per_pair():
+        return np.array([chf.intersection(hulls[i], hulls[j])[2]
+                         for i, j in pairs])
+    areas, per_call = timed("intersection (per pair)", per_pair, args.repeat)
+    batch_areas, batch = timed(
+        "intersectionAreas",
+        lambda: chf.intersectionAreas(points, offsets, pairs), args.repeat)
+    assert np.allclose(areas, batch_areas, rtol=1e-4, atol=1e-3)
+
+    # Whole filter
+    kept, _ = timed("filter",
+                    lambda: chf.filter(points, offsets, 50.0), args.repeat)
+
+    print(f"{len(pairs)} candidate pairs, {len(kept)} convex hulls kept")
+    print(f"Kept tree: join {rebuild / join:.1f}x faster than rebuilding, "
+          f"insert + join {rebuild / (insert + join):.1f}x")
+    print(f"Batch intersection areas {per_call / batch:.1f}x faster")
+
+
+if __name__ == "__main__":
+    main()
@@ -3,9 +3,19 @@
 
 #include <Python.h>
 #define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <exception>
 #include <iostream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "convex_hull_filtering/BoundingBox.hpp"
 #include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
 #include "convex_hull_filtering/Point.hpp"
 #include "convex_hull_filtering/RTree.hpp"
 #include "numpy/arrayobject.h"
@@ -60,9 +70,13 @@ static PyObject* ConvexHull_intersection(PyObject* self, PyObject* args) {
 
   auto [inter, interConvexHull] = a.intersection(b);
   PyObject* ret = convertToPython(interConvexHull.points);
+  // The area comes from the kernel of intersectionAreas and of the filter,
+  // the shoelace of the clipped points can differ from it in the last bits
+  float interArea;
+  std::vector<chf::Point> interPoints;
+  a.intersectionArea(b, &interArea, &interPoints);
 
-  return Py_BuildValue("NOd", PyBool_FromLong(inter), ret,
-                       interConvexHull.getArea());
+  return Py_BuildValue("NNd", PyBool_FromLong(inter), ret, interArea);
 }
 
 static PyObject* ConvexHull_getArea(PyObject* self, PyObject* args) {
@@ -103,13 +117,11 @@ std::vector<std::pair<int, chf::BoundingBox> > parseBoundingBoxes(
   return res;
 }
 
-chf::RTree buildRTree(int m, int M, PyArrayObject* entryArr) {
-  chf::RTree rtree(m, M);
+void fillRTree(PyArrayObject* entryArr, chf::RTree* rtree) {
   auto entries = parseBoundingBoxes(entryArr);
   for (auto& entry : entries) {
-    rtree.insertEntry(entry.first, entry.second);
+    rtree->insertEntry(entry.first, entry.second);
   }
-  return rtree;
 }
 
 static PyObject* RTree_insertEntry(PyObject* self, PyObject* args) {
@@ -123,7 +135,8 @@ static PyObject* RTree_insertEntry(PyObject* self, PyObject* args) {
     return NULL;
   }
 
-  chf::RTree rtree = buildRTree(m, M, entriesArr);
+  chf::RTree rtree(m, M);
+  fillRTree(entriesArr, &rtree);
 
   std::function<PyObject*(chf::RTreeNode&)> traverseTree =
       [&](chf::RTreeNode& node) -> PyObject* {
@@ -151,7 +164,8 @@ static PyObject* RTree_findPairwiseIntersections(PyObject* self,
     return NULL;
   }
 
-  chf::RTree rtree = buildRTree(m, M, entriesArr);
+  chf::RTree rtree(m, M);
+  fillRTree(entriesArr, &rtree);
 
   auto res = rtree.findPairwiseIntersections();
   npy_intp dims[2u];
@@ -181,6 +195,362 @@ static PyObject* BoundingBox(PyObject* self, PyObject* args) {
   return Py_BuildValue("[d,d,d,d]", bb.min.x, bb.min.y, bb.max.x, bb.max.y);
 }
 
+// Batch functions. A batch of convex hulls is given as a (N,2) double
+// matrix holding the points of all the convex hulls one after the other and
+// a vector of H+1 offsets, convex hull i owning the points
+// [offsets[i], offsets[i+1]). The buffers are read in place when they are
+// contiguous and of the right type, the C++ work runs without the GIL.
+
+// Run work without the GIL, return false with the Python error set if it
+// threw
+template <typename Work>
+bool runWithoutGil(const Work& work) {
+  bool failed = false;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS;
+  try {
+    work();
+  } catch (std::exception& e) {
+    failed = true;
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS;
+  if (failed) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+  }
+  return !failed;
+}
+
+// Contiguous array of the given type and number of dimensions, a new
+// reference or NULL with the Python error set
+PyArrayObject* getContiguousArray(PyObject* obj, int type, int nbDims,
+                                  const char* name) {
+  PyArrayObject* arr = reinterpret_cast<PyArrayObject*>(
+      PyArray_FROMANY(obj, type, nbDims, nbDims, NPY_ARRAY_IN_ARRAY));
+  if (arr == NULL) {
+    PyErr_Format(PyExc_ValueError, "ERROR: %s must be a %d dimensional array",
+                 name, nbDims);
+  }
+  return arr;
+}
+
+// Points and offsets of a batch, the arrays are released with the batch
+class HullBatch {
+ public:
+  HullBatch() : points(NULL), offsets(NULL) {}
+  ~HullBatch() {
+    Py_XDECREF(points);
+    Py_XDECREF(offsets);
+  }
+
+  // Return false with the Python error set if the arrays aren't valid
+  bool parse(PyObject* pointsObj, PyObject* offsetsObj) {
+    points = getContiguousArray(pointsObj, NPY_DOUBLE, 2, "points");
+    if (points == NULL) {
+      return false;
+    }
+    offsets = getContiguousArray(offsetsObj, NPY_INT64, 1, "offsets");
+    if (offsets == NULL) {
+      return false;
+    }
+    if (PyArray_DIM(points, 1) != 2) {
+      PyErr_SetString(PyExc_ValueError, "ERROR: points must be (N,2)");
+      return false;
+    }
+    npy_intp nbPoints = PyArray_DIM(points, 0);
+    npy_intp nbOffsets = PyArray_DIM(offsets, 0);
+    const std::int64_t* offsetData =
+        reinterpret_cast<const std::int64_t*>(PyArray_DATA(offsets));
+    if (nbOffsets == 0 || offsetData[0] != 0 ||
+        offsetData[nbOffsets - 1] != nbPoints) {
+      PyErr_SetString(PyExc_ValueError,
+                      "ERROR: offsets must go from 0 to the number of points");
+      return false;
+    }
+    for (npy_intp i = 1; i < nbOffsets; i++) {
+      if (offsetData[i] - offsetData[i - 1] < 3) {
+        PyErr_SetString(PyExc_ValueError,
+                        "ERROR: a convex hull needs at least 3 points");
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Safe to call without the GIL
+  std::vector<chf::ConvexHull> toConvexHulls() const {
+    const double* pointData =
+        reinterpret_cast<const double*>(PyArray_DATA(points));
+    const std::int64_t* offsetData =
+        reinterpret_cast<const std::int64_t*>(PyArray_DATA(offsets));
+    npy_intp nbConvexHulls = PyArray_DIM(offsets, 0) - 1;
+    std::vector<chf::ConvexHull> convexHulls;
+    convexHulls.reserve(nbConvexHulls);
+    std::vector<chf::Point> hullPoints;
+    for (npy_intp i = 0; i < nbConvexHulls; i++) {
+      hullPoints.clear();
+      for (std::int64_t k = offsetData[i]; k < offsetData[i + 1]; k++) {
+        hullPoints.push_back(
+            chf::Point(pointData[2 * k], pointData[2 * k + 1]));
+      }
+      convexHulls.push_back(chf::ConvexHull(hullPoints, i));
+    }
+    return convexHulls;
+  }
+
+  PyArrayObject* points;
+  PyArrayObject* offsets;
+};
+
+static PyObject* ConvexHull_intersectionAreas(PyObject* self, PyObject* args) {
+  PyObject* pointsObj = NULL;
+  PyObject* offsetsObj = NULL;
+  PyObject* pairsObj = NULL;
+
+  if (!PyArg_ParseTuple(args, "OOO", &pointsObj, &offsetsObj, &pairsObj)) {
+    PyErr_SetString(PyExc_ValueError, "ERROR: when parsing tuple");
+    return NULL;
+  }
+  HullBatch batch;
+  if (!batch.parse(pointsObj, offsetsObj)) {
+    return NULL;
+  }
+  PyArrayObject* pairs = getContiguousArray(pairsObj, NPY_INT64, 2, "pairs");
+  if (pairs == NULL) {
+    return NULL;
+  }
+  npy_intp nbPairs = PyArray_DIM(pairs, 0);
+  npy_intp nbConvexHulls = PyArray_DIM(batch.offsets, 0) - 1;
+  const std::int64_t* pairData =
+      reinterpret_cast<const std::int64_t*>(PyArray_DATA(pairs));
+  if (nbPairs > 0 && PyArray_DIM(pairs, 1) != 2) {
+    Py_DECREF(pairs);
+    PyErr_SetString(PyExc_ValueError, "ERROR: pairs must be (K,2)");
+    return NULL;
+  }
+  for (npy_intp i = 0; i < 2 * nbPairs; i++) {
+    if (pairData[i] < 0 || pairData[i] >= nbConvexHulls) {
+      Py_DECREF(pairs);
+      PyErr_SetString(PyExc_IndexError, "ERROR: convex hull out of range");
+      return NULL;
+    }
+  }
+
+  npy_intp dims[1u] = {nbPairs};
+  PyObject* ret = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
+  double* areas = reinterpret_cast<double*>(
+      PyArray_DATA(reinterpret_cast<PyArrayObject*>(ret)));
+  bool done = runWithoutGil([&]() {
+    auto convexHulls = batch.toConvexHulls();
+    std::vector<chf::Point> interPoints;
+    for (npy_intp i = 0; i < nbPairs; i++) {
+      const auto& a = convexHulls[pairData[2 * i]];
+      const auto& b = convexHulls[pairData[2 * i + 1]];
+      float interArea;
+      a.intersectionArea(b, &interArea, &interPoints);
+      areas[i] = interArea;
+    }
+  });
+  Py_DECREF(pairs);
+  if (!done) {
+    Py_DECREF(ret);
+    return NULL;
+  }
+  return ret;
+}
+
+static PyObject* HullFilter_filter(PyObject* self, PyObject* args,
+                                   PyObject* kwargs) {
+  static const char* keywords[] = {"points", "offsets", "threshold", "rule",
+                                   "threads", NULL};
+  PyObject* pointsObj = NULL;
+  PyObject* offsetsObj = NULL;
+  chf::HullFilterConfig config;
+  const char* rule = "each";
+  unsigned int nbThreads = config.nbThreads;
+
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OO|fsI",
+                                   const_cast<char**>(keywords), &pointsObj,
+                                   &offsetsObj, &config.threshold, &rule,
+                                   &nbThreads)) {
+    return NULL;
+  }
+  if (std::string(rule) == "smaller") {
+    config.removalRule = chf::RemovalRule::SMALLER_OF_PAIR;
+  } else if (std::string(rule) != "each") {
+    PyErr_SetString(PyExc_ValueError, "ERROR: rule must be each or smaller");
+    return NULL;
+  }
+  config.nbThreads = nbThreads;
+  HullBatch batch;
+  if (!batch.parse(pointsObj, offsetsObj)) {
+    return NULL;
+  }
+
+  std::vector<int> keptIndices;
+  if (!runWithoutGil([&]() {
+        chf::HullFilter hullFilter(config);
+        keptIndices = hullFilter.filter(batch.toConvexHulls());
+      })) {
+    return NULL;
+  }
+
+  npy_intp dims[1u] = {static_cast<npy_intp>(keptIndices.size())};
+  PyObject* ret = PyArray_SimpleNew(1, dims, NPY_INT64);
+  std::int64_t* kept = reinterpret_cast<std::int64_t*>(
+      PyArray_DATA(reinterpret_cast<PyArrayObject*>(ret)));
+  for (std::size_t i = 0; i < keptIndices.size(); i++) {
+    kept[i] = keptIndices[i];
+  }
+  return ret;
+}
+
+// RTree object living across calls. The tree is only touched without the
+// GIL, under its own mutex so that threads can share it.
+typedef struct {
+  PyObject_HEAD
+  chf::RTree* rtree;
+  std::mutex* mutex;
+  Py_ssize_t nbEntries;
+} PyRTree;
+
+static int PyRTree_init(PyRTree* self, PyObject* args, PyObject* kwargs) {
+  static const char* keywords[] = {"m", "M", NULL};
+  unsigned int m = 4;
+  unsigned int M = 8;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|II",
+                                   const_cast<char**>(keywords), &m, &M)) {
+    return -1;
+  }
+  if (m < 1 || M < 2 * m) {
+    PyErr_SetString(PyExc_ValueError, "ERROR: need 1 <= m <= M / 2");
+    return -1;
+  }
+  delete self->rtree;
+  delete self->mutex;
+  self->rtree = new chf::RTree(m, M);
+  self->mutex = new std::mutex();
+  self->nbEntries = 0;
+  return 0;
+}
+
+static void PyRTree_dealloc(PyRTree* self) {
+  delete self->rtree;
+  delete self->mutex;
+  Py_TYPE(self)->tp_free(reinterpret_cast<PyObject*>(self));
+}
+
+bool checkInitialized(PyRTree* self) {
+  if (self->rtree == NULL) {
+    PyErr_SetString(PyExc_RuntimeError, "ERROR: RTree not initialized");
+    return false;
+  }
+  return true;
+}
+
+// Same (N,5) [value, minX, minY, maxX, maxY] matrix as insertEntry
+static PyObject* PyRTree_insert(PyRTree* self, PyObject* args) {
+  PyObject* entriesObj = NULL;
+  if (!checkInitialized(self) || !PyArg_ParseTuple(args, "O", &entriesObj)) {
+    return NULL;
+  }
+  PyArrayObject* entries =
+      getContiguousArray(entriesObj, NPY_DOUBLE, 2, "entries");
+  if (entries == NULL) {
+    return NULL;
+  }
+  npy_intp nbEntries = PyArray_DIM(entries, 0);
+  if (nbEntries > 0 && PyArray_DIM(entries, 1) != 5) {
+    Py_DECREF(entries);
+    PyErr_SetString(PyExc_ValueError, "ERROR: entries must be (N,5)");
+    return NULL;
+  }
+  const double* data = reinterpret_cast<const double*>(PyArray_DATA(entries));
+  bool done = runWithoutGil([&]() {
+    std::vector<std::pair<int, chf::BoundingBox>> batch;
+    batch.reserve(nbEntries);
+    for (npy_intp i = 0; i < nbEntries; i++) {
+      const double* entry = data + 5 * i;
+      batch.push_back(std::make_pair(
+          std::ceil(entry[0]),
+          chf::BoundingBox(chf::Point(entry[1], entry[2]),
+                           chf::Point(entry[3], entry[4]))));
+    }
+    std::lock_guard<std::mutex> lock(*self->mutex);
+    self->rtree->insertBatch(batch);
+    self->nbEntries += nbEntries;
+  });
+  Py_DECREF(entries);
+  if (!done) {
+    return NULL;
+  }
+  Py_RETURN_NONE;
+}
+
+// Values of the entries whose bounding box intersects [minX, minY, maxX, maxY]
+static PyObject* PyRTree_query(PyRTree* self, PyObject* args) {
+  double minX, minY, maxX, maxY;
+  if (!checkInitialized(self) ||
+      !PyArg_ParseTuple(args, "(dddd)", &minX, &minY, &maxX, &maxY)) {
+    return NULL;
+  }
+  chf::BoundingBox boundingBox(chf::Point(minX, minY), chf::Point(maxX, maxY));
+  std::vector<int> values;
+  if (!runWithoutGil([&]() {
+        std::lock_guard<std::mutex> lock(*self->mutex);
+        self->rtree->search(boundingBox, &values);
+      })) {
+    return NULL;
+  }
+
+  npy_intp dims[1u] = {static_cast<npy_intp>(values.size())};
+  PyObject* ret = PyArray_SimpleNew(1, dims, NPY_INT);
+  std::copy(values.begin(), values.end(),
+            reinterpret_cast<int*>(
+                PyArray_DATA(reinterpret_cast<PyArrayObject*>(ret))));
+  return ret;
+}
+
+// (K,2) values of the entries whose bounding boxes intersect
+static PyObject* PyRTree_join(PyRTree* self, PyObject* Py_UNUSED(args)) {
+  if (!checkInitialized(self)) {
+    return NULL;
+  }
+  std::vector<std::pair<int, int>> pairs;
+  if (!runWithoutGil([&]() {
+        std::lock_guard<std::mutex> lock(*self->mutex);
+        self->rtree->findPairwiseIntersections(&pairs);
+      })) {
+    return NULL;
+  }
+
+  npy_intp dims[2u] = {static_cast<npy_intp>(pairs.size()), 2};
+  PyObject* ret = PyArray_SimpleNew(2, dims, NPY_INT);
+  int* data = reinterpret_cast<int*>(
+      PyArray_DATA(reinterpret_cast<PyArrayObject*>(ret)));
+  for (std::size_t i = 0; i < pairs.size(); i++) {
+    data[2 * i] = pairs[i].first;
+    data[2 * i + 1] = pairs[i].second;
+  }
+  return ret;
+}
+
+static Py_ssize_t PyRTree_len(PyRTree* self) { return self->nbEntries; }
+
+static PyMethodDef PyRTreeMethods[] = {
+    {"insert", reinterpret_cast<PyCFunction>(PyRTree_insert), METH_VARARGS,
+     "Insert a (N,5) matrix of [value, minX, minY, maxX, maxY] entries"},
+    {"query", reinterpret_cast<PyCFunction>(PyRTree_query), METH_VARARGS,
+     "Values of the entries intersecting (minX, minY, maxX, maxY)"},
+    {"join", reinterpret_cast<PyCFunction>(PyRTree_join), METH_NOARGS,
+     "Pairs of values of the intersecting entries"},
+    {NULL, NULL, 0, NULL}};
+
+static PySequenceMethods PyRTreeSequenceMethods = {
+    reinterpret_cast<lenfunc>(PyRTree_len)};
+
+static PyTypeObject PyRTreeType = {PyVarObject_HEAD_INIT(NULL, 0)};
+
 static PyMethodDef chfMethods[] = {
     {"intersection", ConvexHull_intersection, METH_VARARGS,
      "Convex hull intersection"},
@@ -189,6 +559,11 @@ static PyMethodDef chfMethods[] = {
     {"boundingBox", BoundingBox, METH_VARARGS, "Build BoundinbBox"},
     {"findPairwiseIntersections", RTree_findPairwiseIntersections, METH_VARARGS,
      "Search for overlaps using RTree"},
+    {"intersectionAreas", ConvexHull_intersectionAreas, METH_VARARGS,
+     "Intersection area of each pair of a batch of convex hulls"},
+    {"filter", reinterpret_cast<PyCFunction>(HullFilter_filter),
+     METH_VARARGS | METH_KEYWORDS,
+     "Indices of the convex hulls of a batch kept by the filter"},
     {NULL, NULL, 0, NULL}};
 
 static struct PyModuleDef convexHullFilteringModule = {
@@ -197,5 +572,29 @@ static struct PyModuleDef convexHullFilteringModule = {
 
 PyMODINIT_FUNC PyInit_convex_hull_filtering(void) {
   import_array();
-  return PyModule_Create(&convexHullFilteringModule);
+  PyRTreeType.tp_name = "convex_hull_filtering.RTree";
+  PyRTreeType.tp_doc = "RTree of bounding boxes kept between calls";
+  PyRTreeType.tp_basicsize = sizeof(PyRTree);
+  PyRTreeType.tp_flags = Py_TPFLAGS_DEFAULT;
+  PyRTreeType.tp_new = PyType_GenericNew;
+  PyRTreeType.tp_init = reinterpret_cast<initproc>(PyRTree_init);
+  PyRTreeType.tp_dealloc = reinterpret_cast<destructor>(PyRTree_dealloc);
+  PyRTreeType.tp_methods = PyRTreeMethods;
+  PyRTreeType.tp_as_sequence = &PyRTreeSequenceMethods;
+  if (PyType_Ready(&PyRTreeType) < 0) {
+    return NULL;
+  }
+
+  PyObject* module = PyModule_Create(&convexHullFilteringModule);
+  if (module == NULL) {
+    return NULL;
+  }
+  Py_INCREF(&PyRTreeType);
+  if (PyModule_AddObject(module, "RTree",
+                         reinterpret_cast<PyObject*>(&PyRTreeType)) < 0) {
+    Py_DECREF(&PyRTreeType);
+    Py_DECREF(module);
+    return NULL;
+  }
+  return module;
 }
@@ -4,21 +4,34 @@
 setup.py file
 """
 
+import numpy
 from setuptools import setup, Extension
 
 convex_hull_filtering_module = Extension('convex_hull_filtering',
                                          sources=[
                                              'python/convex_hull_filtering.cpp',
                                              'src/convex_hull_filtering/BoundingBox.cpp',
+                                             'src/convex_hull_filtering/BoundingVolumes.cpp',
                                              'src/convex_hull_filtering/ConvexHull.cpp',
                                              'src/convex_hull_filtering/Edge.cpp',
+                                             'src/convex_hull_filtering/FixedConvexHull.cpp',
+                                             'src/convex_hull_filtering/HullFilter.cpp',
+                                             'src/convex_hull_filtering/Instrumentation.cpp',
+                                             'src/convex_hull_filtering/NarrowPhase.cpp',
+                                             'src/convex_hull_filtering/OverlapBounds.cpp',
+                                             'src/convex_hull_filtering/OverlapCache.cpp',
+                                             'src/convex_hull_filtering/OverlapComponents.cpp',
                                              'src/convex_hull_filtering/Point.cpp',
+                                             'src/convex_hull_filtering/QuantizedConvexHulls.cpp',
                                              'src/convex_hull_filtering/RTree.cpp',
                                              'src/convex_hull_filtering/RTreeNode.cpp',
-                                             'src/convex_hull_filtering/Spliter.cpp'],
+                                             'src/convex_hull_filtering/Spliter.cpp',
+                                             'src/convex_hull_filtering/ThreadPool.cpp'],
                                          include_dirs=[
-                                             'include'
-                                         ]
+                                             'include',
+                                             numpy.get_include()
+                                         ],
+                                         extra_compile_args=['-std=c++17']
                                          )
 
 setup(name='convex_hull_filtering',
@@ -0,0 +1,73 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/AsyncHullWriter.hpp"
+
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <utility>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering {
+
+AsyncHullWriter::AsyncHullWriter(const WriteFunction& write)
+    : write(write), done(false), thread(&AsyncHullWriter::run, this) {}
+
+AsyncHullWriter::~AsyncHullWriter() {
+  try {
+    finish();
+  } catch (...) {
+  }
+}
+
+void AsyncHullWriter::push(const ConvexHull* convexHull) {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    queue.push_back(convexHull);
+  }
+  cv.notify_one();
+}
+
+void AsyncHullWriter::finish() {
+  if (!thread.joinable()) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done = true;
+  }
+  cv.notify_one();
+  thread.join();
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
+void AsyncHullWriter::run() {
+  std::deque<const ConvexHull*> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      cv.wait(lock, [this] { return done || !queue.empty(); });
+      if (queue.empty()) {
+        return;
+      }
+      // Take everything queued so far to write it without holding the lock
+      std::swap(batch, queue);
+    }
+    for (const ConvexHull* convexHull : batch) {
+      if (error) {
+        break;
+      }
+      try {
+        write(*convexHull);
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+    batch.clear();
+  }
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,339 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+// The structs are read and written as they are in memory
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The binary format needs a little endian host");
+static_assert(sizeof(BinaryHeader) == 32, "Unexpected header layout");
+static_assert(sizeof(BinaryTableEntry) == 24, "Unexpected table layout");
+// Float files are read in place as arrays of Point
+static_assert(sizeof(Point) == 2 * sizeof(float) &&
+                  std::is_standard_layout<Point>::value,
+              "Point must be two packed floats");
+
+namespace {
+std::uint64_t getVertexArrayOffset(std::uint64_t nbConvexHulls) {
+  return sizeof(BinaryHeader) + nbConvexHulls * sizeof(BinaryTableEntry);
+}
+
+// Check the header and that the table and the vertex array fit in size
+const BinaryHeader* checkContainer(const unsigned char* data, std::size_t size,
+                                   const std::string& name) {
+  const auto* header = reinterpret_cast<const BinaryHeader*>(data);
+  if (size < sizeof(BinaryHeader) ||
+      std::memcmp(header->magic, BINARY_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != BINARY_VERSION ||
+      (header->precision != sizeof(float) &&
+       header->precision != sizeof(double))) {
+    throw std::runtime_error(name + " is not a convex hull binary file");
+  }
+  if (header->nbConvexHulls > size / sizeof(BinaryTableEntry) ||
+      header->nbPoints > size / (2 * header->precision) ||
+      getVertexArrayOffset(header->nbConvexHulls) +
+              header->nbPoints * 2 * header->precision >
+          size) {
+    throw std::runtime_error(name + " is truncated");
+  }
+  return header;
+}
+
+// Compared by subtraction so that a corrupt offset can't wrap around
+bool isInVertexArray(const BinaryTableEntry& entry, std::uint64_t nbPoints) {
+  return entry.offset <= nbPoints && entry.count <= nbPoints - entry.offset;
+}
+
+void checkPrecision(std::uint32_t precision) {
+  if (precision != sizeof(float) && precision != sizeof(double)) {
+    throw std::runtime_error("Unsupported precision " +
+                             std::to_string(precision));
+  }
+}
+}  // namespace
+
+BinaryHullWriter::BinaryHullWriter(const std::string& filePath,
+                                   std::uint64_t nbConvexHulls,
+                                   std::uint32_t precision)
+    : filePath(filePath),
+      nbConvexHulls(nbConvexHulls),
+      nbWritten(0),
+      nbPoints(0),
+      precision(precision),
+      closed(false) {
+  checkPrecision(precision);
+  // Both streams write sequentially into the same file, one in the table
+  // and one in the vertex array
+  tableStream.open(filePath, std::ios::binary | std::ios::trunc);
+  vertexStream.open(filePath,
+                    std::ios::binary | std::ios::in | std::ios::out);
+  if (!tableStream || !vertexStream) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  tableStream.seekp(sizeof(BinaryHeader));
+  vertexStream.seekp(getVertexArrayOffset(nbConvexHulls));
+}
+
+BinaryHullWriter::~BinaryHullWriter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void BinaryHullWriter::write(const ConvexHull& convexHull) {
+  if (closed || nbWritten == nbConvexHulls) {
+    throw std::runtime_error("Too many convex hulls written to " + filePath);
+  }
+  BinaryTableEntry entry = {};
+  entry.id = convexHull.id;
+  entry.score = convexHull.score;
+  entry.offset = nbPoints;
+  entry.count = convexHull.points.size();
+  tableStream.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+
+  if (precision == sizeof(float)) {
+    vertexStream.write(reinterpret_cast<const char*>(convexHull.points.data()),
+                       convexHull.points.size() * sizeof(Point));
+  } else {
+    for (const auto& point : convexHull.points) {
+      double xy[2] = {point.x, point.y};
+      vertexStream.write(reinterpret_cast<const char*>(xy), sizeof(xy));
+    }
+  }
+  nbPoints += convexHull.points.size();
+  nbWritten++;
+}
+
+void BinaryHullWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+  if (nbWritten != nbConvexHulls) {
+    throw std::runtime_error("Expected " + std::to_string(nbConvexHulls) +
+                             " convex hulls in " + filePath + " but got " +
+                             std::to_string(nbWritten));
+  }
+  vertexStream.close();
+  if (!vertexStream) {
+    throw std::runtime_error("Couldn't write the vertices of " + filePath);
+  }
+
+  BinaryHeader header = {};
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+  header.version = BINARY_VERSION;
+  header.precision = precision;
+  header.nbConvexHulls = nbConvexHulls;
+  header.nbPoints = nbPoints;
+  tableStream.seekp(0);
+  tableStream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  tableStream.close();
+  if (!tableStream) {
+    throw std::runtime_error("Couldn't write " + filePath);
+  }
+}
+
+HullView::HullView(const BinaryTableEntry* entry,
+                   const unsigned char* vertices, std::uint32_t precision)
+    : entry(entry), vertices(vertices), precision(precision) {}
+
+int HullView::getId() const { return entry->id; }
+
+float HullView::getScore() const { return entry->score; }
+
+std::size_t HullView::size() const { return entry->count; }
+
+Point HullView::getPoint(std::size_t index) const {
+  if (precision == sizeof(float)) {
+    return data()[index];
+  }
+  const double* xy = reinterpret_cast<const double*>(vertices) + 2 * index;
+  return Point(xy[0], xy[1]);
+}
+
+const Point* HullView::data() const {
+  if (precision != sizeof(float)) {
+    return nullptr;
+  }
+  return reinterpret_cast<const Point*>(vertices);
+}
+
+ConvexHull HullView::toConvexHull() const {
+  std::vector<Point> points;
+  if (precision == sizeof(float)) {
+    points.assign(data(), data() + size());
+  } else {
+    points.reserve(size());
+    for (std::size_t i = 0; i < size(); i++) {
+      points.push_back(getPoint(i));
+    }
+  }
+  return ConvexHull(points, getId(), getScore());
+}
+
+MappedHullFile::MappedHullFile(const std::string& filePath)
+    : mapping(nullptr),
+      mappingSize(0),
+      header(nullptr),
+      table(nullptr),
+      vertices(nullptr) {
+  int fd = open(filePath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(BinaryHeader)) {
+    ::close(fd);
+    throw std::runtime_error(filePath + " is not a convex hull binary file");
+  }
+  mappingSize = st.st_size;
+  void* ptr = mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (ptr == MAP_FAILED) {
+    throw std::runtime_error("Couldn't map " + filePath);
+  }
+  mapping = static_cast<const unsigned char*>(ptr);
+
+  try {
+    header = checkContainer(mapping, mappingSize, filePath);
+  } catch (...) {
+    munmap(const_cast<unsigned char*>(mapping), mappingSize);
+    throw;
+  }
+  table = reinterpret_cast<const BinaryTableEntry*>(mapping +
+                                                    sizeof(BinaryHeader));
+  vertices = mapping + getVertexArrayOffset(header->nbConvexHulls);
+}
+
+MappedHullFile::~MappedHullFile() {
+  munmap(const_cast<unsigned char*>(mapping), mappingSize);
+}
+
+std::size_t MappedHullFile::size() const { return header->nbConvexHulls; }
+
+std::uint32_t MappedHullFile::getPrecision() const {
+  return header->precision;
+}
+
+HullView MappedHullFile::operator[](std::size_t index) const {
+  if (index >= header->nbConvexHulls) {
+    throw std::out_of_range("Convex hull " + std::to_string(index) +
+                            " out of " +
+                            std::to_string(header->nbConvexHulls));
+  }
+  const BinaryTableEntry* entry = table + index;
+  if (!isInVertexArray(*entry, header->nbPoints)) {
+    throw std::out_of_range("Convex hull " + std::to_string(index) +
+                            " points outside of the vertex array");
+  }
+  return HullView(entry, vertices + entry->offset * 2 * header->precision,
+                  header->precision);
+}
+
+bool isBinaryFile(const std::string& filePath) {
+  std::ifstream ifs(filePath, std::ios::binary);
+  char magic[4] = {};
+  ifs.read(magic, sizeof(magic));
+  return ifs && std::memcmp(magic, BINARY_MAGIC, sizeof(magic)) == 0;
+}
+
+std::vector<ConvexHull> loadBinary(const std::string& filePath) {
+  MappedHullFile file(filePath);
+  std::vector<ConvexHull> convexHulls;
+  convexHulls.reserve(file.size());
+  for (std::size_t i = 0; i < file.size(); i++) {
+    convexHulls.push_back(file[i].toConvexHull());
+  }
+  return convexHulls;
+}
+
+void saveBinary(const std::string& filePath,
+                const std::vector<ConvexHull>& convexHulls,
+                std::uint32_t precision) {
+  BinaryHullWriter writer(filePath, convexHulls.size(), precision);
+  for (const auto& convexHull : convexHulls) {
+    writer.write(convexHull);
+  }
+  writer.close();
+}
+
+void encodeBinary(const std::vector<ConvexHull>& convexHulls,
+                  std::vector<unsigned char>* buffer) {
+  std::uint64_t nbPoints = 0;
+  for (const auto& convexHull : convexHulls) {
+    nbPoints += convexHull.points.size();
+  }
+  std::uint64_t vertexArrayOffset = getVertexArrayOffset(convexHulls.size());
+  buffer->resize(vertexArrayOffset + nbPoints * sizeof(Point));
+
+  BinaryHeader header = {};
+  std::memcpy(header.magic, BINARY_MAGIC, sizeof(header.magic));
+  header.version = BINARY_VERSION;
+  header.precision = sizeof(float);
+  header.nbConvexHulls = convexHulls.size();
+  header.nbPoints = nbPoints;
+  std::memcpy(buffer->data(), &header, sizeof(header));
+
+  unsigned char* table = buffer->data() + sizeof(BinaryHeader);
+  unsigned char* vertices = buffer->data() + vertexArrayOffset;
+  std::uint64_t offset = 0;
+  for (const auto& convexHull : convexHulls) {
+    BinaryTableEntry entry = {};
+    entry.id = convexHull.id;
+    entry.score = convexHull.score;
+    entry.offset = offset;
+    entry.count = convexHull.points.size();
+    std::memcpy(table, &entry, sizeof(entry));
+    table += sizeof(entry);
+    std::memcpy(vertices + offset * sizeof(Point), convexHull.points.data(),
+                convexHull.points.size() * sizeof(Point));
+    offset += convexHull.points.size();
+  }
+}
+
+void decodeBinary(const unsigned char* data, std::size_t size,
+                  std::vector<ConvexHull>* convexHulls) {
+  const BinaryHeader* header = checkContainer(data, size, "Buffer");
+  const auto* table =
+      reinterpret_cast<const BinaryTableEntry*>(data + sizeof(BinaryHeader));
+  const unsigned char* vertices =
+      data + getVertexArrayOffset(header->nbConvexHulls);
+  // Reuse the convex hulls already in the vector and their points
+  convexHulls->resize(header->nbConvexHulls, ConvexHull(std::vector<Point>()));
+  for (std::size_t i = 0; i < header->nbConvexHulls; i++) {
+    const BinaryTableEntry& entry = table[i];
+    if (!isInVertexArray(entry, header->nbPoints)) {
+      throw std::out_of_range("Convex hull " + std::to_string(i) +
+                              " points outside of the vertex array");
+    }
+    HullView view(&entry, vertices + entry.offset * 2 * header->precision,
+                  header->precision);
+    auto& convexHull = (*convexHulls)[i];
+    convexHull.id = view.getId();
+    convexHull.score = view.getScore();
+    convexHull.points.resize(view.size(), Point(0.0f, 0.0f));
+    for (std::size_t k = 0; k < view.size(); k++) {
+      convexHull.points[k] = view.getPoint(k);
+    }
+  }
+}
+}  // namespace convex_hull_filtering
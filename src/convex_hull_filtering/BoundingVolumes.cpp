@@ -0,0 +1,204 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BoundingVolumes.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Half extents of the oriented boxes are widened by this fraction of their
+// magnitude so that rounding can't separate two touching convex hulls
+constexpr double ORIENTED_BOX_TOLERANCE = 1e-9;
+
+float roundDown(double value) {
+  float rounded = static_cast<float>(value);
+  return rounded > value
+             ? std::nextafter(rounded, -std::numeric_limits<float>::infinity())
+             : rounded;
+}
+
+float roundUp(double value) {
+  float rounded = static_cast<float>(value);
+  return rounded < value
+             ? std::nextafter(rounded, std::numeric_limits<float>::infinity())
+             : rounded;
+}
+
+DiagonalSlabs makeDiagonalSlabs(const std::vector<Point>& points) {
+  constexpr float INF = std::numeric_limits<float>::infinity();
+  if (points.empty()) {
+    // Nothing is known about it, it may intersect anything
+    return {-INF, INF, -INF, INF};
+  }
+  // The sum and the difference of two floats are exact in double
+  double minSum = std::numeric_limits<double>::infinity();
+  double maxSum = -minSum;
+  double minDiff = minSum;
+  double maxDiff = -minSum;
+  for (const auto& pt : points) {
+    double sum = static_cast<double>(pt.x) + pt.y;
+    double diff = static_cast<double>(pt.x) - pt.y;
+    minSum = std::min(minSum, sum);
+    maxSum = std::max(maxSum, sum);
+    minDiff = std::min(minDiff, diff);
+    maxDiff = std::max(maxDiff, diff);
+  }
+  return {roundDown(minSum), roundUp(maxSum), roundDown(minDiff),
+          roundUp(maxDiff)};
+}
+
+// Box of axis (ux, uy) containing all the points
+OrientedBox fitOrientedBox(const std::vector<Point>& points, double ux,
+                           double uy) {
+  double minU = std::numeric_limits<double>::infinity();
+  double maxU = -minU;
+  double minV = minU;
+  double maxV = -minU;
+  for (const auto& pt : points) {
+    double u = ux * pt.x + uy * pt.y;
+    double v = ux * pt.y - uy * pt.x;
+    minU = std::min(minU, u);
+    maxU = std::max(maxU, u);
+    minV = std::min(minV, v);
+    maxV = std::max(maxV, v);
+  }
+  double centerU = 0.5 * (minU + maxU);
+  double centerV = 0.5 * (minV + maxV);
+  OrientedBox box;
+  box.cx = ux * centerU - uy * centerV;
+  box.cy = uy * centerU + ux * centerV;
+  box.ux = ux;
+  box.uy = uy;
+  double tolerance =
+      ORIENTED_BOX_TOLERANCE * (std::fabs(centerU) + std::fabs(centerV) +
+                                (maxU - minU) + (maxV - minV));
+  box.halfU = 0.5 * (maxU - minU) + tolerance;
+  box.halfV = 0.5 * (maxV - minV) + tolerance;
+  return box;
+}
+}  // namespace
+
+OrientedBox makeOrientedBox(const std::vector<Point>& points) {
+  std::size_t n = points.size();
+  if (n == 0) {
+    constexpr double INF = std::numeric_limits<double>::infinity();
+    return {0.0, 0.0, 1.0, 0.0, INF, INF};
+  }
+  double bestUx = 1.0;
+  double bestUy = 0.0;
+  double bestArea = std::numeric_limits<double>::infinity();
+  // Either orientation works, the extreme vertices of the successive edge
+  // directions always come in the order of the vertices
+  std::size_t maxAlong = 0;
+  std::size_t minAlong = 0;
+  std::size_t farthest = 0;
+  bool started = false;
+  for (std::size_t i = 0; i < n && n >= 3; i++) {
+    const Point& a = points[i];
+    const Point& b = points[(i + 1) % n];
+    double ex = static_cast<double>(b.x) - a.x;
+    double ey = static_cast<double>(b.y) - a.y;
+    // The edge isn't normalized, the projections are all scaled by its
+    // length which doesn't change which vertices are extreme
+    double squaredLength = ex * ex + ey * ey;
+    if (squaredLength == 0.0) {
+      continue;
+    }
+    auto along = [&](std::size_t k) {
+      return ex * (points[k].x - a.x) + ey * (points[k].y - a.y);
+    };
+    auto across = [&](std::size_t k) {
+      return std::fabs(ex * (points[k].y - a.y) - ey * (points[k].x - a.x));
+    };
+    auto next = [n](std::size_t k) { return k + 1 == n ? 0 : k + 1; };
+    if (!started) {
+      for (std::size_t k = 1; k < n; k++) {
+        maxAlong = along(k) > along(maxAlong) ? k : maxAlong;
+        minAlong = along(k) < along(minAlong) ? k : minAlong;
+        farthest = across(k) > across(farthest) ? k : farthest;
+      }
+      started = true;
+    } else {
+      // The steps are bounded in case of collinear vertices
+      for (std::size_t s = 0; s < n && along(next(maxAlong)) >= along(maxAlong);
+           s++) {
+        maxAlong = next(maxAlong);
+      }
+      for (std::size_t s = 0; s < n && along(next(minAlong)) <= along(minAlong);
+           s++) {
+        minAlong = next(minAlong);
+      }
+      for (std::size_t s = 0;
+           s < n && across(next(farthest)) >= across(farthest); s++) {
+        farthest = next(farthest);
+      }
+    }
+    double area =
+        (along(maxAlong) - along(minAlong)) * across(farthest) / squaredLength;
+    if (area < bestArea) {
+      bestArea = area;
+      bestUx = ex / std::sqrt(squaredLength);
+      bestUy = ey / std::sqrt(squaredLength);
+    }
+  }
+  // The calipers only choose the direction, the extents are measured on all
+  // the vertices so that the box contains them whatever the rounding
+  return fitOrientedBox(points, bestUx, bestUy);
+}
+
+BoundingVolumes::BoundingVolumes(const std::vector<ConvexHull>& convexHulls,
+                                 LeafVolume leafVolume)
+    : leafVolume(leafVolume), nbConvexHulls(convexHulls.size()) {
+  if (leafVolume == LeafVolume::KDOP8) {
+    diagonalSlabs.reserve(convexHulls.size());
+    for (const auto& convexHull : convexHulls) {
+      diagonalSlabs.push_back(makeDiagonalSlabs(convexHull.points));
+    }
+  } else if (leafVolume == LeafVolume::ORIENTED_BOX) {
+    orientedBoxes.reserve(convexHulls.size());
+    for (const auto& convexHull : convexHulls) {
+      orientedBoxes.push_back(makeOrientedBox(convexHull.points));
+    }
+  }
+}
+
+std::size_t BoundingVolumes::size() const { return nbConvexHulls; }
+
+LeafVolume BoundingVolumes::getLeafVolume() const { return leafVolume; }
+
+bool BoundingVolumes::intersect(std::size_t first, std::size_t second) const {
+  if (leafVolume == LeafVolume::KDOP8) {
+    const DiagonalSlabs& a = diagonalSlabs[first];
+    const DiagonalSlabs& b = diagonalSlabs[second];
+    return a.minSum <= b.maxSum && b.minSum <= a.maxSum &&
+           a.minDiff <= b.maxDiff && b.minDiff <= a.maxDiff;
+  }
+  if (leafVolume == LeafVolume::ORIENTED_BOX) {
+    // Separating axis test on the axes of both rectangles, an infinite
+    // extent gives NaN or infinity and never separates
+    const OrientedBox& a = orientedBoxes[first];
+    const OrientedBox& b = orientedBoxes[second];
+    double tx = b.cx - a.cx;
+    double ty = b.cy - a.cy;
+    auto radius = [](const OrientedBox& box, double lx, double ly) {
+      return box.halfU * std::fabs(box.ux * lx + box.uy * ly) +
+             box.halfV * std::fabs(box.ux * ly - box.uy * lx);
+    };
+    auto separated = [&](double lx, double ly) {
+      return std::fabs(tx * lx + ty * ly) >
+             radius(a, lx, ly) + radius(b, lx, ly);
+    };
+    return !(separated(a.ux, a.uy) || separated(-a.uy, a.ux) ||
+             separated(b.ux, b.uy) || separated(-b.uy, b.ux));
+  }
+  return true;
+}
+}  // namespace convex_hull_filtering
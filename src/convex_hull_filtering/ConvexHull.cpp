@@ -3,17 +3,19 @@
 
 #include "convex_hull_filtering/ConvexHull.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <vector>
 
 #include "convex_hull_filtering/Config.hpp"
 #include "convex_hull_filtering/Edge.hpp"
+#include "convex_hull_filtering/FixedConvexHull.hpp"
 #include "convex_hull_filtering/Point.hpp"
 
 namespace convex_hull_filtering {
 
-ConvexHull::ConvexHull(const std::vector<Point>& points, int id)
-    : id(id), points(points) {}
+ConvexHull::ConvexHull(const std::vector<Point>& points, int id, float score)
+    : id(id), score(score), points(points) {}
 
 Point ConvexHull::getCircPoint(int index) const {
   int n = points.size();
@@ -23,11 +25,25 @@ Point ConvexHull::getCircPoint(int index) const {
 }
 
 float ConvexHull::getArea() const {
+  // Same terms in the same order as computeArea, the padding only adds
+  // zeros. The plain loop is already the fastest up to 4 vertices
+  int nbPoints = points.size();
+  if (nbPoints <= 4) {
+    return computeArea(points);
+  } else if (nbPoints <= 8) {
+    return FixedConvexHull<8>::computeArea(points.data(), nbPoints);
+  } else if (nbPoints <= 16) {
+    return FixedConvexHull<16>::computeArea(points.data(), nbPoints);
+  }
+  return computeArea(points);
+}
+
+float ConvexHull::computeArea(const std::vector<Point>& points) {
   std::size_t nbPointsP = points.size();
   float area = 0.0f;
   for (std::size_t i = 1; i <= nbPointsP; i++) {
-    Point p = getCircPoint(i);
-    Point pm = getCircPoint(i - 1);
+    const Point& p = points[i % nbPointsP];
+    const Point& pm = points[i - 1];
     area += (pm.x + p.x) * (pm.y - p.y);
   }
   return std::fabs(0.5f * area);
@@ -41,29 +57,26 @@ bool ConvexHull::isPointInside(const Point& pt) const {
     Edge pDot(getCircPoint(i - 1), getCircPoint(i));
     sumAngles += pDot.getAngle(pt);
   }
-  // if the sum of the angles is not zero then the point is outside
-  return std::fabs(sumAngles) > EPSILON;
+  // if the sum of the angles is not zero then the point is inside. Every
+  // atan2 is rounded, so the sum for a point outside is only zero up to an
+  // error that grows with the number of edges
+  return std::fabs(sumAngles) > nbPointsP * EPSILON;
 }
 
-std::tuple<char, bool, Point> ConvexHull::advance(const Edge& pDot,
-                                                  const Edge& qDot,
-                                                  char inside) const {
-  bool addPoint = false;
-  Point pointToAdd;
+char ConvexHull::advance(const Edge& pDot, const Edge& qDot, char inside,
+                        std::vector<Point>* interPoints) const {
   char whichToAdvance = NOT_INIT;
 
   auto advanceP = [&]() {
     if (inside == P_POLY) {
-      pointToAdd = pDot.e;
-      addPoint = true;
+      interPoints->push_back(pDot.e);
     }
     whichToAdvance = P_POLY;
   };
 
   auto advanceQ = [&]() {
     if (inside == Q_POLY) {
-      pointToAdd = qDot.e;
-      addPoint = true;
+      interPoints->push_back(qDot.e);
     }
     whichToAdvance = Q_POLY;
   };
@@ -82,24 +95,54 @@ std::tuple<char, bool, Point> ConvexHull::advance(const Edge& pDot,
     }
   }
 
-  return std::make_tuple(whichToAdvance, addPoint, pointToAdd);
+  return whichToAdvance;
 }
 
 std::pair<bool, ConvexHull> ConvexHull::intersection(
     const ConvexHull& Q) const {
+  std::vector<Point> interConvexHullPoints;
+  char whole;
+  bool inter = intersection(Q, &interConvexHullPoints, &whole);
+  // A whole convex hull comes back as is, with its id and score
+  if (whole == P_POLY) {
+    return std::make_pair(inter, *this);
+  }
+  if (whole == Q_POLY) {
+    return std::make_pair(inter, Q);
+  }
+  return std::make_pair(inter, ConvexHull(interConvexHullPoints));
+}
+
+bool ConvexHull::intersection(const ConvexHull& Q,
+                              std::vector<Point>* interPoints) const {
+  char whole;
+  return intersection(Q, interPoints, &whole);
+}
+
+bool ConvexHull::intersection(const ConvexHull& Q,
+                              std::vector<Point>* interPoints,
+                              char* whole) const {
   std::size_t nbPointsP = points.size();
   std::size_t nbPointsQ = Q.points.size();
 
+  // Each step of the scan adds at most two points, reserving for the worst
+  // case up front guarantees push_back never reallocates during the scan
+  interPoints->clear();
+  interPoints->reserve(4 * (nbPointsP + nbPointsQ));
+
   // TODO(Remi KEAT) : Check and handle all the edge cases (Point, Segment)
+  *whole = NOT_INIT;
   if (nbPointsP < 3 || nbPointsQ < 3) {
-    return std::make_pair(false, *this);
+    interPoints->assign(points.begin(), points.end());
+    *whole = P_POLY;
+    return false;
   }
 
-  std::vector<Point> interConvexHullPoints;
   int curIdxP = 1;
   int curIdxQ = 1;
   int firstInterPtFoundNStepAgo = -1;
   Point firstInterPt;
+  Point interPt;
   char inside = NOT_INIT;
 
   // The direction of scanning the edges should leave the convex hull on it left
@@ -108,19 +151,21 @@ std::pair<bool, ConvexHull> ConvexHull::intersection(
   int Qdirection =
       Edge(Q.points[0], Q.points[1]).belongToHalfPlane(Q.points[2]) ? 1 : -1;
 
-  for (std::size_t i = 0; i < 2 * (nbPointsP + nbPointsQ); i++) {
+  // Every crossing is met within 2 * (n + m) steps, then coming back to
+  // the first one can take as many again when it was only met late
+  std::size_t nbSteps = 2 * (nbPointsP + nbPointsQ);
+  for (std::size_t i = 0; i < nbSteps; i++) {
     // Check to see if pDot and qDot intersect
     Point p = getCircPoint(curIdxP);
     Point q = Q.getCircPoint(curIdxQ);
     Edge pDot(getCircPoint(curIdxP - Pdirection), p);
     Edge qDot(Q.getCircPoint(curIdxQ - Qdirection), q);
-    auto [inter, interPt] = pDot.checkIntersection(qDot);
 
-    if (inter) {
+    if (pDot.checkIntersection(qDot, &interPt)) {
       if (firstInterPtFoundNStepAgo > 0 && (firstInterPt == interPt)) {
-        return std::make_pair(true, ConvexHull(interConvexHullPoints));
+        return true;
       } else {
-        interConvexHullPoints.push_back(interPt);
+        interPoints->push_back(interPt);
         // Set inside
         if (qDot.belongToHalfPlane(p)) {
           inside = P_POLY;
@@ -130,30 +175,60 @@ std::pair<bool, ConvexHull> ConvexHull::intersection(
       }
       if (firstInterPtFoundNStepAgo < 0) {
         firstInterPt = interPt;
+        nbSteps = i + 2 * (nbPointsP + nbPointsQ);
       }
       firstInterPtFoundNStepAgo++;
     }
 
     // Advance either p or q
-    auto [whichToAdvance, addPoint, pointToAdd] = advance(pDot, qDot, inside);
+    char whichToAdvance = advance(pDot, qDot, inside, interPoints);
     if (whichToAdvance == P_POLY) {
       curIdxP += Pdirection;
     }
     if (whichToAdvance == Q_POLY) {
       curIdxQ += Qdirection;
     }
-    if (addPoint) {
-      interConvexHullPoints.push_back(pointToAdd);
-    }
   }
 
   // Either there is no intersection or P is included in Q or the opposite
   if (Q.isPointInside(getCircPoint(0))) {
-    return std::make_pair(true, *this);
+    interPoints->assign(points.begin(), points.end());
+    *whole = P_POLY;
+    return true;
   } else if (isPointInside(Q.getCircPoint(0))) {
-    return std::make_pair(true, Q);
+    interPoints->assign(Q.points.begin(), Q.points.end());
+    *whole = Q_POLY;
+    return true;
   } else {
-    return std::make_pair(false, ConvexHull(interConvexHullPoints));
+    return false;
+  }
+}
+
+bool ConvexHull::intersectionArea(const ConvexHull& Q, float* interArea,
+                                  std::vector<Point>* interPoints) const {
+  int nbPointsP = points.size();
+  int nbPointsQ = Q.points.size();
+  int maxNbPoints = std::max(nbPointsP, nbPointsQ);
+  bool inter = false;
+  bool done = false;
+  if (maxNbPoints <= 4) {
+    done = FixedConvexHull<4>::intersectionArea(
+        points.data(), nbPointsP, Q.points.data(), nbPointsQ, &inter,
+        interArea);
+  } else if (maxNbPoints <= 8) {
+    done = FixedConvexHull<8>::intersectionArea(
+        points.data(), nbPointsP, Q.points.data(), nbPointsQ, &inter,
+        interArea);
+  } else if (maxNbPoints <= 16) {
+    done = FixedConvexHull<16>::intersectionArea(
+        points.data(), nbPointsP, Q.points.data(), nbPointsQ, &inter,
+        interArea);
+  }
+  if (done) {
+    return inter;
   }
+  inter = intersection(Q, interPoints);
+  *interArea = inter ? computeArea(*interPoints) : 0.0f;
+  return inter;
 }
 }  // namespace convex_hull_filtering
@@ -33,7 +33,14 @@ float Edge::getAngle(const Point& pt) const {
 }
 
 std::pair<bool, Point> Edge::checkIntersection(const Edge& qDot) const {
-  auto [qm, q] = qDot;
+  Point interPt = e;
+  bool inter = checkIntersection(qDot, &interPt);
+  return std::make_pair(inter, interPt);
+}
+
+bool Edge::checkIntersection(const Edge& qDot, Point* interPt) const {
+  const Point& qm = qDot.em;
+  const Point& q = qDot.e;
   // Solve for em + ke * (e - em) == qm + kq * (q - qm)
   // ie ke * (e - em) - kq * (q - qm) == qm - em
   // ie ke * (e.x - em.x) - kq * (q.x - qm.x) == qm.x - em.x
@@ -46,11 +53,12 @@ std::pair<bool, Point> Edge::checkIntersection(const Edge& qDot) const {
     float ke = (rhsx * (q.y - qm.y) - rhsy * (q.x - qm.x)) / det;
     float kq = -((e.x - em.x) * rhsy - (e.y - em.y) * rhsx) / det;
     if (0.0f <= ke && ke <= 1.0f && 0.0f <= kq && kq <= 1.0f) {
-      return std::make_pair(
-          true, Point(em.x + ke * (e.x - em.x), em.y + ke * (e.y - em.y)));
+      interPt->x = em.x + ke * (e.x - em.x);
+      interPt->y = em.y + ke * (e.y - em.y);
+      return true;
     }
   }
-  return std::make_pair(false, e);
+  return false;
 }
 
 bool Edge::belongToHalfPlane(const Point& pt) const {
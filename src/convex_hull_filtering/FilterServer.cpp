@@ -0,0 +1,432 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/FilterServer.hpp"
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// The headers are sent as they are in memory
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The messages need a little endian host");
+static_assert(sizeof(MessageHeader) == 16, "Unexpected header layout");
+
+// A client that stops reading its responses is dropped after this long
+// instead of holding the others
+constexpr int SEND_TIMEOUT_SECONDS = 10;
+
+sockaddr_un makeAddress(const std::string& socketPath) {
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+    throw std::runtime_error("Invalid socket path " + socketPath);
+  }
+  std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+  return address;
+}
+
+// A socket left by a server that didn't stop cleanly would fail the bind.
+// Only such a socket is removed: nothing has to be listening on it, and any
+// other file at socketPath is an error rather than something to delete.
+void removeStaleSocket(const std::string& socketPath,
+                       const sockaddr_un& address) {
+  struct stat status;
+  if (lstat(socketPath.c_str(), &status) != 0) {
+    if (errno == ENOENT) {
+      return;
+    }
+    throw std::runtime_error("Couldn't check " + socketPath + " : " +
+                             std::strerror(errno));
+  }
+  if (!S_ISSOCK(status.st_mode)) {
+    throw std::runtime_error(socketPath + " exists and isn't a socket");
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    throw std::runtime_error(std::string("Couldn't create a socket : ") +
+                             std::strerror(errno));
+  }
+  int result = connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                       sizeof(address));
+  int error = errno;
+  close(fd);
+  if (result == 0) {
+    throw std::runtime_error("A server already listens on " + socketPath);
+  }
+  if (error != ECONNREFUSED) {
+    throw std::runtime_error("Couldn't check " + socketPath + " : " +
+                             std::strerror(error));
+  }
+  unlink(socketPath.c_str());
+}
+
+// Return false if the peer closed the connection before size bytes came
+bool readFully(int fd, void* data, std::size_t size) {
+  auto* bytes = static_cast<unsigned char*>(data);
+  while (size > 0) {
+    ssize_t nbRead = ::read(fd, bytes, size);
+    if (nbRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nbRead <= 0) {
+      return false;
+    }
+    bytes += nbRead;
+    size -= nbRead;
+  }
+  return true;
+}
+
+bool writeFully(int fd, const void* data, std::size_t size) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  while (size > 0) {
+    // No SIGPIPE when the peer is gone, the error is reported instead
+    ssize_t nbWritten = ::send(fd, bytes, size, MSG_NOSIGNAL);
+    if (nbWritten < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nbWritten <= 0) {
+      return false;
+    }
+    bytes += nbWritten;
+    size -= nbWritten;
+  }
+  return true;
+}
+
+bool sendMessage(int fd, const char (&magic)[4], std::uint32_t type,
+                 const void* data, std::size_t size) {
+  MessageHeader header = {};
+  std::memcpy(header.magic, magic, sizeof(header.magic));
+  header.type = type;
+  header.size = size;
+  return writeFully(fd, &header, sizeof(header)) &&
+         writeFully(fd, data, size);
+}
+
+bool sendError(int fd, const std::string& message) {
+  return sendMessage(fd, RESPONSE_MAGIC,
+                     static_cast<std::uint32_t>(ResponseStatus::ERROR),
+                     message.data(), message.size());
+}
+}  // namespace
+
+FilterServer::FilterServer(const FilterServerConfig& config)
+    : config(config), hullFilter(config.filter), listenFd(-1), nbRequests(0) {
+  if (!config.referenceFile.empty()) {
+    if (config.filter.mode != FilterMode::PAIRWISE) {
+      throw std::runtime_error("A reference needs the pairwise mode");
+    }
+    reference = loadConvexHulls(config.referenceFile);
+    referenceTree = std::make_unique<RTree>(config.filter.m, config.filter.M);
+    for (std::size_t i = 0; i < reference.size(); i++) {
+      referenceAreas.push_back(reference[i].getArea());
+      referenceTree->insertEntry(i, BoundingBox(reference[i].points));
+    }
+  }
+
+  sockaddr_un address = makeAddress(config.socketPath);
+  removeStaleSocket(config.socketPath, address);
+  listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listenFd < 0) {
+    throw std::runtime_error(std::string("Couldn't create a socket : ") +
+                             std::strerror(errno));
+  }
+  if (bind(listenFd, reinterpret_cast<const sockaddr*>(&address),
+           sizeof(address)) != 0 ||
+      listen(listenFd, SOMAXCONN) != 0) {
+    std::string error = std::strerror(errno);
+    close(listenFd);
+    throw std::runtime_error("Couldn't listen on " + config.socketPath +
+                             " : " + error);
+  }
+}
+
+FilterServer::~FilterServer() {
+  close(listenFd);
+  unlink(config.socketPath.c_str());
+}
+
+std::size_t FilterServer::getNbReferenceConvexHulls() const {
+  return reference.size();
+}
+
+std::uint64_t FilterServer::getNbRequests() const { return nbRequests; }
+
+void FilterServer::run() {
+  // Requests are filtered one at a time on the warm thread pool but any
+  // number of clients can stay connected, connections[k - 1] goes with
+  // fds[k]
+  std::vector<pollfd> fds = {{listenFd, POLLIN, 0}};
+  std::vector<Connection> connections;
+  bool shutdown = false;
+  while (!shutdown) {
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error(std::string("Couldn't poll the clients : ") +
+                               std::strerror(errno));
+    }
+    for (std::size_t k = 1; k < fds.size() && !shutdown;) {
+      if (fds[k].revents != 0 && !serveClient(&connections[k - 1], &shutdown)) {
+        close(fds[k].fd);
+        fds.erase(fds.begin() + k);
+        connections.erase(connections.begin() + k - 1);
+      } else {
+        k++;
+      }
+    }
+    if (!shutdown && (fds[0].revents & POLLIN) != 0) {
+      int clientFd = accept(listenFd, nullptr, nullptr);
+      if (clientFd >= 0) {
+        timeval timeout = {SEND_TIMEOUT_SECONDS, 0};
+        setsockopt(clientFd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+                   sizeof(timeout));
+        fds.push_back({clientFd, POLLIN, 0});
+        Connection connection;
+        connection.fd = clientFd;
+        connection.nbHeaderBytes = 0;
+        connection.nbPayloadBytes = 0;
+        connections.push_back(std::move(connection));
+      } else if (errno != EINTR && errno != ECONNABORTED) {
+        throw std::runtime_error(
+            std::string("Couldn't accept a connection : ") +
+            std::strerror(errno));
+      }
+    }
+  }
+  for (std::size_t k = 1; k < fds.size(); k++) {
+    close(fds[k].fd);
+  }
+}
+
+bool FilterServer::serveClient(Connection* connection, bool* shutdown) {
+  constexpr std::size_t HEADER_SIZE = sizeof(MessageHeader);
+  while (true) {
+    unsigned char* bytes;
+    std::size_t size;
+    if (connection->nbHeaderBytes < HEADER_SIZE) {
+      bytes = reinterpret_cast<unsigned char*>(&connection->header) +
+              connection->nbHeaderBytes;
+      size = HEADER_SIZE - connection->nbHeaderBytes;
+    } else {
+      bytes = connection->payload.data() + connection->nbPayloadBytes;
+      size = connection->payload.size() - connection->nbPayloadBytes;
+    }
+    if (size == 0) {
+      // One request per poll round, the next one waits for the other clients
+      connection->nbHeaderBytes = 0;
+      return serveRequest(*connection, shutdown);
+    }
+    ssize_t nbRead = recv(connection->fd, bytes, size, MSG_DONTWAIT);
+    if (nbRead < 0 && errno == EINTR) {
+      continue;
+    }
+    if (nbRead < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      return true;
+    }
+    if (nbRead <= 0) {
+      return false;
+    }
+    if (connection->nbHeaderBytes < HEADER_SIZE) {
+      connection->nbHeaderBytes += nbRead;
+      if (connection->nbHeaderBytes < HEADER_SIZE) {
+        continue;
+      }
+      const MessageHeader& header = connection->header;
+      if (std::memcmp(header.magic, REQUEST_MAGIC, sizeof(header.magic)) !=
+          0) {
+        sendError(connection->fd, "Not a filter request");
+        return false;
+      }
+      if (header.size > MAX_PAYLOAD_SIZE) {
+        sendError(connection->fd, "Request too large");
+        return false;
+      }
+      connection->payload.resize(header.size);
+      connection->nbPayloadBytes = 0;
+    } else {
+      connection->nbPayloadBytes += nbRead;
+    }
+  }
+}
+
+bool FilterServer::serveRequest(const Connection& connection, bool* shutdown) {
+  int clientFd = connection.fd;
+  const MessageHeader& header = connection.header;
+  const auto& payload = connection.payload;
+  nbRequests++;
+
+  try {
+    switch (static_cast<RequestType>(header.type)) {
+      case RequestType::SHUTDOWN:
+        *shutdown = true;
+        sendMessage(clientFd, RESPONSE_MAGIC,
+                    static_cast<std::uint32_t>(ResponseStatus::OK), nullptr,
+                    0);
+        return false;
+      case RequestType::BINARY:
+        decodeBinary(payload.data(), payload.size(), &batch);
+        break;
+      case RequestType::JSON:
+        batch.clear();
+        loadJson(reinterpret_cast<const char*>(payload.data()),
+                 payload.size(), [this](ConvexHull&& convexHull) {
+                   batch.push_back(std::move(convexHull));
+                 });
+        break;
+      default:
+        return sendError(clientFd, "Unknown request type " +
+                                       std::to_string(header.type));
+    }
+    keptIds = filterBatch(batch);
+  } catch (std::exception& e) {
+    return sendError(clientFd, e.what());
+  }
+  return sendMessage(clientFd, RESPONSE_MAGIC,
+                     static_cast<std::uint32_t>(ResponseStatus::OK),
+                     keptIds.data(), keptIds.size() * sizeof(std::int32_t));
+}
+
+std::vector<int> FilterServer::filterBatch(
+    const std::vector<ConvexHull>& convexHulls) {
+  auto keptIndices = hullFilter.filter(convexHulls);
+  if (referenceTree) {
+    std::vector<bool> convexHullsToRemove(convexHulls.size(), true);
+    for (int idx : keptIndices) {
+      convexHullsToRemove[idx] = false;
+    }
+    removeOverlappedByReference(convexHulls, &convexHullsToRemove);
+    keptIndices.clear();
+    for (std::size_t i = 0; i < convexHulls.size(); i++) {
+      if (!convexHullsToRemove[i]) {
+        keptIndices.push_back(i);
+      }
+    }
+  }
+  std::vector<int> ids;
+  ids.reserve(keptIndices.size());
+  for (int idx : keptIndices) {
+    ids.push_back(convexHulls[idx].id);
+  }
+  return ids;
+}
+
+void FilterServer::removeOverlappedByReference(
+    const std::vector<ConvexHull>& convexHulls,
+    std::vector<bool>* convexHullsToRemove) {
+  // Intersected and rated like NarrowPhase does with the reference convex
+  // hulls placed after the batch
+  int nbConvexHulls = convexHulls.size();
+  for (int i = 0; i < nbConvexHulls; i++) {
+    if ((*convexHullsToRemove)[i]) {
+      continue;
+    }
+    const auto& convexHull = convexHulls[i];
+    found.clear();
+    referenceTree->search(BoundingBox(convexHull.points), &found);
+    float area = convexHull.getArea();
+    for (int refIdx : found) {
+      PairOverlap overlap;
+      overlap.first = i;
+      overlap.second = nbConvexHulls + refIdx;
+      overlap.inter = convexHull.intersectionArea(
+          reference[refIdx], &overlap.interArea, &interPoints);
+      if (!overlap.inter) {
+        continue;
+      }
+      overlap.ratioFirst = overlap.interArea / area * 100;
+      overlap.ratioSecond = overlap.interArea / referenceAreas[refIdx] * 100;
+      if (hullFilter.applyRemovalRule(overlap).first) {
+        (*convexHullsToRemove)[i] = true;
+        break;
+      }
+    }
+  }
+}
+
+FilterClient::FilterClient(const std::string& socketPath) : fd(-1) {
+  sockaddr_un address = makeAddress(socketPath);
+  fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || connect(fd, reinterpret_cast<const sockaddr*>(&address),
+                        sizeof(address)) != 0) {
+    std::string error = std::strerror(errno);
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw std::runtime_error("Couldn't connect to " + socketPath + " : " +
+                             error);
+  }
+}
+
+FilterClient::~FilterClient() { close(fd); }
+
+std::vector<int> FilterClient::filter(
+    const std::vector<ConvexHull>& convexHulls, RequestType type) {
+  if (type == RequestType::JSON) {
+    std::ostringstream oss;
+    saveJson(&oss, convexHulls, false);
+    std::string document = oss.str();
+    return send(type, document.data(), document.size());
+  }
+  std::vector<unsigned char> encoded;
+  encodeBinary(convexHulls, &encoded);
+  return send(type, encoded.data(), encoded.size());
+}
+
+std::vector<int> FilterClient::send(RequestType type, const void* data,
+                                    std::size_t size) {
+  if (!sendMessage(fd, REQUEST_MAGIC, static_cast<std::uint32_t>(type), data,
+                   size)) {
+    throw std::runtime_error("Couldn't send the request");
+  }
+  MessageHeader header;
+  if (!readFully(fd, &header, sizeof(header)) ||
+      std::memcmp(header.magic, RESPONSE_MAGIC, sizeof(header.magic)) != 0 ||
+      header.size > MAX_PAYLOAD_SIZE) {
+    throw std::runtime_error("Invalid response from the server");
+  }
+  buffer.resize(header.size);
+  if (!readFully(fd, buffer.data(), buffer.size())) {
+    throw std::runtime_error("Truncated response from the server");
+  }
+  if (static_cast<ResponseStatus>(header.type) != ResponseStatus::OK) {
+    throw std::runtime_error(std::string(buffer.begin(), buffer.end()));
+  }
+  std::vector<int> ids(buffer.size() / sizeof(std::int32_t));
+  if (!ids.empty()) {
+    std::memcpy(ids.data(), buffer.data(), ids.size() * sizeof(std::int32_t));
+  }
+  return ids;
+}
+
+void FilterClient::shutdown() { send(RequestType::SHUTDOWN, nullptr, 0); }
+}  // namespace convex_hull_filtering
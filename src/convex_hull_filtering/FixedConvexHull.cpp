@@ -0,0 +1,134 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/FixedConvexHull.hpp"
+
+#include <cmath>
+
+#include "convex_hull_filtering/Config.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Shoelace formula over the first nbPoints coordinates, CAPACITY being an
+// upper bound known at compile time. The coordinates past nbPoints are
+// padded with the first point so that their terms are zero and the loop
+// always runs CAPACITY times.
+template <int CAPACITY>
+float computePaddedArea(float* x, float* y, int nbPoints) {
+  for (int i = nbPoints; i <= CAPACITY; i++) {
+    x[i] = x[0];
+    y[i] = y[0];
+  }
+  float area = 0.0f;
+  for (int i = 0; i < CAPACITY; i++) {
+    area += (x[i] + x[i + 1]) * (y[i] - y[i + 1]);
+  }
+  return std::fabs(0.5f * area);
+}
+}  // namespace
+
+template <int MAX_VERTICES>
+float FixedConvexHull<MAX_VERTICES>::computeArea(const Point* points,
+                                                 int nbPoints) {
+  if (nbPoints == 0) {
+    return 0.0f;
+  }
+  float x[MAX_VERTICES + 1];
+  float y[MAX_VERTICES + 1];
+  for (int i = 0; i < nbPoints; i++) {
+    x[i] = points[i].x;
+    y[i] = points[i].y;
+  }
+  return computePaddedArea<MAX_VERTICES>(x, y, nbPoints);
+}
+
+template <int MAX_VERTICES>
+bool FixedConvexHull<MAX_VERTICES>::intersectionArea(const Point* P,
+                                                     int nbPointsP,
+                                                     const Point* Q,
+                                                     int nbPointsQ, bool* inter,
+                                                     float* interArea) {
+  if (nbPointsP < 3 || nbPointsQ < 3 || nbPointsP > MAX_VERTICES ||
+      nbPointsQ > MAX_VERTICES) {
+    return false;
+  }
+
+  // The inside of every edge of Q is on its left when Q is counterclockwise
+  // and on its right otherwise
+  float orientation = 0.0f;
+  for (int i = 0; i < nbPointsQ; i++) {
+    const Point& a = Q[i];
+    const Point& b = Q[i + 1 < nbPointsQ ? i + 1 : 0];
+    orientation += a.x * b.y - a.y * b.x;
+  }
+  if (std::fabs(orientation) <= EPSILON) {
+    return false;
+  }
+  float sign = orientation > 0.0f ? 1.0f : -1.0f;
+
+  // The clipped polygon goes back and forth between the two buffers, one
+  // more slot is kept for the padding of computePaddedArea
+  float x[2][MAX_INTER_VERTICES + 1];
+  float y[2][MAX_INTER_VERTICES + 1];
+  float dist[MAX_INTER_VERTICES];
+  int cur = 0;
+  int nbPoints = nbPointsP;
+  for (int i = 0; i < nbPointsP; i++) {
+    x[cur][i] = P[i].x;
+    y[cur][i] = P[i].y;
+  }
+
+  for (int edgeIdx = 0; edgeIdx < nbPointsQ && nbPoints > 0; edgeIdx++) {
+    const Point& a = Q[edgeIdx];
+    const Point& b = Q[edgeIdx + 1 < nbPointsQ ? edgeIdx + 1 : 0];
+    float edgeX = sign * (b.x - a.x);
+    float edgeY = sign * (b.y - a.y);
+    const float* curX = x[cur];
+    const float* curY = y[cur];
+    float* nextX = x[1 - cur];
+    float* nextY = y[1 - cur];
+
+    // Signed distance to the edge, scaled by its length, positive inside
+    for (int i = 0; i < nbPoints; i++) {
+      dist[i] = edgeX * (curY[i] - a.y) - edgeY * (curX[i] - a.x);
+    }
+
+    int nbNextPoints = 0;
+    for (int i = 0, prev = nbPoints - 1; i < nbPoints; prev = i++) {
+      bool isInside = dist[i] >= 0.0f;
+      if (isInside != (dist[prev] >= 0.0f)) {
+        // Only a polygon that isn't convex can need more room
+        if (nbNextPoints == MAX_INTER_VERTICES) {
+          return false;
+        }
+        float k = dist[prev] / (dist[prev] - dist[i]);
+        nextX[nbNextPoints] = curX[prev] + k * (curX[i] - curX[prev]);
+        nextY[nbNextPoints] = curY[prev] + k * (curY[i] - curY[prev]);
+        nbNextPoints++;
+      }
+      if (isInside) {
+        if (nbNextPoints == MAX_INTER_VERTICES) {
+          return false;
+        }
+        nextX[nbNextPoints] = curX[i];
+        nextY[nbNextPoints] = curY[i];
+        nbNextPoints++;
+      }
+    }
+    nbPoints = nbNextPoints;
+    cur = 1 - cur;
+  }
+
+  *inter = nbPoints >= 3;
+  *interArea = *inter ? computePaddedArea<MAX_INTER_VERTICES>(
+                            x[cur], y[cur], nbPoints)
+                      : 0.0f;
+  return true;
+}
+
+template class FixedConvexHull<4>;
+template class FixedConvexHull<8>;
+template class FixedConvexHull<16>;
+}  // namespace convex_hull_filtering
@@ -0,0 +1,371 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/HullFilter.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/OverlapBounds.hpp"
+#include "convex_hull_filtering/OverlapCache.hpp"
+#include "convex_hull_filtering/OverlapComponents.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+HullFilterConfig::HullFilterConfig()
+    : threshold(50.0f),
+      removalRule(RemovalRule::EACH_OVERLAPPED),
+      mode(FilterMode::PAIRWISE),
+      scoreSource(ScoreSource::AREA),
+      m(1),
+      M(3),
+      nbThreads(ThreadPool::getDefaultNbThreads()),
+      resolution(0.0f),
+      approximate(false),
+      overlapCacheEntries(1 << 18),
+      leafVolume(LeafVolume::BOX) {}
+
+void HullFilterObserver::onTreeBuilt(const RTree&) {}
+
+void HullFilterObserver::onCandidatePairs(
+    const std::vector<std::pair<int, int>>&) {}
+
+void HullFilterObserver::onOverlap(const PairOverlap&, bool, bool) {}
+
+void HullFilterObserver::onConvexHullKept(int) {}
+
+HullFilter::HullFilter(const HullFilterConfig& config)
+    : config(config), threadPool(config.nbThreads), instrumentation(nullptr) {}
+
+const HullFilterConfig& HullFilter::getConfig() const { return config; }
+
+void HullFilter::setInstrumentation(Instrumentation* instrumentation) {
+  this->instrumentation = instrumentation;
+}
+
+void HullFilter::count(Counter counter, std::uint64_t value) {
+  if (instrumentation != nullptr) {
+    instrumentation->add(counter, value);
+  }
+}
+
+void HullFilter::setGauge(Gauge gauge, double value) {
+  if (instrumentation != nullptr) {
+    instrumentation->set(gauge, value);
+  }
+}
+
+std::pair<bool, bool> HullFilter::applyRemovalRule(
+    const PairOverlap& overlap) const {
+  bool removeFirst = overlap.ratioFirst > config.threshold;
+  bool removeSecond = overlap.ratioSecond > config.threshold;
+  if (config.removalRule == RemovalRule::SMALLER_OF_PAIR) {
+    // The intersection is the same for both so the smaller convex hull is the
+    // one with the higher ratio, ties go to the convex hull that comes last
+    bool firstIsSmaller = overlap.ratioFirst > overlap.ratioSecond ||
+                          (overlap.ratioFirst == overlap.ratioSecond &&
+                           overlap.first > overlap.second);
+    removeFirst = removeFirst && firstIsSmaller;
+    removeSecond = removeSecond && !firstIsSmaller;
+  }
+  return std::make_pair(removeFirst, removeSecond);
+}
+
+std::vector<int> HullFilter::filter(const std::vector<ConvexHull>& convexHulls,
+                                    HullFilterObserver* observer) {
+  HullFilterObserver noObserver;
+  if (observer == nullptr) {
+    observer = &noObserver;
+  }
+
+  ScopedTimer filterTimer(instrumentation, Stage::FILTER);
+  count(Counter::CONVEX_HULLS, convexHulls.size());
+
+  // Broad phase
+  RTree rtree(config.m, config.M);
+  {
+    ScopedTimer timer(instrumentation, Stage::TREE_BUILD);
+    for (std::size_t i = 0; i < convexHulls.size(); i++) {
+      // When inserting use the index in the vector instead
+      rtree.insertEntry(i, BoundingBox(convexHulls[i].points));
+    }
+  }
+  observer->onTreeBuilt(rtree);
+
+  std::unique_ptr<QuantizedConvexHulls> quantized;
+  std::unique_ptr<OverlapBounds> overlapBounds;
+  if (config.resolution > 0.0f) {
+    quantized = std::make_unique<QuantizedConvexHulls>(convexHulls,
+                                                       config.resolution);
+  } else if (config.approximate) {
+    overlapBounds = std::make_unique<OverlapBounds>(convexHulls);
+  }
+  std::uint64_t nbCacheHits = 0;
+  std::uint64_t nbCacheMisses = 0;
+  if (!config.overlapCacheFile.empty()) {
+    // Another process holding the file leaves this run without a cache, the
+    // next run tries again
+    if (!overlapCache) {
+      overlapCache = OverlapCache::tryOpen(config.overlapCacheFile,
+                                           config.overlapCacheEntries);
+    }
+    if (overlapCache) {
+      overlapCache->beginRun();
+      nbCacheHits = overlapCache->getNbHits();
+      nbCacheMisses = overlapCache->getNbMisses();
+    }
+  }
+  auto keptIndices =
+      config.mode == FilterMode::GREEDY
+          ? filterGreedy(convexHulls, rtree, observer, quantized.get(),
+                         overlapBounds.get())
+          : filterPairwise(convexHulls, rtree, observer, quantized.get(),
+                           overlapBounds.get());
+  count(Counter::REMOVALS, convexHulls.size() - keptIndices.size());
+  if (overlapCache) {
+    count(Counter::CACHE_HITS, overlapCache->getNbHits() - nbCacheHits);
+    count(Counter::CACHE_MISSES, overlapCache->getNbMisses() - nbCacheMisses);
+  }
+  return keptIndices;
+}
+
+std::vector<std::pair<int, int>> HullFilter::findCandidatePairs(
+    const std::vector<ConvexHull>& convexHulls, const RTree& rtree) {
+  std::vector<std::pair<int, int>> pairs;
+  if (config.leafVolume == LeafVolume::BOX) {
+    rtree.findPairwiseIntersections(&pairs);
+    return pairs;
+  }
+  BoundingVolumes volumes(convexHulls, config.leafVolume);
+  count(Counter::REJECTED_PAIRS,
+        rtree.findPairwiseIntersections(&pairs, volumes));
+  return pairs;
+}
+
+std::vector<int> HullFilter::filterPairwise(
+    const std::vector<ConvexHull>& convexHulls, const RTree& rtree,
+    HullFilterObserver* observer, const QuantizedConvexHulls* quantized,
+    const OverlapBounds* overlapBounds) {
+  std::vector<std::pair<int, int>> pairwiseIntersections;
+  {
+    ScopedTimer timer(instrumentation, Stage::BROAD_PHASE);
+    pairwiseIntersections = findCandidatePairs(convexHulls, rtree);
+    // Once every pair up to a given lower index is checked, the fate of all
+    // the convex hulls before that index is known and they can be handed over
+    auto lowerIndex = [](const std::pair<int, int>& pair) {
+      return std::min(pair.first, pair.second);
+    };
+    std::stable_sort(pairwiseIntersections.begin(),
+                     pairwiseIntersections.end(),
+                     [&lowerIndex](const auto& a, const auto& b) {
+                       return lowerIndex(a) < lowerIndex(b);
+                     });
+  }
+  count(Counter::CANDIDATE_PAIRS, pairwiseIntersections.size());
+  observer->onCandidatePairs(pairwiseIntersections);
+
+  // Narrow phase
+  std::vector<bool> convexHullsToRemove(convexHulls.size(), false);
+  std::vector<int> keptIndices;
+  int nbDecided = 0;
+  auto decideUpTo = [&](int end) {
+    for (; nbDecided < end; nbDecided++) {
+      if (!convexHullsToRemove[nbDecided]) {
+        keptIndices.push_back(nbDecided);
+        observer->onConvexHullKept(nbDecided);
+      }
+    }
+  };
+  auto markToRemove = [&](const PairOverlap& overlap) {
+    decideUpTo(std::min(overlap.first, overlap.second));
+    if (!overlap.exact) {
+      count(Counter::BOUNDED_PAIRS, 1);
+    }
+    if (!overlap.inter) {
+      return;
+    }
+    count(Counter::INTERSECTIONS, 1);
+    auto [removeFirst, removeSecond] = applyRemovalRule(overlap);
+    if (removeFirst) {
+      convexHullsToRemove[overlap.first] = true;
+    }
+    if (removeSecond) {
+      convexHullsToRemove[overlap.second] = true;
+    }
+    observer->onOverlap(overlap, removeFirst, removeSecond);
+  };
+  // Removals are never undone so a pair can't change anything once both of
+  // its convex hulls are removed
+  auto bothRemoved = [&](int first, int second) {
+    return convexHullsToRemove[first] && convexHullsToRemove[second];
+  };
+  {
+    ScopedTimer timer(instrumentation, Stage::NARROW_PHASE);
+    NarrowPhase narrowPhase(convexHulls, &threadPool, quantized);
+    narrowPhase.setOverlapBounds(overlapBounds, config.threshold);
+    narrowPhase.setOverlapCache(overlapCache.get());
+    narrowPhase.computeOverlaps(pairwiseIntersections, markToRemove,
+                                bothRemoved);
+  }
+  decideUpTo(convexHulls.size());
+  return keptIndices;
+}
+
+std::vector<int> HullFilter::filterGreedy(
+    const std::vector<ConvexHull>& convexHulls, const RTree& rtree,
+    HullFilterObserver* observer, const QuantizedConvexHulls* quantized,
+    const OverlapBounds* overlapBounds) {
+  std::size_t nbConvexHulls = convexHulls.size();
+  std::vector<float> scores;
+  scores.reserve(nbConvexHulls);
+  for (const auto& convexHull : convexHulls) {
+    scores.push_back(config.scoreSource == ScoreSource::AREA
+                         ? convexHull.getArea()
+                         : convexHull.score);
+  }
+
+  // Visit by decreasing score, ties are broken by the input order
+  std::vector<int> order(nbConvexHulls);
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&scores](int a, int b) { return scores[a] > scores[b]; });
+  std::vector<std::size_t> rank(nbConvexHulls);
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    rank[order[i]] = i;
+  }
+
+  std::vector<std::pair<int, int>> pairs;
+  {
+    ScopedTimer timer(instrumentation, Stage::BROAD_PHASE);
+    pairs = findCandidatePairs(convexHulls, rtree);
+  }
+  observer->onCandidatePairs(pairs);
+
+  ScopedTimer timer(instrumentation, Stage::NARROW_PHASE);
+  // A hull can only suppress the hulls it overlaps, so the greedy pass of a
+  // connected component of the pairs doesn't depend on any other component
+  // and they are run in parallel
+  OverlapComponents components(nbConvexHulls, pairs);
+  count(Counter::COMPONENTS, components.size());
+  count(Counter::LARGEST_COMPONENT, components.getStats().maxPairs);
+  count(Counter::ISOLATED_CONVEX_HULLS, components.getStats().nbIsolated);
+  setGauge(Gauge::MEAN_COMPONENT_PAIRS, components.getStats().meanPairs);
+
+  // Each hull only lists the neighbours that come after it
+  std::vector<std::size_t> neighbourOffsets(nbConvexHulls + 1, 0);
+  std::vector<int> neighbours(pairs.size());
+  auto orient = [&rank](const std::pair<int, int>& pair) {
+    return rank[pair.first] < rank[pair.second]
+               ? pair
+               : std::make_pair(pair.second, pair.first);
+  };
+  for (const auto& pair : pairs) {
+    neighbourOffsets[orient(pair).first + 1]++;
+  }
+  std::partial_sum(neighbourOffsets.begin(), neighbourOffsets.end(),
+                   neighbourOffsets.begin());
+  {
+    std::vector<std::size_t> nextNeighbour(neighbourOffsets.begin(),
+                                           neighbourOffsets.end() - 1);
+    for (const auto& pair : pairs) {
+      auto [idx, neighbour] = orient(pair);
+      neighbours[nextNeighbour[idx]++] = neighbour;
+    }
+  }
+
+  class GreedyOverlap {
+   public:
+    PairOverlap overlap;
+    bool suppress;
+  };
+  class ThreadState {
+   public:
+    std::vector<Point> interPoints;
+    std::vector<int> order;
+    std::vector<GreedyOverlap> overlaps;
+    std::uint64_t nbCandidatePairs = 0;
+    std::uint64_t nbIntersections = 0;
+    std::uint64_t nbBoundedPairs = 0;
+  };
+  std::vector<ThreadState> threadStates(threadPool.getNbThreads());
+  // Components never share a hull so the threads write to distinct flags
+  std::vector<char> suppressed(nbConvexHulls, false);
+  NarrowPhase narrowPhase(convexHulls, &threadPool, quantized);
+  narrowPhase.setOverlapBounds(overlapBounds, config.threshold);
+  narrowPhase.setOverlapCache(overlapCache.get());
+  components.forEachComponent(
+      &threadPool, [&](std::size_t component, unsigned int threadIdx) {
+        ThreadState& state = threadStates[threadIdx];
+        const int* members = components.getConvexHulls(component);
+        state.order.assign(members,
+                           members + components.getNbConvexHulls(component));
+        std::sort(state.order.begin(), state.order.end(),
+                  [&rank](int a, int b) { return rank[a] < rank[b]; });
+        for (int idx : state.order) {
+          if (suppressed[idx]) {
+            continue;
+          }
+          // idx is kept, it can only suppress hulls that come after it
+          for (std::size_t i = neighbourOffsets[idx];
+               i < neighbourOffsets[idx + 1]; i++) {
+            int neighbour = neighbours[i];
+            if (suppressed[neighbour]) {
+              continue;
+            }
+            state.nbCandidatePairs++;
+            auto overlap =
+                narrowPhase.computeOverlap(idx, neighbour, &state.interPoints);
+            state.nbBoundedPairs += !overlap.exact;
+            if (!overlap.inter) {
+              continue;
+            }
+            state.nbIntersections++;
+            bool suppress = overlap.ratioSecond > config.threshold;
+            suppressed[neighbour] = suppress;
+            state.overlaps.push_back({overlap, suppress});
+          }
+        }
+      });
+
+  // Hand the overlaps over from the calling thread in the order of the
+  // serial pass, the overlaps of a hull all come from the same thread
+  setGauge(Gauge::SCHEDULING_EFFICIENCY,
+           components.getStats().schedulingEfficiency);
+  std::vector<GreedyOverlap> overlaps;
+  for (auto& state : threadStates) {
+    count(Counter::CANDIDATE_PAIRS, state.nbCandidatePairs);
+    count(Counter::INTERSECTIONS, state.nbIntersections);
+    count(Counter::BOUNDED_PAIRS, state.nbBoundedPairs);
+    overlaps.insert(overlaps.end(), state.overlaps.begin(),
+                    state.overlaps.end());
+  }
+  std::stable_sort(overlaps.begin(), overlaps.end(),
+                   [&rank](const GreedyOverlap& a, const GreedyOverlap& b) {
+                     return rank[a.overlap.first] < rank[b.overlap.first];
+                   });
+  for (const auto& greedyOverlap : overlaps) {
+    observer->onOverlap(greedyOverlap.overlap, false, greedyOverlap.suppress);
+  }
+
+  std::vector<int> keptIndices;
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    if (!suppressed[i]) {
+      keptIndices.push_back(i);
+      observer->onConvexHullKept(i);
+    }
+  }
+  return keptIndices;
+}
+}  // namespace convex_hull_filtering
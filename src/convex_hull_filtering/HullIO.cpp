@@ -0,0 +1,69 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/HullIO.hpp"
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+std::vector<ConvexHull> loadConvexHulls(const std::string& filePath,
+                                        unsigned int nbThreads) {
+  if (filePath == "-") {
+    return loadJson(filePath);
+  }
+  if (isBinaryFile(filePath)) {
+    return loadBinary(filePath);
+  }
+  if (nbThreads > 1) {
+    ThreadPool threadPool(nbThreads);
+    return loadJsonParallel(filePath, &threadPool);
+  }
+  return loadJson(filePath);
+}
+
+void streamConvexHulls(const std::string& filePath,
+                       const ConvexHullSink& sink) {
+  if (filePath == "-") {
+    loadJson(&std::cin, sink);
+    return;
+  }
+  if (isBinaryFile(filePath)) {
+    MappedHullFile mappedFile(filePath);
+    for (std::size_t i = 0; i < mappedFile.size(); i++) {
+      sink(mappedFile[i].toConvexHull());
+    }
+    return;
+  }
+  std::ifstream ifs(filePath);
+  if (!ifs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  loadJson(&ifs, sink);
+}
+
+void saveConvexHulls(const std::string& filePath,
+                     const std::vector<ConvexHull>& convexHulls) {
+  if (hasBinaryExtension(filePath)) {
+    saveBinary(filePath, convexHulls);
+  } else {
+    saveJson(filePath, convexHulls);
+  }
+}
+
+bool hasBinaryExtension(const std::string& filePath) {
+  const std::string extension = ".chb";
+  return filePath.size() >= extension.size() &&
+         filePath.compare(filePath.size() - extension.size(), extension.size(),
+                          extension) == 0;
+}
+}  // namespace convex_hull_filtering
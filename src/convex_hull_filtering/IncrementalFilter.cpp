@@ -0,0 +1,288 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/IncrementalFilter.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Point::operator== tolerates an epsilon, a moved convex hull has to be
+// intersected again however small the motion
+bool haveSamePoints(const std::vector<Point>& pointsA,
+                    const std::vector<Point>& pointsB) {
+  if (pointsA.size() != pointsB.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < pointsA.size(); i++) {
+    if (pointsA[i].x != pointsB[i].x || pointsA[i].y != pointsB[i].y) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The pairs are intersected by the thread pool of the IncrementalFilter, the
+// HullFilter only applies the removal rule
+HullFilterConfig getRulesConfig(HullFilterConfig config) {
+  config.nbThreads = 1;
+  return config;
+}
+}  // namespace
+
+std::uint64_t hashGeometry(const ConvexHull& convexHull) {
+  // FNV-1a over the bits of the coordinates
+  constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ULL;
+  constexpr std::uint64_t FNV_PRIME = 1099511628211ULL;
+  std::uint64_t hash = FNV_OFFSET;
+  for (const auto& point : convexHull.points) {
+    for (float coord : {point.x, point.y}) {
+      std::uint32_t bits;
+      std::memcpy(&bits, &coord, sizeof(bits));
+      hash = (hash ^ bits) * FNV_PRIME;
+    }
+  }
+  return hash;
+}
+
+IncrementalFilter::IncrementalFilter(const HullFilterConfig& config)
+    : hullFilter(getRulesConfig(config)),
+      threadPool(config.nbThreads),
+      rtree(std::make_unique<RTree>(config.m, config.M, &nodePool)),
+      nbChangedConvexHulls(0),
+      nbRemovedConvexHulls(0),
+      nbComputedPairs(0),
+      nbCachedPairs(0) {}
+
+std::size_t IncrementalFilter::getNbChangedConvexHulls() const {
+  return nbChangedConvexHulls;
+}
+
+std::size_t IncrementalFilter::getNbRemovedConvexHulls() const {
+  return nbRemovedConvexHulls;
+}
+
+std::size_t IncrementalFilter::getNbComputedPairs() const {
+  return nbComputedPairs;
+}
+
+std::size_t IncrementalFilter::getNbCachedPairs() const {
+  return nbCachedPairs;
+}
+
+void IncrementalFilter::clear() {
+  const auto& config = hullFilter.getConfig();
+  rtree = std::make_unique<RTree>(config.m, config.M, &nodePool);
+  slots.clear();
+  freeSlots.clear();
+  idToSlot.clear();
+  overlaps.clear();
+  nbChangedConvexHulls = 0;
+  nbRemovedConvexHulls = 0;
+  nbComputedPairs = 0;
+  nbCachedPairs = 0;
+}
+
+std::uint64_t IncrementalFilter::getPairKey(int a, int b) {
+  return static_cast<std::uint64_t>(std::min(a, b)) << 32 |
+         static_cast<std::uint32_t>(std::max(a, b));
+}
+
+int IncrementalFilter::allocateSlot() {
+  int slot;
+  if (freeSlots.empty()) {
+    slot = slots.size();
+    slots.emplace_back();
+  } else {
+    slot = freeSlots.back();
+    freeSlots.pop_back();
+  }
+  slots[slot].used = true;
+  return slot;
+}
+
+void IncrementalFilter::releaseSlot(int slot) {
+  slots[slot].used = false;
+  slots[slot].points.clear();
+  freeSlots.push_back(slot);
+}
+
+void IncrementalFilter::detachNeighbors(int slot) {
+  for (int neighbor : slots[slot].neighbors) {
+    auto& neighbors = slots[neighbor].neighbors;
+    auto iter = std::find(neighbors.begin(), neighbors.end(), slot);
+    *iter = neighbors.back();
+    neighbors.pop_back();
+    overlaps.erase(getPairKey(slot, neighbor));
+  }
+  slots[slot].neighbors.clear();
+}
+
+std::vector<int> IncrementalFilter::update(
+    const std::vector<ConvexHull>& frame) {
+  if (hullFilter.getConfig().mode != FilterMode::PAIRWISE) {
+    throw std::runtime_error("Only the pairwise mode can be incremental");
+  }
+  nbChangedConvexHulls = 0;
+  nbRemovedConvexHulls = 0;
+
+  std::unordered_map<int, int> frameIds;
+  frameIds.reserve(frame.size());
+  for (std::size_t i = 0; i < frame.size(); i++) {
+    if (!frameIds.emplace(frame[i].id, i).second) {
+      throw std::runtime_error("Convex hull ID " +
+                               std::to_string(frame[i].id) +
+                               " appears more than once in the frame");
+    }
+  }
+
+  // Remove the convex hulls that left
+  for (std::size_t slot = 0; slot < slots.size(); slot++) {
+    if (slots[slot].used && frameIds.count(slots[slot].id) == 0) {
+      rtree->removeEntry(slot, slots[slot].bb);
+      detachNeighbors(slot);
+      idToSlot.erase(slots[slot].id);
+      releaseSlot(slot);
+      nbRemovedConvexHulls++;
+    }
+  }
+
+  // Move the convex hulls whose points changed and add the new ones
+  std::vector<int> frameSlots(frame.size());
+  std::vector<int> changedSlots;
+  std::vector<std::pair<int, BoundingBox>> insertedEntries;
+  for (std::size_t i = 0; i < frame.size(); i++) {
+    std::uint64_t hash = hashGeometry(frame[i]);
+    auto iter = idToSlot.find(frame[i].id);
+    int slot;
+    if (iter != idToSlot.end()) {
+      slot = iter->second;
+      if (slots[slot].hash == hash &&
+          haveSamePoints(slots[slot].points, frame[i].points)) {
+        frameSlots[i] = slot;
+        continue;
+      }
+      rtree->removeEntry(slot, slots[slot].bb);
+      detachNeighbors(slot);
+    } else {
+      slot = allocateSlot();
+      slots[slot].id = frame[i].id;
+      idToSlot[frame[i].id] = slot;
+    }
+    slots[slot].hash = hash;
+    slots[slot].points = frame[i].points;
+    slots[slot].bb = BoundingBox(frame[i].points);
+    insertedEntries.push_back(std::make_pair(slot, slots[slot].bb));
+    frameSlots[i] = slot;
+    changedSlots.push_back(slot);
+  }
+  rtree->insertBatch(insertedEntries);
+  nbChangedConvexHulls = changedSlots.size();
+
+  // Find the candidate pairs of the changed convex hulls once all of them
+  // are in the tree, a pair of two changed ones is found from both sides
+  std::vector<bool> isChanged(slots.size(), false);
+  for (int slot : changedSlots) {
+    isChanged[slot] = true;
+  }
+  std::vector<int> found;
+  for (int slot : changedSlots) {
+    found.clear();
+    rtree->search(slots[slot].bb, &found);
+    for (int neighbor : found) {
+      if (neighbor == slot || (isChanged[neighbor] && neighbor < slot)) {
+        continue;
+      }
+      slots[slot].neighbors.push_back(neighbor);
+      slots[neighbor].neighbors.push_back(slot);
+      overlaps[getPairKey(slot, neighbor)].computed = false;
+    }
+  }
+
+  // Intersect the new pairs and the pairs whose order in the frame changed,
+  // the convex hull coming first is always the first operand
+  std::vector<int> slotFrames(slots.size(), -1);
+  for (std::size_t i = 0; i < frame.size(); i++) {
+    slotFrames[frameSlots[i]] = i;
+  }
+  std::vector<std::pair<int, int>> pairsToCompute;
+  for (const auto& [key, overlap] : overlaps) {
+    int frameA = slotFrames[key >> 32];
+    int frameB = slotFrames[key & 0xFFFFFFFF];
+    if (!overlap.computed || overlap.aFirst != (frameA < frameB)) {
+      pairsToCompute.push_back(
+          std::make_pair(std::min(frameA, frameB), std::max(frameA, frameB)));
+    }
+  }
+  nbComputedPairs = pairsToCompute.size();
+  nbCachedPairs = overlaps.size() - nbComputedPairs;
+  if (!pairsToCompute.empty()) {
+    // The grid is anchored on (0, 0) so a convex hull gets the same cells
+    // in every frame and the cached overlaps stay valid
+    std::unique_ptr<QuantizedConvexHulls> quantized;
+    if (hullFilter.getConfig().resolution > 0.0f) {
+      quantized = std::make_unique<QuantizedConvexHulls>(
+          frame, hullFilter.getConfig().resolution);
+    }
+    NarrowPhase narrowPhase(frame, &threadPool, quantized.get());
+    narrowPhase.computeOverlaps(
+        pairsToCompute, [&](const PairOverlap& pairOverlap) {
+          int slotFirst = frameSlots[pairOverlap.first];
+          int slotSecond = frameSlots[pairOverlap.second];
+          auto& overlap = overlaps[getPairKey(slotFirst, slotSecond)];
+          overlap.computed = true;
+          overlap.aFirst = slotFirst < slotSecond;
+          overlap.inter = pairOverlap.inter;
+          overlap.ratioA = overlap.aFirst ? pairOverlap.ratioFirst
+                                          : pairOverlap.ratioSecond;
+          overlap.ratioB = overlap.aFirst ? pairOverlap.ratioSecond
+                                          : pairOverlap.ratioFirst;
+        });
+  }
+
+  // The removals don't depend on the order of the pairs
+  std::vector<bool> convexHullsToRemove(frame.size(), false);
+  for (const auto& [key, overlap] : overlaps) {
+    if (!overlap.inter) {
+      continue;
+    }
+    PairOverlap pairOverlap;
+    pairOverlap.first = slotFrames[key >> 32];
+    pairOverlap.second = slotFrames[key & 0xFFFFFFFF];
+    pairOverlap.inter = true;
+    pairOverlap.ratioFirst = overlap.ratioA;
+    pairOverlap.ratioSecond = overlap.ratioB;
+    auto [removeFirst, removeSecond] = hullFilter.applyRemovalRule(pairOverlap);
+    if (removeFirst) {
+      convexHullsToRemove[pairOverlap.first] = true;
+    }
+    if (removeSecond) {
+      convexHullsToRemove[pairOverlap.second] = true;
+    }
+  }
+  std::vector<int> keptIndices;
+  for (std::size_t i = 0; i < frame.size(); i++) {
+    if (!convexHullsToRemove[i]) {
+      keptIndices.push_back(i);
+    }
+  }
+  return keptIndices;
+}
+}  // namespace convex_hull_filtering
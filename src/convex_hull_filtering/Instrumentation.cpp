@@ -0,0 +1,168 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/Instrumentation.hpp"
+
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace convex_hull_filtering {
+
+Instrumentation::Instrumentation()
+    : seconds(),
+      allocations(),
+      counters(),
+      gauges(),
+      allocationCounter(nullptr) {}
+
+void Instrumentation::addTime(Stage stage, double seconds) {
+  this->seconds[static_cast<int>(stage)] += seconds;
+}
+
+void Instrumentation::addAllocations(Stage stage,
+                                     std::uint64_t nbAllocations) {
+  allocations[static_cast<int>(stage)] += nbAllocations;
+}
+
+void Instrumentation::add(Counter counter, std::uint64_t value) {
+  counters[static_cast<int>(counter)] += value;
+}
+
+void Instrumentation::set(Gauge gauge, double value) {
+  gauges[static_cast<int>(gauge)] = value;
+}
+
+double Instrumentation::getSeconds(Stage stage) const {
+  return seconds[static_cast<int>(stage)];
+}
+
+std::uint64_t Instrumentation::getAllocations(Stage stage) const {
+  return allocations[static_cast<int>(stage)];
+}
+
+std::uint64_t Instrumentation::get(Counter counter) const {
+  return counters[static_cast<int>(counter)];
+}
+
+double Instrumentation::get(Gauge gauge) const {
+  return gauges[static_cast<int>(gauge)];
+}
+
+void Instrumentation::setAllocationCounter(
+    const AllocationCounter& allocationCounter) {
+  this->allocationCounter = allocationCounter;
+}
+
+std::uint64_t Instrumentation::countAllocations() const {
+  return allocationCounter ? allocationCounter() : 0;
+}
+
+void Instrumentation::writeReport(std::ostream* os) const {
+  // Written by hand to keep the core library free of the JSON dependency
+  auto formatNumber = [](double value) {
+    char buffer[32];
+    return std::string(buffer,
+                       std::to_chars(buffer, buffer + sizeof(buffer), value).ptr);
+  };
+  *os << "{\n    \"stages\": {";
+  for (int i = 0; i < static_cast<int>(Stage::COUNT); i++) {
+    *os << (i > 0 ? "," : "") << "\n        \""
+        << getName(static_cast<Stage>(i)) << "\": {\"seconds\": "
+        << formatNumber(seconds[i]) << ", \"allocations\": " << allocations[i]
+        << "}";
+  }
+  *os << "\n    },\n    \"counters\": {";
+  for (int i = 0; i < static_cast<int>(Counter::COUNT); i++) {
+    *os << (i > 0 ? "," : "") << "\n        \""
+        << getName(static_cast<Counter>(i)) << "\": " << counters[i];
+  }
+  *os << "\n    },\n    \"gauges\": {";
+  for (int i = 0; i < static_cast<int>(Gauge::COUNT); i++) {
+    *os << (i > 0 ? "," : "") << "\n        \""
+        << getName(static_cast<Gauge>(i))
+        << "\": " << formatNumber(gauges[i]);
+  }
+  *os << "\n    }\n}" << std::endl;
+}
+
+const char* Instrumentation::getName(Stage stage) {
+  switch (stage) {
+    case Stage::LOAD:
+      return "load";
+    case Stage::TREE_BUILD:
+      return "tree_build";
+    case Stage::BROAD_PHASE:
+      return "broad_phase";
+    case Stage::NARROW_PHASE:
+      return "narrow_phase";
+    case Stage::FILTER:
+      return "filter";
+    case Stage::WRITE:
+      return "write";
+    default:
+      return "unknown";
+  }
+}
+
+const char* Instrumentation::getName(Counter counter) {
+  switch (counter) {
+    case Counter::CONVEX_HULLS:
+      return "convex_hulls";
+    case Counter::CANDIDATE_PAIRS:
+      return "candidate_pairs";
+    case Counter::INTERSECTIONS:
+      return "intersections";
+    case Counter::REMOVALS:
+      return "removals";
+    case Counter::COMPONENTS:
+      return "components";
+    case Counter::LARGEST_COMPONENT:
+      return "largest_component";
+    case Counter::ISOLATED_CONVEX_HULLS:
+      return "isolated_convex_hulls";
+    case Counter::BOUNDED_PAIRS:
+      return "bounded_pairs";
+    case Counter::CACHE_HITS:
+      return "cache_hits";
+    case Counter::CACHE_MISSES:
+      return "cache_misses";
+    case Counter::REJECTED_PAIRS:
+      return "rejected_pairs";
+    case Counter::ALLOCATIONS:
+      return "allocations";
+    default:
+      return "unknown";
+  }
+}
+
+const char* Instrumentation::getName(Gauge gauge) {
+  switch (gauge) {
+    case Gauge::MEAN_COMPONENT_PAIRS:
+      return "mean_component_pairs";
+    case Gauge::SCHEDULING_EFFICIENCY:
+      return "scheduling_efficiency";
+    default:
+      return "unknown";
+  }
+}
+
+ScopedTimer::ScopedTimer(Instrumentation* instrumentation, Stage stage)
+    : instrumentation(instrumentation), stage(stage), startAllocations(0) {
+  if (instrumentation != nullptr) {
+    startAllocations = instrumentation->countAllocations();
+    start = std::chrono::steady_clock::now();
+  }
+}
+
+ScopedTimer::~ScopedTimer() {
+  if (instrumentation != nullptr) {
+    std::chrono::duration<double> elapsed =
+        std::chrono::steady_clock::now() - start;
+    instrumentation->addTime(stage, elapsed.count());
+    instrumentation->addAllocations(
+        stage, instrumentation->countAllocations() - startAllocations);
+  }
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,667 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/JsonIO.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+#include "nlohmann/json.hpp"
+
+namespace convex_hull_filtering {
+
+using json = nlohmann::json;
+
+namespace {
+// Build the convex hulls straight from the parser events, keys that are not
+// part of the format are skipped along with their value
+class ConvexHullSaxHandler : public nlohmann::json_sax<json> {
+ public:
+  // Start inside the "convex hulls" array to parse a single convex hull object
+  ConvexHullSaxHandler(const ConvexHullSink& sink, bool insideHulls)
+      : sink(sink),
+        state(insideHulls ? HULLS : OUTSIDE),
+        skipNext(false),
+        skipDepth(0),
+        expected(NONE),
+        hasId(false),
+        hasX(false),
+        hasY(false),
+        id(0),
+        score(0.0f),
+        x(0.0f),
+        y(0.0f) {}
+
+  bool null() override { return scalar(); }
+  bool boolean(bool) override { return scalar(); }
+  bool number_integer(number_integer_t val) override { return number(val); }
+  bool number_unsigned(number_unsigned_t val) override { return number(val); }
+  bool number_float(number_float_t val, const string_t&) override {
+    return number(val);
+  }
+  bool string(string_t&) override { return scalar(); }
+  bool binary(binary_t&) override { return scalar(); }
+
+  bool start_object(std::size_t) override {
+    if (skipping(1)) {
+      return true;
+    }
+    if (state == OUTSIDE) {
+      state = ROOT;
+    } else if (state == HULLS) {
+      state = HULL;
+      hasId = false;
+      score = 0.0f;
+      points.clear();
+    } else if (state == APEXES) {
+      state = APEX;
+      hasX = false;
+      hasY = false;
+    } else {
+      throw std::runtime_error("Unexpected object in convex hulls");
+    }
+    return true;
+  }
+
+  bool end_object() override {
+    if (skipping(-1)) {
+      return true;
+    }
+    if (state == APEX) {
+      if (!hasX || !hasY) {
+        throw std::runtime_error("Apex without x or y");
+      }
+      points.push_back(Point(x, y));
+      state = APEXES;
+    } else if (state == HULL) {
+      if (!hasId) {
+        throw std::runtime_error("Convex hull without ID");
+      }
+      sink(ConvexHull(points, id, score));
+      state = HULLS;
+    } else {
+      state = OUTSIDE;
+    }
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    if (skipping(1)) {
+      return true;
+    }
+    if (state == ROOT && expected == HULLS_ARRAY) {
+      state = HULLS;
+    } else if (state == HULL && expected == APEXES_ARRAY) {
+      state = APEXES;
+    } else {
+      throw std::runtime_error("Unexpected array in convex hulls");
+    }
+    expected = NONE;
+    return true;
+  }
+
+  bool end_array() override {
+    if (skipping(-1)) {
+      return true;
+    }
+    state = state == APEXES ? HULL : ROOT;
+    return true;
+  }
+
+  bool key(string_t& val) override {
+    if (skipDepth > 0) {
+      return true;
+    }
+    expected = NONE;
+    if (state == ROOT && val == "convex hulls") {
+      expected = HULLS_ARRAY;
+    } else if (state == HULL && val == "ID") {
+      expected = ID;
+    } else if (state == HULL && val == "score") {
+      expected = SCORE;
+    } else if (state == HULL && val == "apexes") {
+      expected = APEXES_ARRAY;
+    } else if (state == APEX && val == "x") {
+      expected = X;
+    } else if (state == APEX && val == "y") {
+      expected = Y;
+    } else {
+      skipNext = true;
+    }
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string&,
+                   const nlohmann::detail::exception& ex) override {
+    throw std::runtime_error(ex.what());
+  }
+
+ private:
+  enum State { OUTSIDE, ROOT, HULLS, HULL, APEXES, APEX };
+  enum Expected { NONE, HULLS_ARRAY, ID, SCORE, APEXES_ARRAY, X, Y };
+
+  // Track the value of an unknown key, nesting is +1 when an object or an
+  // array starts and -1 when it ends
+  bool skipping(int nesting) {
+    if (skipNext) {
+      skipNext = false;
+      skipDepth = nesting > 0 ? 1 : 0;
+      return true;
+    }
+    if (skipDepth > 0) {
+      skipDepth += nesting;
+      return true;
+    }
+    return false;
+  }
+
+  bool scalar() {
+    if (skipping(0)) {
+      return true;
+    }
+    if (expected != NONE || state == OUTSIDE) {
+      throw std::runtime_error("Unexpected value in convex hulls");
+    }
+    return true;
+  }
+
+  template <typename T>
+  bool number(T val) {
+    if (skipping(0)) {
+      return true;
+    }
+    switch (expected) {
+      case ID:
+        id = static_cast<int>(val);
+        hasId = true;
+        break;
+      case SCORE:
+        score = static_cast<float>(val);
+        break;
+      case X:
+        x = static_cast<float>(val);
+        hasX = true;
+        break;
+      case Y:
+        y = static_cast<float>(val);
+        hasY = true;
+        break;
+      default:
+        throw std::runtime_error("Unexpected number in convex hulls");
+    }
+    expected = NONE;
+    return true;
+  }
+
+  const ConvexHullSink& sink;
+  State state;
+  bool skipNext;
+  int skipDepth;
+  Expected expected;
+  bool hasId;
+  bool hasX;
+  bool hasY;
+  int id;
+  float score;
+  float x;
+  float y;
+  std::vector<Point> points;
+};
+
+// Read only mapping of a whole file
+class MappedText {
+ public:
+  explicit MappedText(const std::string& filePath)
+      : data(nullptr), size(0) {
+    int fd = open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Couldn't open " + filePath);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      ::close(fd);
+      throw std::runtime_error("Couldn't open " + filePath);
+    }
+    size = st.st_size;
+    if (size > 0) {
+      void* ptr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (ptr == MAP_FAILED) {
+        ::close(fd);
+        throw std::runtime_error("Couldn't map " + filePath);
+      }
+      data = static_cast<const char*>(ptr);
+      madvise(ptr, size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+  }
+  ~MappedText() {
+    if (data != nullptr) {
+      munmap(const_cast<char*>(data), size);
+    }
+  }
+  MappedText(const MappedText&) = delete;
+  MappedText& operator=(const MappedText&) = delete;
+
+  const char* data;
+  std::size_t size;
+};
+
+// [begin, end) of a convex hull object in the text
+using TextRange = std::pair<const char*, const char*>;
+
+// Find the convex hull objects of the "convex hulls" arrays of the root
+// object without parsing them, only the strings and the nesting are tracked.
+// The content of the objects is checked when they are parsed, the rest of
+// the document is checked here so that the same files are rejected as with
+// loadJson.
+std::vector<TextRange> findConvexHullRanges(const char* data,
+                                            std::size_t size) {
+  const std::string hullsKey = "\"convex hulls\"";
+  std::vector<TextRange> ranges;
+  const char* end = data + size;
+  const char* keyBegin = nullptr;  // Last string seen in the root object
+  const char* keyEnd = nullptr;
+  bool hullsKeyFound = false;
+  bool insideHulls = false;
+  const char* hullBegin = nullptr;
+  int depth = 0;
+  for (const char* p = data; p < end; p++) {
+    char c = *p;
+    if (c == '"') {
+      const char* stringBegin = p;
+      for (p++; p < end && *p != '"'; p++) {
+        if (*p == '\\') {
+          p++;
+        }
+      }
+      if (p >= end) {
+        throw std::runtime_error("Truncated convex hulls");
+      }
+      if (depth == 1) {
+        keyBegin = stringBegin;
+        keyEnd = p + 1;
+      }
+      continue;
+    }
+    if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+      continue;
+    }
+    if (insideHulls && depth == 2 && c != '{' && c != ',' && c != ']') {
+      throw std::runtime_error("Unexpected value in convex hulls");
+    }
+    switch (c) {
+      case ':':
+        hullsKeyFound = depth == 1 && keyBegin != nullptr &&
+                        hullsKey.compare(0, hullsKey.size(), keyBegin,
+                                         keyEnd - keyBegin) == 0;
+        break;
+      case ',':
+        hullsKeyFound = false;
+        break;
+      case '[':
+        insideHulls = insideHulls || (depth == 1 && hullsKeyFound);
+        hullsKeyFound = false;
+        depth++;
+        break;
+      case '{':
+        if (insideHulls && depth == 2) {
+          hullBegin = p;
+        }
+        depth++;
+        break;
+      case '}':
+      case ']':
+        depth--;
+        if (insideHulls && depth == 2 && c == '}') {
+          ranges.push_back(TextRange(hullBegin, p + 1));
+        } else if (insideHulls && depth == 1) {
+          insideHulls = false;
+        }
+        break;
+      default:
+        break;
+    }
+    if (depth < 0) {
+      throw std::runtime_error("Unbalanced brackets in convex hulls");
+    }
+  }
+  if (depth != 0) {
+    throw std::runtime_error("Truncated convex hulls");
+  }
+
+  // Parse the document with each convex hull object replaced by {}, which
+  // is short next to the objects
+  std::string skeleton;
+  const char* skeletonEnd = data;
+  for (const auto& range : ranges) {
+    skeleton.append(skeletonEnd, range.first);
+    skeleton += "{}";
+    skeletonEnd = range.second;
+  }
+  skeleton.append(skeletonEnd, end);
+  std::size_t rootBegin = skeleton.find_first_not_of(" \n\r\t");
+  if (rootBegin == std::string::npos || skeleton[rootBegin] != '{') {
+    throw std::runtime_error("The root of the convex hulls isn't an object");
+  }
+  if (!json::accept(skeleton)) {
+    throw std::runtime_error("Malformed convex hulls");
+  }
+  return ranges;
+}
+
+// Size above which the writer hands its buffer to the stream
+constexpr std::size_t FLUSH_SIZE = 1 << 16;
+// Same bounds as nlohmann::json to switch to the exponent notation
+constexpr int MIN_EXPONENT = -4;
+constexpr int MAX_EXPONENT = 15;
+
+json convertToJson(const std::vector<ConvexHull>& convexHulls) {
+  json jConvexHulls = json::array();
+  for (const auto& convexHull : convexHulls) {
+    json jApexes = json::array();
+    for (const auto& point : convexHull.points) {
+      json jPoint = {{"x", point.x}, {"y", point.y}};
+      jApexes.push_back(jPoint);
+    }
+    json jConvexHull = {{"ID", convexHull.id}, {"apexes", jApexes}};
+    if (convexHull.score != 0.0f) {
+      jConvexHull["score"] = convexHull.score;
+    }
+    jConvexHulls.push_back(jConvexHull);
+  }
+  json jRes = {{"convex hulls", jConvexHulls}};
+  return jRes;
+}
+}  // namespace
+
+std::vector<ConvexHull> loadJson(const std::string& filePath) {
+  if (filePath == "-") {
+    return loadJson(&std::cin);
+  }
+  std::ifstream ifs(filePath);
+  if (!ifs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  return loadJson(&ifs);
+}
+
+std::vector<ConvexHull> loadJson(std::istream* is) {
+  std::vector<ConvexHull> convexHulls;
+  loadJson(is, [&convexHulls](ConvexHull&& convexHull) {
+    convexHulls.push_back(std::move(convexHull));
+  });
+  return convexHulls;
+}
+
+void loadJson(std::istream* is, const ConvexHullSink& sink) {
+  ConvexHullSaxHandler handler(sink, false);
+  json::sax_parse(*is, &handler);
+}
+
+void loadJson(const char* data, std::size_t size, const ConvexHullSink& sink) {
+  ConvexHullSaxHandler handler(sink, false);
+  json::sax_parse(data, data + size, &handler);
+}
+
+std::vector<ConvexHull> loadJsonParallel(const std::string& filePath,
+                                         ThreadPool* threadPool) {
+  MappedText text(filePath);
+  auto ranges = findConvexHullRanges(text.data, text.size);
+
+  // Each range is parsed on its own into its slot to keep the input order
+  std::vector<ConvexHull> convexHulls(ranges.size(),
+                                      ConvexHull(std::vector<Point>()));
+  threadPool->parallelFor(
+      ranges.size(), 256,
+      [&](std::size_t begin, std::size_t end, unsigned int) {
+        for (std::size_t i = begin; i < end; i++) {
+          auto& convexHull = convexHulls[i];
+          ConvexHullSink sink = [&convexHull](ConvexHull&& parsed) {
+            convexHull = std::move(parsed);
+          };
+          ConvexHullSaxHandler handler(sink, true);
+          json::sax_parse(ranges[i].first, ranges[i].second, &handler);
+        }
+      });
+  return convexHulls;
+}
+
+std::vector<ConvexHull> loadJsonDom(std::istream* is) {
+  std::vector<ConvexHull> convexHulls;
+
+  json jf = json::parse(*is);
+
+  for (const auto& convexHull : jf["convex hulls"]) {
+    std::vector<Point> points;
+    points.reserve(convexHull["apexes"].size());
+    for (const auto& apexes : convexHull["apexes"]) {
+      points.push_back(Point(apexes["x"], apexes["y"]));
+    }
+    convexHulls.push_back(
+        ConvexHull(points, convexHull["ID"], convexHull.value("score", 0.0f)));
+  }
+
+  return convexHulls;
+}
+
+void saveJson(const std::string& filePath,
+              const std::vector<ConvexHull>& convexHulls, bool pretty) {
+  std::ofstream ofs(filePath, std::ios::binary);
+  if (!ofs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  saveJson(&ofs, convexHulls, pretty);
+}
+
+void saveJson(std::ostream* os, const std::vector<ConvexHull>& convexHulls,
+              bool pretty) {
+  JsonHullWriter writer(os, pretty);
+  for (const auto& convexHull : convexHulls) {
+    writer.write(convexHull);
+  }
+  writer.close();
+}
+
+void saveJsonDom(std::ostream* os, const std::vector<ConvexHull>& convexHulls) {
+  *os << std::setw(4) << convertToJson(convexHulls) << std::endl;
+}
+
+JsonHullWriter::JsonHullWriter(std::ostream* os, bool pretty)
+    : os(os), pretty(pretty), empty(true), closed(false) {
+  buffer.reserve(2 * FLUSH_SIZE);
+  buffer += '{';
+  newLine(1);
+  appendKey("convex hulls");
+  buffer += '[';
+}
+
+JsonHullWriter::~JsonHullWriter() {
+  try {
+    close();
+  } catch (...) {
+  }
+}
+
+void JsonHullWriter::write(const ConvexHull& convexHull) {
+  if (closed) {
+    throw std::runtime_error("Convex hull written after close");
+  }
+  // Keys are written in the order nlohmann::json sorts them
+  if (!empty) {
+    buffer += ',';
+  }
+  empty = false;
+  newLine(2);
+  buffer += '{';
+  newLine(3);
+  appendKey("ID");
+  char number[32];
+  buffer.append(number,
+                std::to_chars(number, number + sizeof(number), convexHull.id)
+                    .ptr);
+  buffer += ',';
+  newLine(3);
+  appendKey("apexes");
+  buffer += '[';
+  for (std::size_t i = 0; i < convexHull.points.size(); i++) {
+    if (i > 0) {
+      buffer += ',';
+    }
+    newLine(4);
+    buffer += '{';
+    newLine(5);
+    appendKey("x");
+    appendNumber(convexHull.points[i].x);
+    buffer += ',';
+    newLine(5);
+    appendKey("y");
+    appendNumber(convexHull.points[i].y);
+    newLine(4);
+    buffer += '}';
+  }
+  if (!convexHull.points.empty()) {
+    newLine(3);
+  }
+  buffer += ']';
+  if (convexHull.score != 0.0f) {
+    buffer += ',';
+    newLine(3);
+    appendKey("score");
+    appendNumber(convexHull.score);
+  }
+  newLine(2);
+  buffer += '}';
+  if (buffer.size() > FLUSH_SIZE) {
+    flush();
+  }
+}
+
+void JsonHullWriter::close() {
+  if (closed) {
+    return;
+  }
+  closed = true;
+  if (!empty) {
+    newLine(1);
+  }
+  buffer += ']';
+  newLine(0);
+  buffer += "}\n";
+  flush();
+  os->flush();
+  if (!*os) {
+    throw std::runtime_error("Couldn't write the convex hulls");
+  }
+}
+
+void JsonHullWriter::newLine(int level) {
+  if (pretty) {
+    buffer += '\n';
+    buffer.append(level * 4, ' ');
+  }
+}
+
+void JsonHullWriter::appendKey(const char* key) {
+  buffer += '"';
+  buffer += key;
+  buffer += pretty ? "\": " : "\":";
+}
+
+void JsonHullWriter::appendNumber(double value) {
+  char number[32];
+  buffer.append(number, formatJsonNumber(value, number));
+}
+
+void JsonHullWriter::flush() {
+  os->write(buffer.data(), buffer.size());
+  buffer.clear();
+}
+
+char* formatJsonNumber(double value, char* first) {
+  if (!std::isfinite(value)) {
+    std::memcpy(first, "null", 4);
+    return first + 4;
+  }
+  // Shortest digits that round trip as [-]d[.ddd]e(+|-)dd
+  char scientific[32];
+  char* end = std::to_chars(scientific, scientific + sizeof(scientific), value,
+                            std::chars_format::scientific)
+                  .ptr;
+  const char* exponentPos = std::find(scientific, end, 'e');
+  const char* p = scientific;
+  if (*p == '-') {
+    *first++ = '-';
+    p++;
+  }
+  char digits[24];
+  int k = 0;
+  for (; p != exponentPos; p++) {
+    if (*p != '.') {
+      digits[k++] = *p;
+    }
+  }
+  // value = 0.digits * 10^n, to_chars doesn't null terminate the exponent
+  int n = 0;
+  std::from_chars(exponentPos + 2, end, n);
+  n = (exponentPos[1] == '-' ? -n : n) + 1;
+
+  if (k <= n && n <= MAX_EXPONENT) {
+    // digits[000].0
+    std::memcpy(first, digits, k);
+    std::memset(first + k, '0', n - k);
+    first += n;
+    *first++ = '.';
+    *first++ = '0';
+    return first;
+  }
+  if (0 < n && n <= MAX_EXPONENT) {
+    // dig.its
+    std::memcpy(first, digits, n);
+    first[n] = '.';
+    std::memcpy(first + n + 1, digits + n, k - n);
+    return first + k + 1;
+  }
+  if (MIN_EXPONENT < n && n <= 0) {
+    // 0.[000]digits
+    *first++ = '0';
+    *first++ = '.';
+    std::memset(first, '0', -n);
+    first += -n;
+    std::memcpy(first, digits, k);
+    return first + k;
+  }
+  // d[.igits]e(+|-)dd
+  *first++ = digits[0];
+  if (k > 1) {
+    *first++ = '.';
+    std::memcpy(first, digits + 1, k - 1);
+    first += k - 1;
+  }
+  *first++ = 'e';
+  int exponent = n - 1;
+  *first++ = exponent < 0 ? '-' : '+';
+  exponent = std::abs(exponent);
+  if (exponent < 10) {
+    *first++ = '0';
+  }
+  return std::to_chars(first, first + 4, exponent).ptr;
+}
+}  // namespace convex_hull_filtering
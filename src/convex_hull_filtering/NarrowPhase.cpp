@@ -0,0 +1,208 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/NarrowPhase.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/OverlapBounds.hpp"
+#include "convex_hull_filtering/OverlapCache.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+PairOverlap::PairOverlap()
+    : first(-1),
+      second(-1),
+      inter(false),
+      interArea(0.0f),
+      ratioFirst(0.0f),
+      ratioSecond(0.0f),
+      exact(true) {}
+
+NarrowPhase::NarrowPhase(const std::vector<ConvexHull>& convexHulls,
+                         ThreadPool* threadPool,
+                         const QuantizedConvexHulls* quantizedConvexHulls)
+    : blockSize(1 << 14),
+      chunkSize(64),
+      convexHulls(convexHulls),
+      quantizedConvexHulls(quantizedConvexHulls),
+      overlapBounds(nullptr),
+      boundsThreshold(0.0f),
+      overlapCache(nullptr),
+      threadPool(threadPool),
+      scratchBuffers(threadPool->getNbThreads()) {
+  // Each area is used by every pair the convex hull belongs to
+  areas.reserve(convexHulls.size());
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    areas.push_back(quantizedConvexHulls != nullptr
+                        ? quantizedConvexHulls->getArea(i)
+                        : convexHulls[i].getArea());
+  }
+}
+
+PairOverlap NarrowPhase::computeOverlap(int first, int second,
+                                        std::vector<Point>* interPoints) const {
+  PairOverlap overlap;
+  overlap.first = first;
+  overlap.second = second;
+
+  // Always intersect in the same order so that a pair gives the exact same
+  // result whichever way it was reported by the broad phase
+  int lowIdx = std::min(first, second);
+  int highIdx = std::max(first, second);
+  // A cached overlap was computed exactly, before the bounds are tried
+  bool cached = !hashes.empty() &&
+                overlapCache->find(hashes[lowIdx], hashes[highIdx],
+                                   areas[lowIdx], areas[highIdx],
+                                   &overlap.inter, &overlap.interArea);
+  if (!cached) {
+    if (overlapBounds != nullptr && quantizedConvexHulls == nullptr &&
+        std::max(convexHulls[first].points.size(),
+                 convexHulls[second].points.size()) > NB_BOUND_DIRECTIONS &&
+        computeBoundedOverlap(lowIdx, highIdx, &overlap)) {
+      return overlap;
+    }
+    if (quantizedConvexHulls != nullptr) {
+      double interArea;
+      overlap.inter =
+          quantizedConvexHulls->intersectionArea(lowIdx, highIdx, &interArea);
+      overlap.interArea = interArea;
+    } else {
+      overlap.inter = convexHulls[lowIdx].intersectionArea(
+          convexHulls[highIdx], &overlap.interArea, interPoints);
+      if (!hashes.empty()) {
+        overlapCache->insert(hashes[lowIdx], hashes[highIdx], areas[lowIdx],
+                             areas[highIdx], overlap.inter,
+                             overlap.interArea);
+      }
+    }
+  }
+  if (overlap.inter) {
+    overlap.ratioFirst = overlap.interArea / areas[first] * 100;
+    overlap.ratioSecond = overlap.interArea / areas[second] * 100;
+  }
+  return overlap;
+}
+
+void NarrowPhase::setOverlapCache(OverlapCache* overlapCache) {
+  this->overlapCache = overlapCache;
+  hashes.clear();
+  if (overlapCache == nullptr || quantizedConvexHulls != nullptr) {
+    return;
+  }
+  hashes.reserve(convexHulls.size());
+  for (const auto& convexHull : convexHulls) {
+    hashes.push_back(hashConvexHull(convexHull));
+  }
+}
+
+void NarrowPhase::setOverlapBounds(const OverlapBounds* overlapBounds,
+                                   float threshold) {
+  this->overlapBounds = overlapBounds;
+  boundsThreshold = threshold;
+}
+
+bool NarrowPhase::computeBoundedOverlap(int lowIdx, int highIdx,
+                                        PairOverlap* overlap) const {
+  int first = overlap->first;
+  int second = overlap->second;
+  if (!(areas[first] > 0.0f && areas[second] > 0.0f)) {
+    return false;
+  }
+  float lowerArea;
+  float upperArea;
+  if (!overlapBounds->intersectionAreaBounds(lowIdx, highIdx, &lowerArea,
+                                             &upperArea)) {
+    return false;
+  }
+  upperArea = std::min({upperArea, areas[first], areas[second]});
+  // Both ratios have to be clearly on one side of the threshold
+  auto settle = [&](float area, float* ratio) {
+    float lowerRatio = lowerArea / area * 100;
+    float upperRatio = upperArea / area * 100;
+    if (lowerRatio > boundsThreshold + BOUND_MARGIN) {
+      *ratio = lowerRatio;
+      return true;
+    }
+    if (upperRatio <= boundsThreshold - BOUND_MARGIN) {
+      *ratio = upperRatio;
+      return true;
+    }
+    return false;
+  };
+  float ratioFirst;
+  float ratioSecond;
+  if (!settle(areas[first], &ratioFirst) ||
+      !settle(areas[second], &ratioSecond)) {
+    return false;
+  }
+  overlap->exact = false;
+  // Without overlap of the inner polygons the pair may not intersect at
+  // all, it is reported as such since neither convex hull can be removed
+  overlap->inter = lowerArea > 0.0f;
+  if (overlap->inter) {
+    overlap->interArea = lowerArea;
+    overlap->ratioFirst = ratioFirst;
+    overlap->ratioSecond = ratioSecond;
+  }
+  return true;
+}
+
+void NarrowPhase::computeOverlaps(const std::vector<std::pair<int, int>>& pairs,
+                                  const PairOverlapSink& sink,
+                                  const PairPredicate& skipPair) {
+  // Pairs are processed block by block to bound the memory used by the
+  // results while keeping enough work per block for all the threads
+  for (std::size_t blockBegin = 0; blockBegin < pairs.size();
+       blockBegin += blockSize) {
+    std::size_t blockEnd = std::min(blockBegin + blockSize, pairs.size());
+    blockPairs.clear();
+    for (std::size_t i = blockBegin; i < blockEnd; i++) {
+      if (!skipPair || !skipPair(pairs[i].first, pairs[i].second)) {
+        blockPairs.push_back(i);
+      }
+    }
+    block.resize(blockPairs.size());
+
+    threadPool->parallelFor(
+        block.size(), chunkSize,
+        [&](std::size_t begin, std::size_t end, unsigned int threadIdx) {
+          auto& interPoints = scratchBuffers[threadIdx];
+          for (std::size_t i = begin; i < end; i++) {
+            const auto& pair = pairs[blockPairs[i]];
+            block[i] = computeOverlap(pair.first, pair.second, &interPoints);
+          }
+        });
+
+    for (const auto& overlap : block) {
+      sink(overlap);
+    }
+  }
+}
+
+std::vector<bool> NarrowPhase::findConvexHullsToRemove(
+    const std::vector<std::pair<int, int>>& pairs, float threshold) {
+  std::vector<bool> convexHullsToRemove(convexHulls.size(), false);
+  auto markToRemove = [&](const PairOverlap& overlap) {
+    if (overlap.inter) {
+      if (overlap.ratioFirst > threshold) {
+        convexHullsToRemove[overlap.first] = true;
+      }
+      if (overlap.ratioSecond > threshold) {
+        convexHullsToRemove[overlap.second] = true;
+      }
+    }
+  };
+  // Nothing left to decide when both are already removed
+  auto bothRemoved = [&](int first, int second) {
+    return convexHullsToRemove[first] && convexHullsToRemove[second];
+  };
+  computeOverlaps(pairs, markToRemove, bothRemoved);
+  return convexHullsToRemove;
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,130 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapBounds.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/FixedConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Outer vertices closer than this fraction of the size of the convex hull
+// are merged, the tiny edge between them would have no reliable direction
+constexpr double MERGE_TOLERANCE = 1e-4;
+
+class Direction {
+ public:
+  double x;
+  double y;
+};
+
+std::vector<Direction> makeDirections() {
+  std::vector<Direction> directions(NB_BOUND_DIRECTIONS);
+  for (int i = 0; i < NB_BOUND_DIRECTIONS; i++) {
+    double angle = 2.0 * M_PI * i / NB_BOUND_DIRECTIONS;
+    directions[i] = {std::cos(angle), std::sin(angle)};
+  }
+  return directions;
+}
+}  // namespace
+
+OverlapBounds::OverlapBounds(const std::vector<ConvexHull>& convexHulls) {
+  static const std::vector<Direction> directions = makeDirections();
+  innerOffsets.reserve(convexHulls.size() + 1);
+  outerOffsets.reserve(convexHulls.size() + 1);
+  innerOffsets.push_back(0);
+  outerOffsets.push_back(0);
+  std::vector<double> supports(NB_BOUND_DIRECTIONS);
+  std::vector<bool> isExtreme;
+  for (const auto& convexHull : convexHulls) {
+    const auto& points = convexHull.points;
+    if (points.size() <= NB_BOUND_DIRECTIONS) {
+      innerPoints.insert(innerPoints.end(), points.begin(), points.end());
+      outerPoints.insert(outerPoints.end(), points.begin(), points.end());
+      innerOffsets.push_back(innerPoints.size());
+      outerOffsets.push_back(outerPoints.size());
+      continue;
+    }
+
+    // Farthest vertex and supporting line in each direction
+    isExtreme.assign(points.size(), false);
+    for (int i = 0; i < NB_BOUND_DIRECTIONS; i++) {
+      const Direction& d = directions[i];
+      std::size_t farthest = 0;
+      supports[i] = d.x * points[0].x + d.y * points[0].y;
+      for (std::size_t j = 1; j < points.size(); j++) {
+        double support = d.x * points[j].x + d.y * points[j].y;
+        if (support > supports[i]) {
+          supports[i] = support;
+          farthest = j;
+        }
+      }
+      isExtreme[farthest] = true;
+    }
+    // A subset of the vertices taken in the same order is a convex polygon
+    // inside the convex hull
+    for (std::size_t j = 0; j < points.size(); j++) {
+      if (isExtreme[j]) {
+        innerPoints.push_back(points[j]);
+      }
+    }
+    innerOffsets.push_back(innerPoints.size());
+
+    // Each vertex of the outer polygon is where two consecutive supporting
+    // lines cross, the polygon is counterclockwise
+    double width = supports[0] + supports[NB_BOUND_DIRECTIONS / 2];
+    double height = supports[NB_BOUND_DIRECTIONS / 4] +
+                    supports[3 * NB_BOUND_DIRECTIONS / 4];
+    double tolerance = MERGE_TOLERANCE * std::max(width, height);
+    std::size_t begin = outerPoints.size();
+    for (int i = 0; i < NB_BOUND_DIRECTIONS; i++) {
+      int next = (i + 1) % NB_BOUND_DIRECTIONS;
+      const Direction& a = directions[i];
+      const Direction& b = directions[next];
+      double det = a.x * b.y - a.y * b.x;
+      double x = (supports[i] * b.y - supports[next] * a.y) / det;
+      double y = (a.x * supports[next] - b.x * supports[i]) / det;
+      if (outerPoints.size() > begin &&
+          std::hypot(x - outerPoints.back().x, y - outerPoints.back().y) <=
+              tolerance) {
+        continue;
+      }
+      outerPoints.emplace_back(x, y);
+    }
+    if (outerPoints.size() - begin > 1 &&
+        std::hypot(outerPoints.back().x - outerPoints[begin].x,
+                   outerPoints.back().y - outerPoints[begin].y) <= tolerance) {
+      outerPoints.pop_back();
+    }
+    outerOffsets.push_back(outerPoints.size());
+  }
+}
+
+std::size_t OverlapBounds::size() const { return innerOffsets.size() - 1; }
+
+bool OverlapBounds::intersectionAreaBounds(std::size_t first,
+                                           std::size_t second,
+                                           float* lowerArea,
+                                           float* upperArea) const {
+  bool inter;
+  if (!FixedConvexHull<NB_BOUND_DIRECTIONS>::intersectionArea(
+          innerPoints.data() + innerOffsets[first],
+          innerOffsets[first + 1] - innerOffsets[first],
+          innerPoints.data() + innerOffsets[second],
+          innerOffsets[second + 1] - innerOffsets[second], &inter,
+          lowerArea)) {
+    return false;
+  }
+  return FixedConvexHull<NB_BOUND_DIRECTIONS>::intersectionArea(
+      outerPoints.data() + outerOffsets[first],
+      outerOffsets[first + 1] - outerOffsets[first],
+      outerPoints.data() + outerOffsets[second],
+      outerOffsets[second + 1] - outerOffsets[second], &inter, upperArea);
+}
+}  // namespace convex_hull_filtering
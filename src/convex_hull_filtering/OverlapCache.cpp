@@ -0,0 +1,272 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapCache.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+
+namespace convex_hull_filtering {
+
+static_assert(sizeof(OverlapCacheHeader) == 32, "Unexpected header layout");
+static_assert(sizeof(OverlapCacheEntry) == 40, "Unexpected slot layout");
+
+namespace {
+std::uint64_t mix(std::uint64_t h) {
+  // Finalizer of splitmix64, spreads every input bit over the whole word
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebULL;
+  h ^= h >> 31;
+  return h;
+}
+
+// At most half of the slots are used so that the probes stay short
+std::uint64_t getCapacity(std::size_t maxEntries) {
+  std::uint64_t capacity = 1;
+  while (capacity < 2 * static_cast<std::uint64_t>(maxEntries)) {
+    capacity *= 2;
+  }
+  return capacity;
+}
+
+// Return -1 when another process holds the lock of the file. The lock goes
+// with the descriptor, which isn't inherited by the processes started later
+// such as the sharded workers.
+int openLocked(const std::string& filePath, std::size_t maxEntries) {
+  if (maxEntries == 0) {
+    throw std::runtime_error("The overlap cache needs room for one entry");
+  }
+  int fd = open(filePath.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  if (fd < 0) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  if (flock(fd, LOCK_EX | LOCK_NB) != 0) {
+    int error = errno;
+    ::close(fd);
+    if (error == EWOULDBLOCK) {
+      return -1;
+    }
+    throw std::runtime_error("Couldn't lock " + filePath);
+  }
+  return fd;
+}
+}  // namespace
+
+std::uint64_t hashConvexHull(const ConvexHull& convexHull) {
+  std::uint64_t h = mix(convexHull.points.size());
+  for (const auto& pt : convexHull.points) {
+    std::uint32_t x;
+    std::uint32_t y;
+    std::memcpy(&x, &pt.x, sizeof(x));
+    std::memcpy(&y, &pt.y, sizeof(y));
+    h = mix(h ^ ((static_cast<std::uint64_t>(x) << 32) | y));
+  }
+  return h;
+}
+
+OverlapCache::OverlapCache(const std::string& filePath, std::size_t maxEntries)
+    : OverlapCache(openLocked(filePath, maxEntries), filePath, maxEntries) {}
+
+std::unique_ptr<OverlapCache> OverlapCache::tryOpen(
+    const std::string& filePath, std::size_t maxEntries) {
+  int fd = openLocked(filePath, maxEntries);
+  if (fd < 0) {
+    return nullptr;
+  }
+  return std::unique_ptr<OverlapCache>(
+      new OverlapCache(fd, filePath, maxEntries));
+}
+
+OverlapCache::OverlapCache(int fd, const std::string& filePath,
+                           std::size_t maxEntries)
+    : fd(fd),
+      filePath(filePath),
+      maxEntries(maxEntries),
+      mapping(nullptr),
+      mappingSize(0),
+      header(nullptr),
+      slots(nullptr),
+      nbHits(0),
+      nbMisses(0),
+      nbEvicted(0) {
+  if (fd < 0) {
+    throw std::runtime_error(filePath + " is used by another process");
+  }
+  mappingSize = sizeof(OverlapCacheHeader) +
+                getCapacity(maxEntries) * sizeof(OverlapCacheEntry);
+  struct stat st;
+  bool reuse = fstat(fd, &st) == 0 &&
+               static_cast<std::size_t>(st.st_size) == mappingSize;
+  try {
+    map(!reuse);
+  } catch (...) {
+    ::close(fd);
+    throw;
+  }
+}
+
+void OverlapCache::map(bool create) {
+  // Truncating first drops the old content, the slots are then read as
+  // zeros which is an empty slot. Allocating the blocks up front saves doing
+  // it on the first write of each page.
+  if (create && (ftruncate(fd, 0) != 0 ||
+                 posix_fallocate(fd, 0, mappingSize) != 0)) {
+    throw std::runtime_error("Couldn't resize " + filePath);
+  }
+  void* ptr = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                   fd, 0);
+  if (ptr == MAP_FAILED) {
+    throw std::runtime_error("Couldn't map " + filePath);
+  }
+  mapping = static_cast<unsigned char*>(ptr);
+  header = reinterpret_cast<OverlapCacheHeader*>(mapping);
+  slots = reinterpret_cast<OverlapCacheEntry*>(mapping +
+                                               sizeof(OverlapCacheHeader));
+  std::uint64_t capacity = getCapacity(maxEntries);
+  if (create || std::memcmp(header->magic, OVERLAP_CACHE_MAGIC,
+                            sizeof(header->magic)) != 0 ||
+      header->version != OVERLAP_CACHE_VERSION ||
+      header->kernelVersion != OVERLAP_CACHE_KERNEL_VERSION ||
+      header->capacity != capacity || header->nbEntries > maxEntries) {
+    // A new file is already zeroed and only gets pages once written
+    if (!create) {
+      std::memset(mapping, 0, mappingSize);
+    }
+    std::memcpy(header->magic, OVERLAP_CACHE_MAGIC, sizeof(header->magic));
+    header->version = OVERLAP_CACHE_VERSION;
+    header->kernelVersion = OVERLAP_CACHE_KERNEL_VERSION;
+    header->capacity = capacity;
+  }
+}
+
+OverlapCache::~OverlapCache() {
+  munmap(mapping, mappingSize);
+  // Closing the last descriptor of the file releases the lock
+  ::close(fd);
+}
+
+void OverlapCache::beginRun() {
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  header->run++;
+  // lastRun 0 marks the empty slots
+  if (header->run == 0) {
+    header->run = 1;
+  }
+}
+
+OverlapCacheEntry* OverlapCache::findSlot(std::uint64_t firstHash,
+                                          std::uint64_t secondHash) const {
+  // The order of the convex hulls matters since the intersection does
+  std::uint64_t mask = header->capacity - 1;
+  std::uint64_t idx = mix(firstHash ^ mix(secondHash)) & mask;
+  while (slots[idx].lastRun != 0 && (slots[idx].firstHash != firstHash ||
+                                     slots[idx].secondHash != secondHash)) {
+    idx = (idx + 1) & mask;
+  }
+  return slots + idx;
+}
+
+bool OverlapCache::find(std::uint64_t firstHash, std::uint64_t secondHash,
+                        float firstArea, float secondArea, bool* inter,
+                        float* interArea) {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  OverlapCacheEntry* slot = findSlot(firstHash, secondHash);
+  if (slot->lastRun == 0 || slot->firstArea != firstArea ||
+      slot->secondArea != secondArea) {
+    nbMisses++;
+    return false;
+  }
+  *inter = slot->inter != 0;
+  *interArea = slot->interArea;
+  // Several threads can only touch the same slot when the same pair is
+  // looked up twice in a run, they then all write the same value
+  __atomic_store_n(&slot->lastRun, header->run, __ATOMIC_RELAXED);
+  nbHits++;
+  return true;
+}
+
+void OverlapCache::insert(std::uint64_t firstHash, std::uint64_t secondHash,
+                          float firstArea, float secondArea, bool inter,
+                          float interArea) {
+  std::unique_lock<std::shared_mutex> lock(mutex);
+  if (header->run == 0) {
+    header->run = 1;
+  }
+  OverlapCacheEntry* slot = findSlot(firstHash, secondHash);
+  if (slot->lastRun == 0) {
+    if (header->nbEntries >= maxEntries) {
+      evict();
+      slot = findSlot(firstHash, secondHash);
+    }
+    header->nbEntries++;
+  }
+  slot->firstHash = firstHash;
+  slot->secondHash = secondHash;
+  slot->interArea = interArea;
+  slot->firstArea = firstArea;
+  slot->secondArea = secondArea;
+  slot->lastRun = header->run;
+  slot->inter = inter;
+}
+
+void OverlapCache::evict() {
+  // Keep the three quarters used the most recently then put them back in
+  // a cleared table, linear probing can't remove entries in place
+  std::vector<OverlapCacheEntry> entries;
+  entries.reserve(header->nbEntries);
+  for (std::uint64_t i = 0; i < header->capacity; i++) {
+    if (slots[i].lastRun != 0) {
+      entries.push_back(slots[i]);
+    }
+  }
+  std::size_t nbKept =
+      maxEntries - std::max<std::size_t>(1, maxEntries / 4);
+  if (entries.size() > nbKept) {
+    std::nth_element(entries.begin(), entries.begin() + nbKept, entries.end(),
+                     [](const OverlapCacheEntry& a,
+                        const OverlapCacheEntry& b) {
+                       return a.lastRun > b.lastRun;
+                     });
+    nbEvicted += entries.size() - nbKept;
+    entries.resize(nbKept);
+  }
+  std::memset(slots, 0, header->capacity * sizeof(OverlapCacheEntry));
+  for (const auto& entry : entries) {
+    *findSlot(entry.firstHash, entry.secondHash) = entry;
+  }
+  header->nbEntries = entries.size();
+}
+
+std::size_t OverlapCache::size() const {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  return header->nbEntries;
+}
+
+std::size_t OverlapCache::getMaxEntries() const { return maxEntries; }
+
+std::uint64_t OverlapCache::getNbHits() const { return nbHits; }
+
+std::uint64_t OverlapCache::getNbMisses() const { return nbMisses; }
+
+std::uint64_t OverlapCache::getNbEvicted() const {
+  std::shared_lock<std::shared_mutex> lock(mutex);
+  return nbEvicted;
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,165 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapComponents.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+int findRoot(std::vector<int>* parents, int idx) {
+  // Path halving: every visited node skips to its grandparent
+  while ((*parents)[idx] != idx) {
+    (*parents)[idx] = (*parents)[(*parents)[idx]];
+    idx = (*parents)[idx];
+  }
+  return idx;
+}
+}  // namespace
+
+ComponentStats::ComponentStats()
+    : nbComponents(0),
+      nbIsolated(0),
+      maxConvexHulls(0),
+      maxPairs(0),
+      meanPairs(0.0),
+      schedulingEfficiency(1.0) {}
+
+OverlapComponents::OverlapComponents(
+    std::size_t nbConvexHulls, const std::vector<std::pair<int, int>>& pairs) {
+  // Union by size so that the trees stay shallow
+  std::vector<int> parents(nbConvexHulls);
+  std::iota(parents.begin(), parents.end(), 0);
+  std::vector<std::size_t> sizes(nbConvexHulls, 1);
+  std::vector<bool> hasPair(nbConvexHulls, false);
+  for (const auto& [first, second] : pairs) {
+    hasPair[first] = true;
+    hasPair[second] = true;
+    int rootA = findRoot(&parents, first);
+    int rootB = findRoot(&parents, second);
+    if (rootA == rootB) {
+      continue;
+    }
+    if (sizes[rootA] < sizes[rootB]) {
+      std::swap(rootA, rootB);
+    }
+    parents[rootB] = rootA;
+    sizes[rootA] += sizes[rootB];
+  }
+
+  // Number the components by their lowest convex hull
+  std::vector<int> componentOf(nbConvexHulls, -1);
+  std::vector<int> rootComponents(nbConvexHulls, -1);
+  std::size_t nbComponents = 0;
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    if (!hasPair[i]) {
+      stats.nbIsolated++;
+      continue;
+    }
+    int root = findRoot(&parents, i);
+    if (rootComponents[root] < 0) {
+      rootComponents[root] = nbComponents++;
+    }
+    componentOf[i] = rootComponents[root];
+  }
+
+  // Both lists are stored one component after the other, counting them first
+  convexHullOffsets.assign(nbComponents + 1, 0);
+  pairOffsets.assign(nbComponents + 1, 0);
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    if (componentOf[i] >= 0) {
+      convexHullOffsets[componentOf[i] + 1]++;
+    }
+  }
+  for (const auto& pair : pairs) {
+    pairOffsets[componentOf[pair.first] + 1]++;
+  }
+  std::partial_sum(convexHullOffsets.begin(), convexHullOffsets.end(),
+                   convexHullOffsets.begin());
+  std::partial_sum(pairOffsets.begin(), pairOffsets.end(),
+                   pairOffsets.begin());
+  convexHulls.resize(convexHullOffsets.back());
+  pairIndices.resize(pairOffsets.back());
+  std::vector<std::size_t> nextConvexHull(convexHullOffsets.begin(),
+                                          convexHullOffsets.end() - 1);
+  std::vector<std::size_t> nextPair(pairOffsets.begin(), pairOffsets.end() - 1);
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    if (componentOf[i] >= 0) {
+      convexHulls[nextConvexHull[componentOf[i]]++] = i;
+    }
+  }
+  for (std::size_t i = 0; i < pairs.size(); i++) {
+    pairIndices[nextPair[componentOf[pairs[i].first]]++] = i;
+  }
+
+  schedule.resize(nbComponents);
+  std::iota(schedule.begin(), schedule.end(), 0);
+  std::stable_sort(schedule.begin(), schedule.end(),
+                   [this](std::size_t a, std::size_t b) {
+                     return getNbPairs(a) > getNbPairs(b);
+                   });
+
+  stats.nbComponents = nbComponents;
+  for (std::size_t i = 0; i < nbComponents; i++) {
+    stats.maxConvexHulls = std::max(stats.maxConvexHulls, getNbConvexHulls(i));
+    stats.maxPairs = std::max(stats.maxPairs, getNbPairs(i));
+  }
+  if (nbComponents > 0) {
+    stats.meanPairs = static_cast<double>(pairs.size()) / nbComponents;
+  }
+}
+
+std::size_t OverlapComponents::size() const { return schedule.size(); }
+
+const int* OverlapComponents::getConvexHulls(std::size_t component) const {
+  return convexHulls.data() + convexHullOffsets[component];
+}
+
+std::size_t OverlapComponents::getNbConvexHulls(std::size_t component) const {
+  return convexHullOffsets[component + 1] - convexHullOffsets[component];
+}
+
+const std::size_t* OverlapComponents::getPairs(std::size_t component) const {
+  return pairIndices.data() + pairOffsets[component];
+}
+
+std::size_t OverlapComponents::getNbPairs(std::size_t component) const {
+  return pairOffsets[component + 1] - pairOffsets[component];
+}
+
+const ComponentStats& OverlapComponents::getStats() const { return stats; }
+
+void OverlapComponents::forEachComponent(ThreadPool* threadPool,
+                                         const ComponentTask& task) {
+  using Clock = std::chrono::steady_clock;
+  std::vector<double> busySeconds(threadPool->getNbThreads(), 0.0);
+  auto start = Clock::now();
+  // One component at a time, they are already sorted from the largest
+  threadPool->parallelFor(
+      schedule.size(), 1,
+      [&](std::size_t begin, std::size_t end, unsigned int threadIdx) {
+        auto taskStart = Clock::now();
+        for (std::size_t i = begin; i < end; i++) {
+          task(schedule[i], threadIdx);
+        }
+        busySeconds[threadIdx] +=
+            std::chrono::duration<double>(Clock::now() - taskStart).count();
+      });
+  double wallSeconds =
+      std::chrono::duration<double>(Clock::now() - start).count();
+  double totalBusySeconds =
+      std::accumulate(busySeconds.begin(), busySeconds.end(), 0.0);
+  stats.schedulingEfficiency =
+      wallSeconds > 0.0
+          ? std::min(1.0, totalBusySeconds /
+                              (wallSeconds * threadPool->getNbThreads()))
+          : 1.0;
+}
+}  // namespace convex_hull_filtering
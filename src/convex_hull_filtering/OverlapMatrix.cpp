@@ -0,0 +1,274 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapMatrix.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+
+namespace convex_hull_filtering {
+
+// The structs are read and written as they are in memory
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "The overlap matrix format needs a little endian host");
+static_assert(sizeof(OverlapMatrixHeader) == 32, "Unexpected header layout");
+static_assert(sizeof(OverlapMatrixHull) == 16, "Unexpected hull layout");
+static_assert(sizeof(OverlapMatrixEntry) == 8, "Unexpected entry layout");
+
+namespace {
+class OverlapCollector : public HullFilterObserver {
+ public:
+  void onOverlap(const PairOverlap& overlap, bool, bool) override {
+    overlaps.push_back(overlap);
+  }
+
+  std::vector<PairOverlap> overlaps;
+};
+}  // namespace
+
+OverlapMatrix::OverlapMatrix() : rowOffsets(1, 0) {}
+
+OverlapMatrix::OverlapMatrix(const std::vector<ConvexHull>& convexHulls,
+                             const std::vector<PairOverlap>& overlaps)
+    : rowOffsets(convexHulls.size() + 1, 0) {
+  this->convexHulls.reserve(convexHulls.size());
+  for (const auto& convexHull : convexHulls) {
+    this->convexHulls.push_back(
+        {convexHull.id, convexHull.getArea(), convexHull.score, 0});
+  }
+
+  // Each intersecting pair fills the row of both of its convex hulls
+  for (const auto& overlap : overlaps) {
+    if (overlap.inter) {
+      rowOffsets[overlap.first + 1]++;
+      rowOffsets[overlap.second + 1]++;
+    }
+  }
+  std::partial_sum(rowOffsets.begin(), rowOffsets.end(), rowOffsets.begin());
+  entries.resize(rowOffsets.back());
+  std::vector<std::uint64_t> nextEntry(rowOffsets.begin(),
+                                       rowOffsets.end() - 1);
+  for (const auto& overlap : overlaps) {
+    if (overlap.inter) {
+      entries[nextEntry[overlap.first]++] = {overlap.second,
+                                             overlap.ratioFirst};
+      entries[nextEntry[overlap.second]++] = {overlap.first,
+                                              overlap.ratioSecond};
+    }
+  }
+  for (std::size_t row = 0; row < size(); row++) {
+    std::sort(entries.begin() + rowOffsets[row],
+              entries.begin() + rowOffsets[row + 1],
+              [](const OverlapMatrixEntry& a, const OverlapMatrixEntry& b) {
+                return a.column < b.column;
+              });
+  }
+}
+
+std::size_t OverlapMatrix::size() const { return convexHulls.size(); }
+
+std::size_t OverlapMatrix::getNbEntries() const { return entries.size(); }
+
+const OverlapMatrixHull& OverlapMatrix::getConvexHull(std::size_t row) const {
+  return convexHulls[row];
+}
+
+const OverlapMatrixEntry* OverlapMatrix::getRow(std::size_t row) const {
+  return entries.data() + rowOffsets[row];
+}
+
+std::size_t OverlapMatrix::getRowSize(std::size_t row) const {
+  return rowOffsets[row + 1] - rowOffsets[row];
+}
+
+float OverlapMatrix::getRatio(std::size_t row, std::size_t column) const {
+  const OverlapMatrixEntry* begin = getRow(row);
+  const OverlapMatrixEntry* end = begin + getRowSize(row);
+  const OverlapMatrixEntry* it = std::lower_bound(
+      begin, end, column,
+      [](const OverlapMatrixEntry& entry, std::size_t column) {
+        return static_cast<std::size_t>(entry.column) < column;
+      });
+  return it != end && static_cast<std::size_t>(it->column) == column
+             ? it->ratio
+             : 0.0f;
+}
+
+std::vector<int> OverlapMatrix::filter(const HullFilterConfig& config) const {
+  return config.mode == FilterMode::GREEDY
+             ? filterGreedy(config.threshold, config.scoreSource)
+             : filterPairwise(config.threshold, config.removalRule);
+}
+
+std::vector<int> OverlapMatrix::filterPairwise(float threshold,
+                                               RemovalRule removalRule) const {
+  // Removals don't depend on the order of the pairs, a convex hull is removed
+  // as soon as one of its overlaps removes it
+  std::vector<int> keptIndices;
+  for (std::size_t row = 0; row < size(); row++) {
+    const OverlapMatrixEntry* entry = getRow(row);
+    bool remove = false;
+    for (std::size_t i = 0; i < getRowSize(row) && !remove; i++) {
+      float ratio = entry[i].ratio;
+      if (!(ratio > threshold)) {
+        continue;
+      }
+      if (removalRule == RemovalRule::SMALLER_OF_PAIR) {
+        // Same tie breaking as HullFilter::applyRemovalRule
+        float otherRatio = getRatio(entry[i].column, row);
+        remove = ratio > otherRatio ||
+                 (ratio == otherRatio &&
+                  row > static_cast<std::size_t>(entry[i].column));
+      } else {
+        remove = true;
+      }
+    }
+    if (!remove) {
+      keptIndices.push_back(row);
+    }
+  }
+  return keptIndices;
+}
+
+std::vector<int> OverlapMatrix::filterGreedy(float threshold,
+                                             ScoreSource scoreSource) const {
+  std::vector<float> scores;
+  scores.reserve(size());
+  for (const auto& convexHull : convexHulls) {
+    scores.push_back(scoreSource == ScoreSource::AREA ? convexHull.area
+                                                      : convexHull.score);
+  }
+  std::vector<int> order(size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(),
+                   [&scores](int a, int b) { return scores[a] > scores[b]; });
+  std::vector<std::size_t> rank(size());
+  for (std::size_t i = 0; i < size(); i++) {
+    rank[order[i]] = i;
+  }
+
+  std::vector<char> suppressed(size(), false);
+  for (int idx : order) {
+    if (suppressed[idx]) {
+      continue;
+    }
+    const OverlapMatrixEntry* entry = getRow(idx);
+    for (std::size_t i = 0; i < getRowSize(idx); i++) {
+      int neighbour = entry[i].column;
+      if (rank[neighbour] > rank[idx] && !suppressed[neighbour] &&
+          getRatio(neighbour, idx) > threshold) {
+        suppressed[neighbour] = true;
+      }
+    }
+  }
+  std::vector<int> keptIndices;
+  for (std::size_t i = 0; i < size(); i++) {
+    if (!suppressed[i]) {
+      keptIndices.push_back(i);
+    }
+  }
+  return keptIndices;
+}
+
+void OverlapMatrix::save(const std::string& filePath) const {
+  std::ofstream ofs(filePath, std::ios::binary | std::ios::trunc);
+  if (!ofs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  OverlapMatrixHeader header = {};
+  std::memcpy(header.magic, OVERLAP_MATRIX_MAGIC, sizeof(header.magic));
+  header.version = OVERLAP_MATRIX_VERSION;
+  header.nbConvexHulls = convexHulls.size();
+  header.nbEntries = entries.size();
+  ofs.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  ofs.write(reinterpret_cast<const char*>(convexHulls.data()),
+            convexHulls.size() * sizeof(OverlapMatrixHull));
+  ofs.write(reinterpret_cast<const char*>(rowOffsets.data()),
+            rowOffsets.size() * sizeof(std::uint64_t));
+  ofs.write(reinterpret_cast<const char*>(entries.data()),
+            entries.size() * sizeof(OverlapMatrixEntry));
+  ofs.close();
+  if (!ofs) {
+    throw std::runtime_error("Couldn't write " + filePath);
+  }
+}
+
+OverlapMatrix OverlapMatrix::load(const std::string& filePath) {
+  std::ifstream ifs(filePath, std::ios::binary | std::ios::ate);
+  if (!ifs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  std::uint64_t fileSize = ifs.tellg();
+  ifs.seekg(0);
+  OverlapMatrixHeader header = {};
+  ifs.read(reinterpret_cast<char*>(&header), sizeof(header));
+  if (!ifs ||
+      std::memcmp(header.magic, OVERLAP_MATRIX_MAGIC, sizeof(header.magic)) !=
+          0 ||
+      header.version != OVERLAP_MATRIX_VERSION) {
+    throw std::runtime_error(filePath + " is not an overlap matrix file");
+  }
+  if (header.nbConvexHulls > fileSize / sizeof(OverlapMatrixHull) ||
+      header.nbEntries > fileSize / sizeof(OverlapMatrixEntry) ||
+      sizeof(header) + header.nbConvexHulls * sizeof(OverlapMatrixHull) +
+              (header.nbConvexHulls + 1) * sizeof(std::uint64_t) +
+              header.nbEntries * sizeof(OverlapMatrixEntry) >
+          fileSize) {
+    throw std::runtime_error(filePath + " is truncated");
+  }
+
+  OverlapMatrix matrix;
+  matrix.convexHulls.resize(header.nbConvexHulls);
+  matrix.rowOffsets.resize(header.nbConvexHulls + 1);
+  matrix.entries.resize(header.nbEntries);
+  ifs.read(reinterpret_cast<char*>(matrix.convexHulls.data()),
+           matrix.convexHulls.size() * sizeof(OverlapMatrixHull));
+  ifs.read(reinterpret_cast<char*>(matrix.rowOffsets.data()),
+           matrix.rowOffsets.size() * sizeof(std::uint64_t));
+  ifs.read(reinterpret_cast<char*>(matrix.entries.data()),
+           matrix.entries.size() * sizeof(OverlapMatrixEntry));
+  if (!ifs) {
+    throw std::runtime_error("Couldn't read " + filePath);
+  }
+  // The queries index with these without further checks
+  bool valid = matrix.rowOffsets.front() == 0 &&
+               matrix.rowOffsets.back() == header.nbEntries &&
+               std::is_sorted(matrix.rowOffsets.begin(),
+                              matrix.rowOffsets.end());
+  for (const auto& entry : matrix.entries) {
+    valid = valid && entry.column >= 0 &&
+            static_cast<std::uint64_t>(entry.column) < header.nbConvexHulls;
+  }
+  if (!valid) {
+    throw std::runtime_error(filePath + " has an invalid index");
+  }
+  return matrix;
+}
+
+OverlapMatrix computeOverlapMatrix(const std::vector<ConvexHull>& convexHulls,
+                                   const HullFilterConfig& config,
+                                   Instrumentation* instrumentation) {
+  // Nothing is ever removed so the pairwise filter computes and reports the
+  // overlap of every candidate pair, the bounds would depend on a threshold
+  HullFilterConfig matrixConfig = config;
+  matrixConfig.mode = FilterMode::PAIRWISE;
+  matrixConfig.threshold = std::numeric_limits<float>::infinity();
+  matrixConfig.approximate = false;
+  HullFilter hullFilter(matrixConfig);
+  hullFilter.setInstrumentation(instrumentation);
+  OverlapCollector collector;
+  hullFilter.filter(convexHulls, &collector);
+  return OverlapMatrix(convexHulls, collector.overlaps);
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,265 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Position num / den along a segment, den is always positive
+class Fraction {
+ public:
+  Fraction(std::int64_t num, std::int64_t den) : num(num), den(den) {}
+
+  std::int64_t num;
+  std::int64_t den;
+};
+
+// The products of two 63 bits integers need 128 bits to be compared exactly
+__extension__ typedef __int128 Int128;
+
+bool operator<(const Fraction& a, const Fraction& b) {
+  return static_cast<Int128>(a.num) * b.den <
+         static_cast<Int128>(b.num) * a.den;
+}
+
+std::int64_t computeDoubleArea(const QuantizedPoint* points, int nbPoints) {
+  // Coordinates are below 2^30 so no partial sum can overflow
+  std::int64_t doubleArea = 0;
+  for (int i = 0; i < nbPoints; i++) {
+    const QuantizedPoint& a = points[i];
+    const QuantizedPoint& b = points[i + 1 < nbPoints ? i + 1 : 0];
+    doubleArea += static_cast<std::int64_t>(a.x) * b.y -
+                  static_cast<std::int64_t>(a.y) * b.x;
+  }
+  return doubleArea;
+}
+
+// Line through an edge of the clipping convex hull, the distance of a point
+// to it (scaled by the length of the edge) is ex * y - ey * x - k
+class ClipLine {
+ public:
+  std::int64_t ex;
+  std::int64_t ey;
+  std::int64_t k;
+  std::int64_t dist;  // Distance of the start of the current segment
+};
+
+// Lines of up to this many edges are kept on the stack
+constexpr int MAX_STACK_LINES = 64;
+
+// Contribution of the part of ab between kIn and kOut to twice the area of
+// the intersection, coordinates are taken relative to the point o
+double computeContribution(const QuantizedPoint& o, const QuantizedPoint& a,
+                           const QuantizedPoint& b, const Fraction& kIn,
+                           const Fraction& kOut) {
+  double ax = static_cast<double>(a.x) - o.x;
+  double ay = static_cast<double>(a.y) - o.y;
+  double abx = static_cast<double>(b.x) - a.x;
+  double aby = static_cast<double>(b.y) - a.y;
+  double kInValue = static_cast<double>(kIn.num) / kIn.den;
+  double kOutValue = static_cast<double>(kOut.num) / kOut.den;
+  double ux = ax + kInValue * abx;
+  double uy = ay + kInValue * aby;
+  double vx = ax + kOutValue * abx;
+  double vy = ay + kOutValue * aby;
+  return ux * vy - uy * vx;
+}
+
+// Cyrus-Beck clipping of every edge of the convex hull S by the closed
+// counterclockwise convex hull C, return their contribution to twice the
+// area of the intersection. An edge of C on the same line as an edge of S
+// bounds nothing when it goes the same way unless sameWayInside is false,
+// and empties the edge of S when it goes the other way: both convex hulls
+// are then on either side of the line so what the two edges would add to
+// the area cancels out. The distance of each vertex of S to each line is
+// only computed once, lines must have room for nbPointsC lines.
+double clipBoundary(const QuantizedPoint* S, int nbPointsS,
+                    const QuantizedPoint* C, int nbPointsC, bool sameWayInside,
+                    const QuantizedPoint& o, ClipLine* lines) {
+  for (int j = 0; j < nbPointsC; j++) {
+    const QuantizedPoint& c = C[j];
+    const QuantizedPoint& d = C[j + 1 < nbPointsC ? j + 1 : 0];
+    ClipLine& line = lines[j];
+    line.ex = static_cast<std::int64_t>(d.x) - c.x;
+    line.ey = static_cast<std::int64_t>(d.y) - c.y;
+    line.k = line.ex * c.y - line.ey * c.x;
+    line.dist = line.ex * S[0].y - line.ey * S[0].x - line.k;
+  }
+
+  double doubleArea = 0.0;
+  for (int i = 0; i < nbPointsS; i++) {
+    const QuantizedPoint& a = S[i];
+    const QuantizedPoint& b = S[i + 1 < nbPointsS ? i + 1 : 0];
+    Fraction kIn(0, 1);
+    Fraction kOut(1, 1);
+    bool isInside = true;
+    for (int j = 0; j < nbPointsC; j++) {
+      ClipLine& line = lines[j];
+      std::int64_t distA = line.dist;
+      std::int64_t distB = line.ex * b.y - line.ey * b.x - line.k;
+      line.dist = distB;
+      if (!isInside) {
+        continue;
+      }
+      if (distA < 0 && distB < 0) {
+        isInside = false;
+      } else if (distA == 0 && distB == 0) {
+        std::int64_t dot = (static_cast<std::int64_t>(b.x) - a.x) * line.ex +
+                           (static_cast<std::int64_t>(b.y) - a.y) * line.ey;
+        isInside = dot == 0 || (dot > 0 && sameWayInside);
+      } else if (distA < 0) {
+        kIn = std::max(kIn, Fraction(-distA, distB - distA));
+      } else if (distB < 0) {
+        kOut = std::min(kOut, Fraction(distA, distA - distB));
+      }
+    }
+    // A single point of the edge inside adds nothing to the area
+    if (isInside && kIn < kOut) {
+      doubleArea += computeContribution(o, a, b, kIn, kOut);
+    }
+  }
+  return doubleArea;
+}
+}  // namespace
+
+QuantizedPoint::QuantizedPoint() : x(0), y(0) {}
+
+QuantizedPoint::QuantizedPoint(std::int32_t x, std::int32_t y) : x(x), y(y) {}
+
+bool operator==(const QuantizedPoint& ptA, const QuantizedPoint& ptB) {
+  return ptA.x == ptB.x && ptA.y == ptB.y;
+}
+
+std::int64_t orientation(const QuantizedPoint& a, const QuantizedPoint& b,
+                         const QuantizedPoint& c) {
+  return static_cast<std::int64_t>(b.x - a.x) * (c.y - a.y) -
+         static_cast<std::int64_t>(b.y - a.y) * (c.x - a.x);
+}
+
+QuantizedConvexHulls::QuantizedConvexHulls(
+    const std::vector<ConvexHull>& convexHulls, float resolution)
+    : resolution(resolution) {
+  if (!(resolution > 0.0f)) {
+    throw std::runtime_error("The resolution must be positive");
+  }
+  auto getCell = [resolution](float value) {
+    return std::llround(static_cast<double>(value) / resolution);
+  };
+  originX = std::numeric_limits<std::int64_t>::max();
+  originY = std::numeric_limits<std::int64_t>::max();
+  std::size_t nbPoints = 0;
+  for (const auto& convexHull : convexHulls) {
+    for (const auto& pt : convexHull.points) {
+      originX = std::min<std::int64_t>(originX, getCell(pt.x));
+      originY = std::min<std::int64_t>(originY, getCell(pt.y));
+    }
+    nbPoints += convexHull.points.size();
+  }
+
+  points.reserve(nbPoints);
+  offsets.reserve(convexHulls.size() + 1);
+  doubleAreas.reserve(convexHulls.size());
+  offsets.push_back(0);
+  auto quantize = [&](float value, std::int64_t originCell) {
+    std::int64_t cell = getCell(value) - originCell;
+    if (cell >= MAX_QUANTIZED_COORDINATE) {
+      throw std::runtime_error(
+          "Convex hulls span more than " +
+          std::to_string(MAX_QUANTIZED_COORDINATE) +
+          " cells, use a coarser resolution");
+    }
+    return static_cast<std::int32_t>(cell);
+  };
+  for (const auto& convexHull : convexHulls) {
+    std::size_t begin = points.size();
+    for (const auto& pt : convexHull.points) {
+      QuantizedPoint qpt(quantize(pt.x, originX), quantize(pt.y, originY));
+      // Vertices closer than a cell collapse into one
+      if (points.size() == begin || !(points.back() == qpt)) {
+        points.push_back(qpt);
+      }
+    }
+    if (points.size() - begin > 1 && points.back() == points[begin]) {
+      points.pop_back();
+    }
+    int nbHullPoints = points.size() - begin;
+    std::int64_t doubleArea =
+        computeDoubleArea(points.data() + begin, nbHullPoints);
+    if (doubleArea < 0) {
+      std::reverse(points.begin() + begin, points.end());
+      doubleArea = -doubleArea;
+    }
+    offsets.push_back(points.size());
+    doubleAreas.push_back(doubleArea);
+  }
+}
+
+std::size_t QuantizedConvexHulls::size() const { return doubleAreas.size(); }
+
+int QuantizedConvexHulls::getNbPoints(std::size_t index) const {
+  return offsets[index + 1] - offsets[index];
+}
+
+const QuantizedPoint* QuantizedConvexHulls::getPoints(std::size_t index) const {
+  return points.data() + offsets[index];
+}
+
+Point QuantizedConvexHulls::dequantize(const QuantizedPoint& pt) const {
+  return Point((originX + pt.x) * static_cast<double>(resolution),
+               (originY + pt.y) * static_cast<double>(resolution));
+}
+
+double QuantizedConvexHulls::getArea(std::size_t index) const {
+  return 0.5 * doubleAreas[index] * resolution * resolution;
+}
+
+bool QuantizedConvexHulls::intersectionArea(std::size_t first,
+                                            std::size_t second,
+                                            double* interArea) const {
+  *interArea = 0.0;
+  if (doubleAreas[first] == 0 || doubleAreas[second] == 0) {
+    return false;
+  }
+  const QuantizedPoint* P = getPoints(first);
+  const QuantizedPoint* Q = getPoints(second);
+  int nbPointsP = getNbPoints(first);
+  int nbPointsQ = getNbPoints(second);
+
+  ClipLine stackLines[MAX_STACK_LINES];
+  std::vector<ClipLine> heapLines;
+  ClipLine* lines = stackLines;
+  if (std::max(nbPointsP, nbPointsQ) > MAX_STACK_LINES) {
+    heapLines.resize(std::max(nbPointsP, nbPointsQ));
+    lines = heapLines.data();
+  }
+  // The boundary of the intersection is made of the parts of the edges of
+  // each convex hull inside the other one. Edges shared by both are only
+  // taken from P.
+  const QuantizedPoint& o = P[0];
+  double doubleArea = clipBoundary(P, nbPointsP, Q, nbPointsQ, true, o, lines) +
+                      clipBoundary(Q, nbPointsQ, P, nbPointsP, false, o, lines);
+  if (doubleArea <= 0.0) {
+    return false;
+  }
+  *interArea = 0.5 * doubleArea * resolution * resolution;
+  return true;
+}
+
+std::size_t QuantizedConvexHulls::getMemoryUsage() const {
+  return points.capacity() * sizeof(QuantizedPoint) +
+         offsets.capacity() * sizeof(std::uint32_t) +
+         doubleAreas.capacity() * sizeof(std::int64_t);
+}
+}  // namespace convex_hull_filtering
@@ -3,20 +3,165 @@
 
 #include "convex_hull_filtering/RTree.hpp"
 
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <tuple>
+#include <utility>
+#include <vector>
 
 #include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/BoundingVolumes.hpp"
 #include "convex_hull_filtering/RTreeNode.hpp"
 #include "convex_hull_filtering/Spliter.hpp"
 
 namespace convex_hull_filtering {
-RTree::RTree(unsigned int m, unsigned int M)
-    : treeRoot(std::make_unique<RTreeNode>()),
+
+namespace {
+bool contains(const BoundingBox& outer, const BoundingBox& inner) {
+  return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y &&
+         inner.max.x <= outer.max.x && inner.max.y <= outer.max.y;
+}
+
+BoundingBox getChildrenUnion(const RTreeNode& node) {
+  if (node.children.empty()) {
+    return BoundingBox();
+  }
+  BoundingBox bb = node.children.front()->bb;
+  for (const auto& child : node.children) {
+    bb = bb.getUnion(child->bb);
+  }
+  return bb;
+}
+
+// Child needing the least enlargement to include the bounding box, ties go
+// to the smallest one
+RTreeNode* chooseSubtree(const RTreeNode& N, const BoundingBox& boundingBox) {
+  RTreeNode* best = nullptr;
+  float minEnlargement = 0.0f;
+  float minArea = 0.0f;
+  for (const auto& child : N.children) {
+    float area = child->bb.getArea();
+    float enlargement = child->bb.getUnion(boundingBox).getArea() - area;
+    if (best == nullptr || enlargement < minEnlargement ||
+        (enlargement == minEnlargement && area < minArea)) {
+      best = child.get();
+      minEnlargement = enlargement;
+      minArea = area;
+    }
+  }
+  return best;
+}
+
+// Twice the coordinates of the center, enough to sort boxes
+float getCenterX(const BoundingBox& bb) { return bb.min.x + bb.max.x; }
+float getCenterY(const BoundingBox& bb) { return bb.min.y + bb.max.y; }
+
+// Position of the cell (x, y) along the Hilbert curve filling a grid of
+// HILBERT_SIZE by HILBERT_SIZE cells
+constexpr std::uint32_t HILBERT_SIZE = 1 << 16;
+
+std::uint64_t getHilbertIndex(std::uint32_t x, std::uint32_t y) {
+  std::uint64_t index = 0;
+  for (std::uint32_t s = HILBERT_SIZE / 2; s > 0; s /= 2) {
+    std::uint32_t rx = (x & s) > 0;
+    std::uint32_t ry = (y & s) > 0;
+    index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+    // Rotate the quadrant so that the curve stays continuous
+    if (ry == 0) {
+      if (rx == 1) {
+        x = HILBERT_SIZE - 1 - x;
+        y = HILBERT_SIZE - 1 - y;
+      }
+      std::swap(x, y);
+    }
+  }
+  return index;
+}
+
+void collectEntries(const RTreeNode& node,
+                    std::vector<std::pair<int, BoundingBox>>* entries) {
+  for (const auto& child : node.children) {
+    if (node.isLeaf) {
+      entries->push_back(std::make_pair(child->value, child->bb));
+    } else {
+      collectEntries(*child, entries);
+    }
+  }
+}
+
+// Call visit with the values of every pair of entries whose bounding boxes
+// intersect, a template so that visit is inlined in the traversal
+template <typename Visit>
+void forEachIntersectingEntryPair(const RTreeNode& root, const Visit& visit) {
+  // Entries of two disjoint subtrees whose bounding boxes intersect
+  std::function<void(const RTreeNode&, const RTreeNode&)> checkPair =
+      [&checkPair, &visit](const RTreeNode& nodeA, const RTreeNode& nodeB) {
+        if (!nodeA.bb.intersect(nodeB.bb)) {
+          return;
+        }
+        if (nodeA.isEntry() && nodeB.isEntry()) {
+          visit(nodeA.value, nodeB.value);
+          return;
+        }
+        // Descend into the larger node unless it is an entry
+        if (nodeB.isEntry() ||
+            (!nodeA.isEntry() && nodeA.bb.getArea() >= nodeB.bb.getArea())) {
+          for (auto& child : nodeA.children) {
+            checkPair(*child, nodeB);
+          }
+        } else {
+          for (auto& child : nodeB.children) {
+            checkPair(nodeA, *child);
+          }
+        }
+      };
+
+  // Entries of the subtree of node whose bounding boxes intersect, every
+  // node is visited even when it is the only child of its parent
+  std::function<void(const RTreeNode&)> checkNode =
+      [&checkNode, &checkPair](const RTreeNode& node) {
+        auto end = node.children.end();
+        for (auto iterI = node.children.begin(); iterI != end; ++iterI) {
+          checkNode(**iterI);
+          auto iterJ = iterI;
+          for (++iterJ; iterJ != end; ++iterJ) {
+            checkPair(**iterI, **iterJ);
+          }
+        }
+      };
+
+  checkNode(root);
+}
+}  // namespace
+
+RTree::RTree(unsigned int m, unsigned int M,
+             std::pmr::memory_resource* resource)
+    : arena(resource == nullptr
+                ? std::make_unique<std::pmr::monotonic_buffer_resource>()
+                : nullptr),
+      resource(resource == nullptr ? arena.get() : resource),
+      nodesToAdd(this->resource),
       m(m),
       M(M),
       nodeIdx(-2),
-      spliter(&nodesToAdd, &nodeIdx) {}
+      spliter(&nodesToAdd, &nodeIdx) {
+  treeRoot = makeRTreeNode(BoundingBox(), this->resource);
+}
+
+RTree::~RTree() {
+  if (arena) {
+    // Nodes only hold memory of the arena, skip their destructors and let
+    // the arena release everything at once
+    treeRoot.release();
+  }
+}
+
+std::pmr::memory_resource* RTree::getMemoryResource() const {
+  return resource;
+}
 
 void RTree::insertEntry(int value, const BoundingBox& boundingBox) {
   auto newNodeIter = makeNewRTreeNode(&nodesToAdd, boundingBox);
@@ -46,7 +191,7 @@ void RTree::insertEntry(int value, const BoundingBox& boundingBox) {
     nodesToAdd.push_front(std::move(treeRoot));
 
     // Make a new treeRoot
-    treeRoot = std::make_unique<RTreeNode>();
+    treeRoot = makeRTreeNode(BoundingBox(), resource);
 
     auto nodeIter = nodesToAdd.begin();
     auto& node = **nodeIter;
@@ -64,33 +209,97 @@ void RTree::insertEntry(int value, const BoundingBox& boundingBox) {
   }
 }
 
-RTreeNode& RTree::chooseLeaf(const BoundingBox& boundingBox) {
-  std::function<RTreeNode&(RTreeNode&, const BoundingBox&)> recurse =
-      [&recurse](RTreeNode& N, const BoundingBox& boundingBox) -> RTreeNode& {
-    // Leaf check
-    if (N.isLeaf) {
-      return N;
-    }
-
-    // Chose subtree
-    auto iter = N.children.begin();
-    auto bestIter = iter;
-    auto& node = **iter;
-    float minArea = node.bb.getUnion(boundingBox).getArea();
-    for (++iter; iter != N.children.end(); ++iter) {
-      auto& node = **iter;
-      float area = node.bb.getUnion(boundingBox).getArea();
-      if (area < minArea) {
-        bestIter = iter;
-        minArea = area;
+bool RTree::removeEntry(int value, const BoundingBox& boundingBox) {
+  // Find node containing record, the bounding boxes of null area are left
+  // out of their parent's so look everywhere if pruning missed the entry
+  RTreeNode* leaf = findLeaf(treeRoot.get(), value, boundingBox, true);
+  if (leaf == nullptr) {
+    leaf = findLeaf(treeRoot.get(), value, boundingBox, false);
+  }
+  if (leaf == nullptr) {
+    return false;
+  }
+
+  // Delete record
+  auto iter = std::find_if(
+      leaf->children.begin(), leaf->children.end(),
+      [value](const RTreeNodePtr& child) { return child->value == value; });
+  leaf->children.erase(iter);
+
+  // Propagate changes
+  condenseTree(leaf);
+  return true;
+}
+
+RTreeNode* RTree::findLeaf(RTreeNode* node, int value,
+                           const BoundingBox& boundingBox, bool prune) {
+  if (node->isLeaf) {
+    for (const auto& child : node->children) {
+      if (child->value == value) {
+        return node;
       }
     }
-    // Descend until a leaf is reached
-    return recurse(**bestIter, boundingBox);
-  };
+    return nullptr;
+  }
+  for (const auto& child : node->children) {
+    if (prune && !contains(child->bb, boundingBox)) {
+      continue;
+    }
+    if (RTreeNode* leaf = findLeaf(child.get(), value, boundingBox, prune)) {
+      return leaf;
+    }
+  }
+  return nullptr;
+}
 
-  // Initialize
-  return recurse(*treeRoot, boundingBox);
+void RTree::condenseTree(RTreeNode* leaf) {
+  // Eliminate under-full nodes
+  RTreeNodePtrList eliminatedNodes(resource);
+  RTreeNode* N = leaf;
+  while (!N->isRoot()) {
+    RTreeNode* parent = N->parent;
+    if (N->children.size() < m) {
+      auto iter = std::find_if(
+          parent->children.begin(), parent->children.end(),
+          [N](const RTreeNodePtr& child) { return child.get() == N; });
+      moveRTreeNode(&parent->children, iter, &eliminatedNodes);
+    } else {
+      // Adjust covering rectangle
+      N->bb = getChildrenUnion(*N);
+    }
+    N = parent;
+  }
+  treeRoot->bb = getChildrenUnion(*treeRoot);
+  if (treeRoot->children.empty()) {
+    treeRoot->isLeaf = true;
+  }
+
+  // Re-insert orphaned entries, at the leaf level instead of the level of
+  // their eliminated node to keep the insertion as it is
+  std::vector<std::pair<int, BoundingBox>> orphans;
+  for (const auto& node : eliminatedNodes) {
+    collectEntries(*node, &orphans);
+  }
+  eliminatedNodes.clear();
+  for (const auto& [value, bb] : orphans) {
+    insertEntry(value, bb);
+  }
+
+  // Shorten tree
+  while (!treeRoot->isLeaf && treeRoot->children.size() == 1) {
+    RTreeNodePtr child = std::move(treeRoot->children.front());
+    child->parent = nullptr;
+    treeRoot = std::move(child);
+  }
+}
+
+RTreeNode& RTree::chooseLeaf(const BoundingBox& boundingBox) {
+  // Descend until a leaf is reached
+  RTreeNode* N = treeRoot.get();
+  while (!N->isLeaf) {
+    N = chooseSubtree(*N, boundingBox);
+  }
+  return *N;
 }
 
 void RTree::adjustTree(const RTreeNode& L) {
@@ -100,116 +309,246 @@ void RTree::adjustTree(const RTreeNode& L) {
   if (N.isRoot()) {
     return;
   }
+  // Splitting the parent can move N to the new node which isn't in the tree
+  // yet, so keep going from the original parent
+  RTreeNode* parent = N.parent;
   // Adjust covering rectangle in parent entry
-  N.parent->bb = N.bb;
-  for (auto& child : N.parent->children) {
-    N.parent->bb = N.parent->bb.getUnion(child->bb);
+  parent->bb = N.bb;
+  for (auto& child : parent->children) {
+    parent->bb = parent->bb.getUnion(child->bb);
   }
   // Propagate node split upward
   if (!nodesToAdd.empty()) {
-    if (N.parent->children.size() < M) {
+    if (parent->children.size() < M) {
       auto iter = nodesToAdd.begin();
       auto& node = **iter;
-      node.parent = N.parent;
-      N.parent->bb = N.parent->bb.getUnion((node.bb));
-      iter = moveRTreeNode(&nodesToAdd, iter, &N.parent->children);
+      node.parent = parent;
+      parent->bb = parent->bb.getUnion((node.bb));
+      iter = moveRTreeNode(&nodesToAdd, iter, &parent->children);
     } else {
-      spliter.splitNode(m, N.parent);
+      spliter.splitNode(m, parent);
     }
   }
   // Move up to next level
-  adjustTree(*N.parent);
+  adjustTree(*parent);
 }
 
-std::vector<std::pair<int, int>> RTree::findPairwiseIntersections() {
-  std::vector<std::pair<int, int>> pairwiseIntersections;
+void RTree::insertBatch(
+    const std::vector<std::pair<int, BoundingBox>>& entries) {
+  if (entries.empty()) {
+    return;
+  }
 
-  auto buildCheckPair = [](RTreeNode* nodeA, RTreeNode* nodeB) {
-    std::vector<std::pair<RTreeNode*, RTreeNode*>> checkPairs;
-    if (!nodeA->isEntry() && !nodeB->isEntry()) {
-      for (auto iterI = nodeA->children.begin(); iterI != nodeA->children.end();
-           ++iterI) {
-        auto iterJ = nodeB->children.begin();
-        if (nodeA->value == nodeB->value) {
-          iterJ = iterI;
-          ++iterJ;
-        }
-        for (; iterJ != nodeB->children.end(); ++iterJ) {
-          auto& nodeI = **iterI;
-          auto& nodeJ = **iterJ;
-          checkPairs.push_back(std::make_pair(&nodeI, &nodeJ));
-        }
+  // Sort the batch along a Hilbert curve over the extent of the centers
+  float minX = getCenterX(entries.front().second);
+  float maxX = minX;
+  float minY = getCenterY(entries.front().second);
+  float maxY = minY;
+  for (const auto& entry : entries) {
+    minX = std::min(minX, getCenterX(entry.second));
+    maxX = std::max(maxX, getCenterX(entry.second));
+    minY = std::min(minY, getCenterY(entry.second));
+    maxY = std::max(maxY, getCenterY(entry.second));
+  }
+  auto toCell = [](float value, float min, float max) {
+    if (!(max > min)) {
+      return std::uint32_t(0);
+    }
+    double ratio = (static_cast<double>(value) - min) / (max - min);
+    return static_cast<std::uint32_t>(ratio * (HILBERT_SIZE - 1));
+  };
+  std::vector<std::pair<std::uint64_t, std::size_t>> order;
+  order.reserve(entries.size());
+  for (std::size_t i = 0; i < entries.size(); i++) {
+    const BoundingBox& bb = entries[i].second;
+    order.push_back(
+        std::make_pair(getHilbertIndex(toCell(getCenterX(bb), minX, maxX),
+                                       toCell(getCenterY(bb), minY, maxY)),
+                       i));
+  }
+  std::sort(order.begin(), order.end());
+  std::vector<std::pair<int, BoundingBox>> batch;
+  batch.reserve(entries.size());
+  for (const auto& [index, i] : order) {
+    batch.push_back(entries[i]);
+  }
+
+  RTreeNodePtrList siblings(resource);
+  insertBatch(treeRoot.get(), batch.begin(), batch.end(), &siblings);
+
+  // Grow tree taller until a single node holds the top level
+  while (!siblings.empty()) {
+    siblings.push_front(std::move(treeRoot));
+    treeRoot = makeRTreeNode(BoundingBox(), resource);
+    treeRoot->isLeaf = false;
+    treeRoot->value = nodeIdx;
+    nodeIdx = nodeIdx - 1;
+    for (auto& node : siblings) {
+      node->parent = treeRoot.get();
+    }
+    moveAllRTreeNode(&siblings, &treeRoot->children);
+    if (treeRoot->children.size() > M) {
+      packNode(treeRoot.get(), &siblings);
+    } else {
+      treeRoot->bb = getChildrenUnion(*treeRoot);
+    }
+  }
+}
+
+void RTree::insertBatch(
+    RTreeNode* node, std::vector<std::pair<int, BoundingBox>>::iterator first,
+    std::vector<std::pair<int, BoundingBox>>::iterator last,
+    RTreeNodePtrList* siblings) {
+  if (node->isLeaf) {
+    for (auto iter = first; iter != last; ++iter) {
+      auto& newNode = **makeNewRTreeNode(&node->children, iter->second);
+      newNode.value = iter->first;
+      newNode.parent = node;
+    }
+  } else {
+    RTreeNodePtrList newChildren(resource);
+    if (last - first == 1) {
+      // A lone entry has nothing to share its path with
+      insertBatch(chooseSubtree(*node, first->second), first, last,
+                  &newChildren);
+    } else {
+      // Group the entries by the child chosen for them, in the order of the
+      // batch, and hand each group to its child
+      std::vector<RTreeNode*> children;
+      for (const auto& child : node->children) {
+        children.push_back(child.get());
       }
-    } else if (nodeA->isEntry() && !nodeB->isEntry()) {
-      for (auto iter = nodeB->children.begin(); iter != nodeB->children.end();
-           ++iter) {
-        auto& node = **iter;
-        checkPairs.push_back(std::make_pair(nodeA, &node));
+      std::size_t nbEntries = last - first;
+      std::vector<std::size_t> chosen(nbEntries);
+      std::vector<std::size_t> offsets(children.size() + 1, 0);
+      for (std::size_t i = 0; i < nbEntries; i++) {
+        RTreeNode* child = chooseSubtree(*node, first[i].second);
+        chosen[i] = std::find(children.begin(), children.end(), child) -
+                    children.begin();
+        offsets[chosen[i] + 1]++;
       }
-    } else if (!nodeA->isEntry() && nodeB->isEntry()) {
-      for (auto iter = nodeA->children.begin(); iter != nodeA->children.end();
-           ++iter) {
-        auto& node = **iter;
-        checkPairs.push_back(std::make_pair(&node, nodeB));
+      for (std::size_t c = 0; c < children.size(); c++) {
+        offsets[c + 1] += offsets[c];
+      }
+      std::vector<std::pair<int, BoundingBox>> grouped(nbEntries);
+      std::vector<std::size_t> positions(offsets.begin(), offsets.end() - 1);
+      for (std::size_t i = 0; i < nbEntries; i++) {
+        grouped[positions[chosen[i]]++] = first[i];
+      }
+      std::copy(grouped.begin(), grouped.end(), first);
+      for (std::size_t c = 0; c < children.size(); c++) {
+        if (offsets[c] < offsets[c + 1]) {
+          insertBatch(children[c], first + offsets[c], first + offsets[c + 1],
+                      &newChildren);
+        }
       }
-    } else {
-      checkPairs.push_back(std::make_pair(nodeA, nodeB));
     }
-    return checkPairs;
+    // Nodes split off the children join them
+    for (auto& child : newChildren) {
+      child->parent = node;
+    }
+    moveAllRTreeNode(&newChildren, &node->children);
+  }
+
+  // Adjust covering rectangle once all the entries are in
+  if (node->children.size() > M) {
+    packNode(node, siblings);
+  } else {
+    node->bb = getChildrenUnion(*node);
+  }
+}
+
+void RTree::packNode(RTreeNode* node, RTreeNodePtrList* siblings) {
+  // Sort-Tile-Recursive: vertical slabs of whole groups sorted by x, each
+  // slab sorted by y and cut in groups. The group sizes differ by one at
+  // most so none of them is under-full when m is at most M / 2.
+  std::vector<RTreeNodePtrList::iterator> children;
+  for (auto iter = node->children.begin(); iter != node->children.end();
+       ++iter) {
+    children.push_back(iter);
+  }
+  std::size_t nbChildren = children.size();
+  std::size_t nbGroups = (nbChildren + M - 1) / M;
+  std::size_t nbSlabs = std::ceil(std::sqrt(static_cast<double>(nbGroups)));
+  auto getStart = [&children, nbChildren, nbGroups](std::size_t group) {
+    return children.begin() + nbChildren * group / nbGroups;
   };
+  std::sort(children.begin(), children.end(),
+            [](const auto& a, const auto& b) {
+              return getCenterX((*a)->bb) < getCenterX((*b)->bb);
+            });
+  for (std::size_t slab = 0; slab < nbSlabs; slab++) {
+    std::sort(getStart(nbGroups * slab / nbSlabs),
+              getStart(nbGroups * (slab + 1) / nbSlabs),
+              [](const auto& a, const auto& b) {
+                return getCenterY((*a)->bb) < getCenterY((*b)->bb);
+              });
+  }
 
-  std::function<void(std::vector<std::pair<RTreeNode*, RTreeNode*>>)> recurse =
-      [&recurse, &pairwiseIntersections, &buildCheckPair](
-          std::vector<std::pair<RTreeNode*, RTreeNode*>> entriesToCheck) {
-        auto end = entriesToCheck.end();
-        for (auto iter = entriesToCheck.begin(); iter != end; ++iter) {
-          auto& nodeI = *iter->first;
-          auto& nodeJ = *iter->second;
-          bool intersectionFound = nodeI.bb.intersect(nodeJ.bb);
-
-          if (nodeI.isEntry() && nodeJ.isEntry()) {
-            if (intersectionFound) {
-              pairwiseIntersections.push_back(
-                  std::make_pair(nodeI.value, nodeJ.value));
-            }
+  // The node keeps the first group, the others go to new siblings
+  RTreeNodePtrList entries(resource);
+  moveAllRTreeNode(&node->children, &entries);
+  for (std::size_t group = 0; group < nbGroups; group++) {
+    RTreeNode* destNode = node;
+    if (group > 0) {
+      destNode = makeNewRTreeNode(siblings, BoundingBox())->get();
+      destNode->isLeaf = node->isLeaf;
+      destNode->value = nodeIdx;
+      nodeIdx = nodeIdx - 1;
+    }
+    for (auto iter = getStart(group); iter != getStart(group + 1); ++iter) {
+      (**iter)->parent = destNode;
+      moveRTreeNode(&entries, *iter, &destNode->children);
+    }
+    destNode->bb = getChildrenUnion(*destNode);
+  }
+}
+
+void RTree::search(const BoundingBox& boundingBox,
+                   std::vector<int>* values) const {
+  std::function<void(const RTreeNode&)> recurse =
+      [&recurse, &boundingBox, values](const RTreeNode& N) {
+        for (const auto& child : N.children) {
+          if (!child->bb.intersect(boundingBox)) {
+            continue;
+          }
+          if (child->isEntry()) {
+            values->push_back(child->value);
           } else {
-            std::vector<std::pair<RTreeNode*, RTreeNode*>> nodesToCheck;
-
-            // Do not check again if it already has been check in the past
-            if (!nodeI.hasBeenChecked) {
-              auto pairI = buildCheckPair(&nodeI, &nodeI);
-              nodesToCheck.insert(nodesToCheck.end(), pairI.begin(),
-                                  pairI.end());
-              nodeI.hasBeenChecked = true;
-            }
-
-            // Do not check again if it already has been check in the past
-            if (!nodeJ.hasBeenChecked) {
-              auto pairJ = buildCheckPair(&nodeJ, &nodeJ);
-              nodesToCheck.insert(nodesToCheck.end(), pairJ.begin(),
-                                  pairJ.end());
-              nodeJ.hasBeenChecked = true;
-            }
-
-            // Check the pairs if there is an intersection
-            if (intersectionFound) {
-              auto pairIJ = buildCheckPair(&nodeI, &nodeJ);
-              nodesToCheck.insert(nodesToCheck.end(), pairIJ.begin(),
-                                  pairIJ.end());
-            }
-            if (!nodesToCheck.empty()) {
-              recurse(nodesToCheck);
-            }
+            recurse(*child);
           }
         }
       };
 
-  std::vector<std::pair<RTreeNode*, RTreeNode*>> entriesToCheck =
-      buildCheckPair(treeRoot.get(), treeRoot.get());
-
-  recurse(entriesToCheck);
+  recurse(*treeRoot);
+}
 
+std::vector<std::pair<int, int>> RTree::findPairwiseIntersections() {
+  std::vector<std::pair<int, int>> pairwiseIntersections;
+  findPairwiseIntersections(&pairwiseIntersections);
   return pairwiseIntersections;
 }
 
+void RTree::findPairwiseIntersections(
+    std::vector<std::pair<int, int>>* pairwiseIntersections) const {
+  forEachIntersectingEntryPair(
+      *treeRoot, [pairwiseIntersections](int a, int b) {
+        pairwiseIntersections->push_back(std::make_pair(a, b));
+      });
+}
+
+std::size_t RTree::findPairwiseIntersections(
+    std::vector<std::pair<int, int>>* pairwiseIntersections,
+    const BoundingVolumes& volumes) const {
+  std::size_t nbRejected = 0;
+  forEachIntersectingEntryPair(*treeRoot, [&](int a, int b) {
+    if (volumes.intersect(a, b)) {
+      pairwiseIntersections->push_back(std::make_pair(a, b));
+    } else {
+      nbRejected++;
+    }
+  });
+  return nbRejected;
+}
+
 }  // namespace convex_hull_filtering
@@ -3,23 +3,48 @@
 
 #include "convex_hull_filtering/RTreeNode.hpp"
 
+#include <iterator>
+#include <memory_resource>
+#include <new>
 #include <utility>
 
 namespace convex_hull_filtering {
 
-RTreeNode::RTreeNode()
-    : hasBeenChecked(false), isLeaf(true), value(-1), parent(nullptr) {}
+void RTreeNodeDeleter::operator()(RTreeNode* node) const {
+  node->~RTreeNode();
+  resource->deallocate(node, sizeof(RTreeNode), alignof(RTreeNode));
+}
+
+RTreeNode::RTreeNode(std::pmr::memory_resource* resource)
+    : isLeaf(true), value(-1), parent(nullptr), children(resource) {}
 
-RTreeNode::RTreeNode(const BoundingBox& bb)
-    : hasBeenChecked(false), isLeaf(true), value(-1), bb(bb), parent(nullptr) {}
+RTreeNode::RTreeNode(const BoundingBox& bb, std::pmr::memory_resource* resource)
+    : isLeaf(true), value(-1), bb(bb), parent(nullptr), children(resource) {}
 
 bool RTreeNode::isRoot() const { return parent == nullptr; }
 
 bool RTreeNode::isEntry() const { return children.empty(); }
 
+RTreeNodePtr makeRTreeNode(const BoundingBox& bb,
+                           std::pmr::memory_resource* resource) {
+  void* memory = resource->allocate(sizeof(RTreeNode), alignof(RTreeNode));
+  try {
+    return RTreeNodePtr(new (memory) RTreeNode(bb, resource),
+                        RTreeNodeDeleter{resource});
+  } catch (...) {
+    resource->deallocate(memory, sizeof(RTreeNode), alignof(RTreeNode));
+    throw;
+  }
+}
+
 RTreeNodePtrList::iterator moveRTreeNode(RTreeNodePtrList* source,
                                          const RTreeNodePtrList::iterator& iter,
                                          RTreeNodePtrList* dest) {
+  if (source->get_allocator() == dest->get_allocator()) {
+    auto next = std::next(iter);
+    dest->splice(dest->end(), *source, iter);
+    return next;
+  }
   dest->push_back(std::move(*iter));
   return source->erase(iter);
 }
@@ -33,7 +58,7 @@ void moveAllRTreeNode(RTreeNodePtrList* source, RTreeNodePtrList* dest) {
 
 RTreeNodePtrList::iterator makeNewRTreeNode(RTreeNodePtrList* list,
                                             const BoundingBox& bb) {
-  list->push_front(std::make_unique<RTreeNode>(bb));
+  list->push_front(makeRTreeNode(bb, list->get_allocator().resource()));
   return list->begin();
 }
 
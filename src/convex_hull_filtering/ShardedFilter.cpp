@@ -0,0 +1,456 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/ShardedFilter.hpp"
+
+#include <signal.h>
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/OverlapBounds.hpp"
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+extern char** environ;
+
+namespace convex_hull_filtering {
+
+namespace {
+float getCenter(const BoundingBox& boundingBox, int axis) {
+  return axis == 0 ? 0.5f * (boundingBox.min.x + boundingBox.max.x)
+                   : 0.5f * (boundingBox.min.y + boundingBox.max.y);
+}
+
+// Sort indices by the center of their bounding box along axis, ties are kept
+// in index order so that the shards don't depend on the sort implementation
+void sortByCenter(const std::vector<BoundingBox>& boundingBoxes, int axis,
+                  std::vector<int>::iterator first,
+                  std::vector<int>::iterator last) {
+  std::sort(first, last, [&boundingBoxes, axis](int a, int b) {
+    float centerA = getCenter(boundingBoxes[a], axis);
+    float centerB = getCenter(boundingBoxes[b], axis);
+    return centerA < centerB || (centerA == centerB && a < b);
+  });
+}
+
+// Start the command without going through a shell and return its pid
+pid_t spawnProcess(const std::vector<std::string>& arguments) {
+  std::vector<char*> argv;
+  for (const auto& argument : arguments) {
+    argv.push_back(const_cast<char*>(argument.c_str()));
+  }
+  argv.push_back(nullptr);
+  pid_t pid;
+  int error = posix_spawn(&pid, argv[0], nullptr, nullptr, argv.data(),
+                          environ);
+  if (error != 0) {
+    throw std::runtime_error("Couldn't start " + arguments[0] + " : " +
+                             std::strerror(error));
+  }
+  return pid;
+}
+
+bool waitProcess(pid_t pid) {
+  int status;
+  while (waitpid(pid, &status, 0) < 0) {
+    if (errno != EINTR) {
+      return false;
+    }
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+// Worker processes of a call to filter. The ones not waited for when it goes
+// out of scope, because the coordinator failed before, are killed and reaped
+// so that none keeps running on the files of a removed directory.
+class WorkerProcesses {
+ public:
+  WorkerProcesses() = default;
+  ~WorkerProcesses() {
+    for (pid_t pid : pids) {
+      kill(pid, SIGKILL);
+      waitProcess(pid);
+    }
+  }
+  WorkerProcesses(const WorkerProcesses&) = delete;
+  WorkerProcesses& operator=(const WorkerProcesses&) = delete;
+
+  void start(const std::vector<std::string>& arguments) {
+    pids.push_back(spawnProcess(arguments));
+  }
+  // Wait for every worker even when one fails, return false when one did
+  bool waitAll() {
+    bool success = true;
+    for (pid_t pid : pids) {
+      success = waitProcess(pid) && success;
+    }
+    pids.clear();
+    return success;
+  }
+
+ private:
+  std::vector<pid_t> pids;
+};
+
+// Result of a worker: the number of convex hulls of the shard then one byte
+// per convex hull, 1 when it has to be removed
+void writeRemovalFlags(const std::string& filePath,
+                       const std::vector<bool>& flags) {
+  std::ofstream ofs(filePath, std::ios::binary);
+  std::uint64_t size = flags.size();
+  ofs.write(reinterpret_cast<const char*>(&size), sizeof(size));
+  std::vector<char> bytes(flags.begin(), flags.end());
+  ofs.write(bytes.data(), bytes.size());
+  if (!ofs) {
+    throw std::runtime_error("Couldn't write " + filePath);
+  }
+}
+
+template <typename T>
+void writeValue(std::ofstream* ofs, T value) {
+  ofs->write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T readValue(std::ifstream* ifs) {
+  T value;
+  if (!ifs->read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error("Truncated worker configuration");
+  }
+  return value;
+}
+
+// Tag and version at the start of the configuration of the workers
+constexpr char WORKER_CONFIG_TAG[4] = {'C', 'H', 'F', 'W'};
+constexpr std::uint32_t WORKER_CONFIG_VERSION = 1;
+
+std::vector<bool> readRemovalFlags(const std::string& filePath,
+                                   std::size_t expectedSize) {
+  std::ifstream ifs(filePath, std::ios::binary);
+  std::uint64_t size = 0;
+  ifs.read(reinterpret_cast<char*>(&size), sizeof(size));
+  if (!ifs || size != expectedSize) {
+    throw std::runtime_error("Invalid worker result " + filePath);
+  }
+  std::vector<char> bytes(size);
+  ifs.read(bytes.data(), bytes.size());
+  if (!ifs) {
+    throw std::runtime_error("Truncated worker result " + filePath);
+  }
+  return std::vector<bool>(bytes.begin(), bytes.end());
+}
+}  // namespace
+
+ShardedFilterConfig::ShardedFilterConfig()
+    : nbWorkers(ThreadPool::getDefaultNbThreads()) {}
+
+ShardedFilter::ShardedFilter(const ShardedFilterConfig& config)
+    : config(config),
+      nbBoundaryConvexHulls(0),
+      nbCrossPairs(0),
+      workerSeconds(0.0),
+      reconcileSeconds(0.0) {}
+
+std::size_t ShardedFilter::getNbBoundaryConvexHulls() const {
+  return nbBoundaryConvexHulls;
+}
+
+std::size_t ShardedFilter::getNbCrossPairs() const { return nbCrossPairs; }
+
+double ShardedFilter::getWorkerSeconds() const { return workerSeconds; }
+
+double ShardedFilter::getReconcileSeconds() const { return reconcileSeconds; }
+
+std::vector<std::vector<int>> ShardedFilter::partition(
+    const std::vector<BoundingBox>& boundingBoxes) const {
+  std::size_t nbConvexHulls = boundingBoxes.size();
+  std::size_t nbShards =
+      std::min<std::size_t>(std::max(1u, config.nbWorkers), nbConvexHulls);
+  std::vector<std::vector<int>> shards;
+  if (nbShards == 0) {
+    return shards;
+  }
+  std::size_t nbSlabs = static_cast<std::size_t>(
+      std::ceil(std::sqrt(static_cast<double>(nbShards))));
+
+  std::vector<int> order(nbConvexHulls);
+  for (std::size_t i = 0; i < nbConvexHulls; i++) {
+    order[i] = i;
+  }
+  sortByCenter(boundingBoxes, 0, order.begin(), order.end());
+
+  // Shards are spread over the slabs and every shard gets about the same
+  // number of convex hulls, the bounds are rounded from the shard count
+  std::size_t shardBegin = 0;
+  for (std::size_t slab = 0; slab < nbSlabs; slab++) {
+    std::size_t nbSlabShards =
+        nbShards / nbSlabs + (slab < nbShards % nbSlabs ? 1 : 0);
+    std::size_t slabBegin = nbConvexHulls * shardBegin / nbShards;
+    std::size_t slabEnd =
+        nbConvexHulls * (shardBegin + nbSlabShards) / nbShards;
+    sortByCenter(boundingBoxes, 1, order.begin() + slabBegin,
+                 order.begin() + slabEnd);
+    for (std::size_t k = 0; k < nbSlabShards; k++) {
+      std::size_t begin = nbConvexHulls * (shardBegin + k) / nbShards;
+      std::size_t end = nbConvexHulls * (shardBegin + k + 1) / nbShards;
+      std::vector<int> shard(order.begin() + begin, order.begin() + end);
+      // Keep the input order inside a shard so that the pairs are checked
+      // the same way as in a single process
+      std::sort(shard.begin(), shard.end());
+      shards.push_back(std::move(shard));
+    }
+    shardBegin += nbSlabShards;
+  }
+  return shards;
+}
+
+std::vector<std::string> ShardedFilter::getWorkerArguments(
+    const std::string& shardFile, const std::string& resultFile,
+    const std::string& configFile) const {
+  return {config.workerExecutable, "--worker", shardFile, resultFile,
+          configFile};
+}
+
+std::vector<int> ShardedFilter::filter(
+    const std::vector<ConvexHull>& convexHulls) {
+  if (config.filter.mode != FilterMode::PAIRWISE) {
+    throw std::runtime_error("Only the pairwise mode can be sharded");
+  }
+  if (config.workerExecutable.empty()) {
+    throw std::runtime_error("The worker executable of the sharded filter "
+                             "isn't set");
+  }
+  std::vector<BoundingBox> boundingBoxes;
+  boundingBoxes.reserve(convexHulls.size());
+  for (const auto& convexHull : convexHulls) {
+    boundingBoxes.push_back(BoundingBox(convexHull.points));
+  }
+  auto shards = partition(boundingBoxes);
+
+  TemporaryDirectory tmpDir(config.tmpDir, "chf_shards_");
+  // The whole configuration goes to the workers, only the threads are split
+  HullFilterConfig workerConfig = config.filter;
+  workerConfig.nbThreads =
+      std::max(1u, config.filter.nbThreads / std::max(1u, config.nbWorkers));
+  std::string configFile = tmpDir.getFilePath("config.bin");
+  writeWorkerConfig(configFile, workerConfig);
+  std::vector<std::string> resultFiles;
+  WorkerProcesses workers;
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t s = 0; s < shards.size(); s++) {
+    std::string shardFile =
+        tmpDir.getFilePath("shard_" + std::to_string(s) + ".chb");
+    resultFiles.push_back(
+        tmpDir.getFilePath("result_" + std::to_string(s) + ".bin"));
+    BinaryHullWriter writer(shardFile, shards[s].size());
+    for (int idx : shards[s]) {
+      writer.write(convexHulls[idx]);
+    }
+    // The destructor would hide a failed write behind a failed worker
+    writer.close();
+    workers.start(
+        getWorkerArguments(shardFile, resultFiles.back(), configFile));
+  }
+  if (!workers.waitAll()) {
+    throw std::runtime_error("A worker of the sharded filter failed");
+  }
+  std::vector<bool> convexHullsToRemove(convexHulls.size(), false);
+  for (std::size_t s = 0; s < shards.size(); s++) {
+    auto flags = readRemovalFlags(resultFiles[s], shards[s].size());
+    for (std::size_t k = 0; k < shards[s].size(); k++) {
+      if (flags[k]) {
+        convexHullsToRemove[shards[s][k]] = true;
+      }
+    }
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  workerSeconds = elapsed.count();
+
+  start = std::chrono::steady_clock::now();
+  reconcile(convexHulls, boundingBoxes, shards, &convexHullsToRemove);
+  elapsed = std::chrono::steady_clock::now() - start;
+  reconcileSeconds = elapsed.count();
+
+  std::vector<int> keptIndices;
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    if (!convexHullsToRemove[i]) {
+      keptIndices.push_back(i);
+    }
+  }
+  return keptIndices;
+}
+
+void ShardedFilter::reconcile(const std::vector<ConvexHull>& convexHulls,
+                              const std::vector<BoundingBox>& boundingBoxes,
+                              const std::vector<std::vector<int>>& shards,
+                              std::vector<bool>* convexHullsToRemove) {
+  std::vector<int> shardOf(convexHulls.size());
+  std::vector<BoundingBox> extents;
+  for (std::size_t s = 0; s < shards.size(); s++) {
+    BoundingBox extent = boundingBoxes[shards[s].front()];
+    for (int idx : shards[s]) {
+      shardOf[idx] = s;
+      const BoundingBox& boundingBox = boundingBoxes[idx];
+      extent.min = Point(std::min(extent.min.x, boundingBox.min.x),
+                         std::min(extent.min.y, boundingBox.min.y));
+      extent.max = Point(std::max(extent.max.x, boundingBox.max.x),
+                         std::max(extent.max.y, boundingBox.max.y));
+    }
+    extents.push_back(extent);
+  }
+
+  // The bounding boxes of a pair across two shards meet and each one is
+  // inside the extent of its shard, so both touch the extent of the other
+  std::vector<int> boundaryIndices;
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    for (std::size_t s = 0; s < extents.size(); s++) {
+      if (static_cast<int>(s) != shardOf[i] &&
+          boundingBoxes[i].intersect(extents[s])) {
+        boundaryIndices.push_back(i);
+        break;
+      }
+    }
+  }
+  nbBoundaryConvexHulls = boundaryIndices.size();
+
+  std::vector<ConvexHull> boundaryConvexHulls;
+  boundaryConvexHulls.reserve(boundaryIndices.size());
+  RTree rtree(config.filter.m, config.filter.M);
+  for (std::size_t i = 0; i < boundaryIndices.size(); i++) {
+    boundaryConvexHulls.push_back(convexHulls[boundaryIndices[i]]);
+    rtree.insertEntry(i, boundingBoxes[boundaryIndices[i]]);
+  }
+  std::vector<std::pair<int, int>> crossPairs;
+  for (const auto& pair : rtree.findPairwiseIntersections()) {
+    if (shardOf[boundaryIndices[pair.first]] !=
+        shardOf[boundaryIndices[pair.second]]) {
+      crossPairs.push_back(pair);
+    }
+  }
+  nbCrossPairs = crossPairs.size();
+
+  // The removal rule only looks at the overlap and at the order of the pair,
+  // which is the same for the boundary subset as for the whole input
+  HullFilterConfig rulesConfig = config.filter;
+  rulesConfig.nbThreads = 1;
+  HullFilter rules(rulesConfig);
+  auto& toRemove = *convexHullsToRemove;
+  auto markToRemove = [&](const PairOverlap& overlap) {
+    if (!overlap.inter) {
+      return;
+    }
+    auto [removeFirst, removeSecond] = rules.applyRemovalRule(overlap);
+    if (removeFirst) {
+      toRemove[boundaryIndices[overlap.first]] = true;
+    }
+    if (removeSecond) {
+      toRemove[boundaryIndices[overlap.second]] = true;
+    }
+  };
+  auto bothRemoved = [&](int first, int second) {
+    return toRemove[boundaryIndices[first]] &&
+           toRemove[boundaryIndices[second]];
+  };
+  ThreadPool threadPool(config.filter.nbThreads);
+  // Same cells as in the workers since the grid is anchored on (0, 0)
+  std::unique_ptr<QuantizedConvexHulls> quantized;
+  if (config.filter.resolution > 0.0f) {
+    quantized = std::make_unique<QuantizedConvexHulls>(boundaryConvexHulls,
+                                                       config.filter.resolution);
+  }
+  std::unique_ptr<OverlapBounds> overlapBounds;
+  if (config.filter.approximate) {
+    overlapBounds = std::make_unique<OverlapBounds>(boundaryConvexHulls);
+  }
+  NarrowPhase narrowPhase(boundaryConvexHulls, &threadPool, quantized.get());
+  narrowPhase.setOverlapBounds(overlapBounds.get(), config.filter.threshold);
+  narrowPhase.computeOverlaps(crossPairs, markToRemove, bothRemoved);
+}
+
+void ShardedFilter::writeWorkerConfig(const std::string& filePath,
+                                      const HullFilterConfig& config) {
+  std::ofstream ofs(filePath, std::ios::binary);
+  ofs.write(WORKER_CONFIG_TAG, sizeof(WORKER_CONFIG_TAG));
+  writeValue<std::uint32_t>(&ofs, WORKER_CONFIG_VERSION);
+  writeValue<float>(&ofs, config.threshold);
+  writeValue<std::int32_t>(&ofs, static_cast<std::int32_t>(config.removalRule));
+  writeValue<std::int32_t>(&ofs, static_cast<std::int32_t>(config.mode));
+  writeValue<std::int32_t>(&ofs, static_cast<std::int32_t>(config.scoreSource));
+  writeValue<std::uint32_t>(&ofs, config.m);
+  writeValue<std::uint32_t>(&ofs, config.M);
+  writeValue<std::uint32_t>(&ofs, config.nbThreads);
+  writeValue<float>(&ofs, config.resolution);
+  writeValue<std::uint8_t>(&ofs, config.approximate);
+  writeValue<std::uint64_t>(&ofs, config.overlapCacheFile.size());
+  ofs.write(config.overlapCacheFile.data(), config.overlapCacheFile.size());
+  writeValue<std::uint64_t>(&ofs, config.overlapCacheEntries);
+  writeValue<std::int32_t>(&ofs, static_cast<std::int32_t>(config.leafVolume));
+  if (!ofs) {
+    throw std::runtime_error("Couldn't write " + filePath);
+  }
+}
+
+HullFilterConfig ShardedFilter::readWorkerConfig(const std::string& filePath) {
+  std::ifstream ifs(filePath, std::ios::binary);
+  char tag[sizeof(WORKER_CONFIG_TAG)];
+  if (!ifs.read(tag, sizeof(tag)) ||
+      !std::equal(tag, tag + sizeof(tag), WORKER_CONFIG_TAG) ||
+      readValue<std::uint32_t>(&ifs) != WORKER_CONFIG_VERSION) {
+    throw std::runtime_error("Invalid worker configuration " + filePath);
+  }
+  HullFilterConfig config;
+  config.threshold = readValue<float>(&ifs);
+  config.removalRule = static_cast<RemovalRule>(readValue<std::int32_t>(&ifs));
+  config.mode = static_cast<FilterMode>(readValue<std::int32_t>(&ifs));
+  config.scoreSource = static_cast<ScoreSource>(readValue<std::int32_t>(&ifs));
+  config.m = readValue<std::uint32_t>(&ifs);
+  config.M = readValue<std::uint32_t>(&ifs);
+  config.nbThreads = readValue<std::uint32_t>(&ifs);
+  config.resolution = readValue<float>(&ifs);
+  config.approximate = readValue<std::uint8_t>(&ifs) != 0;
+  config.overlapCacheFile.resize(readValue<std::uint64_t>(&ifs));
+  if (!ifs.read(config.overlapCacheFile.data(),
+                config.overlapCacheFile.size())) {
+    throw std::runtime_error("Truncated worker configuration");
+  }
+  config.overlapCacheEntries = readValue<std::uint64_t>(&ifs);
+  config.leafVolume = static_cast<LeafVolume>(readValue<std::int32_t>(&ifs));
+  return config;
+}
+
+void ShardedFilter::runWorker(const std::string& shardFile,
+                              const std::string& resultFile,
+                              const std::string& configFile) {
+  auto convexHulls = loadBinary(shardFile);
+  HullFilter hullFilter(readWorkerConfig(configFile));
+  auto keptIndices = hullFilter.filter(convexHulls);
+  std::vector<bool> flags(convexHulls.size(), true);
+  for (int idx : keptIndices) {
+    flags[idx] = false;
+  }
+  writeRemovalFlags(resultFile, flags);
+}
+}  // namespace convex_hull_filtering
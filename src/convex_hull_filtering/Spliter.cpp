@@ -14,7 +14,9 @@
 namespace convex_hull_filtering {
 
 Spliter::Spliter(RTreeNodePtrList* nodesToAdd, int* nodeIdx)
-    : nodesToAdd(nodesToAdd), nodeIdx(nodeIdx) {}
+    : entries(nodesToAdd->get_allocator()),
+      nodesToAdd(nodesToAdd),
+      nodeIdx(nodeIdx) {}
 
 RTreeNodePtrList::iterator Spliter::moveEntryTo(
     const RTreeNodePtrList::iterator& iter, RTreeNode* destNode) {
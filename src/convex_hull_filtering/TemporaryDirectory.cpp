@@ -0,0 +1,34 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace convex_hull_filtering {
+
+TemporaryDirectory::TemporaryDirectory(const std::string& parent,
+                                       const std::string& prefix) {
+  static std::atomic<unsigned int> counter(0);
+  std::filesystem::path parentPath =
+      parent.empty() ? std::filesystem::temp_directory_path()
+                     : std::filesystem::path(parent);
+  path = parentPath / (prefix + std::to_string(getpid()) + "_" +
+                       std::to_string(counter++));
+  std::filesystem::create_directories(path);
+}
+
+TemporaryDirectory::~TemporaryDirectory() {
+  std::error_code ec;
+  std::filesystem::remove_all(path, ec);
+}
+
+std::string TemporaryDirectory::getFilePath(const std::string& fileName) const {
+  return (path / fileName).string();
+}
+}  // namespace convex_hull_filtering
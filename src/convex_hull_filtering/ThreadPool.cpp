@@ -0,0 +1,114 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+namespace convex_hull_filtering {
+
+ThreadPool::ThreadPool(unsigned int nbThreads)
+    : task(nullptr),
+      count(0),
+      chunkSize(1),
+      nextIdx(0),
+      nbBusyWorkers(0),
+      generation(0),
+      stopping(false) {
+  // The calling thread takes part in the work, so spawn one less
+  for (unsigned int i = 1; i < nbThreads; i++) {
+    workers.emplace_back(&ThreadPool::workerLoop, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+  }
+  wakeUp.notify_all();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+unsigned int ThreadPool::getNbThreads() const { return workers.size() + 1; }
+
+unsigned int ThreadPool::getDefaultNbThreads() {
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+void ThreadPool::parallelFor(std::size_t count, std::size_t chunkSize,
+                             const ChunkTask& task) {
+  if (count == 0) {
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->task = &task;
+    this->count = count;
+    this->chunkSize = std::max<std::size_t>(1, chunkSize);
+    nextIdx = 0;
+    firstError = nullptr;
+    nbBusyWorkers = workers.size();
+    generation++;
+  }
+  wakeUp.notify_all();
+
+  runChunks(0);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  allDone.wait(lock, [this]() { return nbBusyWorkers == 0; });
+  this->task = nullptr;
+  if (firstError) {
+    std::rethrow_exception(firstError);
+  }
+}
+
+void ThreadPool::workerLoop(unsigned int threadIdx) {
+  std::uint64_t seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wakeUp.wait(lock, [&]() {
+        return stopping || generation != seenGeneration;
+      });
+      if (stopping) {
+        return;
+      }
+      seenGeneration = generation;
+    }
+
+    runChunks(threadIdx);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    nbBusyWorkers--;
+    if (nbBusyWorkers == 0) {
+      allDone.notify_one();
+    }
+  }
+}
+
+void ThreadPool::runChunks(unsigned int threadIdx) {
+  // Chunks are claimed one at a time so that faster threads take more work
+  while (true) {
+    std::size_t begin = nextIdx.fetch_add(chunkSize);
+    if (begin >= count) {
+      return;
+    }
+    std::size_t end = std::min(begin + chunkSize, count);
+    try {
+      (*task)(begin, end, threadIdx);
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (!firstError) {
+        firstError = std::current_exception();
+      }
+      // Stop handing out chunks
+      nextIdx = count;
+    }
+  }
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,471 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/TiledFilter.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Memory used per convex hull of a tile besides its points: the convex hull,
+// its entry in the RTree, its area and its share of the candidate pairs
+constexpr std::size_t TILE_BYTES_PER_HULL = 512;
+// Number of convex hull centers sampled to build the histogram
+constexpr std::size_t NB_SAMPLES = 1 << 16;
+constexpr std::size_t MIN_SPILL_BUFFER = 1 << 12;
+constexpr std::size_t MAX_SPILL_BUFFER = 1 << 20;
+
+// Spilled convex hull: index in the input, whether the tile owns it, ID,
+// score, number of points then the points as packed floats
+template <typename T>
+void appendValue(std::string* buffer, const T& value) {
+  buffer->append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+T readValue(std::istream* is) {
+  T value;
+  if (!is->read(reinterpret_cast<char*>(&value), sizeof(value))) {
+    throw std::runtime_error("Truncated tile record");
+  }
+  return value;
+}
+
+void appendRecord(std::string* buffer, std::uint64_t index, bool home,
+                  const ConvexHull& convexHull) {
+  appendValue(buffer, index);
+  appendValue(buffer, static_cast<std::uint8_t>(home));
+  appendValue(buffer, static_cast<std::int32_t>(convexHull.id));
+  appendValue(buffer, convexHull.score);
+  appendValue(buffer, static_cast<std::uint32_t>(convexHull.points.size()));
+  buffer->append(reinterpret_cast<const char*>(convexHull.points.data()),
+                 convexHull.points.size() * sizeof(Point));
+}
+
+class TileSpill {
+ public:
+  explicit TileSpill(const std::string& filePath)
+      : filePath(filePath), hasFile(false), nbBytes(0) {}
+
+  void flush() {
+    if (buffer.empty()) {
+      return;
+    }
+    std::ofstream ofs(filePath, std::ios::binary | std::ios::app);
+    ofs.write(buffer.data(), buffer.size());
+    if (!ofs) {
+      throw std::runtime_error("Couldn't write " + filePath);
+    }
+    buffer.clear();
+    hasFile = true;
+  }
+
+  std::string filePath;
+  std::string buffer;
+  bool hasFile;
+  double nbBytes;  // Estimate of the memory needed to filter the tile
+};
+
+float getCoord(const Point& point, int axis) {
+  return axis == 0 ? point.x : point.y;
+}
+}  // namespace
+
+TiledFilterConfig::TiledFilterConfig()
+    : memoryBudget(std::size_t(1) << 30), gridSize(256) {}
+
+TiledFilter::TiledFilter(const TiledFilterConfig& config)
+    : config(config),
+      halo(0.0f),
+      haloCells{0, 0},
+      nbTiles(0),
+      largestTileBytes(0),
+      instrumentation(nullptr) {}
+
+std::size_t TiledFilter::getNbTiles() const { return nbTiles; }
+
+std::size_t TiledFilter::getLargestTileBytes() const {
+  return largestTileBytes;
+}
+
+void TiledFilter::setInstrumentation(Instrumentation* instrumentation) {
+  this->instrumentation = instrumentation;
+}
+
+std::size_t TiledFilter::filter(const std::string& inputFile,
+                                const std::string& outputFile, bool pretty) {
+  if (config.filter.mode != FilterMode::PAIRWISE) {
+    throw std::runtime_error("Only the pairwise mode can be tiled");
+  }
+  if (inputFile == "-") {
+    throw std::runtime_error("The tiled mode reads its input several times");
+  }
+
+  // Pass 1: extent of the data and a sample of the convex hull centers
+  std::uint64_t nbConvexHulls = 0;
+  std::uint64_t nbPoints = 0;
+  float maxExtent = 0.0f;
+  std::vector<Point> samples;
+  std::mt19937_64 gen(42);
+  {
+    ScopedTimer timer(instrumentation, Stage::LOAD);
+    streamConvexHulls(inputFile, [&](ConvexHull&& convexHull) {
+      BoundingBox bb(convexHull.points);
+      if (nbConvexHulls == 0) {
+        world = bb;
+      }
+      world.min.x = std::fmin(world.min.x, bb.min.x);
+      world.min.y = std::fmin(world.min.y, bb.min.y);
+      world.max.x = std::fmax(world.max.x, bb.max.x);
+      world.max.y = std::fmax(world.max.y, bb.max.y);
+      maxExtent = std::fmax(maxExtent, std::fmax(bb.max.x - bb.min.x,
+                                                 bb.max.y - bb.min.y));
+      Point center((bb.min.x + bb.max.x) / 2, (bb.min.y + bb.max.y) / 2);
+      // Reservoir sampling
+      if (samples.size() < NB_SAMPLES) {
+        samples.push_back(center);
+      } else {
+        std::uniform_int_distribution<std::uint64_t> dist(0, nbConvexHulls);
+        std::uint64_t slot = dist(gen);
+        if (slot < NB_SAMPLES) {
+          samples[slot] = center;
+        }
+      }
+      nbConvexHulls++;
+      nbPoints += convexHull.points.size();
+    });
+  }
+
+  // A convex hull can only overlap the convex hulls whose center is within
+  // maxExtent of its own, the margin absorbs the rounding of the cell bounds
+  float worldSize = std::fmax(world.max.x - world.min.x,
+                              world.max.y - world.min.y);
+  float magnitude =
+      std::fmax(std::fmax(std::fabs(world.min.x), std::fabs(world.max.x)),
+                std::fmax(std::fabs(world.min.y), std::fabs(world.max.y)));
+  halo = maxExtent / 2 + 1e-3f * worldSize / config.gridSize +
+         1e-6f * magnitude;
+
+  // Split the histogram until the estimated number of convex hulls of a tile
+  // and of its halo fits in the budget
+  int gridSize = static_cast<int>(std::max(1u, config.gridSize));
+  std::vector<std::size_t> summedCounts((gridSize + 1) * (gridSize + 1), 0);
+  for (const auto& sample : samples) {
+    int cx = getCell(sample.x, 0);
+    int cy = getCell(sample.y, 1);
+    summedCounts[(cy + 1) * (gridSize + 1) + cx + 1]++;
+  }
+  for (int y = 1; y <= gridSize; y++) {
+    for (int x = 1; x <= gridSize; x++) {
+      summedCounts[y * (gridSize + 1) + x] +=
+          summedCounts[(y - 1) * (gridSize + 1) + x] +
+          summedCounts[y * (gridSize + 1) + x - 1] -
+          summedCounts[(y - 1) * (gridSize + 1) + x - 1];
+    }
+  }
+  double avgPoints =
+      nbConvexHulls > 0 ? static_cast<double>(nbPoints) / nbConvexHulls : 0.0;
+  double bytesPerHull = 2 * avgPoints * sizeof(Point) + TILE_BYTES_PER_HULL;
+  double capacity = std::max(1.0, config.memoryBudget / bytesPerHull);
+  // The halo of a tile holds the convex hulls meeting its area grown by
+  // halo, their centers are up to twice as far
+  for (int axis = 0; axis < 2; axis++) {
+    float cellSize =
+        (getCoord(world.max, axis) - getCoord(world.min, axis)) / gridSize;
+    haloCells[axis] =
+        cellSize > 0.0f
+            ? static_cast<int>(std::min<double>(
+                  std::ceil(2 * halo / cellSize), gridSize))
+            : 0;
+  }
+  double samplingRatio =
+      nbConvexHulls > 0 ? static_cast<double>(samples.size()) / nbConvexHulls
+                        : 1.0;
+  tileNodes.clear();
+  nbTiles = 0;
+  buildTiles(summedCounts, 0, 0, gridSize, gridSize,
+             std::max<std::size_t>(1, capacity * samplingRatio));
+
+  // Pass 2: spill the convex hulls to the files of the tiles
+  TemporaryDirectory tmpDir(config.tmpDir, "chf_tiles_");
+  std::size_t bufferSize =
+      std::clamp(config.memoryBudget / (2 * nbTiles), MIN_SPILL_BUFFER,
+                 MAX_SPILL_BUFFER);
+  std::vector<TileSpill> spills;
+  spills.reserve(nbTiles);
+  for (std::size_t i = 0; i < nbTiles; i++) {
+    spills.push_back(TileSpill(tmpDir.getFilePath("tile_" + std::to_string(i))));
+  }
+  std::uint64_t index = 0;
+  std::vector<int> haloTiles;
+  {
+    ScopedTimer timer(instrumentation, Stage::LOAD);
+    streamConvexHulls(inputFile, [&](ConvexHull&& convexHull) {
+      BoundingBox bb(convexHull.points);
+      int home = findHomeTile(bb);
+      haloTiles.clear();
+      findHaloTiles(bb, home, &haloTiles);
+      double nbBytes =
+          2.0 * convexHull.points.size() * sizeof(Point) + TILE_BYTES_PER_HULL;
+      appendRecord(&spills[home].buffer, index, true, convexHull);
+      spills[home].nbBytes += nbBytes;
+      for (int tile : haloTiles) {
+        appendRecord(&spills[tile].buffer, index, false, convexHull);
+        spills[tile].nbBytes += nbBytes;
+      }
+      if (spills[home].buffer.size() > bufferSize) {
+        spills[home].flush();
+      }
+      for (int tile : haloTiles) {
+        if (spills[tile].buffer.size() > bufferSize) {
+          spills[tile].flush();
+        }
+      }
+      index++;
+    });
+  }
+  if (index != nbConvexHulls) {
+    throw std::runtime_error(inputFile + " changed while being filtered");
+  }
+  largestTileBytes = 0;
+  for (const auto& spill : spills) {
+    largestTileBytes = std::max<std::size_t>(largestTileBytes, spill.nbBytes);
+  }
+
+  // Filter the tiles one by one, a convex hull is only decided by the tile
+  // owning it. Tiles keep the input order so the pairs are checked the same
+  // way as when filtering everything at once.
+  HullFilter hullFilter(config.filter);
+  hullFilter.setInstrumentation(instrumentation);
+  std::vector<bool> kept(nbConvexHulls, false);
+  std::size_t nbKept = 0;
+  std::vector<ConvexHull> convexHulls;
+  std::vector<std::uint64_t> indices;
+  std::vector<bool> owned;
+  for (auto& spill : spills) {
+    spill.flush();
+    spill.buffer = std::string();
+  }
+  for (auto& spill : spills) {
+    if (!spill.hasFile) {
+      continue;
+    }
+    {
+      ScopedTimer timer(instrumentation, Stage::LOAD);
+      // Read the records straight into the convex hulls of the tile
+      std::ifstream ifs(spill.filePath, std::ios::binary);
+      convexHulls.clear();
+      indices.clear();
+      owned.clear();
+      while (ifs.peek() != std::ifstream::traits_type::eof()) {
+        auto index = readValue<std::uint64_t>(&ifs);
+        auto home = readValue<std::uint8_t>(&ifs);
+        auto id = readValue<std::int32_t>(&ifs);
+        auto score = readValue<float>(&ifs);
+        auto size = readValue<std::uint32_t>(&ifs);
+        convexHulls.push_back(ConvexHull(std::vector<Point>(), id, score));
+        auto& points = convexHulls.back().points;
+        points.resize(size);
+        ifs.read(reinterpret_cast<char*>(points.data()), size * sizeof(Point));
+        if (!ifs) {
+          throw std::runtime_error("Couldn't read " + spill.filePath);
+        }
+        indices.push_back(index);
+        owned.push_back(home != 0);
+      }
+      ifs.close();
+      std::filesystem::remove(spill.filePath);
+    }
+
+    for (int idx : hullFilter.filter(convexHulls)) {
+      if (owned[idx]) {
+        kept[indices[idx]] = true;
+        nbKept++;
+      }
+    }
+  }
+
+  // Pass 3: write the kept convex hulls in the input order
+  index = 0;
+  {
+    ScopedTimer timer(instrumentation, Stage::WRITE);
+    if (hasBinaryExtension(outputFile)) {
+      BinaryHullWriter writer(outputFile, nbKept);
+      streamConvexHulls(inputFile, [&](ConvexHull&& convexHull) {
+        if (kept[index++]) {
+          writer.write(convexHull);
+        }
+      });
+      writer.close();
+    } else {
+      std::ofstream ofs(outputFile, std::ios::binary);
+      if (!ofs) {
+        throw std::runtime_error("Couldn't open " + outputFile);
+      }
+      JsonHullWriter writer(&ofs, pretty);
+      streamConvexHulls(inputFile, [&](ConvexHull&& convexHull) {
+        if (kept[index++]) {
+          writer.write(convexHull);
+        }
+      });
+      writer.close();
+    }
+  }
+  return nbKept;
+}
+
+int TiledFilter::buildTiles(const std::vector<std::size_t>& summedCounts,
+                            int cellMinX, int cellMinY, int cellMaxX,
+                            int cellMaxY, std::size_t capacity) {
+  int stride = static_cast<int>(std::max(1u, config.gridSize)) + 1;
+  auto countCells = [&](int x0, int y0, int x1, int y1) {
+    return summedCounts[y1 * stride + x1] - summedCounts[y0 * stride + x1] -
+           summedCounts[y1 * stride + x0] + summedCounts[y0 * stride + x0];
+  };
+
+  int nodeIdx = tileNodes.size();
+  TileNode node;
+  node.cellMin[0] = cellMinX;
+  node.cellMin[1] = cellMinY;
+  node.cellMax[0] = cellMaxX;
+  node.cellMax[1] = cellMaxY;
+  node.children[0] = -1;
+  node.children[1] = -1;
+  node.tile = -1;
+  tileNodes.push_back(node);
+
+  // The halo of the tile is held along with it
+  int gridSize = stride - 1;
+  std::size_t nbHeld = countCells(std::max(0, cellMinX - haloCells[0]),
+                                  std::max(0, cellMinY - haloCells[1]),
+                                  std::min(gridSize, cellMaxX + haloCells[0]),
+                                  std::min(gridSize, cellMaxY + haloCells[1]));
+  std::size_t count = countCells(cellMinX, cellMinY, cellMaxX, cellMaxY);
+  int width = cellMaxX - cellMinX;
+  int height = cellMaxY - cellMinY;
+  // Past the size of its halo splitting a tile barely shrinks what it holds
+  // and multiplies the copies of the halos
+  bool smallerThanHalo = width <= haloCells[0] && height <= haloCells[1];
+  if (nbHeld <= capacity || smallerThanHalo || (width == 1 && height == 1)) {
+    tileNodes[nodeIdx].tile = nbTiles++;
+    return nodeIdx;
+  }
+
+  // Split the longest side where half of the convex hulls are on each side
+  int axis = width >= height ? 0 : 1;
+  int lo = node.cellMin[axis];
+  int hi = node.cellMax[axis];
+  int split = lo + 1;
+  for (; split < hi - 1; split++) {
+    std::size_t before =
+        axis == 0 ? countCells(cellMinX, cellMinY, split, cellMaxY)
+                  : countCells(cellMinX, cellMinY, cellMaxX, split);
+    if (2 * before >= count) {
+      break;
+    }
+  }
+  int first, second;
+  if (axis == 0) {
+    first = buildTiles(summedCounts, cellMinX, cellMinY, split, cellMaxY,
+                       capacity);
+    second = buildTiles(summedCounts, split, cellMinY, cellMaxX, cellMaxY,
+                        capacity);
+  } else {
+    first = buildTiles(summedCounts, cellMinX, cellMinY, cellMaxX, split,
+                       capacity);
+    second = buildTiles(summedCounts, cellMinX, split, cellMaxX, cellMaxY,
+                        capacity);
+  }
+  tileNodes[nodeIdx].children[0] = first;
+  tileNodes[nodeIdx].children[1] = second;
+  return nodeIdx;
+}
+
+int TiledFilter::getCell(float coord, int axis) const {
+  int gridSize = static_cast<int>(std::max(1u, config.gridSize));
+  float min = getCoord(world.min, axis);
+  float size = getCoord(world.max, axis) - min;
+  if (!(size > 0.0f)) {
+    return 0;
+  }
+  int cell = static_cast<int>(std::floor((coord - min) / size * gridSize));
+  return std::clamp(cell, 0, gridSize - 1);
+}
+
+int TiledFilter::findHomeTile(const BoundingBox& boundingBox) const {
+  int cell[2] = {
+      getCell((boundingBox.min.x + boundingBox.max.x) / 2, 0),
+      getCell((boundingBox.min.y + boundingBox.max.y) / 2, 1)};
+  int nodeIdx = 0;
+  while (tileNodes[nodeIdx].tile < 0) {
+    const auto& first = tileNodes[tileNodes[nodeIdx].children[0]];
+    bool inFirst = cell[0] < first.cellMax[0] && cell[1] < first.cellMax[1];
+    nodeIdx = tileNodes[nodeIdx].children[inFirst ? 0 : 1];
+  }
+  return tileNodes[nodeIdx].tile;
+}
+
+void TiledFilter::findHaloTiles(const BoundingBox& boundingBox, int home,
+                                std::vector<int>* tiles) const {
+  std::vector<int> toVisit = {0};
+  while (!toVisit.empty()) {
+    const auto& node = tileNodes[toVisit.back()];
+    toVisit.pop_back();
+    BoundingBox area = getTileArea(node);
+    if (boundingBox.max.x < area.min.x - halo ||
+        boundingBox.min.x > area.max.x + halo ||
+        boundingBox.max.y < area.min.y - halo ||
+        boundingBox.min.y > area.max.y + halo) {
+      continue;
+    }
+    if (node.tile >= 0) {
+      if (node.tile != home) {
+        tiles->push_back(node.tile);
+      }
+    } else {
+      toVisit.push_back(node.children[0]);
+      toVisit.push_back(node.children[1]);
+    }
+  }
+}
+
+BoundingBox TiledFilter::getTileArea(const TileNode& node) const {
+  // Cells on the border of the grid also hold what the clamping puts there
+  int gridSize = static_cast<int>(std::max(1u, config.gridSize));
+  float bounds[2][2];
+  for (int axis = 0; axis < 2; axis++) {
+    float min = getCoord(world.min, axis);
+    float cellSize = (getCoord(world.max, axis) - min) / gridSize;
+    bounds[axis][0] = node.cellMin[axis] == 0
+                          ? -std::numeric_limits<float>::infinity()
+                          : min + node.cellMin[axis] * cellSize;
+    bounds[axis][1] = node.cellMax[axis] == gridSize
+                          ? std::numeric_limits<float>::infinity()
+                          : min + node.cellMax[axis] * cellSize;
+  }
+  return BoundingBox(Point(bounds[0][0], bounds[1][0]),
+                     Point(bounds[0][1], bounds[1][1]));
+}
+}  // namespace convex_hull_filtering
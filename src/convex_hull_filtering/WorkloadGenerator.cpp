@@ -0,0 +1,223 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace convex_hull_filtering {
+
+namespace {
+// Half side of a grid box relative to the grid step, and how far a box is
+// stretched to the right to overlap its neighbor
+constexpr float GRID_HALF_SIZE = 0.45f;
+constexpr float GRID_STRETCH = 0.3f;
+// Each vertex is placed in its own angular sector, jittered by this fraction
+// of the sector so that the polygon stays convex without being regular
+constexpr float ANGLE_JITTER = 0.8f;
+// Distance between the centers, in mean radii, under which two random
+// convex hulls overlap on average. Less than 2 as the polygons are inscribed
+// in ellipses of various shapes, measured on uniform layouts.
+constexpr double CONTACT_DISTANCE = 1.83;
+}  // namespace
+
+WorkloadConfig::WorkloadConfig()
+    : count(1000),
+      layout(Layout::UNIFORM),
+      vertexDistribution(VertexDistribution::UNIFORM),
+      minVertices(4),
+      maxVertices(12),
+      meanVertices(8.0),
+      overlapRate(0.3),
+      radius(6.0f),
+      nbClusters(0),
+      clusterRadius(0.0f),
+      seed(42) {}
+
+WorkloadGenerator::WorkloadGenerator(const WorkloadConfig& config)
+    : config(config), gen(config.seed), gridStep(0.0f), gridSide(0),
+      stretchRate(0.0), index(0) {
+  if (this->config.minVertices < 3 ||
+      this->config.maxVertices < this->config.minVertices) {
+    throw std::runtime_error("Convex hulls need at least 3 vertices");
+  }
+  if (!(this->config.radius > 0.0f)) {
+    throw std::runtime_error("The radius must be positive");
+  }
+  double overlapRate =
+      std::clamp(this->config.overlapRate, 1e-6, 1.0 - 1e-6);
+  double count = std::max<std::uint64_t>(this->config.count, 1);
+  double radius = this->config.radius;
+
+  if (this->config.layout == Layout::GRID) {
+    // A box overlaps when it or its left neighbor is stretched
+    gridSide = std::ceil(std::sqrt(count));
+    gridStep = radius / GRID_HALF_SIZE;
+    worldSize = gridSide * gridStep;
+    stretchRate = 1.0 - std::sqrt(1.0 - overlapRate);
+    return;
+  }
+
+  // With centers following a Poisson process of density d the chance to have
+  // no neighbor closer than the contact distance c is exp(-d * pi * c^2),
+  // d is solved for the overlap rate
+  double contactDistance = CONTACT_DISTANCE * radius;
+  double density = -std::log(1.0 - overlapRate) /
+                   (M_PI * contactDistance * contactDistance);
+  worldSize = std::sqrt(count / density);
+
+  if (this->config.layout == Layout::UNIFORM) {
+    return;
+  }
+  std::uint64_t nbClusters = this->config.nbClusters;
+  if (nbClusters == 0) {
+    nbClusters = std::max<std::uint64_t>(this->config.count / 1000, 1);
+  }
+  if (!(this->config.clusterRadius > 0.0f)) {
+    this->config.clusterRadius = worldSize / (4.0f * std::sqrt(nbClusters));
+  }
+  std::uniform_real_distribution<float> centerDist(0.0f, worldSize);
+  clusterCenters.reserve(nbClusters);
+  for (std::uint64_t i = 0; i < nbClusters; i++) {
+    float x = centerDist(gen);
+    float y = centerDist(gen);
+    clusterCenters.push_back(Point(x, y));
+  }
+}
+
+bool WorkloadGenerator::hasNext() const { return index < config.count; }
+
+float WorkloadGenerator::getWorldSize() const { return worldSize; }
+
+Point WorkloadGenerator::nextCenter() {
+  switch (config.layout) {
+    case Layout::CLUSTERED: {
+      std::uniform_int_distribution<std::size_t> clusterDist(
+          0, clusterCenters.size() - 1);
+      const auto& clusterCenter = clusterCenters[clusterDist(gen)];
+      std::uniform_real_distribution<float> unitDist(0.0f, 1.0f);
+      // The square root spreads the centers evenly over the disk
+      float distance = config.clusterRadius * std::sqrt(unitDist(gen));
+      float angle = 2.0f * M_PI * unitDist(gen);
+      return Point(clusterCenter.x + distance * std::cos(angle),
+                   clusterCenter.y + distance * std::sin(angle));
+    }
+    case Layout::GAUSSIAN_BLOBS: {
+      std::uniform_int_distribution<std::size_t> clusterDist(
+          0, clusterCenters.size() - 1);
+      const auto& clusterCenter = clusterCenters[clusterDist(gen)];
+      std::normal_distribution<float> offsetDist(0.0f, config.clusterRadius);
+      float x = clusterCenter.x + offsetDist(gen);
+      float y = clusterCenter.y + offsetDist(gen);
+      return Point(x, y);
+    }
+    default: {
+      std::uniform_real_distribution<float> centerDist(0.0f, worldSize);
+      float x = centerDist(gen);
+      float y = centerDist(gen);
+      return Point(x, y);
+    }
+  }
+}
+
+int WorkloadGenerator::nextNbVertices() {
+  if (config.vertexDistribution == VertexDistribution::POISSON) {
+    std::poisson_distribution<int> nbVerticesDist(config.meanVertices);
+    return std::clamp(nbVerticesDist(gen), config.minVertices,
+                      config.maxVertices);
+  }
+  std::uniform_int_distribution<int> nbVerticesDist(config.minVertices,
+                                                    config.maxVertices);
+  return nbVerticesDist(gen);
+}
+
+ConvexHull WorkloadGenerator::next() {
+  if (!hasNext()) {
+    throw std::runtime_error("No more convex hulls to generate");
+  }
+  int id = index++;
+  std::uniform_real_distribution<float> unitDist(0.0f, 1.0f);
+  points.clear();
+
+  if (config.layout == Layout::GRID) {
+    std::uint64_t row = id / gridSide;
+    std::uint64_t column = id % gridSide;
+    float cx = (column + 0.5f) * gridStep;
+    float cy = (row + 0.5f) * gridStep;
+    float halfSize = GRID_HALF_SIZE * gridStep;
+    float stretch = unitDist(gen) < stretchRate ? GRID_STRETCH : 0.0f;
+    float minX = cx - halfSize;
+    float maxX = cx + halfSize + stretch * gridStep;
+    float minY = cy - halfSize;
+    float maxY = cy + halfSize;
+    points.push_back(Point(minX, minY));
+    points.push_back(Point(maxX, minY));
+    points.push_back(Point(maxX, maxY));
+    points.push_back(Point(minX, maxY));
+    return ConvexHull(points, id, unitDist(gen));
+  }
+
+  // Vertices on a rotated ellipse, one per angular sector in increasing
+  // order of angle so that the polygon is convex and counter clockwise
+  Point center = nextCenter();
+  int nbVertices = nextNbVertices();
+  std::uniform_real_distribution<float> radiusDist(0.5f * config.radius,
+                                                   1.5f * config.radius);
+  float rx = radiusDist(gen);
+  float ry = radiusDist(gen);
+  float rotation = 2.0f * M_PI * unitDist(gen);
+  float cosRotation = std::cos(rotation);
+  float sinRotation = std::sin(rotation);
+  float sector = 2.0f * M_PI / nbVertices;
+  for (int i = 0; i < nbVertices; i++) {
+    float angle = sector * (i + ANGLE_JITTER * unitDist(gen));
+    float x = rx * std::cos(angle);
+    float y = ry * std::sin(angle);
+    points.push_back(Point(center.x + x * cosRotation - y * sinRotation,
+                           center.y + x * sinRotation + y * cosRotation));
+  }
+  return ConvexHull(points, id, unitDist(gen));
+}
+
+std::vector<ConvexHull> generateConvexHulls(const WorkloadConfig& config) {
+  WorkloadGenerator generator(config);
+  std::vector<ConvexHull> convexHulls;
+  convexHulls.reserve(config.count);
+  while (generator.hasNext()) {
+    convexHulls.push_back(generator.next());
+  }
+  return convexHulls;
+}
+
+void generateWorkload(const std::string& filePath,
+                      const WorkloadConfig& config, bool pretty) {
+  WorkloadGenerator generator(config);
+  if (hasBinaryExtension(filePath)) {
+    BinaryHullWriter writer(filePath, config.count);
+    while (generator.hasNext()) {
+      writer.write(generator.next());
+    }
+    writer.close();
+    return;
+  }
+  std::ofstream os(filePath);
+  if (!os) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  JsonHullWriter writer(&os, pretty);
+  while (generator.hasNext()) {
+    writer.write(generator.next());
+  }
+  writer.close();
+}
+}  // namespace convex_hull_filtering
@@ -0,0 +1,126 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+
+void printUsage() {
+  std::cout << "Usage: convex_hull_filtering_generate [options] output_file"
+            << std::endl;
+  std::cout << "Write random convex hulls to a JSON or a binary (.chb) file"
+            << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --count N          Number of convex hulls (1000)"
+            << std::endl;
+  std::cout << "  --layout uniform|clustered|blobs|grid" << std::endl;
+  std::cout << "                     Placement of the centers (uniform)"
+            << std::endl;
+  std::cout << "  --vertices MIN MAX Range of vertices per convex hull (4 12)"
+            << std::endl;
+  std::cout << "  --vertex-distribution uniform|poisson" << std::endl;
+  std::cout << "                     Distribution of the vertex count (uniform)"
+            << std::endl;
+  std::cout << "  --mean-vertices X  Mean of the poisson distribution (8)"
+            << std::endl;
+  std::cout << "  --overlap-rate X   Fraction of convex hulls overlapping "
+               "another one (0.3)"
+            << std::endl;
+  std::cout << "  --radius X         Mean radius of the convex hulls (6)"
+            << std::endl;
+  std::cout << "  --clusters N       Clusters or blobs (1 per 1000 convex hulls)"
+            << std::endl;
+  std::cout << "  --cluster-radius X Radius of a cluster or sigma of a blob"
+            << std::endl;
+  std::cout << "  --seed N           Seed of the generator (42)" << std::endl;
+  std::cout << "  --compact          Write JSON without whitespace"
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+  std::string filePath;
+  chf::WorkloadConfig config;
+  bool pretty = true;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help") {
+      printUsage();
+      return 0;
+    } else if (arg == "--count" && hasValue) {
+      config.count = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--layout" && hasValue) {
+      std::string layout(argv[++i]);
+      if (layout == "uniform") {
+        config.layout = chf::Layout::UNIFORM;
+      } else if (layout == "clustered") {
+        config.layout = chf::Layout::CLUSTERED;
+      } else if (layout == "blobs") {
+        config.layout = chf::Layout::GAUSSIAN_BLOBS;
+      } else if (layout == "grid") {
+        config.layout = chf::Layout::GRID;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--vertices" && i + 2 < argc) {
+      config.minVertices = std::atoi(argv[++i]);
+      config.maxVertices = std::atoi(argv[++i]);
+    } else if (arg == "--vertex-distribution" && hasValue) {
+      std::string distribution(argv[++i]);
+      if (distribution == "uniform") {
+        config.vertexDistribution = chf::VertexDistribution::UNIFORM;
+      } else if (distribution == "poisson") {
+        config.vertexDistribution = chf::VertexDistribution::POISSON;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--mean-vertices" && hasValue) {
+      config.meanVertices = std::atof(argv[++i]);
+    } else if (arg == "--overlap-rate" && hasValue) {
+      config.overlapRate = std::atof(argv[++i]);
+    } else if (arg == "--radius" && hasValue) {
+      config.radius = std::atof(argv[++i]);
+    } else if (arg == "--clusters" && hasValue) {
+      config.nbClusters = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--cluster-radius" && hasValue) {
+      config.clusterRadius = std::atof(argv[++i]);
+    } else if (arg == "--seed" && hasValue) {
+      config.seed = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--compact") {
+      pretty = false;
+    } else if (arg.rfind("--", 0) != 0 && filePath.empty()) {
+      filePath = arg;
+    } else {
+      printUsage();
+      return -1;
+    }
+  }
+  if (filePath.empty()) {
+    printUsage();
+    return -1;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  try {
+    chf::generateWorkload(filePath, config, pretty);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << "Wrote " << config.count << " convex hulls to " << filePath
+            << " in " << elapsed.count() << " s" << std::endl;
+  return 0;
+}
@@ -0,0 +1,191 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/FilterServer.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace chf = convex_hull_filtering;
+
+void printUsage() {
+  std::cout << "Usage: convex_hull_filtering_load [options] --socket SOCKET "
+               "input_file"
+            << std::endl;
+  std::cout << "Send batches of the input to a convex_hull_filtering --serve "
+               "and report the latency"
+            << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --batch N          Convex hulls per request (100)"
+            << std::endl;
+  std::cout << "  --requests N       Requests sent by each client (1000)"
+            << std::endl;
+  std::cout << "  --clients N        Concurrent connections (1)" << std::endl;
+  std::cout << "  --format binary|json" << std::endl;
+  std::cout << "                     Encoding of the batches (binary)"
+            << std::endl;
+  std::cout << "  --shutdown         Stop the server at the end" << std::endl;
+}
+
+double getPercentile(const std::vector<double>& sortedLatencies,
+                     double percentile) {
+  std::size_t rank = static_cast<std::size_t>(
+      percentile / 100.0 * (sortedLatencies.size() - 1) + 0.5);
+  return sortedLatencies[rank];
+}
+
+int main(int argc, char* argv[]) {
+  std::string filePath;
+  std::string socketPath;
+  std::size_t batchSize = 100;
+  int nbRequests = 1000;
+  int nbClients = 1;
+  chf::RequestType type = chf::RequestType::BINARY;
+  bool shutdown = false;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help") {
+      printUsage();
+      return 0;
+    } else if (arg == "--socket" && hasValue) {
+      socketPath = argv[++i];
+    } else if (arg == "--batch" && hasValue) {
+      batchSize = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--requests" && hasValue) {
+      nbRequests = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--clients" && hasValue) {
+      nbClients = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--format" && hasValue) {
+      std::string format(argv[++i]);
+      if (format == "binary") {
+        type = chf::RequestType::BINARY;
+      } else if (format == "json") {
+        type = chf::RequestType::JSON;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--shutdown") {
+      shutdown = true;
+    } else if (arg.rfind("--", 0) != 0 && filePath.empty()) {
+      filePath = arg;
+    } else {
+      printUsage();
+      return -1;
+    }
+  }
+  if (filePath.empty() || socketPath.empty()) {
+    printUsage();
+    return -1;
+  }
+
+  // Encode every batch up front so that only the server is measured
+  std::vector<std::string> payloads;
+  std::vector<std::size_t> payloadSizes;  // Convex hulls in each payload
+  try {
+    auto convexHulls = chf::loadConvexHulls(filePath);
+    for (std::size_t begin = 0; begin < convexHulls.size();
+         begin += batchSize) {
+      std::vector<chf::ConvexHull> batch(
+          convexHulls.begin() + begin,
+          convexHulls.begin() + std::min(begin + batchSize, convexHulls.size()));
+      payloadSizes.push_back(batch.size());
+      if (type == chf::RequestType::JSON) {
+        std::ostringstream oss;
+        chf::saveJson(&oss, batch, false);
+        payloads.push_back(oss.str());
+      } else {
+        std::vector<unsigned char> encoded;
+        chf::encodeBinary(batch, &encoded);
+        payloads.push_back(std::string(encoded.begin(), encoded.end()));
+      }
+    }
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  if (payloads.empty()) {
+    std::cerr << filePath << " has no convex hulls" << std::endl;
+    return -1;
+  }
+
+  std::vector<std::vector<double>> latencies(nbClients);
+  std::vector<std::string> errors(nbClients);
+  std::vector<std::size_t> nbSent(nbClients, 0);
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> clients;
+  for (int c = 0; c < nbClients; c++) {
+    clients.emplace_back([&, c]() {
+      try {
+        chf::FilterClient client(socketPath);
+        for (int r = 0; r < nbRequests; r++) {
+          std::size_t idx = (c + r * nbClients) % payloads.size();
+          const auto& payload = payloads[idx];
+          auto requestStart = std::chrono::steady_clock::now();
+          client.send(type, payload.data(), payload.size());
+          std::chrono::duration<double, std::milli> elapsed =
+              std::chrono::steady_clock::now() - requestStart;
+          latencies[c].push_back(elapsed.count());
+          nbSent[c] += payloadSizes[idx];
+        }
+      } catch (std::exception& e) {
+        errors[c] = e.what();
+      }
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+
+  std::vector<double> allLatencies;
+  for (int c = 0; c < nbClients; c++) {
+    if (!errors[c].empty()) {
+      std::cerr << "Client " << c << " : " << errors[c] << std::endl;
+    }
+    allLatencies.insert(allLatencies.end(), latencies[c].begin(),
+                        latencies[c].end());
+  }
+  if (shutdown) {
+    try {
+      chf::FilterClient(socketPath).shutdown();
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+    }
+  }
+  if (allLatencies.empty()) {
+    return -1;
+  }
+  std::sort(allLatencies.begin(), allLatencies.end());
+
+  std::size_t nbConvexHulls = 0;
+  for (int c = 0; c < nbClients; c++) {
+    nbConvexHulls += nbSent[c];
+  }
+  std::cout << std::fixed << std::setprecision(3);
+  std::cout << allLatencies.size() << " requests of " << batchSize
+            << " convex hulls from " << nbClients << " clients in "
+            << elapsed.count() << " s" << std::endl;
+  std::cout << "Latency p50 " << getPercentile(allLatencies, 50.0)
+            << " ms | p99 " << getPercentile(allLatencies, 99.0)
+            << " ms | max " << allLatencies.back() << " ms" << std::endl;
+  std::cout << "Throughput " << allLatencies.size() / elapsed.count()
+            << " requests/s | " << nbConvexHulls / elapsed.count()
+            << " convex hulls/s" << std::endl;
+  return errors == std::vector<std::string>(nbClients) ? 0 : -1;
+}
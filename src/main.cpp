@@ -1,52 +1,51 @@
 /* Copyright 2023 Remi KEAT */
 // This code follows Google C++ Style Guide.
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
-#include <unordered_set>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 
+#include "convex_hull_filtering/AsyncHullWriter.hpp"
+#include "convex_hull_filtering/BinaryIO.hpp"
 #include "convex_hull_filtering/BoundingBox.hpp"
 #include "convex_hull_filtering/ConvexHull.hpp"
-#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/FilterServer.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/OverlapMatrix.hpp"
 #include "convex_hull_filtering/RTree.hpp"
-#include "nlohmann/json.hpp"
+#include "convex_hull_filtering/ShardedFilter.hpp"
+#include "convex_hull_filtering/TiledFilter.hpp"
 
 namespace chf = convex_hull_filtering;
-using json = nlohmann::json;
 
-std::vector<chf::ConvexHull> loadJson(const std::string& filePath) {
-  std::vector<chf::ConvexHull> convexHulls;
-
-  std::ifstream ifs(filePath);
-  json jf = json::parse(ifs);
+// Count the allocations of the whole process for the report
+std::atomic<std::uint64_t> allocationCount(0);
 
-  for (const auto& convexHull : jf["convex hulls"]) {
-    std::vector<chf::Point> points;
-    points.reserve(convexHull["apexes"].size());
-    for (const auto& apexes : convexHull["apexes"]) {
-      points.push_back(chf::Point(apexes["x"], apexes["y"]));
-    }
-    convexHulls.push_back(chf::ConvexHull(points, convexHull["ID"]));
+void* operator new(std::size_t size) {
+  allocationCount.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
   }
-
-  return convexHulls;
+  throw std::bad_alloc();
 }
 
-json convertToJson(const std::vector<chf::ConvexHull>& convexHulls) {
-  json jConvexHulls;
-  for (const auto& convexHull : convexHulls) {
-    json jApexes;
-    for (const auto& point : convexHull.points) {
-      json jPoint = {{"x", point.x}, {"y", point.y}};
-      jApexes.push_back(jPoint);
-    }
-    json jConvexHull = {{"ID", convexHull.id}, {"apexes", jApexes}};
-    jConvexHulls.push_back(jConvexHull);
-  }
-  json jRes = {{"convex hulls", jConvexHulls}};
-  return jRes;
-}
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
 
 void printBoundingBox(const chf::BoundingBox& bb) {
   std::cout << "(";
@@ -82,111 +81,592 @@ void printTree(const chf::RTreeNode& node, int level) {
   }
 }
 
+// Print a sample of what the filter does: the tree and the ID lists are
+// only printed with a sample rate of 1, otherwise one candidate pair and one
+// overlap out of sampleRate are. A sample rate of 0 disables the log.
+class DebugLogObserver : public chf::HullFilterObserver {
+ public:
+  DebugLogObserver(const std::vector<chf::ConvexHull>& convexHulls,
+                   unsigned int sampleRate)
+      : convexHulls(convexHulls), sampleRate(sampleRate), nbOverlaps(0) {}
+
+  void onTreeBuilt(const chf::RTree& rtree) override {
+    if (sampleRate != 1) {
+      return;
+    }
+    std::cout << "Built the following tree" << std::endl;
+    printTree(*rtree.treeRoot, 0);
+    std::cout << std::string(50, '-') << std::endl;
+  }
+
+  void onCandidatePairs(
+      const std::vector<std::pair<int, int>>& pairwiseIntersections) override {
+    if (sampleRate == 0) {
+      return;
+    }
+    std::cout << "Found " << pairwiseIntersections.size()
+              << " bounding box intersections : ";
+    for (std::size_t i = 0; i < pairwiseIntersections.size();
+         i += sampleRate) {
+      const auto& convexHull1 = convexHulls[pairwiseIntersections[i].first];
+      const auto& convexHull2 = convexHulls[pairwiseIntersections[i].second];
+      std::cout << "[" << convexHull1.id << ", " << convexHull2.id << "] ";
+    }
+    std::cout << std::endl;
+    std::cout << std::string(50, '-') << std::endl;
+  }
+
+  void onOverlap(const chf::PairOverlap& overlap, bool removeFirst,
+                 bool removeSecond) override {
+    if (sampleRate == 0 || nbOverlaps++ % sampleRate != 0) {
+      return;
+    }
+    const auto& convexHull1 = convexHulls[overlap.first];
+    const auto& convexHull2 = convexHulls[overlap.second];
+    std::cout << "Area [";
+    std::cout << std::setw(3) << std::setfill(' ') << convexHull1.id << ", ";
+    std::cout << std::setw(3) << std::setfill(' ') << convexHull2.id << "] ";
+    std::cout << std::setw(6) << std::setfill(' ') << convexHull1.getArea()
+              << " (";
+    std::cout << std::setw(6) << std::setfill(' ') << overlap.ratioFirst
+              << " %) | ";
+    std::cout << std::setw(6) << std::setfill(' ') << overlap.interArea
+              << " | ";
+    std::cout << std::setw(6) << std::setfill(' ') << convexHull2.getArea()
+              << " (";
+    std::cout << std::setw(6) << std::setfill(' ') << overlap.ratioSecond
+              << " %) ";
+    if (removeFirst) {
+      std::cout << "Should remove " << convexHull1.id << " ";
+    }
+    if (removeSecond) {
+      std::cout << "Should remove " << convexHull2.id << " ";
+    }
+    std::cout << std::endl;
+  }
+
+ protected:
+  const std::vector<chf::ConvexHull>& convexHulls;
+
+ private:
+  unsigned int sampleRate;
+  std::uint64_t nbOverlaps;
+};
+
+// Hand the kept convex hulls to the writer while the filter is still running
+class WritingObserver : public DebugLogObserver {
+ public:
+  WritingObserver(const std::vector<chf::ConvexHull>& convexHulls,
+                  unsigned int sampleRate, chf::AsyncHullWriter* writer)
+      : DebugLogObserver(convexHulls, sampleRate), writer(writer) {}
+
+  void onConvexHullKept(int index) override {
+    writer->push(&convexHulls[index]);
+  }
+
+ private:
+  chf::AsyncHullWriter* writer;
+};
+
+void writeConvexHulls(const std::vector<chf::ConvexHull>& convexHulls,
+                      const std::vector<int>& keptIndices,
+                      const std::string& outputFile, bool pretty) {
+  if (chf::hasBinaryExtension(outputFile)) {
+    chf::BinaryHullWriter writer(outputFile, keptIndices.size());
+    for (int idx : keptIndices) {
+      writer.write(convexHulls[idx]);
+    }
+    writer.close();
+    return;
+  }
+  std::ofstream ofs(outputFile, std::ios::binary);
+  if (!ofs) {
+    throw std::runtime_error("Couldn't open " + outputFile);
+  }
+  chf::JsonHullWriter writer(&ofs, pretty);
+  for (int idx : keptIndices) {
+    writer.write(convexHulls[idx]);
+  }
+  writer.close();
+}
+
+// Write the JSON results as the filter goes, the binary format needs the
+// number of convex hulls first so it is written once the filter is done
+std::vector<int> filterToFile(const std::vector<chf::ConvexHull>& convexHulls,
+                              chf::HullFilter* hullFilter,
+                              const std::string& outputFile, bool pretty,
+                              unsigned int sampleRate,
+                              chf::Instrumentation* instrumentation) {
+  if (chf::hasBinaryExtension(outputFile)) {
+    DebugLogObserver observer(convexHulls, sampleRate);
+    auto keptIndices = hullFilter->filter(convexHulls, &observer);
+    chf::ScopedTimer timer(instrumentation, chf::Stage::WRITE);
+    writeConvexHulls(convexHulls, keptIndices, outputFile, pretty);
+    return keptIndices;
+  }
+
+  std::ofstream ofs(outputFile, std::ios::binary);
+  if (!ofs) {
+    throw std::runtime_error("Couldn't open " + outputFile);
+  }
+  chf::JsonHullWriter jsonWriter(&ofs, pretty);
+  // The writer thread only times its own work, its allocations are counted
+  // in the stages running at the same time. Waiting for it isn't counted,
+  // the WRITE stage is the time spent writing and nothing else.
+  chf::AsyncHullWriter writer(
+      [&jsonWriter, instrumentation](const chf::ConvexHull& convexHull) {
+        auto start = std::chrono::steady_clock::now();
+        jsonWriter.write(convexHull);
+        std::chrono::duration<double> elapsed =
+            std::chrono::steady_clock::now() - start;
+        instrumentation->addTime(chf::Stage::WRITE, elapsed.count());
+      });
+  WritingObserver observer(convexHulls, sampleRate, &writer);
+  auto keptIndices = hullFilter->filter(convexHulls, &observer);
+  writer.finish();
+  // The writer thread is done, only the end of the document is left
+  chf::ScopedTimer timer(instrumentation, chf::Stage::WRITE);
+  jsonWriter.close();
+  return keptIndices;
+}
+
+// Filter the shards in worker processes then write the results, the output
+// can only start once the pairs across the shards are reconciled
+std::vector<int> filterSharded(const std::vector<chf::ConvexHull>& convexHulls,
+                               const chf::ShardedFilterConfig& config,
+                               const std::string& outputFile, bool pretty,
+                               chf::Instrumentation* instrumentation) {
+  chf::ShardedFilter shardedFilter(config);
+  std::vector<int> keptIndices;
+  {
+    chf::ScopedTimer timer(instrumentation, chf::Stage::FILTER);
+    keptIndices = shardedFilter.filter(convexHulls);
+  }
+  std::cout << "Workers took " << shardedFilter.getWorkerSeconds() * 1000.0
+            << " ms, reconciling " << shardedFilter.getNbCrossPairs()
+            << " pairs across shards between "
+            << shardedFilter.getNbBoundaryConvexHulls()
+            << " convex hulls took "
+            << shardedFilter.getReconcileSeconds() * 1000.0 << " ms"
+            << std::endl;
+  chf::ScopedTimer timer(instrumentation, chf::Stage::WRITE);
+  writeConvexHulls(convexHulls, keptIndices, outputFile, pretty);
+  return keptIndices;
+}
+
+void printReport(const chf::Instrumentation& instrumentation) {
+  for (auto stage : {chf::Stage::LOAD, chf::Stage::TREE_BUILD,
+                     chf::Stage::BROAD_PHASE, chf::Stage::NARROW_PHASE,
+                     chf::Stage::FILTER, chf::Stage::WRITE}) {
+    std::cout << std::setw(13) << std::setfill(' ') << std::left
+              << chf::Instrumentation::getName(stage) << std::right
+              << std::setw(10) << instrumentation.getSeconds(stage) * 1000.0
+              << " ms" << std::endl;
+  }
+  std::cout << "Candidate pairs : "
+            << instrumentation.get(chf::Counter::CANDIDATE_PAIRS)
+            << " | Intersections : "
+            << instrumentation.get(chf::Counter::INTERSECTIONS)
+            << " | Removals : " << instrumentation.get(chf::Counter::REMOVALS)
+            << " | Allocations : "
+            << instrumentation.get(chf::Counter::ALLOCATIONS) << std::endl;
+  if (instrumentation.get(chf::Counter::COMPONENTS) > 0) {
+    std::cout << "Components : "
+              << instrumentation.get(chf::Counter::COMPONENTS)
+              << " | Largest component : "
+              << instrumentation.get(chf::Counter::LARGEST_COMPONENT)
+              << " pairs | Mean : "
+              << instrumentation.get(chf::Gauge::MEAN_COMPONENT_PAIRS)
+              << " pairs | Isolated : "
+              << instrumentation.get(chf::Counter::ISOLATED_CONVEX_HULLS)
+              << " convex hulls | Scheduling efficiency : "
+              << instrumentation.get(chf::Gauge::SCHEDULING_EFFICIENCY) * 100.0
+              << "%" << std::endl;
+  }
+  if (instrumentation.get(chf::Counter::BOUNDED_PAIRS) > 0) {
+    std::cout << "Settled by bounds : "
+              << instrumentation.get(chf::Counter::BOUNDED_PAIRS) << " of "
+              << instrumentation.get(chf::Counter::CANDIDATE_PAIRS)
+              << " candidate pairs" << std::endl;
+  }
+  if (instrumentation.get(chf::Counter::REJECTED_PAIRS) > 0) {
+    std::cout << "Rejected by leaf volumes : "
+              << instrumentation.get(chf::Counter::REJECTED_PAIRS)
+              << " pairs whose boxes intersect" << std::endl;
+  }
+  std::uint64_t nbCacheHits = instrumentation.get(chf::Counter::CACHE_HITS);
+  std::uint64_t nbCacheMisses =
+      instrumentation.get(chf::Counter::CACHE_MISSES);
+  if (nbCacheHits + nbCacheMisses > 0) {
+    std::cout << "Overlap cache : " << nbCacheHits << " hits | "
+              << nbCacheMisses << " misses ("
+              << 100.0 * nbCacheHits / (nbCacheHits + nbCacheMisses)
+              << " % hit rate)" << std::endl;
+  }
+}
+
+// Write the report to reportFile, - for the standard output and empty for
+// none. Return false when it couldn't be written.
+bool writeReport(const chf::Instrumentation& instrumentation,
+                 const std::string& reportFile) {
+  if (reportFile == "-") {
+    instrumentation.writeReport(&std::cout);
+  } else if (!reportFile.empty()) {
+    std::ofstream ofs(reportFile);
+    instrumentation.writeReport(&ofs);
+    if (!ofs) {
+      std::cerr << "Couldn't write " << reportFile << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+void printUsage() {
+  std::cout << "Usage: convex_hull_filtering [options] input_file" << std::endl;
+  std::cout << "       convex_hull_filtering [options] --serve SOCKET"
+            << std::endl;
+  std::cout << "The input can be a JSON (- for stdin) or a binary .chb file"
+            << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --output FILE      Output file, .chb for the binary format "
+               "(result_convex_hulls.json)"
+            << std::endl;
+  std::cout << "  --convert FILE     Only convert the input to FILE (.json or "
+               ".chb)"
+            << std::endl;
+  std::cout << "  --export-overlaps FILE" << std::endl;
+  std::cout << "                     Only write the overlap ratios of every "
+               "pair to FILE (.chm), see convex_hull_filtering_query"
+            << std::endl;
+  std::cout << "  --compact          Write the JSON without any whitespace"
+            << std::endl;
+  std::cout << "  --report FILE      Write the stage timings and counters as "
+               "JSON (- for stdout)"
+            << std::endl;
+  std::cout << "  --memory-budget MB Filter by tiles spilled to disk so that "
+               "a tile and its halo fit in MB"
+            << std::endl;
+  std::cout << "  --tmp-dir DIR      Where the tiles and shards are written "
+               "(system temporary directory)"
+            << std::endl;
+  std::cout << "  --workers N        Filter shards of the plane in N worker "
+               "processes"
+            << std::endl;
+  std::cout << "  --serve SOCKET     Filter the batches sent to the Unix "
+               "socket until asked to stop"
+            << std::endl;
+  std::cout << "  --reference FILE   Convex hulls kept loaded by --serve, the "
+               "batches are also filtered against them"
+            << std::endl;
+  std::cout << "  --debug-sample N   Log one overlap out of N, 1 also prints "
+               "the tree (0)"
+            << std::endl;
+  std::cout << "  --threshold PCT    Removal threshold in percent (50)"
+            << std::endl;
+  std::cout << "  --rule each|smaller" << std::endl;
+  std::cout << "                     Remove every overlapped convex hull or "
+               "only the smaller of a pair (each)"
+            << std::endl;
+  std::cout << "  --threads N        Loading and narrow phase threads (all the "
+               "cores)"
+            << std::endl;
+  std::cout << "  --resolution X     Snap the coordinates to a grid of step X "
+               "and intersect with exact integer predicates (off)"
+            << std::endl;
+  std::cout << "  --approximate      Only intersect the large convex hulls "
+               "whose overlap bounds straddle the threshold"
+            << std::endl;
+  std::cout << "  --overlap-cache FILE" << std::endl;
+  std::cout << "                     Reuse the overlaps computed by the "
+               "previous runs, stored in FILE (off)"
+            << std::endl;
+  std::cout << "  --overlap-cache-size N" << std::endl;
+  std::cout << "                     Pairs kept in the overlap cache before "
+               "evicting the least recently used (262144)"
+            << std::endl;
+  std::cout << "  --leaf-volume box|kdop|obb" << std::endl;
+  std::cout << "                     Also test the 8-DOP or the oriented "
+               "boxes of the pairs whose boxes intersect (box)"
+            << std::endl;
+  std::cout << "  --mode pairwise|greedy" << std::endl;
+  std::cout << "                     Check every pair or do a non maximum "
+               "suppression by score (pairwise)"
+            << std::endl;
+  std::cout << "  --score area|field Score of the greedy mode, the area or the "
+               "\"score\" of the hull (area)"
+            << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-  if (argc != 2) {
-    std::cout << "Usage: convex_hull_filtering input_file.json" << std::endl;
+  std::string filePath;
+  std::string outputFile = "result_convex_hulls.json";
+  std::string convertFile;
+  std::string exportFile;
+  bool pretty = true;
+  std::string reportFile;
+  unsigned int sampleRate = 0;
+  chf::TiledFilterConfig tiledConfig;
+  bool tiled = false;
+  chf::ShardedFilterConfig shardedConfig;
+  shardedConfig.nbWorkers = 1;
+  std::string workerShardFile;
+  std::string workerResultFile;
+  std::string workerConfigFile;
+  chf::FilterServerConfig serverConfig;
+  chf::HullFilterConfig config;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help") {
+      printUsage();
+      return 0;
+    } else if (arg == "--output" && hasValue) {
+      outputFile = argv[++i];
+    } else if (arg == "--convert" && hasValue) {
+      convertFile = argv[++i];
+    } else if (arg == "--export-overlaps" && hasValue) {
+      exportFile = argv[++i];
+    } else if (arg == "--compact") {
+      pretty = false;
+    } else if (arg == "--report" && hasValue) {
+      reportFile = argv[++i];
+    } else if (arg == "--memory-budget" && hasValue) {
+      tiled = true;
+      tiledConfig.memoryBudget = static_cast<std::size_t>(
+          std::max(0.001, std::atof(argv[++i])) * 1e6);
+    } else if (arg == "--tmp-dir" && hasValue) {
+      tiledConfig.tmpDir = argv[++i];
+    } else if (arg == "--workers" && hasValue) {
+      shardedConfig.nbWorkers = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--worker" && i + 3 < argc) {
+      // Started by the coordinator of --workers, not meant to be used directly
+      workerShardFile = argv[++i];
+      workerResultFile = argv[++i];
+      workerConfigFile = argv[++i];
+    } else if (arg == "--serve" && hasValue) {
+      serverConfig.socketPath = argv[++i];
+    } else if (arg == "--reference" && hasValue) {
+      serverConfig.referenceFile = argv[++i];
+    } else if (arg == "--debug-sample" && hasValue) {
+      sampleRate = std::max(0, std::atoi(argv[++i]));
+    } else if (arg == "--threshold" && hasValue) {
+      config.threshold = std::atof(argv[++i]);
+    } else if (arg == "--rule" && hasValue) {
+      std::string rule(argv[++i]);
+      if (rule == "each") {
+        config.removalRule = chf::RemovalRule::EACH_OVERLAPPED;
+      } else if (rule == "smaller") {
+        config.removalRule = chf::RemovalRule::SMALLER_OF_PAIR;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--mode" && hasValue) {
+      std::string mode(argv[++i]);
+      if (mode == "pairwise") {
+        config.mode = chf::FilterMode::PAIRWISE;
+      } else if (mode == "greedy") {
+        config.mode = chf::FilterMode::GREEDY;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--score" && hasValue) {
+      std::string score(argv[++i]);
+      if (score == "area") {
+        config.scoreSource = chf::ScoreSource::AREA;
+      } else if (score == "field") {
+        config.scoreSource = chf::ScoreSource::FIELD;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--threads" && hasValue) {
+      config.nbThreads = std::max(1, std::atoi(argv[++i]));
+    } else if (arg == "--resolution" && hasValue) {
+      config.resolution = std::atof(argv[++i]);
+    } else if (arg == "--approximate") {
+      config.approximate = true;
+    } else if (arg == "--leaf-volume" && hasValue) {
+      std::string leafVolume(argv[++i]);
+      if (leafVolume == "box") {
+        config.leafVolume = chf::LeafVolume::BOX;
+      } else if (leafVolume == "kdop") {
+        config.leafVolume = chf::LeafVolume::KDOP8;
+      } else if (leafVolume == "obb") {
+        config.leafVolume = chf::LeafVolume::ORIENTED_BOX;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--overlap-cache" && hasValue) {
+      config.overlapCacheFile = argv[++i];
+    } else if (arg == "--overlap-cache-size" && hasValue) {
+      config.overlapCacheEntries = std::max(1LL, std::atoll(argv[++i]));
+    } else if (arg.rfind("--", 0) != 0 && filePath.empty()) {
+      filePath = arg;
+    } else {
+      printUsage();
+      return -1;
+    }
+  }
+  if (!workerShardFile.empty()) {
+    try {
+      chf::ShardedFilter::runWorker(workerShardFile, workerResultFile,
+                                    workerConfigFile);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    return 0;
+  }
+  if (!serverConfig.socketPath.empty()) {
+    serverConfig.filter = config;
+    try {
+      chf::FilterServer server(serverConfig);
+      std::cout << "Listening on " << serverConfig.socketPath << " with "
+                << server.getNbReferenceConvexHulls()
+                << " reference convex hulls" << std::endl;
+      server.run();
+      std::cout << "Served " << server.getNbRequests() << " requests"
+                << std::endl;
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    return 0;
+  }
+  if (filePath.empty()) {
+    printUsage();
     return -1;
   }
 
   std::cout << std::fixed << std::setprecision(2);
 
-  std::string filePath(argv[1u]);
-  std::string outputFile = "result_convex_hulls.json";
+  chf::Instrumentation instrumentation;
+  instrumentation.setAllocationCounter(
+      []() { return allocationCount.load(std::memory_order_relaxed); });
+
+  if (tiled) {
+    std::cout << "Filtering " << filePath << " by tiles of "
+              << tiledConfig.memoryBudget / 1e6 << " MB..." << std::endl;
+    tiledConfig.filter = config;
+    chf::TiledFilter tiledFilter(tiledConfig);
+    tiledFilter.setInstrumentation(&instrumentation);
+    try {
+      std::size_t nbKept = tiledFilter.filter(filePath, outputFile, pretty);
+      std::cout << "Kept " << nbKept << " convex hulls using "
+                << tiledFilter.getNbTiles() << " tiles, wrote " << outputFile
+                << std::endl;
+      std::cout << "The largest tile and its halo took about "
+                << tiledFilter.getLargestTileBytes() / 1e6 << " MB";
+      if (tiledFilter.getLargestTileBytes() > tiledConfig.memoryBudget) {
+        std::cout << ", over the budget as its halo alone doesn't fit";
+      }
+      std::cout << std::endl;
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    instrumentation.add(chf::Counter::ALLOCATIONS,
+                        allocationCount.load(std::memory_order_relaxed));
+    std::cout << std::string(50, '-') << std::endl;
+    printReport(instrumentation);
+    return writeReport(instrumentation, reportFile) ? 0 : -1;
+  }
+
   std::vector<chf::ConvexHull> convexHulls;
   std::cout << "Loading " << filePath << "..." << std::endl;
 
   try {
-    convexHulls = loadJson(filePath);
+    chf::ScopedTimer timer(&instrumentation, chf::Stage::LOAD);
+    convexHulls = chf::loadConvexHulls(filePath, config.nbThreads);
   } catch (std::exception& e) {
     std::cerr << "Couldn't load file " << filePath << std::endl;
     std::cerr << e.what() << std::endl;
     return -1;
   }
 
-  std::cout << "Loaded " << convexHulls.size() << " convex hulls : ";
-  for (auto convexHull : convexHulls) {
-    std::cout << convexHull.id << " ";
-  }
-  std::cout << std::endl;
-  std::cout << std::string(50, '-') << std::endl;
-
-  chf::RTree rtree(1, 3);
-
-  std::cout << "Building the RTree..." << std::endl;
-  for (std::size_t i = 0; i < convexHulls.size(); i++) {
-    const auto& convexHull = convexHulls[i];
-    chf::BoundingBox bb(convexHull.points);
-
-    // When inserting use the index in the vector instead
-    rtree.insertEntry(i, bb);
+  if (!convertFile.empty()) {
+    try {
+      if (chf::hasBinaryExtension(convertFile)) {
+        chf::saveConvexHulls(convertFile, convexHulls);
+      } else {
+        chf::saveJson(convertFile, convexHulls, pretty);
+      }
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    std::cout << "Converted " << convexHulls.size() << " convex hulls to "
+              << convertFile << std::endl;
+    return 0;
   }
-  std::cout << "Built the following tree" << std::endl;
-  printTree(*rtree.treeRoot, 0);
-  std::cout << std::string(50, '-') << std::endl;
 
-  std::cout << "Searching for bounding box overlaps..." << std::endl;
-  auto pairwiseIntersections = rtree.findPairwiseIntersections();
-  std::cout << "Found " << pairwiseIntersections.size()
-            << " bounding box intersections : ";
-  for (auto pair : pairwiseIntersections) {
-    auto convexHull1 = convexHulls[pair.first];
-    auto convexHull2 = convexHulls[pair.second];
-    std::cout << "[" << convexHull1.id << ", " << convexHull2.id << "] ";
+  std::cout << "Loaded " << convexHulls.size() << " convex hulls";
+  if (sampleRate == 1) {
+    std::cout << " : ";
+    for (const auto& convexHull : convexHulls) {
+      std::cout << convexHull.id << " ";
+    }
   }
   std::cout << std::endl;
-  std::cout << std::string(50, '-') << std::endl;
 
-  std::unordered_set<int> convexHullsToRemove;
-
-  std::cout << "Checking convex hull intersections..." << std::endl;
-  for (auto pair : pairwiseIntersections) {
-    auto convexHull1 = convexHulls[pair.first];
-    auto convexHull2 = convexHulls[pair.second];
-    auto [inter, interConvexHull] = convexHull1.intersection(convexHull2);
-    if (inter) {
-      float interArea = interConvexHull.getArea();
-      float convexHullArea1 = convexHull1.getArea();
-      float convexHullArea2 = convexHull2.getArea();
-      float r1 = (interArea / convexHullArea1 * 100);
-      float r2 = (interArea / convexHullArea2 * 100);
-      std::cout << "Area [";
-      std::cout << std::setw(3) << std::setfill(' ') << convexHull1.id << ", ";
-      std::cout << std::setw(3) << std::setfill(' ') << convexHull2.id << "] ";
-      std::cout << std::setw(6) << std::setfill(' ') << convexHullArea1 << " (";
-      std::cout << std::setw(6) << std::setfill(' ') << r1 << " %) | ";
-      std::cout << std::setw(6) << std::setfill(' ') << interArea << " | ";
-      std::cout << std::setw(6) << std::setfill(' ') << convexHullArea2 << " (";
-      std::cout << std::setw(6) << std::setfill(' ') << r2 << " %) ";
-      if (r1 > 50.0f) {
-        std::cout << "Should remove " << convexHull1.id << " ";
-        convexHullsToRemove.insert(pair.first);
-      }
-      if (r2 > 50.0f) {
-        std::cout << "Should remove " << convexHull2.id << " ";
-        convexHullsToRemove.insert(pair.second);
-      }
-      std::cout << std::endl;
+  if (!exportFile.empty()) {
+    try {
+      auto matrix =
+          chf::computeOverlapMatrix(convexHulls, config, &instrumentation);
+      chf::ScopedTimer timer(&instrumentation, chf::Stage::WRITE);
+      matrix.save(exportFile);
+      std::cout << "Wrote the overlaps of " << matrix.getNbEntries() / 2
+                << " pairs to " << exportFile << std::endl;
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
     }
+    instrumentation.add(chf::Counter::ALLOCATIONS,
+                        allocationCount.load(std::memory_order_relaxed));
+    std::cout << std::string(50, '-') << std::endl;
+    printReport(instrumentation);
+    return writeReport(instrumentation, reportFile) ? 0 : -1;
   }
-  std::cout << std::string(50, '-') << std::endl;
 
-  std::cout << "Filtering..." << std::endl;
-  std::vector<chf::ConvexHull> results;
-  for (std::size_t i = 0; i < convexHulls.size(); i++) {
-    if (convexHullsToRemove.find(i) == convexHullsToRemove.end()) {
-      results.push_back(convexHulls[i]);
+  std::cout << "Filtering and writing results to file " << outputFile << "..."
+            << std::endl;
+  chf::HullFilter hullFilter(config);
+  hullFilter.setInstrumentation(&instrumentation);
+  std::vector<int> keptIndices;
+  try {
+    if (shardedConfig.nbWorkers > 1) {
+      shardedConfig.filter = config;
+      shardedConfig.tmpDir = tiledConfig.tmpDir;
+      shardedConfig.workerExecutable = "/proc/self/exe";
+      keptIndices = filterSharded(convexHulls, shardedConfig, outputFile,
+                                  pretty, &instrumentation);
+    } else {
+      keptIndices = filterToFile(convexHulls, &hullFilter, outputFile, pretty,
+                                 sampleRate, &instrumentation);
     }
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
   }
-  std::cout << "Remaining convex hulls : ";
-  for (auto convexHull : results) {
-    std::cout << convexHull.id << " ";
+
+  if (sampleRate == 1) {
+    std::cout << "Remaining convex hulls : ";
+    for (int idx : keptIndices) {
+      std::cout << convexHulls[idx].id << " ";
+    }
+    std::cout << std::endl;
   }
-  std::cout << std::endl;
+  std::cout << "Kept " << keptIndices.size() << " of " << convexHulls.size()
+            << " convex hulls, wrote " << outputFile << std::endl;
 
-  std::cout << "Writing results to file " << outputFile << "..." << std::endl;
-  json res = convertToJson(results);
-  std::ofstream o(outputFile);
-  o << std::setw(4) << res << std::endl;
-  std::cout << "Wrote " << outputFile << std::endl;
-  return 0;
+  instrumentation.add(chf::Counter::ALLOCATIONS,
+                      allocationCount.load(std::memory_order_relaxed));
+  std::cout << std::string(50, '-') << std::endl;
+  printReport(instrumentation);
+  return writeReport(instrumentation, reportFile) ? 0 : -1;
 }
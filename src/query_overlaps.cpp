@@ -0,0 +1,217 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/OverlapMatrix.hpp"
+
+namespace chf = convex_hull_filtering;
+
+void printUsage() {
+  std::cout << "Usage: convex_hull_filtering_query [options] matrix_file"
+            << std::endl;
+  std::cout << "Filter an overlap matrix (.chm) written by "
+               "convex_hull_filtering --export-overlaps for several thresholds"
+            << std::endl;
+  std::cout << "Options:" << std::endl;
+  std::cout << "  --thresholds LIST  Comma separated thresholds in percent "
+               "(50)"
+            << std::endl;
+  std::cout << "  --sweep MIN MAX STEP" << std::endl;
+  std::cout << "                     Thresholds from MIN to MAX included"
+            << std::endl;
+  std::cout << "  --rule LIST        Comma separated removal rules among each "
+               "and smaller (each)"
+            << std::endl;
+  std::cout << "  --mode LIST        Comma separated modes among pairwise and "
+               "greedy (pairwise)"
+            << std::endl;
+  std::cout << "  --score area|field Score of the greedy mode (area)"
+            << std::endl;
+  std::cout << "  --output FILE      Write the IDs kept by every evaluation as "
+               "JSON"
+            << std::endl;
+}
+
+std::vector<std::string> split(const std::string& list) {
+  std::vector<std::string> items;
+  std::istringstream iss(list);
+  std::string item;
+  while (std::getline(iss, item, ',')) {
+    items.push_back(item);
+  }
+  return items;
+}
+
+// One filter to replay, the rule is only used by the pairwise mode
+class Evaluation {
+ public:
+  std::string mode;
+  std::string rule;
+  float threshold;
+  std::vector<int> keptIndices;
+};
+
+void writeEvaluations(const std::string& filePath,
+                      const chf::OverlapMatrix& matrix,
+                      const std::vector<Evaluation>& evaluations) {
+  std::ofstream ofs(filePath, std::ios::binary);
+  if (!ofs) {
+    throw std::runtime_error("Couldn't open " + filePath);
+  }
+  char number[32];
+  ofs << "{\"evaluations\":[";
+  for (std::size_t i = 0; i < evaluations.size(); i++) {
+    const auto& evaluation = evaluations[i];
+    *chf::formatJsonNumber(evaluation.threshold, number) = '\0';
+    ofs << (i > 0 ? "," : "") << "\n{\"mode\":\"" << evaluation.mode
+        << "\",\"rule\":\"" << evaluation.rule << "\",\"threshold\":"
+        << number << ",\"kept\":[";
+    for (std::size_t k = 0; k < evaluation.keptIndices.size(); k++) {
+      ofs << (k > 0 ? "," : "")
+          << matrix.getConvexHull(evaluation.keptIndices[k]).id;
+    }
+    ofs << "]}";
+  }
+  ofs << "\n]}\n";
+  if (!ofs) {
+    throw std::runtime_error("Couldn't write " + filePath);
+  }
+}
+
+int main(int argc, char* argv[]) {
+  std::string filePath;
+  std::string outputFile;
+  std::vector<float> thresholds;
+  std::vector<std::string> rules = {"each"};
+  std::vector<std::string> modes = {"pairwise"};
+  chf::HullFilterConfig config;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg(argv[i]);
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help") {
+      printUsage();
+      return 0;
+    } else if (arg == "--thresholds" && hasValue) {
+      for (const auto& item : split(argv[++i])) {
+        thresholds.push_back(std::atof(item.c_str()));
+      }
+    } else if (arg == "--sweep" && i + 3 < argc) {
+      float minThreshold = std::atof(argv[++i]);
+      float maxThreshold = std::atof(argv[++i]);
+      float step = std::atof(argv[++i]);
+      if (!(step > 0.0f)) {
+        printUsage();
+        return -1;
+      }
+      // Computed from the index so that the steps don't accumulate errors
+      for (int k = 0; minThreshold + k * step <= maxThreshold + 1e-3f * step;
+           k++) {
+        thresholds.push_back(minThreshold + k * step);
+      }
+    } else if (arg == "--rule" && hasValue) {
+      rules = split(argv[++i]);
+    } else if (arg == "--mode" && hasValue) {
+      modes = split(argv[++i]);
+    } else if (arg == "--score" && hasValue) {
+      std::string score(argv[++i]);
+      if (score == "area") {
+        config.scoreSource = chf::ScoreSource::AREA;
+      } else if (score == "field") {
+        config.scoreSource = chf::ScoreSource::FIELD;
+      } else {
+        printUsage();
+        return -1;
+      }
+    } else if (arg == "--output" && hasValue) {
+      outputFile = argv[++i];
+    } else if (arg.rfind("--", 0) != 0 && filePath.empty()) {
+      filePath = arg;
+    } else {
+      printUsage();
+      return -1;
+    }
+  }
+  if (filePath.empty()) {
+    printUsage();
+    return -1;
+  }
+  if (thresholds.empty()) {
+    thresholds.push_back(config.threshold);
+  }
+  for (const auto& rule : rules) {
+    if (rule != "each" && rule != "smaller") {
+      printUsage();
+      return -1;
+    }
+  }
+  for (const auto& mode : modes) {
+    if (mode != "pairwise" && mode != "greedy") {
+      printUsage();
+      return -1;
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  chf::OverlapMatrix matrix;
+  try {
+    matrix = chf::OverlapMatrix::load(filePath);
+  } catch (std::exception& e) {
+    std::cerr << e.what() << std::endl;
+    return -1;
+  }
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << std::fixed << std::setprecision(2);
+  std::cout << "Loaded " << matrix.getNbEntries() / 2
+            << " overlapping pairs of " << matrix.size() << " convex hulls in "
+            << elapsed.count() * 1000.0 << " ms" << std::endl;
+
+  std::vector<Evaluation> evaluations;
+  start = std::chrono::steady_clock::now();
+  for (const auto& mode : modes) {
+    config.mode =
+        mode == "greedy" ? chf::FilterMode::GREEDY : chf::FilterMode::PAIRWISE;
+    // The greedy mode has no removal rule
+    std::vector<std::string> modeRules =
+        mode == "greedy" ? std::vector<std::string>{"-"} : rules;
+    for (const auto& rule : modeRules) {
+      config.removalRule = rule == "smaller"
+                               ? chf::RemovalRule::SMALLER_OF_PAIR
+                               : chf::RemovalRule::EACH_OVERLAPPED;
+      for (float threshold : thresholds) {
+        config.threshold = threshold;
+        evaluations.push_back({mode, rule, threshold, matrix.filter(config)});
+        std::cout << std::setw(9) << std::left << mode << std::setw(8) << rule
+                  << std::right << std::setw(7) << threshold << " % : kept "
+                  << evaluations.back().keptIndices.size() << std::endl;
+      }
+    }
+  }
+  elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Evaluated " << evaluations.size() << " filters in "
+            << elapsed.count() * 1000.0 << " ms" << std::endl;
+
+  if (!outputFile.empty()) {
+    try {
+      writeEvaluations(outputFile, matrix, evaluations);
+    } catch (std::exception& e) {
+      std::cerr << e.what() << std::endl;
+      return -1;
+    }
+    std::cout << "Wrote " << outputFile << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,44 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/AsyncHullWriter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace chf = convex_hull_filtering;
+
+TEST(AsyncHullWriter, writesInPushOrder) {
+  std::vector<chf::ConvexHull> convexHulls;
+  for (int i = 0; i < 1000; i++) {
+    convexHulls.push_back(chf::ConvexHull({chf::Point(i, i)}, i));
+  }
+  std::vector<int> written;
+  chf::AsyncHullWriter writer(
+      [&written](const chf::ConvexHull& convexHull) {
+        written.push_back(convexHull.id);
+      });
+  for (const auto& convexHull : convexHulls) {
+    writer.push(&convexHull);
+  }
+  writer.finish();
+  ASSERT_EQ(convexHulls.size(), written.size());
+  for (std::size_t i = 0; i < written.size(); i++) {
+    EXPECT_EQ(i, written[i]);
+  }
+}
+
+TEST(AsyncHullWriter, rethrowsWriteErrors) {
+  chf::ConvexHull convexHull({chf::Point(0, 0)}, 1);
+  chf::AsyncHullWriter writer([](const chf::ConvexHull&) {
+    throw std::runtime_error("Disk full");
+  });
+  writer.push(&convexHull);
+  writer.push(&convexHull);
+  EXPECT_THROW(writer.finish(), std::runtime_error);
+}
@@ -0,0 +1,168 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BinaryIO.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+const std::string dataDir = CONVEX_HULL_FILTERING_DATA_DIR;
+
+std::string getTmpFile(const std::string& name) {
+  return (std::filesystem::temp_directory_path() / name).string();
+}
+}  // namespace
+
+TEST(BinaryIO, roundTrip) {
+  auto convexHulls = chf::loadConvexHulls(dataDir + "/convex_hulls.json");
+  convexHulls[3].score = 0.25f;
+  for (std::uint32_t precision : {sizeof(float), sizeof(double)}) {
+    std::string filePath = getTmpFile("chf_test_round_trip.chb");
+    chf::saveBinary(filePath, convexHulls, precision);
+    ASSERT_TRUE(chf::isBinaryFile(filePath));
+
+    auto loaded = chf::loadConvexHulls(filePath);
+    ASSERT_EQ(convexHulls.size(), loaded.size());
+    for (std::size_t i = 0; i < convexHulls.size(); i++) {
+      EXPECT_EQ(convexHulls[i].id, loaded[i].id);
+      EXPECT_EQ(convexHulls[i].score, loaded[i].score);
+      ASSERT_EQ(convexHulls[i].points.size(), loaded[i].points.size());
+      for (std::size_t j = 0; j < convexHulls[i].points.size(); j++) {
+        EXPECT_EQ(convexHulls[i].points[j].x, loaded[i].points[j].x);
+        EXPECT_EQ(convexHulls[i].points[j].y, loaded[i].points[j].y);
+      }
+    }
+    std::remove(filePath.c_str());
+  }
+}
+
+TEST(BinaryIO, mappedViews) {
+  std::vector<chf::ConvexHull> convexHulls = {
+      chf::ConvexHull({chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f),
+                       chf::Point(1.0f, 1.0f)},
+                      5),
+      chf::ConvexHull({chf::Point(2.0f, 0.0f), chf::Point(3.0f, 0.0f),
+                       chf::Point(3.0f, 1.0f), chf::Point(2.0f, 1.0f)},
+                      6, 0.5f)};
+  std::string filePath = getTmpFile("chf_test_views.chb");
+  chf::saveBinary(filePath, convexHulls);
+  {
+    chf::MappedHullFile file(filePath);
+    ASSERT_EQ(2, file.size());
+    auto view = file[1];
+    EXPECT_EQ(6, view.getId());
+    EXPECT_FLOAT_EQ(0.5f, view.getScore());
+    ASSERT_EQ(4, view.size());
+    ASSERT_NE(nullptr, view.data());
+    EXPECT_FLOAT_EQ(3.0f, view.data()[2].x);
+    EXPECT_FLOAT_EQ(1.0f, view.getPoint(3).y);
+    EXPECT_THROW(file[2], std::out_of_range);
+  }
+  std::remove(filePath.c_str());
+}
+
+TEST(BinaryIO, writerChecksCount) {
+  std::string filePath = getTmpFile("chf_test_count.chb");
+  chf::BinaryHullWriter writer(filePath, 2);
+  writer.write(chf::ConvexHull({chf::Point(0.0f, 0.0f)}));
+  EXPECT_THROW(writer.close(), std::runtime_error);
+  std::remove(filePath.c_str());
+}
+
+TEST(BinaryIO, rejectsOtherFiles) {
+  EXPECT_FALSE(chf::isBinaryFile(dataDir + "/convex_hulls.json"));
+  EXPECT_THROW(chf::MappedHullFile(dataDir + "/convex_hulls.json"),
+               std::runtime_error);
+}
+
+TEST(BinaryIO, encodeDecode) {
+  auto convexHulls = chf::loadConvexHulls(dataDir + "/convex_hulls.json");
+  convexHulls[3].score = 0.25f;
+  std::vector<unsigned char> buffer;
+  chf::encodeBinary(convexHulls, &buffer);
+
+  // Same bytes as the file written by saveBinary
+  std::string filePath = getTmpFile("chf_test_encode.chb");
+  chf::saveBinary(filePath, convexHulls);
+  std::ifstream ifs(filePath, std::ios::binary);
+  std::vector<unsigned char> fileBytes((std::istreambuf_iterator<char>(ifs)),
+                                       std::istreambuf_iterator<char>());
+  EXPECT_EQ(fileBytes, buffer);
+  std::remove(filePath.c_str());
+
+  // Decoding into a vector holding more convex hulls shrinks it
+  std::vector<chf::ConvexHull> decoded(convexHulls.size() + 3,
+                                       chf::ConvexHull({chf::Point(1, 2)}));
+  chf::decodeBinary(buffer.data(), buffer.size(), &decoded);
+  ASSERT_EQ(convexHulls.size(), decoded.size());
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    EXPECT_EQ(convexHulls[i].id, decoded[i].id);
+    EXPECT_EQ(convexHulls[i].score, decoded[i].score);
+    ASSERT_EQ(convexHulls[i].points.size(), decoded[i].points.size());
+    for (std::size_t j = 0; j < convexHulls[i].points.size(); j++) {
+      EXPECT_EQ(convexHulls[i].points[j].x, decoded[i].points[j].x);
+      EXPECT_EQ(convexHulls[i].points[j].y, decoded[i].points[j].y);
+    }
+  }
+
+  EXPECT_THROW(chf::decodeBinary(buffer.data(), buffer.size() - 1, &decoded),
+               std::runtime_error);
+  EXPECT_THROW(chf::decodeBinary(buffer.data(), 10, &decoded),
+               std::runtime_error);
+}
+
+TEST(BinaryIO, rejectsCorruptOffsets) {
+  std::vector<chf::ConvexHull> convexHulls = {
+      chf::ConvexHull({chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f),
+                       chf::Point(1.0f, 1.0f)}),
+      chf::ConvexHull({chf::Point(2.0f, 0.0f), chf::Point(3.0f, 0.0f),
+                       chf::Point(3.0f, 1.0f)})};
+  std::vector<unsigned char> buffer;
+  chf::encodeBinary(convexHulls, &buffer);
+  // An offset whose sum with the count wraps around inside the vertex array
+  chf::BinaryTableEntry entry;
+  unsigned char* table = buffer.data() + sizeof(chf::BinaryHeader);
+  std::memcpy(&entry, table, sizeof(entry));
+  entry.offset = std::numeric_limits<std::uint64_t>::max() - 1;
+  std::memcpy(table, &entry, sizeof(entry));
+  std::vector<chf::ConvexHull> decoded;
+  EXPECT_THROW(chf::decodeBinary(buffer.data(), buffer.size(), &decoded),
+               std::out_of_range);
+
+  std::string filePath = getTmpFile("chf_test_corrupt.chb");
+  {
+    std::ofstream ofs(filePath, std::ios::binary);
+    ofs.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+  }
+  {
+    chf::MappedHullFile file(filePath);
+    EXPECT_THROW(file[0], std::out_of_range);
+    EXPECT_EQ(3, file[1].size());
+  }
+  std::remove(filePath.c_str());
+}
+
+TEST(BinaryIO, writerChecksWrites) {
+  if (!std::filesystem::exists("/dev/full")) {
+    GTEST_SKIP() << "No /dev/full to fail the writes";
+  }
+  chf::BinaryHullWriter writer("/dev/full", 1);
+  writer.write(chf::ConvexHull(std::vector<chf::Point>(
+      1 << 16, chf::Point(0.0f, 0.0f))));
+  EXPECT_THROW(writer.close(), std::runtime_error);
+}
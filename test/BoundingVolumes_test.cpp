@@ -0,0 +1,151 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/BoundingVolumes.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+// Thin ellipses in random directions, the worst case of the bounding boxes
+std::vector<chf::ConvexHull> makeSticks(std::size_t count, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> centerDist(0.0f, 150.0f);
+  std::uniform_real_distribution<float> angleDist(0.0f, 2.0f * M_PI);
+  std::vector<chf::ConvexHull> convexHulls;
+  for (std::size_t i = 0; i < count; i++) {
+    float cx = centerDist(gen);
+    float cy = centerDist(gen);
+    float rotation = angleDist(gen);
+    std::vector<chf::Point> points;
+    for (int k = 0; k < 12; k++) {
+      float angle = 2.0f * M_PI * k / 12;
+      float x = 10.0f * std::cos(angle);
+      float y = 1.0f * std::sin(angle);
+      points.emplace_back(cx + std::cos(rotation) * x - std::sin(rotation) * y,
+                          cy + std::sin(rotation) * x + std::cos(rotation) * y);
+    }
+    convexHulls.push_back(chf::ConvexHull(points, i));
+  }
+  return convexHulls;
+}
+
+bool isInside(const chf::OrientedBox& box, const chf::Point& pt) {
+  double dx = pt.x - box.cx;
+  double dy = pt.y - box.cy;
+  return std::fabs(box.ux * dx + box.uy * dy) <= box.halfU &&
+         std::fabs(box.ux * dy - box.uy * dx) <= box.halfV;
+}
+}  // namespace
+
+TEST(BoundingVolumes, orientedBox) {
+  // A rectangle of 4 by 1 rotated by 30 degrees is its own oriented box
+  float c = std::cos(M_PI / 6);
+  float s = std::sin(M_PI / 6);
+  std::vector<chf::Point> points = {
+      chf::Point(0.0f, 0.0f), chf::Point(4.0f * c, 4.0f * s),
+      chf::Point(4.0f * c - s, 4.0f * s + c), chf::Point(-s, c)};
+  auto box = chf::makeOrientedBox(points);
+  EXPECT_NEAR(4.0, 4.0 * box.halfU * box.halfV, 1e-4);
+  EXPECT_NEAR(1.0, std::fabs(box.ux * c + box.uy * s) +
+                       std::fabs(box.ux * s - box.uy * c), 1e-6);
+  for (const auto& pt : points) {
+    EXPECT_TRUE(isInside(box, pt));
+  }
+
+  for (const auto& convexHull : makeSticks(200, 7)) {
+    auto stickBox = chf::makeOrientedBox(convexHull.points);
+    // Much tighter than the bounding box of a stick of 20 by 2 in general
+    EXPECT_LT(4.0 * stickBox.halfU * stickBox.halfV, 41.0);
+    for (const auto& pt : convexHull.points) {
+      EXPECT_TRUE(isInside(stickBox, pt));
+    }
+  }
+
+  // Fewer than 3 points still get a box
+  auto pointBox = chf::makeOrientedBox({chf::Point(1.0f, 2.0f)});
+  EXPECT_TRUE(isInside(pointBox, chf::Point(1.0f, 2.0f)));
+}
+
+TEST(BoundingVolumes, intersect) {
+  // Two parallel diagonal sticks whose bounding boxes overlap a lot
+  std::vector<chf::ConvexHull> convexHulls = {
+      chf::ConvexHull({chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f),
+                       chf::Point(11.0f, 10.0f), chf::Point(10.0f, 10.0f)}),
+      chf::ConvexHull({chf::Point(3.0f, 0.0f), chf::Point(4.0f, 0.0f),
+                       chf::Point(14.0f, 10.0f), chf::Point(13.0f, 10.0f)}),
+      chf::ConvexHull({chf::Point(0.0f, 5.0f), chf::Point(10.0f, 5.0f),
+                       chf::Point(10.0f, 6.0f), chf::Point(0.0f, 6.0f)})};
+  for (auto leafVolume :
+       {chf::LeafVolume::KDOP8, chf::LeafVolume::ORIENTED_BOX}) {
+    chf::BoundingVolumes volumes(convexHulls, leafVolume);
+    EXPECT_EQ(3u, volumes.size());
+    EXPECT_FALSE(volumes.intersect(0, 1));
+    EXPECT_FALSE(volumes.intersect(1, 0));
+    EXPECT_TRUE(volumes.intersect(0, 2));
+    EXPECT_TRUE(volumes.intersect(1, 2));
+    EXPECT_TRUE(volumes.intersect(0, 0));
+  }
+  chf::BoundingVolumes boxes(convexHulls, chf::LeafVolume::BOX);
+  EXPECT_TRUE(boxes.intersect(0, 1));
+}
+
+TEST(BoundingVolumes, neverRejectIntersectingPairs) {
+  auto convexHulls = makeSticks(2000, 42);
+  chf::RTree rtree(4, 8);
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    rtree.insertEntry(i, chf::BoundingBox(convexHulls[i].points));
+  }
+  std::vector<std::pair<int, int>> boxPairs;
+  rtree.findPairwiseIntersections(&boxPairs);
+  for (auto leafVolume :
+       {chf::LeafVolume::KDOP8, chf::LeafVolume::ORIENTED_BOX}) {
+    chf::BoundingVolumes volumes(convexHulls, leafVolume);
+    std::vector<std::pair<int, int>> pairs;
+    std::size_t nbRejected = rtree.findPairwiseIntersections(&pairs, volumes);
+    EXPECT_EQ(boxPairs.size(), pairs.size() + nbRejected);
+    EXPECT_GT(nbRejected, boxPairs.size() / 4);
+    std::vector<chf::Point> interPoints;
+    for (const auto& pair : boxPairs) {
+      if (volumes.intersect(pair.first, pair.second)) {
+        continue;
+      }
+      float interArea;
+      EXPECT_FALSE(convexHulls[pair.first].intersectionArea(
+          convexHulls[pair.second], &interArea, &interPoints))
+          << pair.first << " " << pair.second;
+    }
+  }
+}
+
+TEST(BoundingVolumes, hullFilter) {
+  auto convexHulls = makeSticks(2000, 3);
+  for (auto mode : {chf::FilterMode::PAIRWISE, chf::FilterMode::GREEDY}) {
+    chf::HullFilterConfig config;
+    config.mode = mode;
+    config.threshold = 20.0f;
+    auto expected = chf::HullFilter(config).filter(convexHulls);
+    for (auto leafVolume :
+         {chf::LeafVolume::KDOP8, chf::LeafVolume::ORIENTED_BOX}) {
+      config.leafVolume = leafVolume;
+      chf::HullFilter hullFilter(config);
+      chf::Instrumentation instrumentation;
+      hullFilter.setInstrumentation(&instrumentation);
+      EXPECT_EQ(expected, hullFilter.filter(convexHulls));
+      EXPECT_GT(instrumentation.get(chf::Counter::REJECTED_PAIRS), 0u);
+    }
+  }
+}
@@ -5,7 +5,35 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <new>
+#include <tuple>
+#include <vector>
+
+#include "TestData.hpp"
+
 namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+// Incremented by the global operator new below so that tests can check
+// whether a piece of code allocates on the heap
+std::atomic<std::size_t> allocationCount(0);
+}  // namespace
+
+void* operator new(std::size_t size) {
+  allocationCount++;
+  if (void* ptr = std::malloc(size)) {
+    return ptr;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
 
 TEST(ConvexHull, isPointInside) {
   std::vector<chf::Point> points = {
@@ -15,6 +43,23 @@ TEST(ConvexHull, isPointInside) {
   EXPECT_TRUE(convexHull.isPointInside(chf::Point(0.5f, 0.3f)));
 }
 
+TEST(ConvexHull, isPointInsideManyVertices) {
+  // The rounding of the angles of 128 edges adds up above EPSILON for some
+  // of the points just outside
+  for (float center : {0.0f, 1000.0f}) {
+    chf::ConvexHull disk = chft::makeDisk(center, center, 10.0f, 128);
+    for (int i = 0; i < 360; i++) {
+      float angle = 2.0f * M_PI * i / 360;
+      EXPECT_FALSE(disk.isPointInside(chf::Point(
+          center + 10.5f * std::cos(angle), center + 10.5f * std::sin(angle))))
+          << center << " " << i;
+      EXPECT_TRUE(disk.isPointInside(chf::Point(
+          center + 9.5f * std::cos(angle), center + 9.5f * std::sin(angle))))
+          << center << " " << i;
+    }
+  }
+}
+
 TEST(ConvexHull, getCircPoint) {
   chf::ConvexHull a(
       {chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f), chf::Point(1.0f, 1.0f)});
@@ -43,3 +88,87 @@ TEST(ConvexHull, intersection) {
   EXPECT_FLOAT_EQ(5.5f, interConvexHull.points[2].x);
   EXPECT_FLOAT_EQ(5.5f, interConvexHull.points[2].y);
 }
+
+TEST(ConvexHull, intersectionKeepsWholeConvexHulls) {
+  chf::ConvexHull outer({chf::Point(0.0f, 0.0f), chf::Point(10.0f, 0.0f),
+                         chf::Point(10.0f, 10.0f), chf::Point(0.0f, 10.0f)},
+                        7, 0.5f);
+  chf::ConvexHull inner({chf::Point(2.0f, 2.0f), chf::Point(4.0f, 2.0f),
+                         chf::Point(4.0f, 4.0f)},
+                        8, 0.9f);
+  chf::ConvexHull segment({chf::Point(1.0f, 1.0f), chf::Point(2.0f, 2.0f)}, 9);
+
+  // The contained convex hull comes back with its id and score, whichever
+  // side it is on
+  auto [inter, interConvexHull] = inner.intersection(outer);
+  EXPECT_TRUE(inter);
+  EXPECT_EQ(8, interConvexHull.id);
+  EXPECT_FLOAT_EQ(0.9f, interConvexHull.score);
+  EXPECT_EQ(inner.points.size(), interConvexHull.points.size());
+  std::tie(inter, interConvexHull) = outer.intersection(inner);
+  EXPECT_TRUE(inter);
+  EXPECT_EQ(8, interConvexHull.id);
+
+  // A degenerate convex hull is returned as it is
+  std::tie(inter, interConvexHull) = segment.intersection(outer);
+  EXPECT_FALSE(inter);
+  EXPECT_EQ(9, interConvexHull.id);
+  std::tie(inter, interConvexHull) = outer.intersection(segment);
+  EXPECT_FALSE(inter);
+  EXPECT_EQ(7, interConvexHull.id);
+}
+
+TEST(ConvexHull, intersectionFoundLate) {
+  // The scan walks most of the disk before it meets the square, coming back
+  // to that first crossing then takes more than 2 * (n + m) steps
+  chf::ConvexHull square = chft::makeDisk(2.0f, -4.0f, 4.0f, 4, 0.1f);
+  chf::ConvexHull disk = chft::makeDisk(0.0f, 0.0f, 7.0f, 64, 4.0f);
+  std::vector<chf::Point> interPoints;
+  float squareDiskArea;
+  ASSERT_TRUE(square.intersectionArea(disk, &squareDiskArea, &interPoints));
+  EXPECT_GT(interPoints.size(), 4u);
+  float diskSquareArea;
+  ASSERT_TRUE(disk.intersectionArea(square, &diskSquareArea, &interPoints));
+  EXPECT_NEAR(squareDiskArea, diskSquareArea, 1e-3f);
+  // A corner of the square is out of the disk
+  EXPECT_LT(squareDiskArea, square.getArea() - 1.0f);
+  EXPECT_GT(squareDiskArea, 0.9f * square.getArea());
+}
+
+TEST(ConvexHull, intersectionWithScratchBuffer) {
+  chf::ConvexHull a({chf::Point(0.0f, 0.0f), chf::Point(10.0f, 0.0f),
+                     chf::Point(10.0f, 10.0f)});
+  chf::ConvexHull b({chf::Point(0.0f, 11.0f), chf::Point(11.0f, 0.0f),
+                     chf::Point(11.0f, 11.0f)});
+  std::vector<chf::Point> interPoints;
+  ASSERT_TRUE(a.intersection(b, &interPoints));
+  ASSERT_EQ(3, interPoints.size());
+  EXPECT_FLOAT_EQ(10.0f, interPoints[0].x);
+  EXPECT_FLOAT_EQ(1.0f, interPoints[0].y);
+  EXPECT_FLOAT_EQ(20.25f, chf::ConvexHull::computeArea(interPoints));
+}
+
+TEST(ConvexHull, intersectionDoesNotAllocate) {
+  chf::ConvexHull a({chf::Point(0.0f, 0.0f), chf::Point(10.0f, 0.0f),
+                     chf::Point(10.0f, 10.0f), chf::Point(0.0f, 10.0f)});
+  chf::ConvexHull b({chf::Point(5.0f, 5.0f), chf::Point(15.0f, 5.0f),
+                     chf::Point(15.0f, 15.0f), chf::Point(5.0f, 15.0f)});
+  chf::ConvexHull c({chf::Point(2.0f, 2.0f), chf::Point(3.0f, 2.0f),
+                     chf::Point(3.0f, 3.0f)});
+  std::vector<chf::Point> interPoints;
+  // The first call sizes the buffer, the following ones must reuse it
+  a.intersection(b, &interPoints);
+
+  std::size_t allocationsBefore = allocationCount;
+  float area = 0.0f;
+  for (int i = 0; i < 100; i++) {
+    if (a.intersection(b, &interPoints)) {
+      area += chf::ConvexHull::computeArea(interPoints);
+    }
+    if (a.intersection(c, &interPoints)) {
+      area += chf::ConvexHull::computeArea(interPoints);
+    }
+  }
+  EXPECT_EQ(allocationsBefore, allocationCount);
+  EXPECT_FLOAT_EQ(100 * (25.0f + 0.5f), area);
+}
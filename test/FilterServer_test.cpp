@@ -0,0 +1,198 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/FilterServer.hpp"
+
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+const std::string dataDir = CONVEX_HULL_FILTERING_DATA_DIR;
+
+std::vector<int> filterIds(const std::vector<chf::ConvexHull>& convexHulls,
+                           const chf::HullFilterConfig& config) {
+  chf::HullFilter hullFilter(config);
+  std::vector<int> ids;
+  for (int idx : hullFilter.filter(convexHulls)) {
+    ids.push_back(convexHulls[idx].id);
+  }
+  return ids;
+}
+
+class FilterServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    convexHulls = chf::loadConvexHulls(dataDir + "/convex_hulls.json");
+    config.socketPath =
+        (std::filesystem::temp_directory_path() / "chf_server_test.sock")
+            .string();
+    config.filter.nbThreads = 2;
+  }
+
+  // Run the server on its own thread until it is asked to stop
+  void startServer() {
+    server = std::make_unique<chf::FilterServer>(config);
+    serverThread = std::thread([this]() { server->run(); });
+  }
+
+  void stopServer() {
+    chf::FilterClient(config.socketPath).shutdown();
+    serverThread.join();
+    server.reset();
+  }
+
+  std::vector<chf::ConvexHull> convexHulls;
+  chf::FilterServerConfig config;
+  std::unique_ptr<chf::FilterServer> server;
+  std::thread serverThread;
+};
+}  // namespace
+
+TEST_F(FilterServerTest, sameAsHullFilter) {
+  startServer();
+  {
+    chf::FilterClient client(config.socketPath);
+    auto expected = filterIds(convexHulls, config.filter);
+    EXPECT_EQ(expected, client.filter(convexHulls, chf::RequestType::BINARY));
+    EXPECT_EQ(expected, client.filter(convexHulls, chf::RequestType::JSON));
+    // Batches of different sizes on the same warm server
+    std::vector<chf::ConvexHull> half(convexHulls.begin() + 3,
+                                      convexHulls.begin() + 9);
+    EXPECT_EQ(filterIds(half, config.filter), client.filter(half));
+    EXPECT_TRUE(client.filter({}).empty());
+  }
+  // A second connection after the first one closed
+  chf::FilterClient client(config.socketPath);
+  EXPECT_EQ(filterIds(convexHulls, config.filter), client.filter(convexHulls));
+  stopServer();
+  EXPECT_FALSE(std::filesystem::exists(config.socketPath));
+}
+
+TEST_F(FilterServerTest, reference) {
+  // The reference behaves like convex hulls placed after the batch
+  std::vector<chf::ConvexHull> batch(convexHulls.begin() + 4,
+                                     convexHulls.end());
+  std::vector<chf::ConvexHull> reference(convexHulls.begin(),
+                                         convexHulls.begin() + 4);
+  config.referenceFile =
+      (std::filesystem::temp_directory_path() / "chf_server_reference.chb")
+          .string();
+  chf::saveConvexHulls(config.referenceFile, reference);
+  for (auto rule :
+       {chf::RemovalRule::EACH_OVERLAPPED, chf::RemovalRule::SMALLER_OF_PAIR}) {
+    config.filter.removalRule = rule;
+    chf::FilterServer server(config);
+    EXPECT_EQ(reference.size(), server.getNbReferenceConvexHulls());
+
+    std::vector<chf::ConvexHull> all(batch);
+    all.insert(all.end(), reference.begin(), reference.end());
+    std::vector<int> expected;
+    for (int id : filterIds(all, config.filter)) {
+      if (id >= batch.front().id) {
+        expected.push_back(id);
+      }
+    }
+    EXPECT_EQ(expected, server.filterBatch(batch));
+    EXPECT_NE(filterIds(batch, config.filter), expected);
+  }
+  std::filesystem::remove(config.referenceFile);
+}
+
+TEST_F(FilterServerTest, errors) {
+  startServer();
+  chf::FilterClient client(config.socketPath);
+  std::string garbage = "{\"convex hulls\": [{\"ID\": 1, \"apexes\": [";
+  EXPECT_THROW(client.send(chf::RequestType::JSON, garbage.data(),
+                           garbage.size()),
+               std::runtime_error);
+  EXPECT_THROW(client.send(chf::RequestType::BINARY, garbage.data(),
+                           garbage.size()),
+               std::runtime_error);
+  EXPECT_THROW(client.send(static_cast<chf::RequestType>(7), nullptr, 0),
+               std::runtime_error);
+  // The connection is still usable after an error
+  EXPECT_EQ(filterIds(convexHulls, config.filter), client.filter(convexHulls));
+  stopServer();
+  EXPECT_THROW(chf::FilterClient client(config.socketPath),
+               std::runtime_error);
+}
+
+TEST_F(FilterServerTest, socketPathInUse) {
+  // Any other file is left alone
+  std::ofstream(config.socketPath) << "results";
+  EXPECT_THROW(chf::FilterServer server(config), std::runtime_error);
+  std::ifstream ifs(config.socketPath);
+  std::string content;
+  ifs >> content;
+  EXPECT_EQ("results", content);
+  std::filesystem::remove(config.socketPath);
+
+  // So is the socket of a running server
+  startServer();
+  EXPECT_THROW(chf::FilterServer server(config), std::runtime_error);
+  EXPECT_EQ(filterIds(convexHulls, config.filter),
+            chf::FilterClient(config.socketPath).filter(convexHulls));
+  stopServer();
+}
+
+TEST_F(FilterServerTest, staleSocket) {
+  // Left bound but not listening, like after a crash
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, config.socketPath.c_str());
+  std::filesystem::remove(config.socketPath);
+  ASSERT_EQ(0, bind(fd, reinterpret_cast<const sockaddr*>(&address),
+                    sizeof(address)));
+  close(fd);
+  startServer();
+  EXPECT_EQ(filterIds(convexHulls, config.filter),
+            chf::FilterClient(config.socketPath).filter(convexHulls));
+  stopServer();
+}
+
+TEST_F(FilterServerTest, stalledClient) {
+  startServer();
+  sockaddr_un address = {};
+  address.sun_family = AF_UNIX;
+  std::strcpy(address.sun_path, config.socketPath.c_str());
+  chf::MessageHeader header = {};
+  std::memcpy(header.magic, chf::REQUEST_MAGIC, sizeof(header.magic));
+  header.type = static_cast<std::uint32_t>(chf::RequestType::JSON);
+  header.size = 1000;
+  // One client stops in the middle of a header, another one in the middle
+  // of a payload
+  int headerFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(0, connect(headerFd, reinterpret_cast<const sockaddr*>(&address),
+                       sizeof(address)));
+  ASSERT_EQ(6, write(headerFd, &header, 6));
+  int payloadFd = socket(AF_UNIX, SOCK_STREAM, 0);
+  ASSERT_EQ(0, connect(payloadFd, reinterpret_cast<const sockaddr*>(&address),
+                       sizeof(address)));
+  ASSERT_EQ(static_cast<ssize_t>(sizeof(header)),
+            write(payloadFd, &header, sizeof(header)));
+  ASSERT_EQ(3, write(payloadFd, "{\"c", 3));
+
+  // The live client is served and can still stop the server
+  EXPECT_EQ(filterIds(convexHulls, config.filter),
+            chf::FilterClient(config.socketPath).filter(convexHulls));
+  stopServer();
+  close(headerFd);
+  close(payloadFd);
+}
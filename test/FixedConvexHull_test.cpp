@@ -0,0 +1,144 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/FixedConvexHull.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+chf::WorkloadConfig makeWorkloadConfig(int minVertices, int maxVertices) {
+  auto config = chft::makeClusteredConfig(300, 20, 10.0f);
+  config.minVertices = minVertices;
+  config.maxVertices = maxVertices;
+  config.overlapRate = 0.6;
+  return config;
+}
+
+chf::ConvexHull makeSquare(float x, float y, float side) {
+  return chf::ConvexHull({chf::Point(x, y), chf::Point(x + side, y),
+                          chf::Point(x + side, y + side),
+                          chf::Point(x, y + side)});
+}
+}  // namespace
+
+TEST(FixedConvexHull, computeArea) {
+  auto square = makeSquare(1.0f, 2.0f, 3.0f);
+  EXPECT_FLOAT_EQ(9.0f, chf::FixedConvexHull<4>::computeArea(
+                            square.points.data(), square.points.size()));
+  EXPECT_FLOAT_EQ(9.0f, chf::FixedConvexHull<16>::computeArea(
+                            square.points.data(), square.points.size()));
+  for (const auto& convexHull :
+       chf::generateConvexHulls(makeWorkloadConfig(3, 16))) {
+    EXPECT_EQ(chf::ConvexHull::computeArea(convexHull.points),
+              convexHull.getArea());
+  }
+}
+
+TEST(FixedConvexHull, intersectionArea) {
+  auto a = makeSquare(0.0f, 0.0f, 1.0f);
+  auto b = makeSquare(0.25f, 0.5f, 1.0f);
+  bool inter = false;
+  float interArea = 0.0f;
+  ASSERT_TRUE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, b.points.data(), 4, &inter, &interArea));
+  EXPECT_TRUE(inter);
+  EXPECT_FLOAT_EQ(0.375f, interArea);
+
+  // Clockwise clipping convex hull
+  std::vector<chf::Point> clockwise(b.points.rbegin(), b.points.rend());
+  ASSERT_TRUE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, clockwise.data(), 4, &inter, &interArea));
+  EXPECT_TRUE(inter);
+  EXPECT_FLOAT_EQ(0.375f, interArea);
+
+  // Inclusion both ways
+  auto inside = makeSquare(0.25f, 0.25f, 0.5f);
+  ASSERT_TRUE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, inside.points.data(), 4, &inter, &interArea));
+  EXPECT_FLOAT_EQ(0.25f, interArea);
+  ASSERT_TRUE(chf::FixedConvexHull<4>::intersectionArea(
+      inside.points.data(), 4, a.points.data(), 4, &inter, &interArea));
+  EXPECT_FLOAT_EQ(0.25f, interArea);
+
+  auto far = makeSquare(5.0f, 5.0f, 1.0f);
+  ASSERT_TRUE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, far.points.data(), 4, &inter, &interArea));
+  EXPECT_FALSE(inter);
+  EXPECT_EQ(0.0f, interArea);
+}
+
+TEST(FixedConvexHull, unsupported) {
+  auto a = makeSquare(0.0f, 0.0f, 1.0f);
+  bool inter = false;
+  float interArea = 0.0f;
+  std::vector<chf::Point> octagon;
+  for (int i = 0; i < 8; i++) {
+    float angle = i * std::atan(1.0f);
+    octagon.push_back(chf::Point(std::cos(angle), std::sin(angle)));
+  }
+  EXPECT_FALSE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, octagon.data(), 8, &inter, &interArea));
+  EXPECT_TRUE(chf::FixedConvexHull<8>::intersectionArea(
+      a.points.data(), 4, octagon.data(), 8, &inter, &interArea));
+  // Flat or too small clipping convex hulls
+  std::vector<chf::Point> flat = {chf::Point(0.0f, 0.0f),
+                                  chf::Point(1.0f, 1.0f),
+                                  chf::Point(2.0f, 2.0f)};
+  EXPECT_FALSE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, flat.data(), 3, &inter, &interArea));
+  EXPECT_FALSE(chf::FixedConvexHull<4>::intersectionArea(
+      a.points.data(), 4, flat.data(), 2, &inter, &interArea));
+}
+
+// The dispatcher gives the same overlaps as the generic intersection for
+// every size class, including the one left to the generic intersection
+TEST(FixedConvexHull, matchesGenericIntersection) {
+  for (auto [minVertices, maxVertices] :
+       {std::make_pair(3, 4), std::make_pair(5, 8), std::make_pair(9, 16),
+        std::make_pair(3, 32)}) {
+    auto convexHulls =
+        chf::generateConvexHulls(makeWorkloadConfig(minVertices, maxVertices));
+    std::vector<chf::Point> interPoints;
+    int nbOverlapping = 0;
+    int nbWrongInclusions = 0;
+    for (std::size_t i = 0; i < convexHulls.size(); i++) {
+      for (std::size_t j = i + 1; j < convexHulls.size(); j++) {
+        const auto& P = convexHulls[i];
+        const auto& Q = convexHulls[j];
+        bool expectedInter = P.intersection(Q, &interPoints);
+        float expectedArea =
+            expectedInter ? chf::ConvexHull::computeArea(interPoints) : 0.0f;
+        float interArea = -1.0f;
+        bool inter = P.intersectionArea(Q, &interArea, &interPoints);
+        float tolerance = 1e-4f * std::max(P.getArea(), Q.getArea());
+        if (std::fabs(expectedArea - interArea) > tolerance) {
+          // When its scan misses the crossings, the generic intersection
+          // falls back to an inclusion test that can wrongly return all of
+          // P or Q, the clipping has no such fallback
+          EXPECT_TRUE(expectedArea == P.getArea() ||
+                      expectedArea == Q.getArea());
+          EXPECT_LT(interArea, expectedArea);
+          nbWrongInclusions++;
+        } else if (expectedArea > tolerance) {
+          EXPECT_TRUE(inter);
+          nbOverlapping++;
+        }
+      }
+    }
+    EXPECT_GT(nbOverlapping, 100);
+    EXPECT_LE(nbWrongInclusions, 2);
+  }
+}
@@ -0,0 +1,124 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/HullFilter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+const std::string dataDir = CONVEX_HULL_FILTERING_DATA_DIR;
+
+std::vector<int> getIds(const std::vector<chf::ConvexHull>& convexHulls,
+                        const std::vector<int>& indices) {
+  std::vector<int> ids;
+  for (int idx : indices) {
+    ids.push_back(convexHulls[idx].id);
+  }
+  return ids;
+}
+
+std::vector<chf::ConvexHull> makeOverlappingSquares() {
+  return {chf::ConvexHull({chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f),
+                           chf::Point(1.0f, 1.0f), chf::Point(0.0f, 1.0f)},
+                          10),
+          chf::ConvexHull({chf::Point(0.25f, 0.0f), chf::Point(1.25f, 0.0f),
+                           chf::Point(1.25f, 1.0f), chf::Point(0.25f, 1.0f)},
+                          11)};
+}
+}  // namespace
+
+TEST(HullFilter, filterConvexHullsJson) {
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  auto expected = chf::loadJson(dataDir + "/result_convex_hulls.json");
+  chf::HullFilter hullFilter;
+  auto keptIndices = hullFilter.filter(convexHulls);
+  std::vector<int> expectedIds;
+  for (const auto& convexHull : expected) {
+    expectedIds.push_back(convexHull.id);
+  }
+  EXPECT_EQ(expectedIds, getIds(convexHulls, keptIndices));
+}
+
+TEST(HullFilter, threshold) {
+  auto convexHulls = makeOverlappingSquares();
+  chf::HullFilterConfig config;
+  config.threshold = 80.0f;
+  chf::HullFilter hullFilter(config);
+  EXPECT_EQ(std::vector<int>({0, 1}), hullFilter.filter(convexHulls));
+}
+
+TEST(HullFilter, removalRule) {
+  auto convexHulls = makeOverlappingSquares();
+  chf::HullFilter eachOverlapped;
+  EXPECT_TRUE(eachOverlapped.filter(convexHulls).empty());
+
+  chf::HullFilterConfig config;
+  config.removalRule = chf::RemovalRule::SMALLER_OF_PAIR;
+  chf::HullFilter smallerOfPair(config);
+  EXPECT_EQ(std::vector<int>({0}), smallerOfPair.filter(convexHulls));
+}
+
+TEST(HullFilter, greedy) {
+  // Chain of squares where each one covers 60% of the next one and 20% of
+  // the one after
+  std::vector<chf::ConvexHull> convexHulls;
+  for (int i = 0; i < 4; i++) {
+    float x = 2.0f * i;
+    convexHulls.push_back(chf::ConvexHull(
+        {chf::Point(x, 0.0f), chf::Point(x + 5.0f, 0.0f),
+         chf::Point(x + 5.0f, 5.0f), chf::Point(x, 5.0f)},
+        i, 4.0f - i));
+  }
+  chf::HullFilter pairwise;
+  EXPECT_TRUE(pairwise.filter(convexHulls).empty());
+
+  // The second square is suppressed by the first one, so it can't suppress
+  // the third one anymore which in turn suppresses the last one
+  chf::HullFilterConfig config;
+  config.mode = chf::FilterMode::GREEDY;
+  config.scoreSource = chf::ScoreSource::FIELD;
+  chf::HullFilter greedy(config);
+  EXPECT_EQ(std::vector<int>({0, 2}), greedy.filter(convexHulls));
+
+  // With the opposite ranking the last square goes first and the other
+  // half of the chain is kept
+  for (auto& convexHull : convexHulls) {
+    convexHull.score = -convexHull.score;
+  }
+  EXPECT_EQ(std::vector<int>({1, 3}), greedy.filter(convexHulls));
+
+  // Both ends first, each one suppresses its only neighbour
+  convexHulls[0].score = 10.0f;
+  EXPECT_EQ(std::vector<int>({0, 3}), greedy.filter(convexHulls));
+
+  // The squares have the same area, ties go to the input order
+  config.scoreSource = chf::ScoreSource::AREA;
+  EXPECT_EQ(std::vector<int>({0, 2}),
+            chf::HullFilter(config).filter(convexHulls));
+}
+
+TEST(HullFilter, keptConvexHullsAreStreamedInOrder) {
+  class KeptObserver : public chf::HullFilterObserver {
+   public:
+    void onConvexHullKept(int index) override { kept.push_back(index); }
+    std::vector<int> kept;
+  };
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  for (auto mode : {chf::FilterMode::PAIRWISE, chf::FilterMode::GREEDY}) {
+    chf::HullFilterConfig config;
+    config.mode = mode;
+    chf::HullFilter hullFilter(config);
+    KeptObserver observer;
+    auto keptIndices = hullFilter.filter(convexHulls, &observer);
+    EXPECT_EQ(keptIndices, observer.kept);
+  }
+}
@@ -0,0 +1,136 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/IncrementalFilter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Point.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+chf::ConvexHull makeHexagon(float x, float y, float r, int id) {
+  std::vector<chf::Point> points;
+  for (int k = 0; k < 6; k++) {
+    float angle = k * static_cast<float>(M_PI) / 3;
+    points.push_back(
+        chf::Point(x + r * std::cos(angle), y + r * std::sin(angle)));
+  }
+  return chf::ConvexHull(points, id);
+}
+
+// Move, add and remove a fraction of the convex hulls of the frame and
+// shuffle a few of them
+void nextFrame(std::vector<chf::ConvexHull>* frame, float changeRate,
+               int* nextId, std::mt19937* gen) {
+  std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+  std::uniform_real_distribution<float> position(0.0f, 100.0f);
+  std::uniform_real_distribution<float> motion(-0.5f, 0.5f);
+  std::vector<chf::ConvexHull> next;
+  for (auto& convexHull : *frame) {
+    float draw = uniform(*gen);
+    if (draw < changeRate / 3) {
+      continue;
+    }
+    if (draw < changeRate) {
+      float dx = motion(*gen);
+      float dy = motion(*gen);
+      for (auto& point : convexHull.points) {
+        point = chf::Point(point.x + dx, point.y + dy);
+      }
+    }
+    next.push_back(convexHull);
+  }
+  while (next.size() < frame->size()) {
+    next.push_back(makeHexagon(position(*gen), position(*gen),
+                               1.0f + 4.0f * uniform(*gen), (*nextId)++));
+  }
+  for (int k = 0; k < 5; k++) {
+    std::swap(next[(*gen)() % next.size()], next[(*gen)() % next.size()]);
+  }
+  *frame = next;
+}
+}  // namespace
+
+TEST(IncrementalFilter, sameAsFullRecompute) {
+  for (auto rule :
+       {chf::RemovalRule::EACH_OVERLAPPED, chf::RemovalRule::SMALLER_OF_PAIR}) {
+    std::mt19937 gen(11);
+    chf::HullFilterConfig config;
+    config.removalRule = rule;
+    config.threshold = 20.0f;
+    chf::HullFilter hullFilter(config);
+    chf::IncrementalFilter incrementalFilter(config);
+    std::vector<chf::ConvexHull> frame;
+    int nextId = 0;
+    for (int i = 0; i < 400; i++) {
+      frame.push_back(makeHexagon(100.0f * (gen() % 1000) / 1000.0f,
+                                  100.0f * (gen() % 1000) / 1000.0f,
+                                  1.0f + (gen() % 400) / 100.0f, nextId++));
+    }
+    for (int k = 0; k < 20; k++) {
+      EXPECT_EQ(hullFilter.filter(frame), incrementalFilter.update(frame))
+          << "frame " << k;
+      if (k > 0) {
+        EXPECT_GT(incrementalFilter.getNbCachedPairs(), 0);
+      }
+      nextFrame(&frame, k < 10 ? 0.05f : 0.5f, &nextId, &gen);
+    }
+  }
+}
+
+TEST(IncrementalFilter, unchangedFrame) {
+  std::vector<chf::ConvexHull> frame = {makeHexagon(0.0f, 0.0f, 2.0f, 1),
+                                        makeHexagon(0.5f, 0.0f, 2.0f, 2),
+                                        makeHexagon(10.0f, 0.0f, 1.0f, 3)};
+  chf::IncrementalFilter incrementalFilter;
+  auto keptIndices = incrementalFilter.update(frame);
+  EXPECT_EQ(3, incrementalFilter.getNbChangedConvexHulls());
+  EXPECT_EQ(1, incrementalFilter.getNbComputedPairs());
+
+  EXPECT_EQ(keptIndices, incrementalFilter.update(frame));
+  EXPECT_EQ(0, incrementalFilter.getNbChangedConvexHulls());
+  EXPECT_EQ(0, incrementalFilter.getNbComputedPairs());
+  EXPECT_EQ(1, incrementalFilter.getNbCachedPairs());
+
+  // The pair is intersected again when its order in the frame changes
+  std::swap(frame[0], frame[1]);
+  incrementalFilter.update(frame);
+  EXPECT_EQ(1, incrementalFilter.getNbComputedPairs());
+
+  frame.pop_back();
+  incrementalFilter.update(frame);
+  EXPECT_EQ(1, incrementalFilter.getNbRemovedConvexHulls());
+
+  incrementalFilter.clear();
+  EXPECT_EQ(0, incrementalFilter.getNbChangedConvexHulls());
+  EXPECT_EQ(0, incrementalFilter.getNbRemovedConvexHulls());
+  EXPECT_EQ(0, incrementalFilter.getNbComputedPairs());
+  EXPECT_EQ(0, incrementalFilter.getNbCachedPairs());
+  incrementalFilter.update(frame);
+  EXPECT_EQ(2, incrementalFilter.getNbChangedConvexHulls());
+}
+
+TEST(IncrementalFilter, duplicateIds) {
+  std::vector<chf::ConvexHull> frame = {makeHexagon(0.0f, 0.0f, 2.0f, 1),
+                                        makeHexagon(5.0f, 0.0f, 2.0f, 1)};
+  chf::IncrementalFilter incrementalFilter;
+  EXPECT_THROW(incrementalFilter.update(frame), std::runtime_error);
+}
+
+TEST(IncrementalFilter, hashGeometry) {
+  auto convexHull = makeHexagon(1.0f, 2.0f, 3.0f, 1);
+  auto moved = makeHexagon(1.0f, 2.0f + 1e-6f, 3.0f, 2);
+  EXPECT_EQ(chf::hashGeometry(convexHull),
+            chf::hashGeometry(makeHexagon(1.0f, 2.0f, 3.0f, 5)));
+  EXPECT_NE(chf::hashGeometry(convexHull), chf::hashGeometry(moved));
+}
@@ -0,0 +1,87 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/Instrumentation.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+const std::string dataDir = CONVEX_HULL_FILTERING_DATA_DIR;
+}  // namespace
+
+TEST(Instrumentation, scopedTimer) {
+  chf::Instrumentation instrumentation;
+  std::uint64_t nbAllocations = 10;
+  instrumentation.setAllocationCounter(
+      [&nbAllocations]() { return nbAllocations; });
+  {
+    chf::ScopedTimer timer(&instrumentation, chf::Stage::LOAD);
+    nbAllocations += 3;
+  }
+  EXPECT_GE(instrumentation.getSeconds(chf::Stage::LOAD), 0.0);
+  EXPECT_EQ(3, instrumentation.getAllocations(chf::Stage::LOAD));
+  EXPECT_EQ(0, instrumentation.getAllocations(chf::Stage::WRITE));
+  // Nothing to record into
+  chf::ScopedTimer timer(nullptr, chf::Stage::LOAD);
+}
+
+TEST(Instrumentation, hullFilterCounters) {
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  chf::Instrumentation instrumentation;
+  chf::HullFilter hullFilter;
+  hullFilter.setInstrumentation(&instrumentation);
+  auto keptIndices = hullFilter.filter(convexHulls);
+  EXPECT_EQ(12, instrumentation.get(chf::Counter::CONVEX_HULLS));
+  EXPECT_EQ(7, instrumentation.get(chf::Counter::CANDIDATE_PAIRS));
+  EXPECT_EQ(7, instrumentation.get(chf::Counter::INTERSECTIONS));
+  EXPECT_EQ(convexHulls.size() - keptIndices.size(),
+            instrumentation.get(chf::Counter::REMOVALS));
+  EXPECT_GE(instrumentation.getSeconds(chf::Stage::FILTER),
+            instrumentation.getSeconds(chf::Stage::NARROW_PHASE));
+
+  std::ostringstream oss;
+  instrumentation.writeReport(&oss);
+  std::string report = oss.str();
+  EXPECT_NE(std::string::npos, report.find("\"narrow_phase\""));
+  EXPECT_NE(std::string::npos, report.find("\"candidate_pairs\": 7,"));
+  // Only set by the greedy mode
+  EXPECT_NE(std::string::npos,
+            report.find("\"scheduling_efficiency\": 0\n"));
+}
+
+TEST(Instrumentation, greedyComponents) {
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  chf::Instrumentation instrumentation;
+  chf::HullFilterConfig config;
+  config.mode = chf::FilterMode::GREEDY;
+  chf::HullFilter hullFilter(config);
+  hullFilter.setInstrumentation(&instrumentation);
+  hullFilter.filter(convexHulls);
+  std::uint64_t nbComponents = instrumentation.get(chf::Counter::COMPONENTS);
+  ASSERT_GT(nbComponents, 0);
+  std::uint64_t nbIsolated =
+      instrumentation.get(chf::Counter::ISOLATED_CONVEX_HULLS);
+  EXPECT_LT(nbIsolated, convexHulls.size());
+  EXPECT_GT(instrumentation.get(chf::Gauge::MEAN_COMPONENT_PAIRS), 0.0);
+  double efficiency = instrumentation.get(chf::Gauge::SCHEDULING_EFFICIENCY);
+  EXPECT_GT(efficiency, 0.0);
+  EXPECT_LE(efficiency, 1.0);
+
+  std::ostringstream oss;
+  instrumentation.writeReport(&oss);
+  std::string report = oss.str();
+  EXPECT_NE(std::string::npos,
+            report.find("\"isolated_convex_hulls\": " +
+                        std::to_string(nbIsolated) + ","));
+  EXPECT_NE(std::string::npos, report.find("\"mean_component_pairs\": "));
+  EXPECT_NE(std::string::npos, report.find("\"scheduling_efficiency\": "));
+}
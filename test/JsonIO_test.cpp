@@ -0,0 +1,201 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/JsonIO.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+const std::string dataDir = CONVEX_HULL_FILTERING_DATA_DIR;
+
+void expectSameConvexHulls(const std::vector<chf::ConvexHull>& expected,
+                           const std::vector<chf::ConvexHull>& actual) {
+  ASSERT_EQ(expected.size(), actual.size());
+  for (std::size_t i = 0; i < expected.size(); i++) {
+    EXPECT_EQ(expected[i].id, actual[i].id);
+    EXPECT_EQ(expected[i].score, actual[i].score);
+    ASSERT_EQ(expected[i].points.size(), actual[i].points.size());
+    for (std::size_t j = 0; j < expected[i].points.size(); j++) {
+      EXPECT_EQ(expected[i].points[j].x, actual[i].points[j].x);
+      EXPECT_EQ(expected[i].points[j].y, actual[i].points[j].y);
+    }
+  }
+}
+
+std::vector<chf::ConvexHull> loadJsonParallel(const std::string& content,
+                                              unsigned int nbThreads) {
+  auto filePath =
+      (std::filesystem::temp_directory_path() / "chf_parallel_test.json")
+          .string();
+  std::ofstream(filePath) << content;
+  chf::ThreadPool threadPool(nbThreads);
+  auto convexHulls = chf::loadJsonParallel(filePath, &threadPool);
+  std::filesystem::remove(filePath);
+  return convexHulls;
+}
+}  // namespace
+
+TEST(JsonIO, loadJsonMatchesDom) {
+  std::ifstream ifs(dataDir + "/convex_hulls.json");
+  auto dom = chf::loadJsonDom(&ifs);
+  auto sax = chf::loadJson(dataDir + "/convex_hulls.json");
+  EXPECT_EQ(12, sax.size());
+  expectSameConvexHulls(dom, sax);
+}
+
+TEST(JsonIO, loadJsonSkipsUnknownKeys) {
+  std::istringstream iss(R"({
+    "version": {"major": 1, "tags": [1, [2, {"a": 3}]]},
+    "convex hulls": [
+      {"ID": 4, "label": {"apexes": []}, "score": 0.5,
+       "apexes": [{"x": 0, "y": 0, "z": 1}, {"x": 1.5, "y": 0},
+                  {"x": 1, "y": 1}]},
+      {"apexes": [], "ID": 7}
+    ],
+    "comment": "done"
+  })");
+  auto convexHulls = chf::loadJson(&iss);
+  ASSERT_EQ(2, convexHulls.size());
+  EXPECT_EQ(4, convexHulls[0].id);
+  EXPECT_FLOAT_EQ(0.5f, convexHulls[0].score);
+  ASSERT_EQ(3, convexHulls[0].points.size());
+  EXPECT_FLOAT_EQ(1.5f, convexHulls[0].points[1].x);
+  EXPECT_EQ(7, convexHulls[1].id);
+  EXPECT_TRUE(convexHulls[1].points.empty());
+}
+
+TEST(JsonIO, loadJsonRejectsMalformedInput) {
+  std::istringstream missingId(R"({"convex hulls": [{"apexes": []}]})");
+  EXPECT_THROW(chf::loadJson(&missingId), std::runtime_error);
+  std::istringstream truncated(R"({"convex hulls": [{"ID": 1, "apexes": [)");
+  EXPECT_THROW(chf::loadJson(&truncated), std::runtime_error);
+}
+
+TEST(JsonIO, saveJsonRoundTrip) {
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  convexHulls[1].score = 2.0f;
+  std::stringstream ss;
+  chf::saveJson(&ss, convexHulls);
+  expectSameConvexHulls(convexHulls, chf::loadJson(&ss));
+}
+
+TEST(JsonIO, loadJsonParallelMatchesSax) {
+  auto expected = chf::loadJson(dataDir + "/convex_hulls.json");
+  for (unsigned int nbThreads : {1, 3}) {
+    chf::ThreadPool threadPool(nbThreads);
+    expectSameConvexHulls(
+        expected,
+        chf::loadJsonParallel(dataDir + "/convex_hulls.json", &threadPool));
+  }
+}
+
+TEST(JsonIO, loadJsonParallelFindsConvexHullBoundaries) {
+  std::string content = R"({
+    "note": "{\"convex hulls\": [{\"ID\": 9}]}",
+    "other": [{"ID": 8, "apexes": []}],
+    "convex hulls": [
+      {"ID": 1, "label": "}]\\", "apexes": [{"x": 1, "y": 2}]},
+      {"ID": 2, "meta": {"apexes": [{"x": 5}]}, "apexes": [], "score": 3}
+    ],
+    "tail": {"convex hulls": [{"ID": 7, "apexes": []}]}
+  })";
+  std::istringstream iss(content);
+  auto expected = chf::loadJson(&iss);
+  ASSERT_EQ(2, expected.size());
+  expectSameConvexHulls(expected, loadJsonParallel(content, 2));
+  EXPECT_TRUE(loadJsonParallel(R"({"convex hulls": []})", 2).empty());
+}
+
+TEST(JsonIO, loadJsonParallelRejectsMalformedInput) {
+  EXPECT_THROW(loadJsonParallel(R"({"convex hulls": [{"apexes": []}]})", 2),
+               std::runtime_error);
+  EXPECT_THROW(loadJsonParallel(R"({"convex hulls": [{"ID": 1, "apexes": [)",
+                                2),
+               std::runtime_error);
+  EXPECT_THROW(loadJsonParallel(R"({"convex hulls": [1, 2]})", 2),
+               std::runtime_error);
+  EXPECT_THROW(loadJsonParallel(R"({"convex hulls": [{"ID": 1, "apexes": [}]})",
+                                2),
+               std::runtime_error);
+}
+
+TEST(JsonIO, loadersRejectMalformedDocument) {
+  // Whether a file is accepted can't depend on the number of threads
+  std::string hull = R"({"ID": 1, "apexes": [{"x": 1, "y": 2}]})";
+  std::vector<std::string> contents = {
+      R"({"convex hulls": [)" + hull + "]} trailing",
+      R"({"convex hulls": [)" + hull + R"(]}{"convex hulls": [)" + hull +
+          "]}",
+      R"({"convex hulls": [)" + hull + ",,, " + hull + "]}",
+      R"({"convex hulls": [)" + hull + ",]}",
+      R"({"convex hulls": [, )" + hull + "]}",
+      "[" + hull + "]",
+      "5",
+      ""};
+  for (const auto& content : contents) {
+    std::istringstream iss(content);
+    EXPECT_THROW(chf::loadJson(&iss), std::runtime_error) << content;
+    EXPECT_THROW(loadJsonParallel(content, 2), std::runtime_error) << content;
+  }
+}
+
+TEST(JsonIO, saveJsonMatchesDom) {
+  // Values with a single shortest representation are written exactly like
+  // nlohmann::json does
+  std::vector<chf::ConvexHull> convexHulls = {
+      chf::ConvexHull({chf::Point(0, 0), chf::Point(1.5f, -2.25f),
+                       chf::Point(1e20f, 0.125f)},
+                      3, 0.75f),
+      chf::ConvexHull({chf::Point(-0.0f, 1e-5f)}, -1),
+      chf::ConvexHull({}, 8)};
+  std::stringstream streamed;
+  chf::saveJson(&streamed, convexHulls);
+  std::stringstream dom;
+  chf::saveJsonDom(&dom, convexHulls);
+  EXPECT_EQ(dom.str(), streamed.str());
+
+  std::stringstream emptyStreamed;
+  chf::saveJson(&emptyStreamed, {});
+  std::stringstream emptyDom;
+  chf::saveJsonDom(&emptyDom, {});
+  EXPECT_EQ(emptyDom.str(), emptyStreamed.str());
+}
+
+TEST(JsonIO, saveJsonCompact) {
+  auto convexHulls = chf::loadJson(dataDir + "/convex_hulls.json");
+  std::stringstream ss;
+  chf::saveJson(&ss, convexHulls, false);
+  std::string compact = ss.str();
+  EXPECT_EQ(std::string::npos, compact.find_first_of(" \t", 14));
+  EXPECT_EQ(compact.size() - 1, compact.find('\n'));
+  expectSameConvexHulls(convexHulls, chf::loadJson(&ss));
+}
+
+TEST(JsonIO, formatJsonNumber) {
+  auto format = [](double value) {
+    char buffer[32];
+    return std::string(buffer, chf::formatJsonNumber(value, buffer));
+  };
+  EXPECT_EQ("0.0", format(0.0));
+  EXPECT_EQ("-0.0", format(-0.0));
+  EXPECT_EQ("123.0", format(123.0));
+  EXPECT_EQ("-36.230472564697266", format(-36.230472564697266));
+  EXPECT_EQ("0.001", format(0.001));
+  EXPECT_EQ("1e-05", format(1e-5));
+  EXPECT_EQ("1e+16", format(1e16));
+  EXPECT_EQ("1.5e+300", format(1.5e300));
+  EXPECT_EQ("null", format(1.0 / 0.0));
+  double value = 0.1f;
+  EXPECT_EQ(value, std::stod(format(value)));
+}
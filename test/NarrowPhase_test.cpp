@@ -0,0 +1,91 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/NarrowPhase.hpp"
+
+#include <gtest/gtest.h>
+
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+// Row of unit squares, each one shifted by step from the previous one
+std::vector<chf::ConvexHull> makeSquares(int count, float step) {
+  std::vector<chf::ConvexHull> convexHulls;
+  for (int i = 0; i < count; i++) {
+    float x = i * step;
+    convexHulls.push_back(chf::ConvexHull(
+        {chf::Point(x, 0.0f), chf::Point(x + 1.0f, 0.0f),
+         chf::Point(x + 1.0f, 1.0f), chf::Point(x, 1.0f)},
+        i));
+  }
+  return convexHulls;
+}
+
+std::vector<std::pair<int, int>> makeAllPairs(int count) {
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i < count; i++) {
+    for (int j = i + 1; j < count; j++) {
+      pairs.push_back(std::make_pair(j, i));
+    }
+  }
+  return pairs;
+}
+}  // namespace
+
+TEST(NarrowPhase, computeOverlap) {
+  auto convexHulls = makeSquares(2, 0.25f);
+  chf::ThreadPool threadPool(1);
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+  std::vector<chf::Point> interPoints;
+  auto overlap = narrowPhase.computeOverlap(1, 0, &interPoints);
+  ASSERT_TRUE(overlap.inter);
+  EXPECT_EQ(1, overlap.first);
+  EXPECT_EQ(0, overlap.second);
+  EXPECT_FLOAT_EQ(0.75f, overlap.interArea);
+  EXPECT_FLOAT_EQ(75.0f, overlap.ratioFirst);
+  EXPECT_FLOAT_EQ(75.0f, overlap.ratioSecond);
+}
+
+TEST(NarrowPhase, findConvexHullsToRemoveIsDeterministic) {
+  auto convexHulls = makeSquares(60, 0.3f);
+  auto pairs = makeAllPairs(convexHulls.size());
+
+  chf::ThreadPool serialPool(1);
+  chf::NarrowPhase serial(convexHulls, &serialPool);
+  auto expected = serial.findConvexHullsToRemove(pairs, 50.0f);
+  EXPECT_TRUE(expected[0]);
+
+  for (unsigned int nbThreads : {2u, 3u, 8u}) {
+    chf::ThreadPool threadPool(nbThreads);
+    chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+    // Small blocks and chunks to exercise the scheduling
+    narrowPhase.blockSize = 37;
+    narrowPhase.chunkSize = 5;
+    std::vector<std::pair<int, int>> order;
+    narrowPhase.computeOverlaps(pairs, [&](const chf::PairOverlap& overlap) {
+      order.push_back(std::make_pair(overlap.first, overlap.second));
+    });
+    EXPECT_EQ(pairs, order);
+    EXPECT_EQ(expected, narrowPhase.findConvexHullsToRemove(pairs, 50.0f));
+  }
+}
+
+TEST(NarrowPhase, skipPair) {
+  auto convexHulls = makeSquares(10, 0.3f);
+  auto pairs = makeAllPairs(convexHulls.size());
+  chf::ThreadPool threadPool(2);
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+  narrowPhase.blockSize = 4;
+  std::size_t nbOverlaps = 0;
+  narrowPhase.computeOverlaps(
+      pairs, [&](const chf::PairOverlap&) { nbOverlaps++; },
+      [](int first, int second) { return first == 9 || second == 9; });
+  EXPECT_EQ(pairs.size() - 9, nbOverlaps);
+}
@@ -0,0 +1,193 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+chf::WorkloadConfig makeWorkloadConfig() {
+  auto config = chft::makeClusteredConfig(400, 8, 15.0f);
+  config.minVertices = 3;
+  config.maxVertices = 40;
+  return config;
+}
+}  // namespace
+
+TEST(OverlapCache, hashConvexHull) {
+  chf::ConvexHull convexHull(
+      {chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f), chf::Point(0.0f, 1.0f)});
+  chf::ConvexHull same(
+      {chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f), chf::Point(0.0f, 1.0f)});
+  chf::ConvexHull moved(
+      {chf::Point(0.0f, 0.0f), chf::Point(1.0f, 0.0f), chf::Point(0.0f, 2.0f)});
+  EXPECT_EQ(chf::hashConvexHull(convexHull), chf::hashConvexHull(same));
+  EXPECT_NE(chf::hashConvexHull(convexHull), chf::hashConvexHull(moved));
+}
+
+TEST(OverlapCache, findInserted) {
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_test");
+  std::string filePath = tmpDir.getFilePath("cache.chc");
+  {
+    chf::OverlapCache cache(filePath, 16);
+    cache.beginRun();
+    bool inter;
+    float interArea;
+    EXPECT_FALSE(cache.find(1, 2, 3.0f, 4.0f, &inter, &interArea));
+    cache.insert(1, 2, 3.0f, 4.0f, true, 1.5f);
+    cache.insert(5, 6, 3.0f, 4.0f, false, 0.0f);
+    EXPECT_EQ(2u, cache.size());
+    ASSERT_TRUE(cache.find(1, 2, 3.0f, 4.0f, &inter, &interArea));
+    EXPECT_TRUE(inter);
+    EXPECT_EQ(1.5f, interArea);
+    ASSERT_TRUE(cache.find(5, 6, 3.0f, 4.0f, &inter, &interArea));
+    EXPECT_FALSE(inter);
+    // The order of the pair and the areas are part of the key
+    EXPECT_FALSE(cache.find(2, 1, 4.0f, 3.0f, &inter, &interArea));
+    EXPECT_FALSE(cache.find(1, 2, 3.0f, 4.5f, &inter, &interArea));
+    EXPECT_EQ(2u, cache.getNbHits());
+    EXPECT_EQ(3u, cache.getNbMisses());
+  }
+  {
+    // The entries outlive the process that wrote them
+    chf::OverlapCache cache(filePath, 16);
+    cache.beginRun();
+    EXPECT_EQ(2u, cache.size());
+    bool inter;
+    float interArea;
+    ASSERT_TRUE(cache.find(1, 2, 3.0f, 4.0f, &inter, &interArea));
+    EXPECT_EQ(1.5f, interArea);
+  }
+  {
+    // Another size starts from an empty cache
+    chf::OverlapCache cache(filePath, 1000);
+    EXPECT_EQ(0u, cache.size());
+  }
+}
+
+TEST(OverlapCache, otherKernelVersion) {
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_test");
+  std::string filePath = tmpDir.getFilePath("cache.chc");
+  {
+    chf::OverlapCache cache(filePath, 16);
+    cache.beginRun();
+    cache.insert(1, 2, 3.0f, 4.0f, true, 1.5f);
+  }
+  {
+    // Overlaps computed by another version of the clipping can't be trusted
+    std::fstream fs(filePath,
+                    std::ios::in | std::ios::out | std::ios::binary);
+    std::uint32_t kernelVersion = chf::OVERLAP_CACHE_KERNEL_VERSION + 1;
+    fs.seekp(offsetof(chf::OverlapCacheHeader, kernelVersion));
+    fs.write(reinterpret_cast<const char*>(&kernelVersion),
+             sizeof(kernelVersion));
+  }
+  chf::OverlapCache cache(filePath, 16);
+  cache.beginRun();
+  EXPECT_EQ(0u, cache.size());
+  bool inter;
+  float interArea;
+  EXPECT_FALSE(cache.find(1, 2, 3.0f, 4.0f, &inter, &interArea));
+}
+
+TEST(OverlapCache, lockedFile) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_test");
+  std::string filePath = tmpDir.getFilePath("cache.chc");
+  chf::HullFilterConfig config;
+  auto expected = chf::HullFilter(config).filter(convexHulls);
+  config.overlapCacheFile = filePath;
+  {
+    auto cache = std::make_unique<chf::OverlapCache>(filePath, 16);
+    EXPECT_THROW(chf::OverlapCache(filePath, 16), std::runtime_error);
+    EXPECT_EQ(nullptr, chf::OverlapCache::tryOpen(filePath, 16));
+
+    // The filter runs without the cache held by someone else
+    chf::Instrumentation instrumentation;
+    chf::HullFilter hullFilter(config);
+    hullFilter.setInstrumentation(&instrumentation);
+    EXPECT_EQ(expected, hullFilter.filter(convexHulls));
+    EXPECT_EQ(0u, instrumentation.get(chf::Counter::CACHE_HITS));
+    EXPECT_EQ(0u, instrumentation.get(chf::Counter::CACHE_MISSES));
+    EXPECT_EQ(0u, cache->size());
+  }
+  EXPECT_NE(nullptr, chf::OverlapCache::tryOpen(filePath, 16));
+}
+
+TEST(OverlapCache, evictLeastRecentlyUsed) {
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_test");
+  chf::OverlapCache cache(tmpDir.getFilePath("cache.chc"), 8);
+  cache.beginRun();
+  for (std::uint64_t i = 0; i < 8; i++) {
+    cache.insert(i, i + 100, 1.0f, 1.0f, true, 0.5f);
+  }
+  cache.beginRun();
+  bool inter;
+  float interArea;
+  ASSERT_TRUE(cache.find(3, 103, 1.0f, 1.0f, &inter, &interArea));
+  ASSERT_TRUE(cache.find(6, 106, 1.0f, 1.0f, &inter, &interArea));
+  cache.insert(8, 108, 1.0f, 1.0f, true, 0.5f);
+  EXPECT_LE(cache.size(), 8u);
+  EXPECT_GT(cache.getNbEvicted(), 0u);
+  EXPECT_EQ(8u, cache.size() + cache.getNbEvicted() - 1);
+  // The entries used during the current run are kept
+  EXPECT_TRUE(cache.find(3, 103, 1.0f, 1.0f, &inter, &interArea));
+  EXPECT_TRUE(cache.find(6, 106, 1.0f, 1.0f, &inter, &interArea));
+  EXPECT_TRUE(cache.find(8, 108, 1.0f, 1.0f, &inter, &interArea));
+
+  for (std::uint64_t i = 0; i < 100; i++) {
+    cache.insert(i + 1000, i, 1.0f, 1.0f, false, 0.0f);
+  }
+  EXPECT_LE(cache.size(), 8u);
+}
+
+TEST(OverlapCache, hullFilter) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_cache_test");
+  for (auto mode : {chf::FilterMode::PAIRWISE, chf::FilterMode::GREEDY}) {
+    chf::HullFilterConfig config;
+    config.mode = mode;
+    config.nbThreads = 4;
+    auto expected = chf::HullFilter(config).filter(convexHulls);
+    config.overlapCacheFile = tmpDir.getFilePath(
+        mode == chf::FilterMode::PAIRWISE ? "pairwise.chc" : "greedy.chc");
+
+    chf::Instrumentation cold;
+    {
+      chf::HullFilter coldFilter(config);
+      coldFilter.setInstrumentation(&cold);
+      EXPECT_EQ(expected, coldFilter.filter(convexHulls));
+      EXPECT_EQ(0u, cold.get(chf::Counter::CACHE_HITS));
+      EXPECT_GT(cold.get(chf::Counter::CACHE_MISSES), 0u);
+    }
+
+    // A new filter reopens the file like a later process would, once the
+    // first one released it
+    chf::Instrumentation warm;
+    chf::HullFilter warmFilter(config);
+    warmFilter.setInstrumentation(&warm);
+    EXPECT_EQ(expected, warmFilter.filter(convexHulls));
+    EXPECT_EQ(cold.get(chf::Counter::CACHE_MISSES),
+              warm.get(chf::Counter::CACHE_HITS));
+    EXPECT_EQ(0u, warm.get(chf::Counter::CACHE_MISSES));
+  }
+}
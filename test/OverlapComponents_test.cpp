@@ -0,0 +1,188 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapComponents.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+#include "convex_hull_filtering/ThreadPool.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+std::vector<int> getConvexHulls(const chf::OverlapComponents& components,
+                                std::size_t component) {
+  const int* convexHulls = components.getConvexHulls(component);
+  return std::vector<int>(
+      convexHulls, convexHulls + components.getNbConvexHulls(component));
+}
+
+std::vector<std::size_t> getPairs(const chf::OverlapComponents& components,
+                                  std::size_t component) {
+  const std::size_t* pairs = components.getPairs(component);
+  return std::vector<std::size_t>(pairs,
+                                  pairs + components.getNbPairs(component));
+}
+
+chf::WorkloadConfig makeWorkloadConfig() {
+  return chft::makeClusteredConfig(2000, 40, 20.0f);
+}
+
+// The greedy pass over the whole set at once, searching the neighbours of
+// each kept hull in the tree
+std::vector<int> filterGreedySerial(
+    const std::vector<chf::ConvexHull>& convexHulls, float threshold) {
+  chf::RTree rtree(1, 3);
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    rtree.insertEntry(i, chf::BoundingBox(convexHulls[i].points));
+  }
+  std::vector<int> order(convexHulls.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return convexHulls[a].getArea() > convexHulls[b].getArea();
+  });
+  std::vector<std::size_t> rank(convexHulls.size());
+  for (std::size_t i = 0; i < order.size(); i++) {
+    rank[order[i]] = i;
+  }
+  chf::ThreadPool threadPool(1);
+  chf::NarrowPhase narrowPhase(convexHulls, &threadPool);
+  std::vector<chf::Point> interPoints;
+  std::vector<bool> suppressed(convexHulls.size(), false);
+  for (int idx : order) {
+    if (suppressed[idx]) {
+      continue;
+    }
+    std::vector<int> neighbours;
+    rtree.search(chf::BoundingBox(convexHulls[idx].points), &neighbours);
+    for (int neighbour : neighbours) {
+      if (suppressed[neighbour] || rank[neighbour] <= rank[idx]) {
+        continue;
+      }
+      auto overlap = narrowPhase.computeOverlap(idx, neighbour, &interPoints);
+      suppressed[neighbour] = overlap.inter && overlap.ratioSecond > threshold;
+    }
+  }
+  std::vector<int> keptIndices;
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    if (!suppressed[i]) {
+      keptIndices.push_back(i);
+    }
+  }
+  return keptIndices;
+}
+
+class OverlapRecorder : public chf::HullFilterObserver {
+ public:
+  void onOverlap(const chf::PairOverlap& overlap, bool,
+                 bool removeSecond) override {
+    overlaps.emplace_back(overlap.first, overlap.second);
+    removals.push_back(removeSecond);
+  }
+
+  std::vector<std::pair<int, int>> overlaps;
+  std::vector<bool> removals;
+};
+}  // namespace
+
+TEST(OverlapComponents, components) {
+  // {0, 3, 5} and {1, 4} with 2 and 6 isolated
+  std::vector<std::pair<int, int>> pairs = {{3, 5}, {4, 1}, {0, 5}, {3, 0}};
+  chf::OverlapComponents components(7, pairs);
+  ASSERT_EQ(2u, components.size());
+  EXPECT_EQ(std::vector<int>({0, 3, 5}), getConvexHulls(components, 0));
+  EXPECT_EQ(std::vector<std::size_t>({0, 2, 3}), getPairs(components, 0));
+  EXPECT_EQ(std::vector<int>({1, 4}), getConvexHulls(components, 1));
+  EXPECT_EQ(std::vector<std::size_t>({1}), getPairs(components, 1));
+
+  const auto& stats = components.getStats();
+  EXPECT_EQ(2u, stats.nbComponents);
+  EXPECT_EQ(2u, stats.nbIsolated);
+  EXPECT_EQ(3u, stats.maxConvexHulls);
+  EXPECT_EQ(3u, stats.maxPairs);
+  EXPECT_DOUBLE_EQ(2.0, stats.meanPairs);
+
+  chf::OverlapComponents empty(3, {});
+  EXPECT_EQ(0u, empty.size());
+  EXPECT_EQ(3u, empty.getStats().nbIsolated);
+}
+
+TEST(OverlapComponents, forEachComponent) {
+  // A chain of 100 hulls then 50 separate pairs
+  std::vector<std::pair<int, int>> pairs;
+  for (int i = 0; i + 1 < 100; i++) {
+    pairs.emplace_back(i, i + 1);
+  }
+  for (int i = 100; i < 200; i += 2) {
+    pairs.emplace_back(i, i + 1);
+  }
+  chf::OverlapComponents components(200, pairs);
+  ASSERT_EQ(51u, components.size());
+  EXPECT_EQ(99u, components.getStats().maxPairs);
+
+  chf::ThreadPool threadPool(4);
+  std::mutex mutex;
+  std::vector<std::size_t> visited;
+  components.forEachComponent(&threadPool, [&](std::size_t component,
+                                               unsigned int threadIdx) {
+    EXPECT_LT(threadIdx, 4u);
+    std::lock_guard<std::mutex> lock(mutex);
+    visited.push_back(component);
+  });
+  ASSERT_EQ(51u, visited.size());
+  std::sort(visited.begin(), visited.end());
+  for (std::size_t i = 0; i < visited.size(); i++) {
+    EXPECT_EQ(i, visited[i]);
+  }
+  double efficiency = components.getStats().schedulingEfficiency;
+  EXPECT_GE(efficiency, 0.0);
+  EXPECT_LE(efficiency, 1.0);
+}
+
+TEST(OverlapComponents, greedyFilter) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  auto expected = filterGreedySerial(convexHulls, 50.0f);
+  ASSERT_LT(expected.size(), convexHulls.size());
+
+  chf::HullFilterConfig config;
+  config.mode = chf::FilterMode::GREEDY;
+  config.nbThreads = 1;
+  chf::HullFilter serial(config);
+  chf::Instrumentation instrumentation;
+  serial.setInstrumentation(&instrumentation);
+  OverlapRecorder serialRecorder;
+  EXPECT_EQ(expected, serial.filter(convexHulls, &serialRecorder));
+  EXPECT_GT(instrumentation.get(chf::Counter::COMPONENTS), 1u);
+  EXPECT_GT(instrumentation.get(chf::Counter::LARGEST_COMPONENT), 0u);
+  EXPECT_GT(instrumentation.get(chf::Gauge::MEAN_COMPONENT_PAIRS), 0.0);
+  EXPECT_LE(instrumentation.get(chf::Gauge::MEAN_COMPONENT_PAIRS),
+            instrumentation.get(chf::Counter::LARGEST_COMPONENT));
+  EXPECT_LT(instrumentation.get(chf::Counter::ISOLATED_CONVEX_HULLS),
+            convexHulls.size());
+  EXPECT_GT(instrumentation.get(chf::Gauge::SCHEDULING_EFFICIENCY), 0.0);
+  EXPECT_LE(instrumentation.get(chf::Gauge::SCHEDULING_EFFICIENCY), 1.0);
+
+  // Same kept hulls and same overlaps in the same order on 4 threads
+  config.nbThreads = 4;
+  chf::HullFilter parallel(config);
+  OverlapRecorder parallelRecorder;
+  EXPECT_EQ(expected, parallel.filter(convexHulls, &parallelRecorder));
+  EXPECT_EQ(serialRecorder.overlaps, parallelRecorder.overlaps);
+  EXPECT_EQ(serialRecorder.removals, parallelRecorder.removals);
+}
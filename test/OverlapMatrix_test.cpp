@@ -0,0 +1,121 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/OverlapMatrix.hpp"
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/NarrowPhase.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/TemporaryDirectory.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+chf::ConvexHull makeSquare(float x, float y, float side, int id) {
+  return chf::ConvexHull({chf::Point(x, y), chf::Point(x + side, y),
+                          chf::Point(x + side, y + side),
+                          chf::Point(x, y + side)},
+                         id);
+}
+
+chf::WorkloadConfig makeWorkloadConfig() {
+  auto config = chft::makeClusteredConfig(1500, 6, 30.0f);
+  config.overlapRate = 0.6;
+  return config;
+}
+}  // namespace
+
+TEST(OverlapMatrix, ratios) {
+  // The second square covers a quarter of the first one and the whole third
+  std::vector<chf::ConvexHull> convexHulls = {
+      makeSquare(0.0f, 0.0f, 2.0f, 10), makeSquare(1.0f, 1.0f, 2.0f, 11),
+      makeSquare(1.5f, 1.5f, 1.0f, 12), makeSquare(10.0f, 10.0f, 1.0f, 13)};
+  auto matrix = chf::computeOverlapMatrix(convexHulls, chf::HullFilterConfig());
+  ASSERT_EQ(4u, matrix.size());
+  EXPECT_EQ(11, matrix.getConvexHull(1).id);
+  EXPECT_FLOAT_EQ(4.0f, matrix.getConvexHull(1).area);
+  EXPECT_FLOAT_EQ(25.0f, matrix.getRatio(0, 1));
+  EXPECT_FLOAT_EQ(25.0f, matrix.getRatio(1, 0));
+  EXPECT_FLOAT_EQ(100.0f, matrix.getRatio(2, 1));
+  EXPECT_FLOAT_EQ(25.0f, matrix.getRatio(1, 2));
+  EXPECT_EQ(0.0f, matrix.getRatio(0, 3));
+  EXPECT_EQ(0u, matrix.getRowSize(3));
+  ASSERT_EQ(2u, matrix.getRowSize(1));
+  EXPECT_EQ(0, matrix.getRow(1)[0].column);
+  EXPECT_EQ(2, matrix.getRow(1)[1].column);
+}
+
+TEST(OverlapMatrix, sameAsHullFilter) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  auto matrix = chf::computeOverlapMatrix(convexHulls, chf::HullFilterConfig());
+  EXPECT_GT(matrix.getNbEntries(), 1000u);
+  int nbChecked = 0;
+  for (float threshold : {0.0f, 10.0f, 25.0f, 50.0f, 75.0f, 90.0f}) {
+    chf::HullFilterConfig config;
+    config.threshold = threshold;
+    for (auto rule : {chf::RemovalRule::EACH_OVERLAPPED,
+                      chf::RemovalRule::SMALLER_OF_PAIR}) {
+      config.removalRule = rule;
+      EXPECT_EQ(chf::HullFilter(config).filter(convexHulls),
+                matrix.filter(config));
+      nbChecked++;
+    }
+    config.mode = chf::FilterMode::GREEDY;
+    for (auto score : {chf::ScoreSource::AREA, chf::ScoreSource::FIELD}) {
+      config.scoreSource = score;
+      EXPECT_EQ(chf::HullFilter(config).filter(convexHulls),
+                matrix.filter(config));
+      nbChecked++;
+    }
+  }
+  EXPECT_EQ(24, nbChecked);
+}
+
+TEST(OverlapMatrix, saveAndLoad) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  auto matrix = chf::computeOverlapMatrix(convexHulls, chf::HullFilterConfig());
+  chf::TemporaryDirectory tmpDir("", "chf_overlap_matrix_test");
+  std::string filePath = tmpDir.getFilePath("matrix.chm");
+  matrix.save(filePath);
+  auto loaded = chf::OverlapMatrix::load(filePath);
+  ASSERT_EQ(matrix.size(), loaded.size());
+  ASSERT_EQ(matrix.getNbEntries(), loaded.getNbEntries());
+  for (std::size_t row = 0; row < matrix.size(); row++) {
+    EXPECT_EQ(matrix.getConvexHull(row).id, loaded.getConvexHull(row).id);
+    EXPECT_EQ(matrix.getConvexHull(row).score,
+              loaded.getConvexHull(row).score);
+    ASSERT_EQ(matrix.getRowSize(row), loaded.getRowSize(row));
+    for (std::size_t i = 0; i < matrix.getRowSize(row); i++) {
+      EXPECT_EQ(matrix.getRow(row)[i].column, loaded.getRow(row)[i].column);
+      EXPECT_EQ(matrix.getRow(row)[i].ratio, loaded.getRow(row)[i].ratio);
+    }
+  }
+  chf::HullFilterConfig config;
+  config.mode = chf::FilterMode::GREEDY;
+  EXPECT_EQ(matrix.filter(config), loaded.filter(config));
+
+  // Cut the file in the middle of the entries
+  std::string truncatedPath = tmpDir.getFilePath("truncated.chm");
+  {
+    std::ifstream ifs(filePath, std::ios::binary);
+    std::string content((std::istreambuf_iterator<char>(ifs)),
+                        std::istreambuf_iterator<char>());
+    std::ofstream ofs(truncatedPath, std::ios::binary);
+    ofs.write(content.data(), content.size() - 12);
+  }
+  EXPECT_THROW(chf::OverlapMatrix::load(truncatedPath), std::runtime_error);
+  EXPECT_THROW(chf::OverlapMatrix::load(tmpDir.getFilePath("missing.chm")),
+               std::runtime_error);
+}
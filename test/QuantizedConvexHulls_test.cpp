@@ -0,0 +1,180 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/QuantizedConvexHulls.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+chf::ConvexHull makeBox(float minX, float minY, float maxX, float maxY) {
+  return chf::ConvexHull({chf::Point(minX, minY), chf::Point(maxX, minY),
+                          chf::Point(maxX, maxY), chf::Point(minX, maxY)});
+}
+
+double getInterArea(const std::vector<chf::ConvexHull>& convexHulls,
+                    float resolution) {
+  chf::QuantizedConvexHulls quantized(convexHulls, resolution);
+  double interArea = -1.0;
+  bool inter = quantized.intersectionArea(0, 1, &interArea);
+  EXPECT_EQ(inter, interArea > 0.0);
+  return interArea;
+}
+
+chf::WorkloadConfig makeWorkloadConfig() {
+  return chft::makeClusteredConfig(200, 10, 10.0f);
+}
+}  // namespace
+
+TEST(QuantizedConvexHulls, orientation) {
+  // Too close to collinear for a float cross product
+  chf::QuantizedPoint a(0, 0);
+  chf::QuantizedPoint b(1 << 29, (1 << 29) + 1);
+  chf::QuantizedPoint c((1 << 29) - 1, 1 << 29);
+  EXPECT_EQ(1, chf::orientation(a, b, c));
+  EXPECT_EQ(-1, chf::orientation(a, c, b));
+  EXPECT_EQ(0, chf::orientation(a, chf::QuantizedPoint(2, 2),
+                                chf::QuantizedPoint(1 << 29, 1 << 29)));
+}
+
+TEST(QuantizedConvexHulls, quantize) {
+  // Clockwise, with two vertices in the same cell
+  std::vector<chf::ConvexHull> convexHulls = {chf::ConvexHull(
+      {chf::Point(-1.0f, -1.0f), chf::Point(-1.0f, 0.5f),
+       chf::Point(0.5f, 0.5f), chf::Point(0.5f, -1.0f),
+       chf::Point(0.4f, -1.1f)})};
+  chf::QuantizedConvexHulls quantized(convexHulls, 0.5f);
+  ASSERT_EQ(1u, quantized.size());
+  ASSERT_EQ(4, quantized.getNbPoints(0));
+  EXPECT_DOUBLE_EQ(2.25, quantized.getArea(0));
+  const chf::QuantizedPoint* points = quantized.getPoints(0);
+  EXPECT_GT(chf::orientation(points[0], points[1], points[2]), 0);
+  auto corner = quantized.dequantize(chf::QuantizedPoint(0, 0));
+  EXPECT_FLOAT_EQ(-1.0f, corner.x);
+  EXPECT_FLOAT_EQ(-1.0f, corner.y);
+
+  EXPECT_THROW(chf::QuantizedConvexHulls(convexHulls, 0.0f),
+               std::runtime_error);
+  convexHulls.push_back(makeBox(1e6f, 1e6f, 1e6f + 1.0f, 1e6f + 1.0f));
+  EXPECT_THROW(chf::QuantizedConvexHulls(convexHulls, 1e-4f),
+               std::runtime_error);
+}
+
+TEST(QuantizedConvexHulls, intersectionArea) {
+  EXPECT_DOUBLE_EQ(0.25, getInterArea({makeBox(0.0f, 0.0f, 1.0f, 1.0f),
+                                       makeBox(0.5f, 0.5f, 2.0f, 2.0f)},
+                                      0.125f));
+  // Inclusion both ways
+  EXPECT_DOUBLE_EQ(0.25, getInterArea({makeBox(0.0f, 0.0f, 1.0f, 1.0f),
+                                       makeBox(0.25f, 0.25f, 0.75f, 0.75f)},
+                                      0.125f));
+  EXPECT_DOUBLE_EQ(0.25, getInterArea({makeBox(0.25f, 0.25f, 0.75f, 0.75f),
+                                       makeBox(0.0f, 0.0f, 1.0f, 1.0f)},
+                                      0.125f));
+  // Same convex hull
+  EXPECT_DOUBLE_EQ(1.0, getInterArea({makeBox(0.0f, 0.0f, 1.0f, 1.0f),
+                                      makeBox(0.0f, 0.0f, 1.0f, 1.0f)},
+                                     0.125f));
+  // Edges on the same line going the same way are only counted once
+  EXPECT_DOUBLE_EQ(2.0, getInterArea({makeBox(0.0f, 0.0f, 2.0f, 2.0f),
+                                      makeBox(1.0f, 0.0f, 3.0f, 2.0f)},
+                                     0.125f));
+  // Touching along an edge or at a corner is no intersection
+  EXPECT_EQ(0.0, getInterArea({makeBox(0.0f, 0.0f, 1.0f, 1.0f),
+                               makeBox(0.0f, 1.0f, 1.0f, 2.0f)},
+                              0.125f));
+  EXPECT_EQ(0.0, getInterArea({makeBox(0.0f, 0.0f, 1.0f, 1.0f),
+                               makeBox(1.0f, 1.0f, 2.0f, 2.0f)},
+                              0.125f));
+  // Triangles with a vertex exactly on the edge of the box, pointing out
+  // of it or into it
+  EXPECT_EQ(0.0, getInterArea({makeBox(0.0f, 0.0f, 2.0f, 2.0f),
+                               chf::ConvexHull({chf::Point(1.0f, 2.0f),
+                                                chf::Point(2.0f, 3.0f),
+                                                chf::Point(0.0f, 3.0f)})},
+                              0.125f));
+  EXPECT_DOUBLE_EQ(0.5, getInterArea({makeBox(0.0f, 0.0f, 2.0f, 2.0f),
+                                      chf::ConvexHull({chf::Point(1.0f, 1.0f),
+                                                       chf::Point(2.0f, 3.0f),
+                                                       chf::Point(0.0f, 3.0f)})},
+                                     0.125f));
+}
+
+TEST(QuantizedConvexHulls, matchesFloatIntersection) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  chf::QuantizedConvexHulls quantized(convexHulls, 1.0f / 1024);
+  std::vector<chf::Point> interPoints;
+  int nbOverlapping = 0;
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    for (std::size_t j = i + 1; j < convexHulls.size(); j++) {
+      float expectedArea;
+      convexHulls[i].intersectionArea(convexHulls[j], &expectedArea,
+                                      &interPoints);
+      double interArea;
+      quantized.intersectionArea(i, j, &interArea);
+      // A vertex moves by at most half a cell
+      EXPECT_NEAR(expectedArea, interArea, 0.05);
+      nbOverlapping += interArea > 0.0;
+    }
+  }
+  EXPECT_GT(nbOverlapping, 100);
+}
+
+// Moving every convex hull by a whole number of cells changes nothing, not
+// even the last bit of the areas
+TEST(QuantizedConvexHulls, translationInvariant) {
+  // On the grid so that the translation is exact in float too
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  for (auto& convexHull : convexHulls) {
+    for (auto& pt : convexHull.points) {
+      pt.x = std::round(pt.x * 64.0f) / 64.0f;
+      pt.y = std::round(pt.y * 64.0f) / 64.0f;
+    }
+  }
+  auto moved = convexHulls;
+  for (auto& convexHull : moved) {
+    for (auto& pt : convexHull.points) {
+      pt.x += 4096.0f;
+      pt.y -= 2048.0f;
+    }
+  }
+  chf::QuantizedConvexHulls quantized(convexHulls, 1.0f / 64);
+  chf::QuantizedConvexHulls quantizedMoved(moved, 1.0f / 64);
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    ASSERT_EQ(quantized.getArea(i), quantizedMoved.getArea(i));
+    for (std::size_t j = i + 1; j < convexHulls.size(); j++) {
+      double interArea;
+      double movedInterArea;
+      bool inter = quantized.intersectionArea(i, j, &interArea);
+      EXPECT_EQ(inter, quantizedMoved.intersectionArea(i, j, &movedInterArea));
+      EXPECT_EQ(interArea, movedInterArea);
+    }
+  }
+}
+
+TEST(QuantizedConvexHulls, hullFilter) {
+  auto convexHulls = chf::generateConvexHulls(makeWorkloadConfig());
+  chf::HullFilterConfig config;
+  config.nbThreads = 1;
+  auto expected = chf::HullFilter(config).filter(convexHulls);
+  config.resolution = 1.0f / 1024;
+  EXPECT_EQ(expected, chf::HullFilter(config).filter(convexHulls));
+  config.mode = chf::FilterMode::GREEDY;
+  auto greedy = chf::HullFilter(config).filter(convexHulls);
+  config.resolution = 0.0f;
+  EXPECT_EQ(chf::HullFilter(config).filter(convexHulls), greedy);
+}
@@ -0,0 +1,412 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/RTree.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <numeric>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTreeNode.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+// Heap resource keeping track of what is still allocated
+class CountingResource : public std::pmr::memory_resource {
+ public:
+  std::size_t nbAllocations = 0;
+  std::size_t nbBytes = 0;
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    nbAllocations++;
+    nbBytes += bytes;
+    return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+  }
+  void do_deallocate(void* p, std::size_t bytes,
+                     std::size_t alignment) override {
+    nbBytes -= bytes;
+    std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+  }
+  bool do_is_equal(
+      const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+std::vector<chf::BoundingBox> makeBoxes(int count, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> position(0.0f, 100.0f);
+  std::uniform_real_distribution<float> size(1.0f, 8.0f);
+  std::vector<chf::BoundingBox> boxes;
+  for (int i = 0; i < count; i++) {
+    chf::Point min(position(gen), position(gen));
+    boxes.push_back(
+        chf::BoundingBox(min, chf::Point(min.x + size(gen), min.y + size(gen))));
+  }
+  return boxes;
+}
+
+// Check the parents, the covering rectangles and the node sizes below node,
+// return the number of entries and set the depth of the leaves
+std::size_t checkNode(const chf::RTreeNode& node, unsigned int M, int depth,
+                      int* leafDepth) {
+  EXPECT_LE(node.children.size(), M);
+  if (node.isLeaf) {
+    if (*leafDepth < 0) {
+      *leafDepth = depth;
+    }
+    EXPECT_EQ(*leafDepth, depth);
+  }
+  std::size_t nbEntries = 0;
+  for (const auto& child : node.children) {
+    EXPECT_EQ(&node, child->parent);
+    EXPECT_LE(node.bb.min.x, child->bb.min.x);
+    EXPECT_LE(node.bb.min.y, child->bb.min.y);
+    EXPECT_GE(node.bb.max.x, child->bb.max.x);
+    EXPECT_GE(node.bb.max.y, child->bb.max.y);
+    nbEntries += node.isLeaf ? 1 : checkNode(*child, M, depth + 1, leafDepth);
+  }
+  return nbEntries;
+}
+
+std::vector<std::pair<int, int>> getSortedPairs(chf::RTree* rtree) {
+  auto pairs = rtree->findPairwiseIntersections();
+  for (auto& pair : pairs) {
+    pair = std::make_pair(std::min(pair.first, pair.second),
+                          std::max(pair.first, pair.second));
+  }
+  std::sort(pairs.begin(), pairs.end());
+  return pairs;
+}
+}  // namespace
+
+TEST(RTree, search) {
+  chf::RTree rtree(1, 3);
+  // 10x10 grid of unit boxes spaced by 2
+  for (int i = 0; i < 100; i++) {
+    float x = 2.0f * (i % 10);
+    float y = 2.0f * (i / 10);
+    rtree.insertEntry(
+        i, chf::BoundingBox(chf::Point(x, y), chf::Point(x + 1.0f, y + 1.0f)));
+  }
+  std::vector<int> values;
+  rtree.search(chf::BoundingBox(chf::Point(2.5f, 2.5f), chf::Point(4.5f, 4.5f)),
+               &values);
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ(std::vector<int>({11, 12, 21, 22}), values);
+
+  values.clear();
+  rtree.search(chf::BoundingBox(chf::Point(1.2f, 1.2f), chf::Point(1.8f, 1.8f)),
+               &values);
+  EXPECT_TRUE(values.empty());
+}
+
+TEST(RTree, findPairwiseIntersectionsMatchesBruteForce) {
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> position(0.0f, 100.0f);
+  std::uniform_real_distribution<float> size(1.0f, 8.0f);
+  for (int nbEntries : {2, 5, 17, 40, 300}) {
+    for (auto [m, M] : {std::make_pair(1u, 3u), std::make_pair(2u, 6u)}) {
+      chf::RTree rtree(m, M);
+      std::vector<chf::BoundingBox> boxes;
+      for (int i = 0; i < nbEntries; i++) {
+        chf::Point min(position(gen), position(gen));
+        boxes.push_back(chf::BoundingBox(
+            min, chf::Point(min.x + size(gen), min.y + size(gen))));
+        rtree.insertEntry(i, boxes.back());
+      }
+      std::vector<std::pair<int, int>> expected;
+      for (int i = 0; i < nbEntries; i++) {
+        for (int j = i + 1; j < nbEntries; j++) {
+          if (boxes[i].intersect(boxes[j])) {
+            expected.push_back(std::make_pair(i, j));
+          }
+        }
+      }
+      auto pairs = rtree.findPairwiseIntersections();
+      for (auto& pair : pairs) {
+        pair = std::make_pair(std::min(pair.first, pair.second),
+                              std::max(pair.first, pair.second));
+      }
+      std::sort(pairs.begin(), pairs.end());
+      EXPECT_EQ(expected, pairs) << nbEntries << " entries";
+    }
+  }
+}
+
+TEST(RTree, findPairwiseIntersectionsSkipsSelfPairs) {
+  chf::RTree rtree(1, 3);
+  chf::BoundingBox box(chf::Point(0.0f, 0.0f), chf::Point(1.0f, 1.0f));
+  rtree.insertEntry(0, box);
+  EXPECT_TRUE(rtree.findPairwiseIntersections().empty());
+  rtree.insertEntry(1, box);
+  std::vector<std::pair<int, int>> expected = {{0, 1}};
+  EXPECT_EQ(expected, getSortedPairs(&rtree));
+}
+
+TEST(RTree, findPairwiseIntersectionsInsideOnlyChildren) {
+  // root -> node -> leaf -> two overlapping entries, every node being the
+  // only child of its parent
+  chf::RTree rtree(1, 3);
+  chf::BoundingBox bb(chf::Point(0.0f, 0.0f), chf::Point(3.0f, 3.0f));
+  chf::RTreeNode* parent = rtree.treeRoot.get();
+  parent->isLeaf = false;
+  parent->bb = bb;
+  for (bool isLeaf : {false, true}) {
+    chf::RTreeNode* node = chf::makeNewRTreeNode(&parent->children, bb)->get();
+    node->isLeaf = isLeaf;
+    node->parent = parent;
+    parent = node;
+  }
+  for (int value : {0, 1}) {
+    chf::RTreeNode* entry =
+        chf::makeNewRTreeNode(&parent->children,
+                              chf::BoundingBox(chf::Point(value, value),
+                                               chf::Point(value + 2.0f,
+                                                          value + 2.0f)))
+            ->get();
+    entry->value = value;
+    entry->parent = parent;
+  }
+  std::vector<std::pair<int, int>> expected = {{0, 1}};
+  EXPECT_EQ(expected, getSortedPairs(&rtree));
+}
+
+TEST(RTree, findPairwiseIntersectionsIsRepeatable) {
+  // Nothing is marked in the nodes while looking for the pairs
+  auto boxes = makeBoxes(300, 8);
+  chf::RTree rtree(2, 6);
+  for (std::size_t i = 0; i < boxes.size(); i++) {
+    rtree.insertEntry(i, boxes[i]);
+  }
+  auto pairs = getSortedPairs(&rtree);
+  EXPECT_FALSE(pairs.empty());
+  EXPECT_EQ(pairs, getSortedPairs(&rtree));
+  rtree.insertEntry(boxes.size(), boxes[0]);
+  auto morePairs = getSortedPairs(&rtree);
+  EXPECT_GT(morePairs.size(), pairs.size());
+}
+
+TEST(RTree, adjustTreeKeepsCoveringRectangles) {
+  // Splits propagating up must grow the original ancestors, not the nodes
+  // split off which aren't in the tree yet
+  auto boxes = makeBoxes(1000, 9);
+  for (auto [m, M] : {std::make_pair(1u, 3u), std::make_pair(2u, 4u)}) {
+    chf::RTree rtree(m, M);
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+      rtree.insertEntry(i, boxes[i]);
+      if (i % 97 == 0) {
+        int leafDepth = -1;
+        EXPECT_EQ(i + 1, checkNode(*rtree.treeRoot, M, 0, &leafDepth));
+      }
+    }
+    int leafDepth = -1;
+    EXPECT_EQ(boxes.size(), checkNode(*rtree.treeRoot, M, 0, &leafDepth));
+  }
+}
+
+TEST(RTree, insertEntryChoosesLeastEnlargement) {
+  // Root with a leaf per entry: a large box and a small box away from it
+  chf::RTree rtree(1, 3);
+  chf::RTreeNode* root = rtree.treeRoot.get();
+  root->isLeaf = false;
+  std::vector<chf::RTreeNode*> leaves;
+  for (const auto& bb :
+       {chf::BoundingBox(chf::Point(0.0f, 0.0f), chf::Point(10.0f, 10.0f)),
+        chf::BoundingBox(chf::Point(20.0f, 0.0f), chf::Point(22.0f, 2.0f)),
+        chf::BoundingBox(chf::Point(0.0f, 0.0f), chf::Point(2.0f, 2.0f))}) {
+    chf::RTreeNode* leaf = chf::makeNewRTreeNode(&root->children, bb)->get();
+    leaf->isLeaf = true;
+    leaf->parent = root;
+    chf::RTreeNode* entry = chf::makeNewRTreeNode(&leaf->children, bb)->get();
+    entry->value = leaves.size();
+    entry->parent = leaf;
+    root->bb = leaves.empty() ? bb : root->bb.getUnion(bb);
+    leaves.push_back(leaf);
+  }
+  // Inside the large box, the union with the small box away from it would be
+  // smaller but that one would have to grow
+  rtree.insertEntry(3, chf::BoundingBox(chf::Point(8.0f, 0.0f),
+                                        chf::Point(9.0f, 1.0f)));
+  EXPECT_EQ(2, leaves[0]->children.size());
+  EXPECT_EQ(3, leaves[0]->children.back()->value);
+  // Inside both the large and the other small box, ties go to the smaller one
+  rtree.insertEntry(4, chf::BoundingBox(chf::Point(0.5f, 0.5f),
+                                        chf::Point(1.0f, 1.0f)));
+  EXPECT_EQ(2, leaves[2]->children.size());
+  EXPECT_EQ(4, leaves[2]->children.back()->value);
+  EXPECT_EQ(1, leaves[1]->children.size());
+  int leafDepth = -1;
+  EXPECT_EQ(5, checkNode(*rtree.treeRoot, 3, 0, &leafDepth));
+}
+
+TEST(RTree, removeEntry) {
+  std::mt19937 gen(4);
+  std::uniform_real_distribution<float> position(0.0f, 100.0f);
+  std::uniform_real_distribution<float> size(1.0f, 8.0f);
+  for (auto [m, M] : {std::make_pair(1u, 3u), std::make_pair(2u, 6u)}) {
+    chf::RTree rtree(m, M);
+    std::vector<chf::BoundingBox> boxes;
+    std::vector<bool> present;
+    for (int i = 0; i < 300; i++) {
+      chf::Point min(position(gen), position(gen));
+      boxes.push_back(chf::BoundingBox(
+          min, chf::Point(min.x + size(gen), min.y + size(gen))));
+      present.push_back(true);
+      rtree.insertEntry(i, boxes.back());
+    }
+    // Remove two thirds of the entries in a random order, moving some of
+    // them back in, and check the tree after each batch
+    std::vector<int> order(boxes.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::shuffle(order.begin(), order.end(), gen);
+    for (std::size_t k = 0; k < 200; k++) {
+      int idx = order[k];
+      EXPECT_TRUE(rtree.removeEntry(idx, boxes[idx]));
+      present[idx] = false;
+      if (k % 5 == 0) {
+        boxes[idx].min.x += 1.0f;
+        boxes[idx].max.x += 1.0f;
+        rtree.insertEntry(idx, boxes[idx]);
+        present[idx] = true;
+      }
+      if (k % 20 != 19) {
+        continue;
+      }
+      std::vector<std::pair<int, int>> expected;
+      for (std::size_t i = 0; i < boxes.size(); i++) {
+        for (std::size_t j = i + 1; j < boxes.size(); j++) {
+          if (present[i] && present[j] && boxes[i].intersect(boxes[j])) {
+            expected.push_back(std::make_pair(i, j));
+          }
+        }
+      }
+      auto pairs = rtree.findPairwiseIntersections();
+      for (auto& pair : pairs) {
+        pair = std::make_pair(std::min(pair.first, pair.second),
+                              std::max(pair.first, pair.second));
+      }
+      std::sort(pairs.begin(), pairs.end());
+      EXPECT_EQ(expected, pairs) << k << " removals";
+    }
+    EXPECT_FALSE(rtree.removeEntry(order[1], boxes[order[1]]));
+
+    // Empty the tree and fill it again
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+      if (present[i]) {
+        EXPECT_TRUE(rtree.removeEntry(i, boxes[i]));
+      }
+    }
+    EXPECT_TRUE(rtree.treeRoot->children.empty());
+    rtree.insertEntry(0, boxes[0]);
+    rtree.insertEntry(1, boxes[0]);
+    ASSERT_EQ(1, rtree.findPairwiseIntersections().size());
+  }
+}
+
+TEST(RTree, memoryResource) {
+  auto boxes = makeBoxes(500, 5);
+  CountingResource heap;
+  std::vector<std::pair<int, int>> expected;
+  {
+    // Every node comes from the given resource and goes back to it
+    chf::RTree rtree(2, 6, &heap);
+    EXPECT_EQ(&heap, rtree.getMemoryResource());
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+      rtree.insertEntry(i, boxes[i]);
+    }
+    EXPECT_GT(heap.nbAllocations, boxes.size());
+    for (std::size_t i = 0; i < boxes.size(); i += 2) {
+      EXPECT_TRUE(rtree.removeEntry(i, boxes[i]));
+    }
+    rtree.findPairwiseIntersections(&expected);
+  }
+  EXPECT_EQ(0u, heap.nbBytes);
+
+  // An arena over the same heap gives the same tree in a few allocations
+  CountingResource upstream;
+  {
+    std::pmr::monotonic_buffer_resource arena(&upstream);
+    chf::RTree rtree(2, 6, &arena);
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+      rtree.insertEntry(i, boxes[i]);
+    }
+    for (std::size_t i = 0; i < boxes.size(); i += 2) {
+      EXPECT_TRUE(rtree.removeEntry(i, boxes[i]));
+    }
+    std::vector<std::pair<int, int>> pairs;
+    rtree.findPairwiseIntersections(&pairs);
+    EXPECT_EQ(expected, pairs);
+    EXPECT_LT(upstream.nbAllocations * 20, heap.nbAllocations);
+  }
+  EXPECT_EQ(0u, upstream.nbBytes);
+
+  // Same with the arena owned by the tree
+  chf::RTree rtree(2, 6);
+  EXPECT_NE(std::pmr::get_default_resource(), rtree.getMemoryResource());
+  for (std::size_t i = 0; i < boxes.size(); i++) {
+    rtree.insertEntry(i, boxes[i]);
+  }
+  for (std::size_t i = 0; i < boxes.size(); i += 2) {
+    EXPECT_TRUE(rtree.removeEntry(i, boxes[i]));
+  }
+  EXPECT_EQ(expected, rtree.findPairwiseIntersections());
+}
+
+TEST(RTree, insertBatch) {
+  auto boxes = makeBoxes(3000, 6);
+  for (auto [m, M] : {std::make_pair(1u, 3u), std::make_pair(4u, 8u)}) {
+    // Batches of growing sizes into a tree built one entry at a time and
+    // into an empty one, both must find the same pairs as the reference
+    chf::RTree reference(m, M);
+    chf::RTree rtree(m, M);
+    chf::RTree bulkLoaded(m, M);
+    std::size_t nbInserted = 0;
+    for (; nbInserted < 500; nbInserted++) {
+      reference.insertEntry(nbInserted, boxes[nbInserted]);
+      rtree.insertEntry(nbInserted, boxes[nbInserted]);
+    }
+    for (std::size_t batchSize : {1, 2, 10, 100, 2387}) {
+      std::vector<std::pair<int, chf::BoundingBox>> batch;
+      for (std::size_t i = 0; i < batchSize; i++, nbInserted++) {
+        batch.push_back(std::make_pair(nbInserted, boxes[nbInserted]));
+        reference.insertEntry(nbInserted, boxes[nbInserted]);
+      }
+      rtree.insertBatch(batch);
+      int leafDepth = -1;
+      EXPECT_EQ(nbInserted, checkNode(*rtree.treeRoot, M, 0, &leafDepth));
+      EXPECT_EQ(getSortedPairs(&reference), getSortedPairs(&rtree))
+          << batchSize << " entries";
+    }
+    ASSERT_EQ(boxes.size(), nbInserted);
+
+    std::vector<std::pair<int, chf::BoundingBox>> entries;
+    for (std::size_t i = 0; i < boxes.size(); i++) {
+      entries.push_back(std::make_pair(i, boxes[i]));
+    }
+    bulkLoaded.insertBatch(entries);
+    int leafDepth = -1;
+    EXPECT_EQ(boxes.size(), checkNode(*bulkLoaded.treeRoot, M, 0, &leafDepth));
+    EXPECT_EQ(getSortedPairs(&reference), getSortedPairs(&bulkLoaded));
+
+    // The batch inserted entries can be searched and removed as usual
+    std::vector<int> values;
+    bulkLoaded.search(boxes[42], &values);
+    EXPECT_NE(values.end(), std::find(values.begin(), values.end(), 42));
+    for (std::size_t i = 0; i < boxes.size(); i += 2) {
+      EXPECT_TRUE(bulkLoaded.removeEntry(i, boxes[i]));
+      EXPECT_TRUE(rtree.removeEntry(i, boxes[i]));
+    }
+    EXPECT_EQ(getSortedPairs(&rtree), getSortedPairs(&bulkLoaded));
+  }
+}
@@ -0,0 +1,140 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/ShardedFilter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+class ShardedFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tmpDir = std::filesystem::temp_directory_path() / "chf_sharded_test";
+    std::filesystem::create_directories(tmpDir);
+    convexHulls = chft::makeHexagons(1500, 7);
+  }
+  void TearDown() override { std::filesystem::remove_all(tmpDir); }
+
+  chf::ShardedFilterConfig makeConfig(unsigned int nbWorkers) {
+    chf::ShardedFilterConfig config;
+    config.nbWorkers = nbWorkers;
+    config.workerExecutable = CONVEX_HULL_FILTERING_CLI;
+    config.tmpDir = tmpDir.string();
+    return config;
+  }
+
+  std::filesystem::path tmpDir;
+  std::vector<chf::ConvexHull> convexHulls;
+};
+}  // namespace
+
+TEST_F(ShardedFilterTest, sameAsSingleProcess) {
+  for (auto rule :
+       {chf::RemovalRule::EACH_OVERLAPPED, chf::RemovalRule::SMALLER_OF_PAIR}) {
+    for (unsigned int nbWorkers : {1, 2, 3, 4, 7}) {
+      auto config = makeConfig(nbWorkers);
+      config.filter.removalRule = rule;
+      config.filter.threshold = 33.3f;
+      chf::HullFilter hullFilter(config.filter);
+      chf::ShardedFilter shardedFilter(config);
+      EXPECT_EQ(hullFilter.filter(convexHulls),
+                shardedFilter.filter(convexHulls));
+      if (nbWorkers > 1) {
+        EXPECT_GT(shardedFilter.getNbCrossPairs(), 0);
+      }
+    }
+  }
+  // The shards and the results of the workers are removed
+  EXPECT_TRUE(std::filesystem::is_empty(tmpDir));
+}
+
+TEST_F(ShardedFilterTest, moreWorkersThanConvexHulls) {
+  convexHulls.erase(convexHulls.begin() + 3, convexHulls.end());
+  auto config = makeConfig(8);
+  chf::HullFilter hullFilter(config.filter);
+  chf::ShardedFilter shardedFilter(config);
+  EXPECT_EQ(hullFilter.filter(convexHulls), shardedFilter.filter(convexHulls));
+  EXPECT_TRUE(shardedFilter.filter({}).empty());
+}
+
+TEST_F(ShardedFilterTest, failingWorker) {
+  auto config = makeConfig(2);
+  config.workerExecutable = "/bin/false";
+  chf::ShardedFilter shardedFilter(config);
+  EXPECT_THROW(shardedFilter.filter(convexHulls), std::runtime_error);
+}
+
+TEST_F(ShardedFilterTest, onlyPairwise) {
+  auto config = makeConfig(2);
+  config.filter.mode = chf::FilterMode::GREEDY;
+  chf::ShardedFilter shardedFilter(config);
+  EXPECT_THROW(shardedFilter.filter(convexHulls), std::runtime_error);
+}
+
+TEST_F(ShardedFilterTest, workerExecutableIsRequired) {
+  auto config = makeConfig(2);
+  config.workerExecutable.clear();
+  chf::ShardedFilter shardedFilter(config);
+  EXPECT_THROW(shardedFilter.filter(convexHulls), std::runtime_error);
+}
+
+TEST_F(ShardedFilterTest, workerConfigKeepsEveryField) {
+  chf::HullFilterConfig config;
+  config.threshold = 33.3f;
+  config.removalRule = chf::RemovalRule::SMALLER_OF_PAIR;
+  config.mode = chf::FilterMode::GREEDY;
+  config.scoreSource = chf::ScoreSource::FIELD;
+  config.m = 4;
+  config.M = 9;
+  config.nbThreads = 3;
+  config.resolution = 0.125f;
+  config.approximate = true;
+  config.overlapCacheFile = (tmpDir / "overlaps.chc").string();
+  config.overlapCacheEntries = 1234;
+  config.leafVolume = chf::LeafVolume::ORIENTED_BOX;
+  std::string filePath = (tmpDir / "config.bin").string();
+  chf::ShardedFilter::writeWorkerConfig(filePath, config);
+  auto read = chf::ShardedFilter::readWorkerConfig(filePath);
+  EXPECT_EQ(config.threshold, read.threshold);
+  EXPECT_EQ(config.removalRule, read.removalRule);
+  EXPECT_EQ(config.mode, read.mode);
+  EXPECT_EQ(config.scoreSource, read.scoreSource);
+  EXPECT_EQ(config.m, read.m);
+  EXPECT_EQ(config.M, read.M);
+  EXPECT_EQ(config.nbThreads, read.nbThreads);
+  EXPECT_EQ(config.resolution, read.resolution);
+  EXPECT_EQ(config.approximate, read.approximate);
+  EXPECT_EQ(config.overlapCacheFile, read.overlapCacheFile);
+  EXPECT_EQ(config.overlapCacheEntries, read.overlapCacheEntries);
+  EXPECT_EQ(config.leafVolume, read.leafVolume);
+
+  std::ofstream(filePath, std::ios::binary) << "CHFW";
+  EXPECT_THROW(chf::ShardedFilter::readWorkerConfig(filePath),
+               std::runtime_error);
+}
+
+TEST_F(ShardedFilterTest, workersUseTheOverlapCache) {
+  auto config = makeConfig(2);
+  config.filter.m = 2;
+  config.filter.M = 6;
+  auto expected = chf::HullFilter(config.filter).filter(convexHulls);
+  // The workers run at the same time, the one locking the file first uses it
+  // and the other one runs without it
+  config.filter.overlapCacheFile = (tmpDir / "overlaps.chc").string();
+  chf::ShardedFilter shardedFilter(config);
+  EXPECT_EQ(expected, shardedFilter.filter(convexHulls));
+  EXPECT_TRUE(std::filesystem::exists(config.filter.overlapCacheFile));
+}
@@ -0,0 +1,56 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "TestData.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "convex_hull_filtering/Point.hpp"
+
+namespace convex_hull_filtering_test {
+
+std::vector<chf::ConvexHull> makeHexagons(int count, unsigned int seed) {
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> position(0.0f, 200.0f);
+  std::uniform_real_distribution<float> radius(1.0f, 5.0f);
+  std::vector<chf::ConvexHull> convexHulls;
+  for (int i = 0; i < count; i++) {
+    float x = position(gen);
+    float y = position(gen);
+    float r = radius(gen);
+    std::vector<chf::Point> points;
+    for (int k = 0; k < 6; k++) {
+      float angle = k * static_cast<float>(M_PI) / 3;
+      points.push_back(chf::Point(x + r * std::cos(angle),
+                                  y + r * std::sin(angle)));
+    }
+    convexHulls.push_back(chf::ConvexHull(points, 1000 + i));
+  }
+  return convexHulls;
+}
+
+chf::ConvexHull makeDisk(float x, float y, float radius, int nbVertices,
+                         float firstAngle) {
+  std::vector<chf::Point> points;
+  for (int i = 0; i < nbVertices; i++) {
+    float angle = 2.0f * M_PI * i / nbVertices + firstAngle;
+    points.emplace_back(x + radius * std::cos(angle),
+                        y + radius * std::sin(angle));
+  }
+  return chf::ConvexHull(points);
+}
+
+chf::WorkloadConfig makeClusteredConfig(std::uint64_t count,
+                                        std::uint64_t nbClusters,
+                                        float clusterRadius) {
+  chf::WorkloadConfig config;
+  config.count = count;
+  config.layout = chf::Layout::CLUSTERED;
+  config.nbClusters = nbClusters;
+  config.clusterRadius = clusterRadius;
+  return config;
+}
+}  // namespace convex_hull_filtering_test
@@ -0,0 +1,32 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#ifndef TEST_TESTDATA_HPP_
+#define TEST_TESTDATA_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+namespace convex_hull_filtering_test {
+
+namespace chf = convex_hull_filtering;
+
+// Random hexagons of various sizes, dense enough for many overlaps
+std::vector<chf::ConvexHull> makeHexagons(int count, unsigned int seed);
+
+// Regular polygon of nbVertices inscribed in a circle, counterclockwise
+// from firstAngle
+chf::ConvexHull makeDisk(float x, float y, float radius, int nbVertices,
+                         float firstAngle = 0.0f);
+
+// Workload of count convex hulls crowded in nbClusters clusters so that many
+// pairs overlap, the other fields keep their defaults
+chf::WorkloadConfig makeClusteredConfig(std::uint64_t count,
+                                        std::uint64_t nbClusters,
+                                        float clusterRadius);
+}  // namespace convex_hull_filtering_test
+
+#endif  // TEST_TESTDATA_HPP_
@@ -0,0 +1,138 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/TiledFilter.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "TestData.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullFilter.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/Instrumentation.hpp"
+#include "convex_hull_filtering/JsonIO.hpp"
+
+namespace chf = convex_hull_filtering;
+namespace chft = convex_hull_filtering_test;
+
+namespace {
+std::vector<int> getIds(const std::vector<chf::ConvexHull>& convexHulls) {
+  std::vector<int> ids;
+  for (const auto& convexHull : convexHulls) {
+    ids.push_back(convexHull.id);
+  }
+  return ids;
+}
+
+class TiledFilterTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    tmpDir = std::filesystem::temp_directory_path() / "chf_tiled_test";
+    std::filesystem::create_directories(tmpDir);
+    inputFile = (tmpDir / "input.json").string();
+    convexHulls = chft::makeHexagons(1500, 5);
+    chf::saveConvexHulls(inputFile, convexHulls);
+  }
+  void TearDown() override { std::filesystem::remove_all(tmpDir); }
+
+  std::vector<int> filterInMemory(const chf::HullFilterConfig& config) {
+    chf::HullFilter hullFilter(config);
+    std::vector<int> ids;
+    for (int idx : hullFilter.filter(convexHulls)) {
+      ids.push_back(convexHulls[idx].id);
+    }
+    return ids;
+  }
+
+  std::filesystem::path tmpDir;
+  std::string inputFile;
+  std::vector<chf::ConvexHull> convexHulls;
+};
+}  // namespace
+
+TEST_F(TiledFilterTest, sameAsInMemory) {
+  for (auto rule :
+       {chf::RemovalRule::EACH_OVERLAPPED, chf::RemovalRule::SMALLER_OF_PAIR}) {
+    chf::TiledFilterConfig config;
+    config.filter.removalRule = rule;
+    config.memoryBudget = 40000;
+    config.tmpDir = tmpDir.string();
+    auto expected = filterInMemory(config.filter);
+
+    for (std::string extension : {".json", ".chb"}) {
+      std::string outputFile = (tmpDir / ("output" + extension)).string();
+      chf::TiledFilter tiledFilter(config);
+      EXPECT_EQ(expected.size(), tiledFilter.filter(inputFile, outputFile));
+      EXPECT_GT(tiledFilter.getNbTiles(), 10);
+      // The halos are counted in the budget
+      EXPECT_GT(tiledFilter.getLargestTileBytes(), 0u);
+      EXPECT_LE(tiledFilter.getLargestTileBytes(), config.memoryBudget);
+      EXPECT_EQ(expected, getIds(chf::loadConvexHulls(outputFile)));
+    }
+  }
+  // Only the input and the outputs are left
+  EXPECT_EQ(3, std::distance(std::filesystem::directory_iterator(tmpDir),
+                             std::filesystem::directory_iterator()));
+}
+
+TEST_F(TiledFilterTest, singleTile) {
+  chf::TiledFilterConfig config;
+  config.tmpDir = tmpDir.string();
+  std::string outputFile = (tmpDir / "output.json").string();
+  chf::TiledFilter tiledFilter(config);
+  tiledFilter.filter(inputFile, outputFile);
+  EXPECT_EQ(1, tiledFilter.getNbTiles());
+  EXPECT_EQ(filterInMemory(config.filter),
+            getIds(chf::loadConvexHulls(outputFile)));
+}
+
+TEST_F(TiledFilterTest, instrumentation) {
+  chf::TiledFilterConfig config;
+  config.memoryBudget = 40000;
+  config.tmpDir = tmpDir.string();
+  chf::Instrumentation instrumentation;
+  chf::TiledFilter tiledFilter(config);
+  tiledFilter.setInstrumentation(&instrumentation);
+  std::size_t nbKept =
+      tiledFilter.filter(inputFile, (tmpDir / "output.json").string());
+  for (auto stage : {chf::Stage::LOAD, chf::Stage::TREE_BUILD,
+                     chf::Stage::BROAD_PHASE, chf::Stage::NARROW_PHASE,
+                     chf::Stage::FILTER, chf::Stage::WRITE}) {
+    EXPECT_GT(instrumentation.getSeconds(stage), 0.0)
+        << chf::Instrumentation::getName(stage);
+  }
+  // The convex hulls of the halos are counted by every tile they are in
+  EXPECT_GT(instrumentation.get(chf::Counter::CONVEX_HULLS),
+            convexHulls.size());
+  EXPECT_GE(instrumentation.get(chf::Counter::REMOVALS),
+            convexHulls.size() - nbKept);
+}
+
+TEST_F(TiledFilterTest, onlyPairwise) {
+  chf::TiledFilterConfig config;
+  config.filter.mode = chf::FilterMode::GREEDY;
+  chf::TiledFilter tiledFilter(config);
+  EXPECT_THROW(tiledFilter.filter(inputFile, (tmpDir / "out.json").string()),
+               std::runtime_error);
+}
+
+TEST_F(TiledFilterTest, halosLargerThanTheBudget) {
+  // A budget of a few convex hulls can't hold a tile and its halo, the tiles
+  // stop at the size of the halo and the largest one is reported
+  chf::TiledFilterConfig config;
+  config.memoryBudget = 4000;
+  config.tmpDir = tmpDir.string();
+  std::string outputFile = (tmpDir / "output.json").string();
+  chf::TiledFilter tiledFilter(config);
+  tiledFilter.filter(inputFile, outputFile);
+  // Far from the 65536 cells of the histogram
+  EXPECT_LT(tiledFilter.getNbTiles(), 4096);
+  EXPECT_GT(tiledFilter.getLargestTileBytes(), config.memoryBudget);
+  EXPECT_EQ(filterInMemory(config.filter),
+            getIds(chf::loadConvexHulls(outputFile)));
+}
@@ -0,0 +1,142 @@
+/* Copyright 2023 Remi KEAT */
+// This code follows Google C++ Style Guide.
+
+#include "convex_hull_filtering/WorkloadGenerator.hpp"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "convex_hull_filtering/BoundingBox.hpp"
+#include "convex_hull_filtering/ConvexHull.hpp"
+#include "convex_hull_filtering/HullIO.hpp"
+#include "convex_hull_filtering/Point.hpp"
+#include "convex_hull_filtering/RTree.hpp"
+
+namespace chf = convex_hull_filtering;
+
+namespace {
+// Fraction of the convex hulls whose intersection with another one isn't
+// empty
+double measureOverlapRate(const std::vector<chf::ConvexHull>& convexHulls) {
+  chf::RTree rtree(4, 8);
+  for (std::size_t i = 0; i < convexHulls.size(); i++) {
+    rtree.insertEntry(i, chf::BoundingBox(convexHulls[i].points));
+  }
+  std::vector<bool> overlapping(convexHulls.size(), false);
+  std::vector<chf::Point> interPoints;
+  for (const auto& [i, j] : rtree.findPairwiseIntersections()) {
+    if (convexHulls[i].intersection(convexHulls[j], &interPoints) &&
+        chf::ConvexHull::computeArea(interPoints) > 0.0f) {
+      overlapping[i] = true;
+      overlapping[j] = true;
+    }
+  }
+  std::size_t nbOverlapping = 0;
+  for (bool isOverlapping : overlapping) {
+    nbOverlapping += isOverlapping;
+  }
+  return static_cast<double>(nbOverlapping) / convexHulls.size();
+}
+
+bool samePoints(const chf::ConvexHull& a, const chf::ConvexHull& b) {
+  if (a.id != b.id || a.score != b.score ||
+      a.points.size() != b.points.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < a.points.size(); i++) {
+    if (a.points[i].x != b.points[i].x || a.points[i].y != b.points[i].y) {
+      return false;
+    }
+  }
+  return true;
+}
+}  // namespace
+
+TEST(WorkloadGenerator, deterministic) {
+  chf::WorkloadConfig config;
+  config.count = 200;
+  for (auto layout : {chf::Layout::UNIFORM, chf::Layout::CLUSTERED,
+                      chf::Layout::GAUSSIAN_BLOBS, chf::Layout::GRID}) {
+    config.layout = layout;
+    config.seed = 42;
+    auto first = chf::generateConvexHulls(config);
+    auto second = chf::generateConvexHulls(config);
+    ASSERT_EQ(config.count, first.size());
+    ASSERT_EQ(first.size(), second.size());
+    for (std::size_t i = 0; i < first.size(); i++) {
+      EXPECT_TRUE(samePoints(first[i], second[i]));
+    }
+    config.seed = 43;
+    auto other = chf::generateConvexHulls(config);
+    EXPECT_FALSE(samePoints(first[10], other[10]));
+  }
+}
+
+TEST(WorkloadGenerator, convexCounterClockwise) {
+  chf::WorkloadConfig config;
+  config.count = 500;
+  config.minVertices = 3;
+  config.maxVertices = 40;
+  for (auto distribution :
+       {chf::VertexDistribution::UNIFORM, chf::VertexDistribution::POISSON}) {
+    config.vertexDistribution = distribution;
+    for (const auto& convexHull : chf::generateConvexHulls(config)) {
+      const auto& points = convexHull.points;
+      ASSERT_GE(points.size(), 3u);
+      ASSERT_LE(points.size(), 40u);
+      for (std::size_t i = 0; i < points.size(); i++) {
+        const auto& a = points[i];
+        const auto& b = points[(i + 1) % points.size()];
+        const auto& c = points[(i + 2) % points.size()];
+        float cross = (b.x - a.x) * (c.y - b.y) - (b.y - a.y) * (c.x - b.x);
+        EXPECT_GT(cross, 0.0f);
+      }
+    }
+  }
+  config.minVertices = 2;
+  EXPECT_THROW(chf::WorkloadGenerator generator(config), std::runtime_error);
+}
+
+TEST(WorkloadGenerator, overlapRate) {
+  chf::WorkloadConfig config;
+  config.count = 5000;
+  for (auto layout : {chf::Layout::UNIFORM, chf::Layout::GRID}) {
+    config.layout = layout;
+    for (double overlapRate : {0.1, 0.3, 0.6}) {
+      config.overlapRate = overlapRate;
+      EXPECT_NEAR(overlapRate,
+                  measureOverlapRate(chf::generateConvexHulls(config)), 0.03);
+    }
+  }
+  // Same world, crowded in clusters
+  config.overlapRate = 0.3;
+  config.layout = chf::Layout::UNIFORM;
+  double uniformRate = measureOverlapRate(chf::generateConvexHulls(config));
+  for (auto layout : {chf::Layout::CLUSTERED, chf::Layout::GAUSSIAN_BLOBS}) {
+    config.layout = layout;
+    EXPECT_GT(measureOverlapRate(chf::generateConvexHulls(config)),
+              uniformRate);
+  }
+}
+
+TEST(WorkloadGenerator, generateWorkload) {
+  chf::WorkloadConfig config;
+  config.count = 300;
+  config.layout = chf::Layout::GAUSSIAN_BLOBS;
+  auto expected = chf::generateConvexHulls(config);
+  auto tmpDir = std::filesystem::temp_directory_path();
+  for (std::string name : {"chf_workload.chb", "chf_workload.json"}) {
+    std::string filePath = (tmpDir / name).string();
+    chf::generateWorkload(filePath, config, false);
+    auto convexHulls = chf::loadConvexHulls(filePath);
+    ASSERT_EQ(expected.size(), convexHulls.size());
+    for (std::size_t i = 0; i < expected.size(); i++) {
+      EXPECT_TRUE(samePoints(expected[i], convexHulls[i]));
+    }
+    std::filesystem::remove(filePath);
+  }
+}
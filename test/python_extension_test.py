@@ -0,0 +1,65 @@
+#!/bin/env python
+
+"""
+Build the Python extension with setup.py into a directory and import it, an
+undefined symbol only shows up at import when a source is missing from
+setup.py. Then check that the per pair and the batch intersection areas agree
+like python/benchmark.py does. Exit with 77, the skip code of the ctest,
+without numpy or setuptools.
+"""
+
+import importlib
+import os
+import subprocess
+import sys
+
+try:
+    import numpy as np
+    import setuptools  # noqa: F401
+except ImportError:
+    sys.exit(77)
+
+
+def main():
+    if len(sys.argv) != 2:
+        print("Usage: python_extension_test.py BUILD_DIR")
+        return 2
+    build_dir = os.path.abspath(sys.argv[1])
+    source_dir = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+    subprocess.run([sys.executable, "setup.py", "-q", "build_ext",
+                    "--build-lib", os.path.join(build_dir, "lib"),
+                    "--build-temp", os.path.join(build_dir, "temp")],
+                   cwd=source_dir, check=True)
+    sys.path.insert(0, os.path.join(build_dir, "lib"))
+    chf = importlib.import_module("convex_hull_filtering")
+
+    # Two squares, the second one covering 75% of the first one
+    points = np.array([[0.0, 0.0], [1.0, 0.0], [1.0, 1.0], [0.0, 1.0],
+                       [0.25, 0.0], [1.25, 0.0], [1.25, 1.0], [0.25, 1.0]])
+    offsets = np.array([0, 4, 8], dtype=np.int64)
+    kept = chf.filter(points, offsets, 50.0, "smaller")
+    if list(kept) != [0]:
+        print("Unexpected kept convex hulls", list(kept))
+        return 1
+
+    # Same data as the benchmark, its coordinates are large enough for the
+    # rounding of the areas to show
+    sys.path.insert(0, os.path.join(source_dir, "python"))
+    benchmark = importlib.import_module("benchmark")
+    points, offsets = benchmark.make_convex_hulls(20000, 8, 6.0, 42)
+    pairs = chf.findPairwiseIntersections(
+        4, 8, benchmark.get_entries(points, offsets)).astype(np.int64)
+    areas = np.array([
+        chf.intersection(np.matrix(points[offsets[i]:offsets[i + 1]]),
+                         np.matrix(points[offsets[j]:offsets[j + 1]]))[2]
+        for i, j in pairs])
+    batch_areas = chf.intersectionAreas(points, offsets, pairs)
+    if not np.allclose(areas, batch_areas, rtol=1e-4, atol=1e-3):
+        print("The per pair and the batch intersection areas differ on",
+              np.count_nonzero(areas != batch_areas), "pairs")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())